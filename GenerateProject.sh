@@ -0,0 +1,2 @@
+#!/bin/sh
+Dependencies/bx/tools/bin/linux/genie --gcc=linux-gcc gmake
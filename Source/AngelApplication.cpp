@@ -8,6 +8,16 @@ void angelApplication_RegisterTypes(asIScriptEngine* engine, Application** app)
     AS_VERIFY(engine->RegisterObjectType("CApplication", sizeof(Application), asOBJ_REF | asOBJ_NOCOUNT));
     AS_VERIFY(engine->RegisterObjectMethod("CApplication", "void loadScene(AssetRef)", asMETHOD(Application, loadScene), asCALL_THISCALL));
     AS_VERIFY(engine->RegisterObjectMethod("CApplication", "void restartScene()", asMETHOD(Application, restartScene), asCALL_THISCALL));
+    AS_VERIFY(engine->RegisterObjectMethod("CApplication", "void rewind(uint)", asMETHOD(Application, rewind), asCALL_THISCALL));
     AS_VERIFY(engine->RegisterObjectMethod("CApplication", "void exit()", asMETHOD(Application, exit), asCALL_THISCALL));
+    AS_VERIFY(engine->RegisterObjectMethod("CApplication", "void recordInput()", asMETHOD(Application, recordInput), asCALL_THISCALL));
+    AS_VERIFY(engine->RegisterObjectMethod("CApplication", "void saveInputRecording()", asMETHOD(Application, saveInputRecording), asCALL_THISCALL));
+    AS_VERIFY(engine->RegisterObjectMethod("CApplication", "void printMemoryReport()", asMETHOD(Application, printMemoryReport), asCALL_THISCALL));
+#ifdef NW_PROFILE
+    AS_VERIFY(engine->RegisterObjectMethod("CApplication", "void captureProfile(uint)", asMETHOD(Application, captureProfile), asCALL_THISCALL));
+    AS_VERIFY(engine->RegisterObjectMethod("CApplication", "void profileScriptLines(bool)", asMETHOD(Application, profileScriptLines), asCALL_THISCALL));
+    AS_VERIFY(engine->RegisterObjectMethod("CApplication", "void saveScriptProfile()", asMETHOD(Application, saveScriptProfile), asCALL_THISCALL));
+    AS_VERIFY(engine->RegisterObjectMethod("CApplication", "void saveCounters()", asMETHOD(Application, saveCounters), asCALL_THISCALL));
+#endif
     AS_VERIFY(engine->RegisterGlobalProperty("CApplication@ Application", app));
 }
@@ -47,6 +47,8 @@ void AppSettings::load(AppSettings& settings, const char* file)
         jRoot["width"].GetDouble() : 640;
     settings.height = jRoot.HasMember("height") ?
         jRoot["height"].GetDouble() : 360;
+    settings.jobWorkers = jRoot.HasMember("jobWorkers") ?
+        jRoot["jobWorkers"].GetInt() : -1;
 
     if (jRoot.HasMember("keys") && jRoot["keys"].IsObject())
     {
@@ -87,6 +89,7 @@ void AppSettings::save(const AppSettings& settings, const char* file)
     writer.String("fullscreen"); writer.Bool(settings.fullscreen);
     writer.String("width"); writer.Int(settings.width);
     writer.String("height"); writer.Int(settings.height);
+    writer.String("jobWorkers"); writer.Int(settings.jobWorkers);
     saveKeyBindings(writer, settings.bindings);
     writer.EndObject();
 
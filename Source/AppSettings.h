@@ -10,6 +10,7 @@ public:
     bool fullscreen;
     int32_t width;
     int32_t height;
+    int32_t jobWorkers;     //-1 for one per spare core, 0 runs jobs deterministically on the main thread
     input::KeyBindings bindings;
 
     static void load(AppSettings& settings, const char* file);
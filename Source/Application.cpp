@@ -1,50 +1,111 @@
 #include "Core/Core.h"
-#include <SDL_syswm.h>
 #include <SDL_mixer.h>
 #include <bgfx/platform.h>
+#include <ctime>
+#include <EASTL/sort.h>
+#include <rapidjson/writer.h>
+#include <rapidjson/stringbuffer.h>
 #include "Application.h"
 #include "AngelApplication.h"
 #include "Render/RenderCommon.h"
+#include "Core/FrameArena.h"
+#include "Core/MemoryTracker.h"
+#include "Util/File.h"
+
+//The window system header brings in X11 on Linux, whose macros (Bool, None,
+//Status) break headers included after it, so it goes last. Headless Linux
+//builds never open a window and leave it out.
+#if !defined(NW_HEADLESS) || defined(PLATFORM_WINDOWS)
+    #define USE_SDL_SYSWM
+    #include <SDL_syswm.h>
+#endif
 
 const char* SETTINGS_FILE = "app.json";
+const char* PROFILE_FILE = "profile.json";
+const char* SCRIPT_PROFILE_FILE = "script_profile.txt";
+const char* COUNTERS_FILE = "counters.csv";
+const char* INPUT_RECORDING_FILE = "input.rec";
+const char* REPLAY_FRAMES_FILE = "replay_frames.json";
+
+//About 10 seconds of history
+const uint32_t REWIND_TICKS = 600;
+const uint32_t REWIND_BYTES = 8 * 1024 * 1024;
+
+//Per buffer, there are two
+const size_t FRAME_ARENA_BYTES = 2 * 1024 * 1024;
 
-Application::Application() :
+Application::Application(bool headless) :
     _isRunning(true),
-    _isLoading(false)
+    _isLoading(false),
+    _isHeadless(headless),
+    _rewindTicks(0),
+    _fixedElapsed(0)
 {
     //Load settings from json file
     AppSettings::load(_settings, SETTINGS_FILE);
 
-    //Init SDL
-    NW_ASSERT(SDL_Init(SDL_INIT_EVERYTHING) == 0);
+    memory::g_FrameArena.init(FRAME_ARENA_BYTES);
+#ifdef NW_PROFILE
+    profiler::init();
+#endif
 
-    //Create window and context
-    uint32_t flags = 0;
-    if (_settings.fullscreen) { flags |= SDL_WINDOW_FULLSCREEN; }
-    _window = SDL_CreateWindow("Edge of No World",
-        SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-        _settings.width, _settings.height, flags);
+    //Start the job system, no workers runs every job on the main thread
+    _jobSystem.init(_settings.jobWorkers >= 0 ?
+        (uint32_t)_settings.jobWorkers : nw::JobSystem::getDefaultWorkerCount());
 
-    //Initialize rendering
+    if (_isHeadless)
+    {
+        //No window, the sounds still load but play into the dummy driver
+        NW_ASSERT(SDL_Init(SDL_INIT_TIMER | SDL_INIT_EVENTS) == 0);
+        SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+        _window = nullptr;
+
+        //Draw calls are still built and submitted, bgfx drops them
+        bgfx::PlatformData bgfxPlatformData;
+        memset(&bgfxPlatformData, 0, sizeof(bgfxPlatformData));
+        render::initRendering(bgfxPlatformData, bgfx::RendererType::Noop);
+        bgfx::reset(_settings.width, _settings.height, BGFX_RESET_NONE);
+    }
+    else
     {
+#ifdef USE_SDL_SYSWM
+        //Init SDL
+        NW_ASSERT(SDL_Init(SDL_INIT_EVERYTHING) == 0);
+
+        //Create window and context
+        uint32_t flags = 0;
+        if (_settings.fullscreen) { flags |= SDL_WINDOW_FULLSCREEN; }
+        _window = SDL_CreateWindow("Edge of No World",
+            SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+            _settings.width, _settings.height, flags);
+
+        //Initialize rendering
         SDL_SysWMinfo wmInfo;
         SDL_VERSION(&wmInfo.version);
         SDL_GetWindowWMInfo(_window, &wmInfo);
 
         bgfx::PlatformData bgfxPlatformData;
         memset(&bgfxPlatformData, 0, sizeof(bgfxPlatformData));
-#if _WIN32
+#ifdef PLATFORM_WINDOWS
         bgfxPlatformData.nwh = wmInfo.info.win.window;
+        render::initRendering(bgfxPlatformData, bgfx::RendererType::Direct3D11);
+#else
+        bgfxPlatformData.ndt = wmInfo.info.x11.display;
+        bgfxPlatformData.nwh = (void*)(uintptr_t)wmInfo.info.x11.window;
+        render::initRendering(bgfxPlatformData, bgfx::RendererType::OpenGL);
 #endif
-
-        render::initRendering(bgfxPlatformData);
         bgfx::reset(_settings.width, _settings.height, BGFX_RESET_VSYNC);
+#else
+        //Headless Linux builds have no window system to open a window with
+        NW_REQUIRE(false);
+#endif
     }
 
     //Initialize SDL_mixer
     Mix_Init(MIX_INIT_OGG);
     Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048);
 
+    memory::ScopedMemoryTag assetTag(memory::MemoryTag::Asset);
 #if USE_ASSET_REF_NAMES
     AssetNameTable::loadAssetNames("Assets.cpknames");
 #endif
@@ -69,12 +130,16 @@ Application::Application() :
 
 
     //TODO: Move away from fixed buffer size for 2D rendering
-    _renderManager.init(640, 360);
-    _renderManager.getRenderer2d().init(baseProgram);
+    {
+        memory::ScopedMemoryTag renderTag(memory::MemoryTag::Render);
+        _renderManager.init(640, 360);
+        _renderManager.getRenderer2d().init(baseProgram);
 
-    _renderManager.getPostProcessingManager().init(saturateProgram, _settings.width, _settings.height);
+        _renderManager.getPostProcessingManager().init(saturateProgram, _settings.width, _settings.height);
+    }
 
     //Initialize angelscript and load all scripts
+    memory::ScopedMemoryTag scriptTag(memory::MemoryTag::Script);
     _angelState.init();
     _angelState.setAssetManager(_assetManager);
     _angelState.setInput(_input);
@@ -82,37 +147,84 @@ Application::Application() :
     _angelState.setScene(_scene);
     static Application* angelApp = this;
     angelApplication_RegisterTypes(_angelState.getScriptEngine(), &angelApp);
-    _angelState.startCompiling();
-    eastl::string sectionName, sectionCode;
+
+    //The cook saves the built module, so scripts don't have to be compiled at startup
+    bool scriptsLoaded = false;
     for (auto iter = _assetManager.getPackFile().fileSpanBegin();
         iter != _assetManager.getPackFile().fileSpanEnd(); iter++)
     {
-        //TODO: We should have a separate list of only scripts
-        if (iter->second.assetType != AssetType::AngelScript) { continue; }
+        if (iter->second.assetType != AssetType::AngelBytecode) { continue; }
 
-        _assetManager.loadScript(iter->first, sectionName, sectionCode);
-        _angelState.addScriptSection(sectionName.c_str(), sectionCode.c_str());
+        eastl::vector<uint8_t> bytecode;
+        _assetManager.loadScriptBytecode(iter->first, bytecode);
+        _angelState.loadBytecode(bytecode.data(), bytecode.size());
+        scriptsLoaded = true;
+        break;
     }
-    _angelState.endCompiling();
 
+#ifdef NW_DEVELOP
+    //Packs cooked before the bytecode existed only have the sources
+    if (!scriptsLoaded)
+    {
+        _angelState.startCompiling();
+        eastl::string sectionName, sectionCode;
+        for (auto iter = _assetManager.getPackFile().fileSpanBegin();
+            iter != _assetManager.getPackFile().fileSpanEnd(); iter++)
+        {
+            //TODO: We should have a separate list of only scripts
+            if (iter->second.assetType != AssetType::AngelScript) { continue; }
+
+            _assetManager.loadScript(iter->first, sectionName, sectionCode);
+            _angelState.addScriptSection(sectionName.c_str(), sectionCode.c_str());
+        }
+        _angelState.endCompiling();
+        scriptsLoaded = true;
+    }
+#endif
+    NW_REQUIRE(scriptsLoaded);
+
+
+    memory::ScopedMemoryTag sceneTag(memory::MemoryTag::Scene);
+    _rewindBuffer.init(REWIND_TICKS, REWIND_BYTES);
 
     //Load initial scene
     _sceneRef = _assetManager.getAssetRefFromName("Scenes/Level01.scene");
 
     PackFile& packFile = _assetManager.getPackFile();
-    _scene.load(_assetManager, packFile, packFile.getFileSpan(_sceneRef), _angelState);
+    _scene.load(_assetManager, packFile, _sceneRef, _angelState, &_sceneSnapshot);
 
     _timer.reset();
     _input.init(_settings.bindings);
+    _input.setRecording(&_inputRecording);
 }
 
 Application::~Application()
 {
+    if (_inputRecording.isRecording())
+    {
+        saveInputRecording();
+    }
+
     Mix_HaltMusic();
     Mix_Quit();
     SDL_Quit();
 
     AppSettings::save(_settings, SETTINGS_FILE);
+
+#ifdef NW_DEVELOP
+    memory::FrameArenaStats arenaStats = memory::g_FrameArena.getStats();
+    printf("Frame arena high water mark: %u KB of %u KB, %u allocations overflowed to the heap\n",
+        (uint32_t)(arenaStats.highWaterMark / 1024), (uint32_t)(arenaStats.capacity / 1024), arenaStats.overflowCount);
+#endif
+#ifdef NW_MEMORY_TRACKING
+    memory::printMemoryStats();
+#endif
+#ifdef NW_PROFILE
+    profiler::printZoneStats();
+    counters::printCounterStats();
+    counters::writeCsv(COUNTERS_FILE);
+    _angelState.getProfiler().writeFlatProfile(SCRIPT_PROFILE_FILE);
+#endif
 }
 
 
@@ -120,6 +232,7 @@ Application::~Application()
 void Application::update()
 {
     SCOPED_CPU_EVENT(updateEvent)(0xFFFFFFFF, "Application::update");
+    uint64_t frameStart = SDL_GetPerformanceCounter();
 
     SDL_Event event;
     while (SDL_PollEvent(&event))
@@ -142,6 +255,62 @@ void Application::update()
         }
     }
 
+    memory::ScopedMemoryTag sceneTag(memory::MemoryTag::Scene);
+    beginFrame();
+
+    //Replays take every frame's time from the recording, so each frame runs
+    //the same number of fixed updates it did when it was recorded
+    bool replaying = _inputRecording.isReplaying();
+    uint32_t replayElapsed = 0;
+    if (replaying && !_inputRecording.replayFrame(replayElapsed))
+    {
+        finishReplay();
+        replaying = false;
+    }
+
+    //Update every 16ms
+    if (replaying)
+    {
+        _timer.advance(replayElapsed);
+    }
+    else
+    {
+        _timer.update();
+        if (_inputRecording.isRecording()) { _inputRecording.recordFrame(_timer.elapsedTicks()); }
+    }
+    _fixedElapsed += _timer.elapsedTicks();
+    while (_fixedElapsed > Timer::FIXED_UPDATE)
+    {
+        fixedUpdate();
+        _fixedElapsed -= Timer::FIXED_UPDATE;
+    }
+
+    endFrame();
+
+    if (replaying)
+    {
+        uint64_t elapsed = SDL_GetPerformanceCounter() - frameStart;
+        _replayFrameUs.push_back((uint32_t)(elapsed * 1000000 / SDL_GetPerformanceFrequency()));
+    }
+}
+
+void Application::runHeadless(uint32_t ticks)
+{
+    NW_ASSERT(_isHeadless);
+
+    //One update per frame, however long it takes
+    for (uint32_t i = 0; i < ticks && _isRunning; i++)
+    {
+        SCOPED_CPU_EVENT(updateEvent)(0xFFFFFFFF, "Application::update");
+        memory::ScopedMemoryTag sceneTag(memory::MemoryTag::Scene);
+        beginFrame();
+        fixedUpdate();
+        endFrame();
+    }
+}
+
+void Application::beginFrame()
+{
     //Check for scene change
     if (_isLoading)
     {
@@ -150,33 +319,81 @@ void Application::update()
         //Stop all sounds
         Mix_HaltChannel(-1);
 
+        //Recorded sessions start here, before any script runs. Scripts draw
+        //from rand(), so every load in a session reseeds it the same way.
+        if (_inputRecording.isPending())
+        {
+            _inputRecording.beginSession(_sceneRef);
+        }
+        if (_inputRecording.isActive())
+        {
+            srand(_inputRecording.getSeed());
+            _input.clear();
+        }
+
         _scene.~Scene();
         new (&_scene) Scene();
-        auto& packFile = _assetManager.getPackFile();
-        _scene.load(_assetManager, packFile, packFile.getFileSpan(_sceneRef), _angelState);
+
+        //Restarts come straight from the snapshot taken when the scene was first loaded
+        if (_sceneSnapshot.isOf(_sceneRef))
+        {
+            _scene.load(_assetManager, _sceneSnapshot, _angelState);
+        }
+        else
+        {
+            auto& packFile = _assetManager.getPackFile();
+            _scene.load(_assetManager, packFile, _sceneRef, _angelState, &_sceneSnapshot);
+        }
         _angelState.setScene(_scene);
         _input.update();
         _isLoading = false;
+        _rewindBuffer.clear();
+        _rewindTicks = 0;
 
         _timer.reset();
+        _fixedElapsed = 0;
+    }
+
+    //Rewinds are requested mid update, so they're applied here like scene changes
+    if (_rewindTicks > 0)
+    {
+        _rewindBuffer.rewind(_scene, _assetManager, _rewindTicks);
+        _rewindTicks = 0;
     }
 
     _scene.handleInstantiated(_assetManager);
+}
 
-    //Update every 16ms
-    static uint32_t totalElapsed = 0;
-    _timer.update();
-    totalElapsed += _timer.elapsedTicks();
-    while (totalElapsed > Timer::FIXED_UPDATE)
+void Application::fixedUpdate()
+{
+    _input.update();
+    _scene.update(_assetManager, Timer::FIXED_UPDATE, _jobSystem);
+    _rewindBuffer.capture(_scene);
+
+    if (_inputRecording.endTick())
     {
-        _input.update();
-        _scene.update(_assetManager, Timer::FIXED_UPDATE);
-        totalElapsed -= Timer::FIXED_UPDATE;
+        _inputRecording.checkState(_rewindBuffer.getStateHash());
+    }
+}
+
+void Application::endFrame()
+{
+    {
+        memory::ScopedMemoryTag renderTag(memory::MemoryTag::Render);
+        _scene.render(_renderManager, _jobSystem);
+        _renderManager.renderPostProcessing();
+        bgfx::frame();
     }
 
-    _scene.render(_renderManager);
-    _renderManager.renderPostProcessing();
-    bgfx::frame();
+    //Everything allocated two frames ago is done with
+    memory::g_FrameArena.endFrame();
+#ifdef NW_MEMORY_TRACKING
+    memory::endMemoryFrame();
+#endif
+#ifdef NW_PROFILE
+    profiler::endFrame();
+    counters::endFrame();
+#endif
 }
 
 bool Application::isRunning() { return _isRunning; }
@@ -192,3 +409,126 @@ void Application::loadScene(AssetRef ref)
     _isLoading = true;
     _sceneRef = ref;
 }
+
+void Application::rewind(uint32_t ticks)
+{
+    _rewindTicks += ticks;
+}
+
+void Application::recordInput()
+{
+    _inputRecording.startRecording((uint32_t)time(nullptr));
+    restartScene();
+}
+
+void Application::saveInputRecording()
+{
+    if (!_inputRecording.isRecording()) { return; }
+
+    _inputRecording.stop();
+    if (_inputRecording.save(INPUT_RECORDING_FILE))
+    {
+        printf("Recorded %u frames (%u ticks) of input to %s\n",
+            _inputRecording.getFrameCount(), _inputRecording.getTickCount(), INPUT_RECORDING_FILE);
+    }
+    else
+    {
+        printf("Couldn't write %s\n", INPUT_RECORDING_FILE);
+    }
+}
+
+bool Application::replayInput(const char* fileName)
+{
+    if (!_inputRecording.load(fileName))
+    {
+        printf("Couldn't read input recording %s\n", fileName);
+        return false;
+    }
+
+    _inputRecording.startReplay();
+    loadScene(_inputRecording.getSceneRef());
+    _replayFrameUs.clear();
+    return true;
+}
+
+void Application::printMemoryReport()
+{
+    _scene.printMemoryStats();
+    _assetManager.printMemoryStats();
+#ifdef NW_MEMORY_TRACKING
+    memory::printMemoryStats();
+#endif
+}
+
+static uint32_t percentile(const eastl::vector<uint32_t>& sorted, uint32_t percent)
+{
+    return sorted[(sorted.size() - 1) * percent / 100];
+}
+
+void Application::finishReplay()
+{
+    _inputRecording.stop();
+    _timer.reset();
+
+    printf("Replayed %u frames (%u ticks), %s\n", (uint32_t)_replayFrameUs.size(), _inputRecording.getTickCount(),
+        _inputRecording.hasDiverged() ? "the simulation diverged" : "the simulation matched the recording");
+
+    if (!_replayFrameUs.empty())
+    {
+        eastl::vector<uint32_t> sorted = _replayFrameUs;
+        eastl::sort(sorted.begin(), sorted.end());
+
+        uint64_t total = 0;
+        for (uint32_t us : sorted) { total += us; }
+
+        printf("Frame times: avg %u us, p50 %u us, p90 %u us, p99 %u us, max %u us\n",
+            (uint32_t)(total / sorted.size()), percentile(sorted, 50), percentile(sorted, 90),
+            percentile(sorted, 99), sorted.back());
+
+        //Every frame in order, so runs can be compared by whatever tool
+        rapidjson::StringBuffer buf;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buf);
+        writer.StartObject();
+        writer.Key("frames"); writer.Uint((uint32_t)sorted.size());
+        writer.Key("ticks"); writer.Uint(_inputRecording.getTickCount());
+        writer.Key("diverged"); writer.Bool(_inputRecording.hasDiverged());
+        writer.Key("avgUs"); writer.Uint((uint32_t)(total / sorted.size()));
+        writer.Key("p50Us"); writer.Uint(percentile(sorted, 50));
+        writer.Key("p90Us"); writer.Uint(percentile(sorted, 90));
+        writer.Key("p99Us"); writer.Uint(percentile(sorted, 99));
+        writer.Key("maxUs"); writer.Uint(sorted.back());
+        writer.Key("frameUs");
+        writer.StartArray();
+        for (uint32_t us : _replayFrameUs) { writer.Uint(us); }
+        writer.EndArray();
+        writer.EndObject();
+        util::file::writeAllText(REPLAY_FRAMES_FILE, buf.GetString());
+    }
+
+    if (_isHeadless)
+    {
+        exit();
+    }
+}
+
+#ifdef NW_PROFILE
+void Application::captureProfile(uint32_t frames)
+{
+    if (frames > 0) { profiler::captureTrace(frames, PROFILE_FILE); }
+}
+
+void Application::profileScriptLines(bool enabled)
+{
+    _angelState.getProfiler().setLineProfiling(enabled);
+}
+
+void Application::saveScriptProfile()
+{
+    _angelState.getProfiler().writeFlatProfile(SCRIPT_PROFILE_FILE);
+}
+
+void Application::saveCounters()
+{
+    counters::writeCsv(COUNTERS_FILE);
+}
+#endif
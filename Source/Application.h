@@ -5,9 +5,12 @@
 #include "AppSettings.h"
 #include "Timer.h"
 #include "Input/Input.h"
+#include "Input/InputRecording.h"
 #include "Asset/AssetManager.h"
 #include "Scene/Scene.h"
+#include "Scene/RewindBuffer.h"
 #include "Render/RenderManager.h"
+#include "Core/JobSystem.h"
 #include "Script/AngelState.h"
 
 class Application
@@ -15,7 +18,10 @@ class Application
 private:
     bool _isRunning;
     bool _isLoading;
+    bool _isHeadless;
     AssetRef _sceneRef;
+    uint32_t _rewindTicks;
+    uint32_t _fixedElapsed;
 
     AppSettings _settings;
 
@@ -23,22 +29,60 @@ private:
 
     Timer _timer;
     input::Input _input;
+    input::InputRecording _inputRecording;
+    eastl::vector<uint32_t> _replayFrameUs;
+    nw::JobSystem _jobSystem;
     asset::AssetManager _assetManager;
     scene::Scene _scene;
     render::RenderManager _renderManager;
     script::AngelState _angelState;
 
+    //Declared after the angel state so its script objects are released first
+    scene::SceneSnapshot _sceneSnapshot;
+
+    scene::RewindBuffer _rewindBuffer;
+
+    void beginFrame();
+    void fixedUpdate();
+    void endFrame();
+    void finishReplay();
+
 public:
-    Application();
+    //Headless runs without a window, audio device or GPU
+    explicit Application(bool headless = false);
     ~Application();
 
     void update();
+    //Runs ticks fixed updates, each followed by a render, as fast as possible
+    void runHeadless(uint32_t ticks);
 
     bool isRunning();
     void exit();
 
     void restartScene();
     void loadScene(AssetRef ref);
+    void rewind(uint32_t ticks);
+
+    //Records input from a restart of the current scene until saveInputRecording()
+    void recordInput();
+    void saveInputRecording();
+    //Plays a recording back from a load of the scene it was recorded in. The
+    //frame times are written to replay_frames.json when it ends, and headless
+    //runs exit then.
+    bool replayInput(const char* fileName);
+
+    //Prints what the current scene's systems and the loaded assets hold
+    void printMemoryReport();
+#ifdef NW_PROFILE
+    //Writes a Chrome trace of the next frames to profile.json
+    void captureProfile(uint32_t frames);
+    //Times every script function and line from the next script call, slow
+    void profileScriptLines(bool enabled);
+    //Writes the script flat profile to script_profile.txt
+    void saveScriptProfile();
+    //Writes the last frames of work counters to counters.csv
+    void saveCounters();
+#endif
 };
 
 #endif
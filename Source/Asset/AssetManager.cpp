@@ -4,6 +4,8 @@
 #include "Scene/Scene.h"
 #include "Util/Archives.h"
 #include "Core/xxhash/xxhash.h"
+#include "Core/FrameArena.h"
+#include "Core/MemoryTracker.h"
 
 namespace asset
 {
@@ -19,6 +21,7 @@ namespace asset
 
     void AssetManager::loadTextures(AssetRef* refs, uint32_t count)
     {
+        memory::ScopedMemoryTag tag(memory::MemoryTag::Asset);
         eastl::vector<uint8_t> buffer;
         buffer.resize(1024);    //Let's just pick some arbitrary starting point
         for (uint32_t i = 0; i < count; i++)
@@ -41,12 +44,14 @@ namespace asset
                 //Create texture
                 bgfx::TextureHandle tex = render::createTexture(buffer.data(), (uint32_t)buffer.size());
                 _textures.insert(eastl::make_pair(refs[i], tex));
+                COUNT_WORK(AssetsLoaded, 1);
             }
         }
     }
 
     void AssetManager::loadShaders(AssetRef* refs, uint32_t count)
     {
+        memory::ScopedMemoryTag tag(memory::MemoryTag::Asset);
         _packFile.lock();   //TEMP: Should have this loaded by the scene
 
         eastl::vector<uint8_t> buffer;
@@ -66,6 +71,7 @@ namespace asset
             //Create and store shader
             bgfx::ShaderHandle shader = bgfx::createShader(bgfx::copy(buffer.data(), span.size));
             _shaders.insert(eastl::make_pair(refs[i], shader));
+            COUNT_WORK(AssetsLoaded, 1);
         }
 
         _packFile.unlock(); //TEMP: Should have this loaded by the scene
@@ -73,6 +79,7 @@ namespace asset
 
     void AssetManager::loadSounds(AssetRef* refs, uint32_t count)
     {
+        memory::ScopedMemoryTag tag(memory::MemoryTag::Asset);
         struct SoundData
         {
             AssetRef asset;
@@ -127,6 +134,7 @@ namespace asset
             chunk.alen = tempSoundData[i].span.size;
             chunk.abuf = &_soundData[pos];
             _sounds.insert(eastl::make_pair(tempSoundData[i].asset, chunk));
+            COUNT_WORK(AssetsLoaded, 1);
 
             pos += tempSoundData[i].span.size;
         }
@@ -137,7 +145,8 @@ namespace asset
         _packFile.lock();
 
         auto span = _packFile.getFileSpan(ref);
-        void* buffer = malloc(span.size);
+        memory::FrameAllocator frameAllocator;
+        void* buffer = frameAllocator.allocate(span.size);
         _packFile.decompress(span, buffer);
 
         uint32_t chunkLen = ((uint32_t*)buffer)[0];
@@ -153,7 +162,20 @@ namespace asset
         memcpy(&code[0], (char*)buffer + chunkLen + 8, codeLen);
         code[codeLen] = 0;
 
-        free(buffer);
+        frameAllocator.deallocate(buffer, span.size);
+        COUNT_WORK(AssetsLoaded, 1);
+
+        _packFile.unlock();
+    }
+
+    void AssetManager::loadScriptBytecode(AssetRef ref, eastl::vector<uint8_t>& bytecode)
+    {
+        _packFile.lock();
+
+        auto span = _packFile.getFileSpan(ref);
+        bytecode.resize(span.size);
+        _packFile.decompress(span, bytecode.data());
+        COUNT_WORK(AssetsLoaded, 1);
 
         _packFile.unlock();
     }
@@ -205,6 +227,35 @@ namespace asset
         return _music.music;
     }
 
+    AssetMemoryStats AssetManager::getMemoryStats() const
+    {
+        AssetMemoryStats stats = {};
+
+        stats.textureCount = (uint32_t)_textures.size();
+        for (const auto& texture : _textures)
+        {
+            stats.textureBytes += render::getTextureInfo(texture.second).storageSize;
+        }
+        stats.shaderCount = (uint32_t)_shaders.size();
+
+        stats.soundCount = (uint32_t)_sounds.size();
+        stats.soundBytes = _soundData.size();
+        stats.soundReservedBytes = _soundData.capacity();
+
+        if (_music.music != nullptr) { stats.musicBytes = _music.span.size; }
+        return stats;
+    }
+
+    void AssetManager::printMemoryStats() const
+    {
+        AssetMemoryStats stats = getMemoryStats();
+        printf("Textures: %u, %.1f KB\n", stats.textureCount, stats.textureBytes / 1024.0);
+        printf("Shaders: %u\n", stats.shaderCount);
+        printf("Sounds: %u, %.1f KB (%.1f KB reserved)\n", stats.soundCount,
+            stats.soundBytes / 1024.0, stats.soundReservedBytes / 1024.0);
+        printf("Music: %.1f KB streamed\n", stats.musicBytes / 1024.0);
+    }
+
 #ifdef NW_EDITOR
     void AssetManager::saveScene(const char* fileName, const Scene& scene)
     {
@@ -19,6 +19,17 @@ using scene::Scene;
 
 namespace asset
 {
+    struct AssetMemoryStats
+    {
+        uint32_t textureCount;
+        size_t textureBytes;        //Image data handed to bgfx
+        uint32_t shaderCount;
+        uint32_t soundCount;
+        size_t soundBytes;          //Decoded samples, every sound shares one buffer
+        size_t soundReservedBytes;
+        size_t musicBytes;          //Size of the track being streamed, only a window of it is resident
+    };
+
     class AssetManager
     {
     private:
@@ -39,6 +50,7 @@ namespace asset
         void loadSounds(AssetRef* refs, uint32_t count);
 
         void loadScript(AssetRef ref, eastl::string& chunkName, eastl::string& code);
+        void loadScriptBytecode(AssetRef ref, eastl::vector<uint8_t>& bytecode);
 
         bgfx::TextureHandle getTexture(AssetRef ref);
         bgfx::ShaderHandle getShader(AssetRef ref);
@@ -46,6 +58,9 @@ namespace asset
 
         Mix_Music* streamMusic(AssetRef ref);
 
+        AssetMemoryStats getMemoryStats() const;
+        void printMemoryStats() const;
+
 #ifdef NW_EDITOR
         void saveScene(const char* fileName, const Scene& scene);
 #endif
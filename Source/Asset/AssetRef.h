@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include "../Util/ScopeTimer.h"
+#include "../Util/ArchiveTraits.h"
 
 #ifdef NW_DEVELOP
     #define USE_ASSET_REF_NAMES 1
@@ -36,6 +37,10 @@ namespace asset
 #endif
         }
 
+        //The name index is looked up on load, so only builds without names can be copied in bulk
+#if !USE_ASSET_REF_NAMES
+        AR_BULK_SERIALIZABLE(4);
+#endif
         template <typename Archive> void serialize(Archive& ar)
         {
             ar.serializeU32(hash);
@@ -19,6 +19,7 @@ namespace asset
         //Game
         AngelScript,
         Scene,
+        AngelBytecode,  //Compiled script module, see AngelState::loadBytecode()
     };
 }
 
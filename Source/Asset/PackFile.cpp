@@ -1,6 +1,6 @@
 #include "Core/Core.h"
 #include "PackFile.h"
-#include <lz4\lz4.h>
+#include <lz4/lz4.h>
 
 namespace asset
 {
@@ -108,8 +108,6 @@ namespace asset
         //Seek to the proper place in the file
         fseek(_file, span.offset, SEEK_SET);
 
-        char decBuf[2][BLOCK_BYTES];
-        int decBufIndex = 0;
         size_t totalBytesRead = 0;
         size_t totalUncompressed = 0;
 
@@ -134,19 +132,21 @@ namespace asset
                 }
             }
 
-            char* const decPtr = decBuf[decBufIndex];
-            const int decBytes = LZ4_decompress_safe_continue(lz4StreamDecode, cmpBuf, decPtr, cmpBytes, BLOCK_BYTES);
-            totalUncompressed += decBytes;
+            //Blocks are decoded straight into the output; the previously decoded
+            //block stays in place right before it to serve as the dictionary
+            char* const decPtr = (char*)buffer + totalUncompressed;
+            const size_t remaining = span.size - totalUncompressed;
+            const int maxBytes = (remaining < (size_t)BLOCK_BYTES) ? (int)remaining : BLOCK_BYTES;
+            const int decBytes = LZ4_decompress_safe_continue(lz4StreamDecode, cmpBuf, decPtr, cmpBytes, maxBytes);
             if (decBytes <= 0)
             {
                 break;
             }
-            memcpy(buffer, decPtr, (size_t)decBytes);
-            buffer = (char*)buffer + decBytes;
-            decBufIndex = (decBufIndex + 1) % 2;
+            totalUncompressed += decBytes;
         }
 
         NW_ASSERT(totalBytesRead == span.compressedSize);
         NW_ASSERT(totalUncompressed == span.size);
+        COUNT_WORK(BytesDecompressed, totalUncompressed);
     }
 }
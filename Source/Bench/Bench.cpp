@@ -0,0 +1,60 @@
+#include "Core/Core.h"
+#include "Bench.h"
+
+#ifdef NW_BENCHMARKS
+#include <cstdio>
+#include <SDL.h>
+
+namespace bench
+{
+    struct BenchEntry
+    {
+        const char* name;
+        BenchFn fn;
+    };
+
+    static const BenchEntry BENCHMARKS[] =
+    {
+        { "buddy", benchBuddy },
+        { "destroy", benchDestroy },
+        { "entities", benchEntities },
+        { "entities-check", checkEntities },
+        { "jobs", benchJobs },
+        { "profiler", benchProfiler },
+        { "scene", benchScene },
+    };
+
+    bool runBenchmarks(const char* name)
+    {
+        bool found = false;
+        for (const BenchEntry& entry : BENCHMARKS)
+        {
+            if (name == nullptr || strcmp(name, entry.name) == 0)
+            {
+                printf("== %s\n", entry.name);
+                entry.fn();
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    BenchTimer::BenchTimer(const char* name) :
+        _name(name),
+        _start(SDL_GetPerformanceCounter())
+    {
+    }
+
+    void BenchTimer::stop(uint32_t itemCount)
+    {
+        double us = elapsedUs();
+        printf("%s: %.1f us (%.3f us per item, %u items)\n", _name, us, us / (double)itemCount, itemCount);
+    }
+
+    double BenchTimer::elapsedUs() const
+    {
+        uint64_t elapsed = SDL_GetPerformanceCounter() - _start;
+        return (double)elapsed * 1000000.0 / (double)SDL_GetPerformanceFrequency();
+    }
+}
+#endif
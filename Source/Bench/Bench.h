@@ -0,0 +1,41 @@
+#ifndef BENCH_BENCH_H
+#define BENCH_BENCH_H
+
+#include "Core/Features.h"
+
+#ifdef NW_BENCHMARKS
+namespace bench
+{
+    typedef void (*BenchFn)();
+
+    //Runs the benchmark with the given name, or all of them if name is null.
+    //Returns false if no benchmark has that name.
+    bool runBenchmarks(const char* name);
+
+    //Timer for the section being measured, prints the elapsed time when stopped
+    class BenchTimer
+    {
+    private:
+        const char* _name;
+        uint64_t _start;
+
+    public:
+        BenchTimer(const char* name);
+        void stop(uint32_t itemCount);
+        //Time since construction, for benchmarks that aggregate their own runs
+        double elapsedUs() const;
+    };
+
+    void benchBuddy();
+    void benchDestroy();
+    void benchEntities();
+    void benchJobs();
+    void benchProfiler();
+    void benchScene();
+
+    //Checks that aren't timed, run along with the benchmarks
+    void checkEntities();
+}
+#endif
+
+#endif
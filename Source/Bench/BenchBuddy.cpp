@@ -0,0 +1,140 @@
+#include "Core/Core.h"
+#include "Bench.h"
+
+#ifdef NW_BENCHMARKS
+#include <cstdio>
+#include <cstdlib>
+#include "Core/BuddyAllocator.h"
+
+namespace bench
+{
+    const uint32_t BUDDY_LIVE_COUNT = 4096;
+    const uint32_t BUDDY_OP_COUNT = 1000000;
+    const uint32_t BUDDY_GROW_COUNT = 16384;
+
+    //Same leaf size and levels as the tag system
+    const size_t BUDDY_LEAF_SIZE = 16;
+    const uint32_t BUDDY_LEVELS = 12;
+
+    struct BuddyBlock
+    {
+        void* ptr;
+        size_t size;
+    };
+
+    static uint32_t nextRandom(uint32_t& state)
+    {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+
+    //Sizes of tag blocks: a couple of header words plus a few tags, with the
+    //occasional large one
+    static size_t randomSize(uint32_t& state)
+    {
+        uint32_t r = nextRandom(state);
+        return ((r & 15) == 0) ? 64 + (r >> 4) % 448 : 16 + (r >> 4) % 48;
+    }
+
+    struct MallocAllocator
+    {
+        void* alloc(size_t size) { return malloc(size); }
+        void free(void* ptr, size_t) { ::free(ptr); }
+    };
+
+    static void printStats(MallocAllocator&)
+    {
+    }
+
+    template <typename Allocator>
+    static void printStats(Allocator& allocator)
+    {
+        memory::BuddyStats stats = allocator.getStats();
+        printf("   %u arenas, %u KB used of %u KB, largest free block %u B, fragmentation %.2f\n",
+            stats.arenaCount, (uint32_t)(stats.usedBytes / 1024), (uint32_t)(stats.capacity / 1024),
+            (uint32_t)stats.largestFreeBlock, stats.getFragmentation());
+    }
+
+    //Keeps BUDDY_LIVE_COUNT blocks alive and replaces a random one every op,
+    //like entities with tags being spawned and destroyed
+    template <typename Allocator>
+    static void benchChurn(const char* name, Allocator& allocator)
+    {
+        eastl::vector<BuddyBlock> blocks(BUDDY_LIVE_COUNT);
+        uint32_t state = 1;
+        for (BuddyBlock& block : blocks)
+        {
+            block.size = randomSize(state);
+            block.ptr = allocator.alloc(block.size);
+            NW_REQUIRE(block.ptr != nullptr);
+        }
+
+        BenchTimer timer(name);
+        for (uint32_t i = 0; i < BUDDY_OP_COUNT; i++)
+        {
+            BuddyBlock& block = blocks[nextRandom(state) % BUDDY_LIVE_COUNT];
+            allocator.free(block.ptr, block.size);
+            block.size = randomSize(state);
+            block.ptr = allocator.alloc(block.size);
+            NW_REQUIRE(block.ptr != nullptr);
+        }
+        timer.stop(BUDDY_OP_COUNT);
+        printStats(allocator);
+
+        for (BuddyBlock& block : blocks)
+        {
+            allocator.free(block.ptr, block.size);
+        }
+    }
+
+    //Allocates well past the size of one arena
+    template <typename Allocator>
+    static void benchGrow(const char* name, Allocator& allocator)
+    {
+        eastl::vector<BuddyBlock> blocks(BUDDY_GROW_COUNT);
+        uint32_t state = 2;
+
+        BenchTimer timer(name);
+        for (BuddyBlock& block : blocks)
+        {
+            block.size = randomSize(state);
+            block.ptr = allocator.alloc(block.size);
+            NW_REQUIRE(block.ptr != nullptr);
+        }
+        timer.stop(BUDDY_GROW_COUNT);
+        printStats(allocator);
+
+        for (BuddyBlock& block : blocks)
+        {
+            allocator.free(block.ptr, block.size);
+        }
+    }
+
+    void benchBuddy()
+    {
+        {
+            MallocAllocator allocator;
+            benchChurn("malloc churn", allocator);
+            benchGrow("malloc grow", allocator);
+        }
+
+        {
+            memory::BuddyAllocator allocator;
+            allocator.init(BUDDY_LEAF_SIZE, BUDDY_LEVELS);
+            benchChurn("buddy churn", allocator);
+        }
+
+        {
+            memory::BuddyAllocator allocator;
+            allocator.init(BUDDY_LEAF_SIZE, BUDDY_LEVELS);
+            benchGrow("buddy grow", allocator);
+        }
+
+        {
+            memory::ConcurrentBuddyAllocator allocator;
+            allocator.init(BUDDY_LEAF_SIZE, BUDDY_LEVELS);
+            benchChurn("concurrent buddy churn", allocator);
+        }
+    }
+}
+#endif
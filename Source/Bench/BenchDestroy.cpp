@@ -0,0 +1,142 @@
+#include "Core/Core.h"
+#include "Bench.h"
+
+#ifdef NW_BENCHMARKS
+#include <cstdlib>
+#include "Scene/EntityManager.h"
+#include "Scene/TransformSystem.h"
+#include "Scene/SpriteSystem.h"
+#include "Scene/MovementSystem.h"
+#include "Scene/TagSystem.h"
+
+using namespace scene;
+
+namespace bench
+{
+    const uint32_t DESTROY_ENTITY_COUNT = 10000;
+    const uint32_t DESTROY_CHILDREN = 3;    //Children per root, so a quarter of the entities are roots
+    const uint32_t DESTROY_TAG_EVERY = 10;
+    const uint32_t DESTROY_ITERATIONS = 5;
+
+    //The systems Scene::handleDestroyed() runs, minus scripts since they need a script engine
+    struct DestroyScene
+    {
+        EntityManager entityManager;
+        TransformSystem trSystem;
+        SpriteSystem spriteSystem;
+        MovementSystem moveSystem;
+        TagSystem tagSystem;
+        DestroyBatch batch;
+        eastl::vector<Entity> roots;
+        eastl::vector<Entity> entities;
+
+        DestroyScene()
+        {
+            tagSystem.init();
+        }
+
+        void populate()
+        {
+            roots.clear();
+            entities.clear();
+
+            SpriteSystem::Template spriteTmpl = {};
+            spriteTmpl.size = Vector2i(16, 16);
+            spriteTmpl.texture = BGFX_INVALID_HANDLE;
+
+            MovementSystem::Template moveTmpl = {};
+            moveTmpl.size = Vector2i(16, 16);
+
+            uint32_t tag = 1;
+            TagSystem::Template tagTmpl = { (const uint8_t*)&tag, 1 };
+
+            EInstance root;
+            for (uint32_t i = 0; i < DESTROY_ENTITY_COUNT; i++)
+            {
+                Entity e = entityManager.create();
+                entities.push_back(e);
+
+                Vector2i pos((int32_t)i, 0);
+                trSystem.createMany(&e, 1, &pos);
+                spriteSystem.createMany(&e, 1, spriteTmpl);
+                moveTmpl.worldColl = (i & 1) != 0;
+                moveSystem.createMany(&e, 1, moveTmpl);
+                if (i % DESTROY_TAG_EVERY == 0)
+                {
+                    tagSystem.createMany(&e, 1, tagTmpl);
+                }
+
+                if (i % (DESTROY_CHILDREN + 1) == 0)
+                {
+                    root = trSystem.getInstance(e);
+                    roots.push_back(e);
+                }
+                else
+                {
+                    trSystem.setParent(trSystem.getInstance(e), root);
+                }
+            }
+        }
+
+        void checkEmpty()
+        {
+            for (Entity e : entities)
+            {
+                NW_REQUIRE(!trSystem.exists(e) && !spriteSystem.exists(e) && !moveSystem.exists(e) && !tagSystem.exists(e));
+            }
+        }
+
+        void handleDestroyed()
+        {
+            trSystem.expandDestroyed(entityManager);
+            const auto& destroyed = entityManager.pollDestroyed();
+            trSystem.handleDestroyed(destroyed.data(), destroyed.size(), batch);
+            spriteSystem.handleDestroyed(destroyed.data(), destroyed.size(), batch);
+            moveSystem.handleDestroyed(destroyed.data(), destroyed.size(), batch);
+            tagSystem.handleDestroyed(destroyed.data(), destroyed.size(), batch);
+            entityManager.clearDestroyed();
+        }
+    };
+
+    void benchDestroy()
+    {
+        DestroyScene scene;
+
+        //Killing the roots takes the whole hierarchy down with them
+        for (uint32_t i = 0; i < DESTROY_ITERATIONS; i++)
+        {
+            scene.populate();
+            for (Entity e : scene.roots)
+            {
+                scene.entityManager.destroy(e);
+            }
+
+            BenchTimer timer("destroy hierarchies");
+            scene.handleDestroyed();
+            timer.stop(DESTROY_ENTITY_COUNT);
+            scene.checkEmpty();
+        }
+
+        //Every entity destroyed directly, in random order
+        srand(1);
+        for (uint32_t i = 0; i < DESTROY_ITERATIONS; i++)
+        {
+            scene.populate();
+            eastl::vector<Entity>& entities = scene.entities;
+            for (uint32_t j = (uint32_t)entities.size() - 1; j > 0; j--)
+            {
+                eastl::swap(entities[j], entities[rand() % (j + 1)]);
+            }
+            for (Entity e : entities)
+            {
+                scene.entityManager.destroy(e);
+            }
+
+            BenchTimer timer("destroy shuffled");
+            scene.handleDestroyed();
+            timer.stop(DESTROY_ENTITY_COUNT);
+            scene.checkEmpty();
+        }
+    }
+}
+#endif
@@ -0,0 +1,309 @@
+#include "Core/Core.h"
+#include "Bench.h"
+
+#ifdef NW_BENCHMARKS
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <EASTL/sort.h>
+#include "Scene/EntityManager.h"
+
+using namespace scene;
+
+namespace bench
+{
+    const uint32_t STRESS_THREADS = 8;
+    const uint32_t STRESS_CREATES_PER_THREAD = 4096;
+    const uint32_t STRESS_SHARED = 4096;         //Destroyed by every thread at once
+    const uint32_t STRESS_ROUNDS = 20;
+
+    struct StressThread
+    {
+        EntityManager* entityManager;
+        uint32_t threadIndex;
+        const eastl::vector<Entity>* shared;
+        eastl::vector<Entity> created;
+        eastl::vector<Entity> destroyed;
+        uint32_t sharedDestroyed;
+    };
+
+    static void stressWorker(StressThread* thread)
+    {
+        EntityManager& entityManager = *thread->entityManager;
+        const eastl::vector<Entity>& shared = *thread->shared;
+        uint32_t sharedCount = (uint32_t)shared.size();
+
+        //Every thread walks the shared entities from a different start, racing the others
+        uint32_t sharedPos = thread->threadIndex * (sharedCount / STRESS_THREADS);
+        for (uint32_t i = 0; i < STRESS_CREATES_PER_THREAD; i++)
+        {
+            Entity e = entityManager.createConcurrent();
+            NW_REQUIRE(entityManager.alive(e));
+            thread->created.push_back(e);
+
+            //Destroy every other entity created by this thread
+            if (i & 1)
+            {
+                Entity victim = thread->created[i - 1];
+                NW_REQUIRE(entityManager.destroyConcurrent(thread->threadIndex, victim));
+                NW_REQUIRE(!entityManager.alive(victim));
+                NW_REQUIRE(!entityManager.destroyConcurrent(thread->threadIndex, victim));
+                thread->destroyed.push_back(victim);
+            }
+
+            Entity target = shared[sharedPos];
+            sharedPos = (sharedPos + 1) % sharedCount;
+            if (entityManager.destroyConcurrent(thread->threadIndex, target))
+            {
+                thread->sharedDestroyed++;
+            }
+            NW_REQUIRE(!entityManager.alive(target));
+        }
+    }
+
+    static bool lessEntityId(Entity a, Entity b)
+    {
+        return a.id() < b.id();
+    }
+
+    static bool lessEntityIndex(Entity a, Entity b)
+    {
+        return a.index() < b.index();
+    }
+
+    struct StressReader
+    {
+        EntityManager* entityManager;
+        const eastl::vector<Entity>* shared;
+        const std::atomic<bool>* done;
+        uint32_t passes;
+    };
+
+    //Watches the shared entities while they are destroyed. An entity never
+    //comes back to life once a reader has seen it dead.
+    static void stressReader(StressReader* reader)
+    {
+        EntityManager& entityManager = *reader->entityManager;
+        const eastl::vector<Entity>& shared = *reader->shared;
+        eastl::vector<uint8_t> seenDead(shared.size(), 0);
+
+        bool last = false;
+        while (!last)
+        {
+            last = reader->done->load(std::memory_order_acquire);
+            for (size_t i = 0; i < shared.size(); i++)
+            {
+                bool alive = entityManager.alive(shared[i]);
+                NW_REQUIRE(!(alive && seenDead[i]));
+                if (!alive) { seenDead[i] = 1; }
+            }
+            reader->passes++;
+        }
+
+        //The last pass started after every destroyer finished
+        for (uint8_t dead : seenDead)
+        {
+            NW_REQUIRE(dead);
+        }
+    }
+
+    //Multi-threaded create/destroy against a single EntityManager, checking
+    //that every entity is destroyed exactly once and that alive() agrees
+    void benchEntities()
+    {
+        EntityManager entityManager;
+        eastl::vector<Entity> shared;
+        eastl::vector<Entity> survivors;
+        eastl::vector<Entity> merged;
+        StressThread threads[STRESS_THREADS];
+        std::thread workers[STRESS_THREADS];
+
+        for (uint32_t round = 0; round < STRESS_ROUNDS; round++)
+        {
+            shared.resize(STRESS_SHARED);
+            entityManager.createMany(STRESS_SHARED, shared.data());
+
+            BenchTimer timer("concurrent create/destroy");
+            entityManager.beginConcurrent(STRESS_THREADS, STRESS_THREADS * STRESS_CREATES_PER_THREAD);
+            for (uint32_t i = 0; i < STRESS_THREADS; i++)
+            {
+                StressThread& thread = threads[i];
+                thread.entityManager = &entityManager;
+                thread.threadIndex = i;
+                thread.shared = &shared;
+                thread.created.clear();
+                thread.destroyed.clear();
+                thread.sharedDestroyed = 0;
+                workers[i] = std::thread(stressWorker, &thread);
+            }
+            for (uint32_t i = 0; i < STRESS_THREADS; i++)
+            {
+                workers[i].join();
+            }
+            entityManager.endConcurrent();
+            timer.stop(STRESS_THREADS * STRESS_CREATES_PER_THREAD);
+
+            //Each shared entity was destroyed by exactly one thread
+            uint32_t sharedDestroyed = 0;
+            uint32_t ownDestroyed = 0;
+            for (StressThread& thread : threads)
+            {
+                sharedDestroyed += thread.sharedDestroyed;
+                ownDestroyed += (uint32_t)thread.destroyed.size();
+                for (Entity e : thread.created)
+                {
+                    if (entityManager.alive(e)) { survivors.push_back(e); }
+                }
+            }
+            NW_REQUIRE(sharedDestroyed == STRESS_SHARED);
+
+            //The merged destroyed list holds every destroyed entity once
+            merged = entityManager.pollDestroyed();
+            NW_REQUIRE(merged.size() == STRESS_SHARED + ownDestroyed);
+            eastl::sort(merged.begin(), merged.end(), lessEntityId);
+            for (size_t i = 1; i < merged.size(); i++)
+            {
+                NW_REQUIRE(merged[i - 1] != merged[i]);
+            }
+            entityManager.clearDestroyed();
+
+            //No two live entities share an index, even after indices are recycled
+            eastl::sort(survivors.begin(), survivors.end(), lessEntityId);
+            for (size_t i = 1; i < survivors.size(); i++)
+            {
+                NW_REQUIRE(survivors[i - 1].index() != survivors[i].index());
+            }
+
+            //Keep the live count bounded across rounds
+            entityManager.destroyMany(survivors.data(), (uint32_t)survivors.size());
+            for (Entity e : survivors)
+            {
+                NW_REQUIRE(!entityManager.alive(e));
+            }
+            survivors.clear();
+            entityManager.clearDestroyed();
+        }
+    }
+
+    const uint32_t CHECK_READERS = 2;
+    const uint32_t CHECK_ROUNDS = 300;      //Enough to wrap 8 bit generations
+
+    //Untimed check of the concurrent section. Readers call alive() while the
+    //workers create and destroy, and every round is checked against what the
+    //serial API would have produced: each reserved index is handed out once,
+    //never to a live entity, and every destroyed entity moved its generation
+    //on exactly once.
+    void checkEntities()
+    {
+        EntityManager entityManager;
+        eastl::vector<Entity> shared;
+        eastl::vector<Entity> live;         //Survivors of the previous round
+        eastl::vector<Entity> created;
+        eastl::vector<Entity> destroyed;
+        eastl::vector<Entity> merged;
+        eastl::vector<Entity> occupied;
+        StressThread threads[STRESS_THREADS];
+        StressReader readers[CHECK_READERS];
+        std::thread workers[STRESS_THREADS];
+        std::thread readerThreads[CHECK_READERS];
+        uint32_t readerPasses = 0;
+
+        for (uint32_t round = 0; round < CHECK_ROUNDS; round++)
+        {
+            shared.resize(STRESS_SHARED);
+            entityManager.createMany(STRESS_SHARED, shared.data());
+            entityManager.clearDestroyed();
+
+            std::atomic<bool> done(false);
+            entityManager.beginConcurrent(STRESS_THREADS, STRESS_THREADS * STRESS_CREATES_PER_THREAD);
+            for (uint32_t i = 0; i < CHECK_READERS; i++)
+            {
+                StressReader& reader = readers[i];
+                reader.entityManager = &entityManager;
+                reader.shared = &shared;
+                reader.done = &done;
+                reader.passes = 0;
+                readerThreads[i] = std::thread(stressReader, &reader);
+            }
+            for (uint32_t i = 0; i < STRESS_THREADS; i++)
+            {
+                StressThread& thread = threads[i];
+                thread.entityManager = &entityManager;
+                thread.threadIndex = i;
+                thread.shared = &shared;
+                thread.created.clear();
+                thread.destroyed.clear();
+                thread.sharedDestroyed = 0;
+                workers[i] = std::thread(stressWorker, &thread);
+            }
+            for (uint32_t i = 0; i < STRESS_THREADS; i++)
+            {
+                workers[i].join();
+            }
+            done.store(true, std::memory_order_release);
+            for (uint32_t i = 0; i < CHECK_READERS; i++)
+            {
+                readerThreads[i].join();
+                readerPasses += readers[i].passes;
+            }
+            entityManager.endConcurrent();
+
+            created.clear();
+            destroyed.clear();
+            uint32_t sharedDestroyed = 0;
+            for (StressThread& thread : threads)
+            {
+                created.insert(created.end(), thread.created.begin(), thread.created.end());
+                destroyed.insert(destroyed.end(), thread.destroyed.begin(), thread.destroyed.end());
+                sharedDestroyed += thread.sharedDestroyed;
+            }
+            NW_REQUIRE(created.size() == STRESS_THREADS * STRESS_CREATES_PER_THREAD);
+            NW_REQUIRE(sharedDestroyed == STRESS_SHARED);
+
+            //Created entities, the shared ones and last round's survivors all
+            //held their index at the same time, so no two share one
+            occupied = created;
+            occupied.insert(occupied.end(), shared.begin(), shared.end());
+            occupied.insert(occupied.end(), live.begin(), live.end());
+            eastl::sort(occupied.begin(), occupied.end(), lessEntityIndex);
+            for (size_t i = 1; i < occupied.size(); i++)
+            {
+                NW_REQUIRE(occupied[i - 1].index() != occupied[i].index());
+            }
+
+            //The destroyed list is exactly the shared entities and the workers' own
+            destroyed.insert(destroyed.end(), shared.begin(), shared.end());
+            merged = entityManager.pollDestroyed();
+            NW_REQUIRE(merged.size() == destroyed.size());
+            eastl::sort(merged.begin(), merged.end(), lessEntityId);
+            eastl::sort(destroyed.begin(), destroyed.end(), lessEntityId);
+            for (size_t i = 0; i < merged.size(); i++)
+            {
+                NW_REQUIRE(merged[i] == destroyed[i]);
+            }
+
+            //Their indices haven't been handed out again, so the generation
+            //shows exactly one destroy
+            for (Entity e : merged)
+            {
+                EntityGen next = (EntityGen)((e.gen() + 1) & ENTITY_GEN_MASK);
+                NW_REQUIRE(!entityManager.alive(e));
+                NW_REQUIRE(entityManager.alive(Entity(e.index(), next)));
+            }
+            entityManager.clearDestroyed();
+
+            //Keep this round's survivors alive through the next one
+            entityManager.destroyMany(live.data(), (uint32_t)live.size());
+            entityManager.clearDestroyed();
+            live.clear();
+            for (Entity e : created)
+            {
+                if (entityManager.alive(e)) { live.push_back(e); }
+            }
+            NW_REQUIRE(live.size() == created.size() / 2);
+        }
+
+        printf("%u rounds ok, %u reader passes\n", CHECK_ROUNDS, readerPasses);
+    }
+}
+#endif
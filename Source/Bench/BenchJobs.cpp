@@ -0,0 +1,131 @@
+#include "Core/Core.h"
+#include "Bench.h"
+
+#ifdef NW_BENCHMARKS
+#include <cmath>
+#include <cstdio>
+#include "Core/JobSystem.h"
+
+namespace bench
+{
+    const uint32_t JOBS_EMPTY_COUNT = 100000;
+    const uint32_t JOBS_FOR_COUNT = 4 * 1024 * 1024;
+    const uint32_t JOBS_FOR_GRAIN = 16 * 1024;
+    const uint32_t JOBS_STAGE_TASKS = 16;
+    const uint32_t JOBS_STAGE_ROUNDS = 1000;
+
+    static void emptyJob(void*, uint32_t, uint32_t)
+    {
+    }
+
+    struct ForData
+    {
+        const float* input;
+        float* output;
+    };
+
+    static void forJob(void* data, uint32_t begin, uint32_t end)
+    {
+        ForData* forData = (ForData*)data;
+        for (uint32_t i = begin; i < end; i++)
+        {
+            forData->output[i] = sqrtf(forData->input[i]) * 0.5f + 1.0f;
+        }
+    }
+
+    struct StageData
+    {
+        std::atomic<uint32_t>* sequence;
+        uint32_t order[JOBS_STAGE_TASKS];
+        uint32_t index;
+    };
+
+    static void stageTask(void* data)
+    {
+        StageData* stageData = (StageData*)data;
+        stageData->order[stageData->index] = stageData->sequence->fetch_add(1);
+    }
+
+    //Task i reads resource i % 4 and writes resource 4 + i % 3, giving a mix
+    //of chains and tasks that are free to run alongside each other
+    static uint32_t stageReads(uint32_t i) { return 1u << (i % 4); }
+    static uint32_t stageWrites(uint32_t i) { return 1u << (4 + i % 3); }
+
+    static void benchJobSystem(uint32_t workerCount)
+    {
+        nw::JobSystem jobSystem;
+        jobSystem.init(workerCount);
+        printf("-- %u workers%s\n", workerCount, jobSystem.isSingleThreaded() ? " (single threaded)" : "");
+
+        {
+            nw::JobCounter counter(0);
+            BenchTimer timer("empty jobs");
+            for (uint32_t i = 0; i < JOBS_EMPTY_COUNT; i++)
+            {
+                jobSystem.run(emptyJob, nullptr, &counter);
+            }
+            jobSystem.wait(&counter);
+            timer.stop(JOBS_EMPTY_COUNT);
+        }
+
+        {
+            eastl::vector<float> input(JOBS_FOR_COUNT);
+            eastl::vector<float> output(JOBS_FOR_COUNT);
+            for (uint32_t i = 0; i < JOBS_FOR_COUNT; i++) { input[i] = (float)i; }
+
+            ForData forData = { input.data(), output.data() };
+            nw::JobCounter counter(0);
+            BenchTimer timer("parallelFor");
+            jobSystem.parallelFor(forJob, &forData, JOBS_FOR_COUNT, JOBS_FOR_GRAIN, &counter);
+            jobSystem.wait(&counter);
+            timer.stop(JOBS_FOR_COUNT);
+
+            for (uint32_t i = 0; i < JOBS_FOR_COUNT; i++)
+            {
+                NW_REQUIRE(output[i] == sqrtf(input[i]) * 0.5f + 1.0f);
+            }
+        }
+
+        {
+            std::atomic<uint32_t> sequence(0);
+            StageData stageData[JOBS_STAGE_TASKS];
+            nw::JobStage stage;
+
+            BenchTimer timer("stages");
+            for (uint32_t round = 0; round < JOBS_STAGE_ROUNDS; round++)
+            {
+                sequence.store(0);
+                for (uint32_t i = 0; i < JOBS_STAGE_TASKS; i++)
+                {
+                    stageData[i].sequence = &sequence;
+                    stageData[i].index = i;
+                    stage.add("stageTask", stageTask, &stageData[i], stageReads(i), stageWrites(i));
+                }
+                stage.execute(jobSystem);
+
+                //Conflicting tasks ran in the order they were added
+                for (uint32_t i = 0; i < JOBS_STAGE_TASKS; i++)
+                {
+                    for (uint32_t j = 0; j < i; j++)
+                    {
+                        bool conflict = (stageWrites(j) & (stageReads(i) | stageWrites(i))) != 0 ||
+                            (stageReads(j) & stageWrites(i)) != 0;
+                        NW_REQUIRE(!conflict || stageData[j].order[j] < stageData[i].order[i]);
+                    }
+                    //Single threaded mode runs everything in order
+                    NW_REQUIRE(!jobSystem.isSingleThreaded() || stageData[i].order[i] == i);
+                }
+            }
+            timer.stop(JOBS_STAGE_ROUNDS * JOBS_STAGE_TASKS);
+        }
+
+        jobSystem.shutdown();
+    }
+
+    void benchJobs()
+    {
+        benchJobSystem(0);
+        benchJobSystem(nw::JobSystem::getDefaultWorkerCount());
+    }
+}
+#endif
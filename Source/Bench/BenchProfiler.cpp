@@ -0,0 +1,56 @@
+#include "Core/Core.h"
+#include "Bench.h"
+
+#ifdef NW_BENCHMARKS
+#include <cstdio>
+#include "Core/Profiler.h"
+
+namespace bench
+{
+    const uint32_t PROFILER_ZONE_COUNT = 1000000;
+    const uint32_t PROFILER_ZONES_PER_FRAME = 4096;     //Well under the per thread buffer size
+
+    void benchProfiler()
+    {
+        profiler::init();
+
+        //Includes draining, which happens once per frame on the main thread
+        {
+            BenchTimer timer("Scoped zone");
+            for (uint32_t i = 0; i < PROFILER_ZONE_COUNT; i++)
+            {
+                SCOPED_CPU_EVENT(event)(0xFFFFFFFF, "BenchZone");
+                if ((i % PROFILER_ZONES_PER_FRAME) == PROFILER_ZONES_PER_FRAME - 1) { profiler::endFrame(); }
+            }
+            timer.stop(PROFILER_ZONE_COUNT);
+        }
+        profiler::endFrame();
+
+        //Just the recording side
+        {
+            BenchTimer timer("Record only");
+            for (uint32_t i = 0; i < PROFILER_ZONES_PER_FRAME; i++)
+            {
+                SCOPED_CPU_EVENT(event)(0xFFFFFFFF, "BenchZone");
+            }
+            timer.stop(PROFILER_ZONES_PER_FRAME);
+        }
+        profiler::endFrame();
+
+        //The floor for any zone, the rest of its cost is the profiler's own
+        {
+            uint64_t sum = 0;
+            BenchTimer timer("Two timestamps");
+            for (uint32_t i = 0; i < PROFILER_ZONE_COUNT; i++)
+            {
+                sum += profiler::getTicks();
+                sum += profiler::getTicks();
+            }
+            timer.stop(PROFILER_ZONE_COUNT);
+            NW_UNUSED(sum);
+        }
+
+        profiler::printZoneStats();
+    }
+}
+#endif
@@ -0,0 +1,293 @@
+#include "Core/Core.h"
+#include "Bench.h"
+
+#ifdef NW_BENCHMARKS
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
+#include <EASTL/vector.h>
+#include <rapidjson/writer.h>
+#include <rapidjson/stringbuffer.h>
+#include "Core/JobSystem.h"
+#include "Script/AngelState.h"
+#include "Util/File.h"
+#include "SyntheticScene.h"
+
+using namespace scene;
+
+namespace bench
+{
+    static const uint32_t SCENE_SIZES[] = { 1000, 10000, 100000, 1000000 };
+    const uint32_t SCENE_ITERATIONS = 5;
+    const uint32_t SCENE_TILE_QUERIES = 100000;
+    const uint32_t SCENE_MAX_COLLISION_MOVERS = 8192;   //recordCollisions() is n^2
+    const float SCENE_CHURN_RATIO = 0.1f;
+    const float SCENE_DT = 1.0f / 60.0f;
+    static const char* SCENE_RESULTS_FILE = "bench_scene.json";
+
+    struct PathResult
+    {
+        const char* name;
+        uint32_t items;
+        uint32_t runs;
+        double minUs;
+        double totalUs;
+
+        void add(double us)
+        {
+            runs++;
+            minUs = eastl::min(minUs, us);
+            totalUs += us;
+        }
+    };
+
+    struct SceneRun
+    {
+        SyntheticSceneDesc desc;
+        Vector2i worldSize;
+        eastl::vector<PathResult> results;
+
+        PathResult& getResult(const char* name, uint32_t items)
+        {
+            for (PathResult& result : results)
+            {
+                if (strcmp(result.name, name) == 0)
+                {
+                    result.items = items;
+                    return result;
+                }
+            }
+            PathResult result = { name, items, 0, DBL_MAX, 0.0 };
+            results.push_back(result);
+            return results.back();
+        }
+    };
+
+    //Keeps the tile queries from being optimized out
+    static volatile uint32_t sFreeTiles;
+
+    static void runScene(SceneRun& run, nw::JobSystem& jobSystem, script::AngelState& angelState)
+    {
+        SyntheticScene synth;
+        synth.build(run.desc, &angelState);
+        run.worldSize = synth.getWorldSize();
+
+        uint32_t sprites = 0;
+        uint32_t movers = 0;
+        uint32_t worldMovers = 0;
+        uint32_t scripts = 0;
+        for (Entity e : synth.entities)
+        {
+            if (synth.spriteSystem.exists(e)) { sprites++; }
+            if (synth.moveSystem.exists(e))
+            {
+                movers++;
+                if (synth.moveSystem.getWorldCollision(synth.moveSystem.getInstance(e))) { worldMovers++; }
+            }
+            if (synth.scriptSystem.exists(e)) { scripts++; }
+        }
+
+        //The image has to be taken before churn, while entities are still numbered in order
+        util::EndianVectorWriteArchive imageAr;
+        synth.saveImage(imageAr);
+
+        eastl::vector<IntRect> tileQueries(SCENE_TILE_QUERIES);
+        for (IntRect& rect : tileQueries)
+        {
+            rect = IntRect((int32_t)synth.randomInt(run.worldSize.x), (int32_t)synth.randomInt(run.worldSize.y),
+                SyntheticScene::ENTITY_SIZE, SyntheticScene::ENTITY_SIZE);
+        }
+
+        eastl::vector<EInstance> roots;
+        uint32_t churnCount = (uint32_t)(run.desc.entityCount * SCENE_CHURN_RATIO);
+
+        for (uint32_t iteration = 0; iteration < SCENE_ITERATIONS; iteration++)
+        {
+            {
+                BenchTimer timer("movement world");
+                synth.moveSystem.updateWorldColl(SCENE_DT, synth.trSystem, synth.tileSystem);
+                run.getResult("movement world", worldMovers).add(timer.elapsedUs());
+            }
+            {
+                BenchTimer timer("movement non-world");
+                synth.moveSystem.updateNonWorldColl(SCENE_DT, synth.trSystem, synth.tileSystem);
+                run.getResult("movement non-world", movers - worldMovers).add(timer.elapsedUs());
+            }
+            if (movers <= SCENE_MAX_COLLISION_MOVERS)
+            {
+                BenchTimer timer("record collisions");
+                synth.moveSystem.recordCollisions(synth.trSystem, jobSystem);
+                run.getResult("record collisions", movers).add(timer.elapsedUs());
+            }
+
+            //Nudging every root moves the whole hierarchy under it
+            roots.clear();
+            for (Entity e : synth.entities)
+            {
+                EInstance ei = synth.trSystem.getInstance(e);
+                if (!synth.trSystem.getParent(ei).isValid()) { roots.push_back(ei); }
+            }
+            {
+                Vector2i nudge((iteration & 1) ? -1 : 1, 0);
+                BenchTimer timer("transform propagation");
+                for (EInstance ei : roots)
+                {
+                    synth.trSystem.setLocalPos(ei, synth.trSystem.getLocalPos(ei) + nudge);
+                }
+                run.getResult("transform propagation", (uint32_t)synth.entities.size()).add(timer.elapsedUs());
+            }
+
+            {
+                BenchTimer timer("sprite render list");
+                synth.spriteSystem.buildRenderList(synth.trSystem, jobSystem);
+                run.getResult("sprite render list", sprites).add(timer.elapsedUs());
+            }
+
+            {
+                BenchTimer timer("tile isFree");
+                uint32_t free = 0;
+                for (const IntRect& rect : tileQueries)
+                {
+                    if (synth.tileSystem.isFree(rect)) { free++; }
+                }
+                run.getResult("tile isFree", SCENE_TILE_QUERIES).add(timer.elapsedUs());
+                sFreeTiles += free;
+            }
+
+            if (scripts > 0)
+            {
+                BenchTimer timer("script update");
+                synth.scriptSystem.update();
+                run.getResult("script update", scripts).add(timer.elapsedUs());
+            }
+
+            //Churn goes last since it reorders every system
+            {
+                BenchTimer timer("churn destroy");
+                synth.destroyRandom(churnCount);
+                uint32_t destroyed = synth.handleDestroyed();
+                run.getResult("churn destroy", destroyed).add(timer.elapsedUs());
+
+                synth.removeDead();
+                BenchTimer createTimer("churn create");
+                synth.createEntities(destroyed);
+                run.getResult("churn create", destroyed).add(createTimer.elapsedUs());
+            }
+
+            {
+                SyntheticImage* image = new SyntheticImage();
+                BenchTimer timer("scene load image");
+                image->load(imageAr.data(), imageAr.size());
+                run.getResult("scene load image", run.desc.entityCount).add(timer.elapsedUs());
+                delete image;
+            }
+        }
+
+        if (movers > SCENE_MAX_COLLISION_MOVERS)
+        {
+            run.getResult("record collisions", movers);
+        }
+    }
+
+    static void printRun(const SceneRun& run)
+    {
+        printf("-- %u entities, %dx%d world\n", run.desc.entityCount, run.worldSize.x, run.worldSize.y);
+        for (const PathResult& result : run.results)
+        {
+            if (result.runs == 0)
+            {
+                printf("%s: skipped (%u items)\n", result.name, result.items);
+                continue;
+            }
+
+            double avgUs = result.totalUs / result.runs;
+            printf("%s: min %.1f us, avg %.1f us (%.3f us per item, %u items)\n",
+                result.name, result.minUs, avgUs, result.minUs / eastl::max(result.items, 1u), result.items);
+        }
+    }
+
+    static void writeResults(const eastl::vector<SceneRun>& runs)
+    {
+        rapidjson::StringBuffer buf;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buf);
+
+        writer.StartObject();
+        writer.Key("benchmark"); writer.String("scene");
+        writer.Key("iterations"); writer.Uint(SCENE_ITERATIONS);
+        writer.Key("runs");
+        writer.StartArray();
+        for (const SceneRun& run : runs)
+        {
+            const SyntheticSceneDesc& desc = run.desc;
+
+            writer.StartObject();
+            writer.Key("entities"); writer.Uint(desc.entityCount);
+            writer.Key("config");
+            writer.StartObject();
+            writer.Key("spriteRatio"); writer.Double(desc.spriteRatio);
+            writer.Key("movementRatio"); writer.Double(desc.movementRatio);
+            writer.Key("scriptRatio"); writer.Double(desc.scriptRatio);
+            writer.Key("tagRatio"); writer.Double(desc.tagRatio);
+            writer.Key("worldCollisionRatio"); writer.Double(desc.worldCollisionRatio);
+            writer.Key("hierarchyDepth"); writer.Uint(desc.hierarchyDepth);
+            writer.Key("solidTileRatio"); writer.Double(desc.solidTileRatio);
+            writer.Key("collisionDensity"); writer.Double(desc.collisionDensity);
+            writer.Key("worldWidth"); writer.Int(run.worldSize.x);
+            writer.Key("worldHeight"); writer.Int(run.worldSize.y);
+            writer.Key("seed"); writer.Uint(desc.seed);
+            writer.EndObject();
+
+            writer.Key("results");
+            writer.StartObject();
+            for (const PathResult& result : run.results)
+            {
+                writer.Key(result.name);
+                writer.StartObject();
+                writer.Key("items"); writer.Uint(result.items);
+                if (result.runs == 0)
+                {
+                    writer.Key("skipped"); writer.Bool(true);
+                }
+                else
+                {
+                    writer.Key("minUs"); writer.Double(result.minUs);
+                    writer.Key("avgUs"); writer.Double(result.totalUs / result.runs);
+                }
+                writer.EndObject();
+            }
+            writer.EndObject();
+
+            writer.EndObject();
+        }
+        writer.EndArray();
+        writer.EndObject();
+
+        util::file::writeAllText(SCENE_RESULTS_FILE, buf.GetString());
+        printf("Wrote %u runs to %s\n", (uint32_t)runs.size(), SCENE_RESULTS_FILE);
+    }
+
+    void benchScene()
+    {
+        nw::JobSystem jobSystem;
+        jobSystem.init(nw::JobSystem::getDefaultWorkerCount());
+
+        script::AngelState angelState;
+        angelState.init();
+        SyntheticScene::compileScripts(angelState);
+
+        eastl::vector<SceneRun> runs;
+        for (uint32_t size : SCENE_SIZES)
+        {
+            runs.push_back();
+            SceneRun& run = runs.back();
+            run.desc.entityCount = size;
+            run.desc.scriptRatio = 0.01f;
+
+            runScene(run, jobSystem, angelState);
+            printRun(run);
+        }
+
+        writeResults(runs);
+    }
+}
+#endif
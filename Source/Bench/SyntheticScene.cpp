@@ -0,0 +1,281 @@
+#include "Core/Core.h"
+#include "SyntheticScene.h"
+
+#ifdef NW_BENCHMARKS
+#include <cmath>
+#include "Script/AngelState.h"
+#include "Tile/Tile.h"
+
+using namespace scene;
+
+namespace bench
+{
+    const uint32_t SYNTH_TAG_COUNT = 8;
+    const uint32_t SYNTH_MIN_TILES = 8;
+    const float SYNTH_MAX_SPEED = 60.0f;
+
+    //Every script component gets the cheapest update there is, so the timing
+    //is the engine's cost of calling into scripts
+    static const char* SYNTH_SCRIPT =
+        "class ComponentBase { Entity _entity; }\n"
+        "class BenchComponent : ComponentBase\n"
+        "{\n"
+        "    int ticks;\n"
+        "    void update() { ticks++; }\n"
+        "}\n";
+
+    SyntheticSceneDesc::SyntheticSceneDesc() :
+        entityCount(10000),
+        spriteRatio(0.8f),
+        movementRatio(0.25f),
+        scriptRatio(0.0f),
+        tagRatio(0.1f),
+        worldCollisionRatio(0.5f),
+        hierarchyDepth(3),
+        tileMapWidth(0),
+        tileMapHeight(0),
+        solidTileRatio(0.1f),
+        collisionDensity(1.0f),
+        seed(1)
+    {
+    }
+
+    SyntheticScene::SyntheticScene() :
+        _angelState(nullptr),
+        _random(1),
+        _chainLength(0)
+    {
+        tagSystem.init();
+    }
+
+    SyntheticScene::~SyntheticScene()
+    {
+        //Script objects belong to the script engine, hand them back
+        if (_angelState != nullptr)
+        {
+            for (Entity e : entities)
+            {
+                if (entityManager.alive(e) && scriptSystem.exists(e)) { entityManager.destroy(e); }
+            }
+            const auto& destroyed = entityManager.pollDestroyed();
+            scriptSystem.handleDestroyed(destroyed.data(), destroyed.size(), batch);
+            entityManager.clearDestroyed();
+        }
+    }
+
+    void SyntheticScene::compileScripts(script::AngelState& angelState)
+    {
+        angelState.startCompiling();
+        angelState.addScriptSection("SyntheticScene", SYNTH_SCRIPT);
+        angelState.endCompiling();
+    }
+
+    uint32_t SyntheticScene::randomInt(uint32_t max)
+    {
+        _random = _random * 1664525u + 1013904223u;
+        return (_random >> 8) % max;
+    }
+
+    float SyntheticScene::randomFloat()
+    {
+        _random = _random * 1664525u + 1013904223u;
+        return (float)(_random >> 8) / (float)(1 << 24);
+    }
+
+    void SyntheticScene::build(const SyntheticSceneDesc& desc, script::AngelState* angelState)
+    {
+        NW_ASSERT(entities.empty());
+        NW_ASSERT(desc.scriptRatio == 0.0f || angelState != nullptr);
+        NW_ASSERT(desc.hierarchyDepth > 0);
+
+        _desc = desc;
+        _random = desc.seed;
+        _angelState = angelState;
+        if (_angelState != nullptr)
+        {
+            scriptSystem.init(*_angelState);
+        }
+
+        buildTileMap();
+
+        entities.reserve(desc.entityCount);
+        createEntities(desc.entityCount);
+    }
+
+    void SyntheticScene::buildTileMap()
+    {
+        uint32_t width = _desc.tileMapWidth;
+        uint32_t height = _desc.tileMapHeight;
+        if (width == 0 || height == 0)
+        {
+            //Two movers overlap when their centers are less than a size apart
+            //on both axes, so each one covers (2 * size)^2 of the world
+            float movers = (float)_desc.entityCount * _desc.movementRatio;
+            float density = (_desc.collisionDensity > 0.0f) ? _desc.collisionDensity : 1.0f;
+            float side = sqrtf(movers * 4.0f * ENTITY_SIZE * ENTITY_SIZE / density);
+            width = height = (uint32_t)ceilf(side / TILE_SIZE);
+        }
+        width = eastl::max(width, SYNTH_MIN_TILES);
+        height = eastl::max(height, SYNTH_MIN_TILES);
+        _worldSize = Vector2i((int32_t)width * TILE_SIZE, (int32_t)height * TILE_SIZE);
+
+        tileSystem.setTileMap(asset::AssetRef(0));
+        tileSystem.setSize(width, height);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                bool solid = randomFloat() < _desc.solidTileRatio;
+                tileSystem.setForegroundTile(x, y, solid ? 1 : 0);
+                tileSystem.setBackgroundTile(x, y, 0);
+                tileSystem.setCollision(x, y, solid ? TILE_COLL_SOLID : TILE_COLL_NONE);
+            }
+        }
+    }
+
+    void SyntheticScene::createEntities(uint32_t count)
+    {
+        SpriteSystem::Template spriteTmpl = {};
+        spriteTmpl.size = Vector2i(ENTITY_SIZE, ENTITY_SIZE);
+        spriteTmpl.texture = BGFX_INVALID_HANDLE;
+        spriteTmpl.misc.alpha = 255;
+
+        MovementSystem::Template moveTmpl = {};
+        moveTmpl.size = Vector2i(ENTITY_SIZE, ENTITY_SIZE);
+
+        uint32_t tag = 0;
+        TagSystem::Template tagTmpl = { (const uint8_t*)&tag, 1 };
+
+        script::AngelType scriptType("BenchComponent");
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            Entity e = entityManager.create();
+            entities.push_back(e);
+
+            Vector2i pos((int32_t)randomInt(_worldSize.x), (int32_t)randomInt(_worldSize.y));
+            trSystem.createMany(&e, 1, &pos);
+
+            //Churn may have killed the end of the last chain, start a new one then
+            if (_chainLength > 0 && _chainLength < _desc.hierarchyDepth && entityManager.alive(_chainParent))
+            {
+                EInstance ei = trSystem.getInstance(e);
+                trSystem.setParent(ei, trSystem.getInstance(_chainParent));
+                trSystem.setLocalPos(ei, Vector2i((int32_t)randomInt(ENTITY_SIZE * 2) - ENTITY_SIZE,
+                    (int32_t)randomInt(ENTITY_SIZE * 2) - ENTITY_SIZE));
+                _chainLength++;
+            }
+            else
+            {
+                _chainLength = 1;
+            }
+            _chainParent = e;
+
+            if (randomFloat() < _desc.spriteRatio)
+            {
+                spriteTmpl.misc.depth = (uint8_t)randomInt(256);
+                spriteSystem.createMany(&e, 1, spriteTmpl);
+            }
+            if (randomFloat() < _desc.movementRatio)
+            {
+                moveTmpl.velocity = Vector2f((randomFloat() * 2.0f - 1.0f) * SYNTH_MAX_SPEED,
+                    (randomFloat() * 2.0f - 1.0f) * SYNTH_MAX_SPEED);
+                moveTmpl.worldColl = randomFloat() < _desc.worldCollisionRatio;
+                moveSystem.createMany(&e, 1, moveTmpl);
+            }
+            if (randomFloat() < _desc.tagRatio)
+            {
+                tag = randomInt(SYNTH_TAG_COUNT);
+                tagSystem.createMany(&e, 1, tagTmpl);
+            }
+            if (_angelState != nullptr && randomFloat() < _desc.scriptRatio)
+            {
+                scriptSystem.create(e, scriptType);
+            }
+        }
+    }
+
+    void SyntheticScene::destroyRandom(uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            Entity e = entities[randomInt((uint32_t)entities.size())];
+            if (entityManager.alive(e))
+            {
+                entityManager.destroy(e);
+            }
+        }
+    }
+
+    uint32_t SyntheticScene::handleDestroyed()
+    {
+        trSystem.expandDestroyed(entityManager);
+        const auto& destroyed = entityManager.pollDestroyed();
+        trSystem.handleDestroyed(destroyed.data(), destroyed.size(), batch);
+        spriteSystem.handleDestroyed(destroyed.data(), destroyed.size(), batch);
+        moveSystem.handleDestroyed(destroyed.data(), destroyed.size(), batch);
+        tagSystem.handleDestroyed(destroyed.data(), destroyed.size(), batch);
+        scriptSystem.handleDestroyed(destroyed.data(), destroyed.size(), batch);
+
+        uint32_t count = (uint32_t)destroyed.size();
+        entityManager.clearDestroyed();
+        return count;
+    }
+
+    void SyntheticScene::removeDead()
+    {
+        uint32_t live = 0;
+        for (uint32_t i = 0; i < (uint32_t)entities.size(); i++)
+        {
+            if (entityManager.alive(entities[i]))
+            {
+                entities[live++] = entities[i];
+            }
+        }
+        entities.resize(live);
+    }
+
+    void SyntheticScene::saveImage(util::EndianVectorWriteArchive& ar)
+    {
+        NW_ASSERT(ar.size() == 0);
+
+        uint32_t entityCount = (uint32_t)entities.size();
+        ar.serializeU32(entityCount);
+
+        tagSystem.serialize(ar);
+        trSystem.serialize(ar);
+        spriteSystem.serialize(ar);
+        moveSystem.serialize(ar);
+        tileSystem.serialize(ar);
+    }
+
+    SyntheticImage::SyntheticImage() :
+        arenaBinding(arena)
+    {
+        arenaBinding.end();
+    }
+
+    void SyntheticImage::load(const void* image, size_t size)
+    {
+        //Systems use their columns straight out of the image, so it has to
+        //live in the arena like a real scene's does
+        void* copy = arena.alloc(size);
+        memcpy(copy, image, size);
+
+        util::MemoryReadArchive ar;
+        ar.init(copy, size);
+
+        tagSystem.init();
+
+        uint32_t entityCount;
+        ar.serializeU32(entityCount);
+        entityManager.createMany(entityCount, nullptr);
+
+        tagSystem.serialize(ar);
+        trSystem.serialize(ar);
+        spriteSystem.serialize(ar);
+        moveSystem.serialize(ar);
+        tileSystem.serialize(ar);
+    }
+}
+#endif
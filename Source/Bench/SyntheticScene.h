@@ -0,0 +1,135 @@
+#ifndef BENCH_SYNTHETIC_SCENE_H
+#define BENCH_SYNTHETIC_SCENE_H
+
+#include "Core/Features.h"
+
+#ifdef NW_BENCHMARKS
+#include <stdint.h>
+#include <EASTL/vector.h>
+#include "Core/SceneArena.h"
+#include "Scene/EntityManager.h"
+#include "Scene/TransformSystem.h"
+#include "Scene/SpriteSystem.h"
+#include "Scene/MovementSystem.h"
+#include "Scene/TagSystem.h"
+#include "Scene/TileSystem.h"
+#include "Scene/ScriptSystem.h"
+#include "Util/Archives.h"
+
+namespace script { class AngelState; }
+
+namespace bench
+{
+    //What a synthetic scene is made of. Every entity has a transform, the
+    //ratios are the chance of it getting each of the other components.
+    struct SyntheticSceneDesc
+    {
+        uint32_t entityCount;
+        float spriteRatio;
+        float movementRatio;
+        float scriptRatio;          //Needs an angel state, see SyntheticScene::build()
+        float tagRatio;
+        float worldCollisionRatio;  //Of the movers
+
+        //Entities are created in chains this long, each one parented to the
+        //one before it. 1 makes every entity a root.
+        uint32_t hierarchyDepth;
+
+        //Size of the tile map in tiles. Zero sizes it so the movers end up
+        //with the collision density below.
+        uint32_t tileMapWidth;
+        uint32_t tileMapHeight;
+        float solidTileRatio;
+
+        //Average number of other movers each mover overlaps
+        float collisionDensity;
+
+        uint32_t seed;
+
+        SyntheticSceneDesc();
+    };
+
+    //The systems a scene updates every frame, filled with generated entities
+    //instead of a cooked scene, so each hot path can be timed on its own
+    //at any size. Nothing here touches bgfx or the asset manager.
+    class SyntheticScene
+    {
+    public:
+        static const int32_t ENTITY_SIZE = 16;
+
+        scene::EntityManager entityManager;
+        scene::TransformSystem trSystem;
+        scene::SpriteSystem spriteSystem;
+        scene::MovementSystem moveSystem;
+        scene::TagSystem tagSystem;
+        scene::TileSystem tileSystem;
+        scene::ScriptSystem scriptSystem;
+        scene::DestroyBatch batch;
+
+        //Every live entity, in creation order
+        eastl::vector<scene::Entity> entities;
+
+    private:
+        SyntheticSceneDesc _desc;
+        script::AngelState* _angelState;
+        uint32_t _random;
+        uint32_t _chainLength;
+        scene::Entity _chainParent;
+        Vector2i _worldSize;
+
+        SyntheticScene(const SyntheticScene&);
+        SyntheticScene& operator=(const SyntheticScene&);
+
+    public:
+        SyntheticScene();
+        ~SyntheticScene();
+
+        //The angel state is only needed when the description has scripts, and
+        //must have compiled the module from compileScripts()
+        void build(const SyntheticSceneDesc& desc, script::AngelState* angelState);
+        static void compileScripts(script::AngelState& angelState);
+
+        const SyntheticSceneDesc& getDesc() const { return _desc; }
+        Vector2i getWorldSize() const { return _worldSize; }
+        uint32_t randomInt(uint32_t max);
+
+        void createEntities(uint32_t count);
+        //Destroys up to count random entities, their children go in handleDestroyed()
+        void destroyRandom(uint32_t count);
+        //Runs every system's handleDestroyed() the way Scene::handleDestroyed()
+        //does, returns the number of entities that died
+        uint32_t handleDestroyed();
+        //Drops the dead from the entity list
+        void removeDead();
+
+        //Writes the systems in the order Scene::serialize() does, minus prefabs
+        //and scripts. Entities are recreated by index on load, so this only
+        //works on a freshly built scene. Read back by SyntheticImage::load().
+        void saveImage(util::EndianVectorWriteArchive& ar);
+
+    private:
+        float randomFloat();
+        void buildTileMap();
+    };
+
+    //Fresh systems loaded from a SyntheticScene image the way Scene::loadImage()
+    //loads a cooked one, with the image and containers in a scene arena
+    struct SyntheticImage
+    {
+        memory::SceneArena arena;
+        memory::SceneArena::Binding arenaBinding;
+
+        scene::EntityManager entityManager;
+        scene::TagSystem tagSystem;
+        scene::TransformSystem trSystem;
+        scene::SpriteSystem spriteSystem;
+        scene::MovementSystem moveSystem;
+        scene::TileSystem tileSystem;
+
+        SyntheticImage();
+        void load(const void* image, size_t size);
+    };
+}
+#endif
+
+#endif
@@ -5,15 +5,6 @@
 #include <lz4/lz4hc.h>
 #include <stdio.h>
 
-#define IMPLEMENT_WRITE_FN(classname, fnname, type)\
-    void classname::fnname(type data)\
-    {\
-        union { type value; char bytes[sizeof(data)]; } temp;\
-        temp.value = data;\
-        if (!_flipBytes) { for (int i = 0; i < sizeof(data); i++) { _data.push_back(temp.bytes[i]); } }\
-        else             { for (int i = sizeof(data) - 1; i >= 0; i++) { _data.push_back(temp.bytes[i]); } }\
-    }
-
 namespace cook
 {
     AssetFileWriter::AssetFileWriter() :
@@ -26,6 +26,9 @@ namespace cook
 
     fs::path relativeTo(fs::path from, fs::path to);
 
+    //Not a real file, just the name the script module is hashed under
+    const char* const SCRIPT_MODULE_PATH = "Scripts/GameModule.asbc";
+
 
 
     void readCookSettings(const char* inputFile, CookSettings& output)
@@ -171,6 +174,21 @@ namespace cook
         }
     }
 
+    //The built script module is saved as its own asset, so the game can load
+    //it instead of compiling the script sources
+    void cookScriptModule(FILE* assetNamesFile, const fs::path& cacheFolder, script::AngelState& angelState, uint32_t seed)
+    {
+        fs::path modulePath(SCRIPT_MODULE_PATH);
+        uint32_t fileHash = hashFile(modulePath, seed);
+        std::string outFile = (cacheFolder / hashToPath(fileHash)).string();
+        fprintf(assetNamesFile, "%08x %s\n", fileHash, SCRIPT_MODULE_PATH);
+
+        AssetFileWriter writer;
+        cookAngelBytecode(angelState, writer);
+        writer.saveToFile(outFile.c_str());
+        printf("Cook: %s -> %s\n", SCRIPT_MODULE_PATH, outFile.c_str());
+    }
+
     void cookAssets(const CookSettings& settings)
     {
         fs::path inFolder(settings.assetFolder);
@@ -201,6 +219,7 @@ namespace cook
         angelState.startCompiling();
         cookDirHelper(assetNamesFile, inFolder, outRoot, angelState, hashSeed, cookAsset<(int)COOK_PASS_SCRIPT>);
         angelState.endCompiling();
+        cookScriptModule(assetNamesFile, outRoot, angelState, hashSeed);
         cookDirHelper(assetNamesFile, inFolder, outRoot, angelState, hashSeed, cookAsset<(int)COOK_PASS_SCENE>);
 
         fclose(assetNamesFile);
@@ -23,14 +23,22 @@ using namespace scene;
 
 namespace cook
 {
-    void cookTexture2D(const char* inputFile, AssetFileWriter& writer)
+    //Copies the raw contents of a file into the writer's archive
+    static void writeFileContents(const char* inputFile, AssetFileWriter& writer)
     {
-        writer.setAssetType(AssetType::Texture);
-        writer.setCompressed(true);
-
         FILE* input = fopen(inputFile, "rb");
+        NW_REQUIRE(input);
 
-        const int bufferSize = 1024;
+        //Size the archive up front so the copy below never reallocates
+        fseek(input, 0, SEEK_END);
+        long fileSize = ftell(input);
+        fseek(input, 0, SEEK_SET);
+        if (fileSize > 0)
+        {
+            writer.ar.reserve(writer.ar.size() + (size_t)fileSize);
+        }
+
+        const int bufferSize = 64 * 1024;
         uint8_t buffer[bufferSize];
         size_t numRead = 0;
         while ((numRead = fread(buffer, 1, bufferSize, input)) > 0)
@@ -40,6 +48,14 @@ namespace cook
         fclose(input);
     }
 
+    void cookTexture2D(const char* inputFile, AssetFileWriter& writer)
+    {
+        writer.setAssetType(AssetType::Texture);
+        writer.setCompressed(true);
+
+        writeFileContents(inputFile, writer);
+    }
+
     void readLines(std::ifstream& input, std::string& buffer, const char* target)
     {
         std::string line;
@@ -57,16 +73,7 @@ namespace cook
         writer.setAssetType(AssetType::Shader);
         writer.setCompressed(true);
 
-        FILE* input = fopen(inputFile, "rb");
-
-        const int bufferSize = 1024;
-        uint8_t buffer[bufferSize];
-        size_t numRead = 0;
-        while ((numRead = fread(buffer, 1, bufferSize, input)) > 0)
-        {
-            AR_SERIALIZE_ARRAY_U8(writer.ar, buffer, numRead);
-        }
-        fclose(input);
+        writeFileContents(inputFile, writer);
     }
 
     void cookSound(const char* inputFile, AssetFileWriter& writer)
@@ -77,6 +84,7 @@ namespace cook
         Mix_Chunk* chunk = Mix_LoadWAV(inputFile);
 
         //No point in saving the length; we can get it from the file/span size
+        writer.ar.reserve(writer.ar.size() + chunk->alen);
         AR_SERIALIZE_ARRAY_U8(writer.ar, chunk->abuf, chunk->alen);
         Mix_FreeChunk(chunk);
     }
@@ -86,16 +94,7 @@ namespace cook
         writer.setAssetType(AssetType::Music);
         writer.setCompressed(false);
 
-        FILE* input = fopen(inputFile, "rb");
-
-        const int bufferSize = 1024;
-        uint8_t buffer[bufferSize];
-        size_t numRead = 0;
-        while ((numRead = fread(buffer, 1, bufferSize, input)) > 0)
-        {
-            AR_SERIALIZE_ARRAY_U8(writer.ar, buffer, numRead);
-        }
-        fclose(input);
+        writeFileContents(inputFile, writer);
     }
 
 
@@ -718,7 +717,8 @@ namespace cook
                         cookPrefab(compData, prefabName);
                     }
 
-                    scene.instantiate(e, scene.getPrefab(prefabRef));
+                    Scene::PrefabData prefab;
+                    if (scene.getPrefab(prefabRef, prefab)) { scene.instantiate(e, prefab); }
                 }
 
                 if (jEntity->HasMember("tags")) { addTags(compData, e, (*jEntity)["tags"]); }
@@ -769,8 +769,16 @@ namespace cook
         ar.serializeU32(textLen);
 
         //Write name and contents of script file
+        ar.reserve(ar.size() + nameLen + textLen);
         AR_SERIALIZE_ARRAY_CHAR(ar, inputFile, nameLen);
         AR_SERIALIZE_ARRAY_CHAR(ar, text.data(), text.size());
     }
+
+    void cookAngelBytecode(script::AngelState& angelState, AssetFileWriter& writer)
+    {
+        writer.setAssetType(AssetType::AngelBytecode);
+        writer.setCompressed(true);
+        angelState.saveBytecode(writer.ar);
+    }
 }
 #endif
@@ -19,6 +19,7 @@ namespace cook
     void cookMusic(const char* inputFile, AssetFileWriter& writer);
     void cookScene(const AssetCookData& cdat, script::AngelState& angelState);
     void cookAngelScript(const AssetCookData& cdat, script::AngelState& angelState);
+    void cookAngelBytecode(script::AngelState& angelState, AssetFileWriter& writer);
 }
 
 #endif
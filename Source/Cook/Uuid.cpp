@@ -1,5 +1,5 @@
 #include "Core/Core.h"
-#include "UUID.h"
+#include "Uuid.h"
 #include <cstdlib>
 
 namespace cook
@@ -1,119 +1,84 @@
 #include "Core/Core.h"
 #include "BuddyAllocator.h"
-#include <cassert>
 #include <cstdlib>
-#include <cmath>
 #include <cstring>
+#include <bx/uint32_t.h>
 
 namespace memory
 {
-    inline bool isPowerOfTwo(uint32_t x)
+    inline bool isPowerOfTwo(size_t x)
     {
         return !(x & (x - 1));
     }
 
-    uint32_t nextPowerOfTwo(uint32_t x)
+    inline uint32_t log2Floor(uint64_t x)
     {
-        if (isPowerOfTwo(x)) { return x; }
-
-        x |= x >> 1;
-        x |= x >> 2;
-        x |= x >> 4;
-        x |= x >> 8;
-        x |= x >> 16;
+        return 63 - bx::uint64_cntlz(x);
+    }
 
-        return x + 1;
+    inline uint32_t log2Ceil(uint64_t x)
+    {
+        return (x <= 1) ? 0 : log2Floor(x - 1) + 1;
     }
 
 
 
-    struct BuddyNode
-    {
-        BuddyNode* next;
-        BuddyNode* prev;
-    };
-
     BuddyAllocator::BuddyAllocator() :
-        _memory(nullptr),
+        _arenaCount(0),
+        _maxArenas(0),
+        _bitmapWords(0),
         _leafSize(0),
-        _allocatedSize(0),
-        _levels(0)
+        _leafShift(0),
+        _arenaSize(0),
+        _arenaShift(0),
+        _levels(0),
+        _allocationCount(0),
+        _usedBytes(0)
     {
-        for (int i = 0; i < MAX_LEVELS; i++)
+        for (uint32_t i = 0; i < MAX_ARENAS; i++)
         {
-            _freeLists[i] = nullptr;
+            _arenas[i] = nullptr;
         }
     }
 
     BuddyAllocator::~BuddyAllocator()
     {
-        std::free(_memory);
-        _memory = nullptr;
+        for (uint32_t i = 0; i < _arenaCount; i++)
+        {
+            std::free(_arenas[i]->memory);
+            std::free(_arenas[i]->freeBits);
+            delete _arenas[i];
+            _arenas[i] = nullptr;
+        }
+        _arenaCount = 0;
     }
 
-    void BuddyAllocator::init(size_t leafSize, uint32_t levels)
+    void BuddyAllocator::init(size_t leafSize, uint32_t levels, uint32_t maxArenas)
     {
-        assert(_memory == nullptr);     //Make sure this isn't initialized twice
-        assert(levels > 1);
-        assert(levels < MAX_LEVELS);
-
-        //Needs to be large enough to store two pointers
-        _leafSize = leafSize;
-        if (_leafSize < 16) { _leafSize = 16; }
+        NW_ASSERT(_arenaCount == 0);    //Make sure this isn't initialized twice
+        NW_ASSERT(levels > 1);
+        NW_ASSERT(levels <= MAX_LEVELS);
+        NW_ASSERT(maxArenas > 0 && maxArenas <= MAX_ARENAS);
 
+        _leafShift = log2Ceil(leafSize);
+        _leafSize = (size_t)1 << _leafShift;
         _levels = levels;
-        const uint32_t totalLeafNodes = 1 << (_levels - 1);
-        _allocatedSize = _leafSize * totalLeafNodes;
-        _memory = malloc(_allocatedSize);
-
-        //Initialize free lists. This is kind of tricky because we are storing
-        //the metadata bits that mark blocks as free/full at the beginning of
-        //the buffer. First things first, let's calculate the number of leaf
-        //nodes that this metadata will occupy.
-        uint32_t leafNodes = (uint32_t)ceil((float)totalLeafNodes / 4 / (float)_leafSize);
-        void* leafNodePtr = _memory;    //This is also used below for setting
-                                        //up the free blocks
-
-        //Zero out the leaf nodes to mark all as free
-        memset(_memory, 0, leafNodes * _leafSize);
-
-        //Now mark all of those leaf nodes as occupied
-        for (uint32_t i = 0; i < leafNodes; i++)
-        {
-            //Loop to mark "parent" blocks as allocated
-            uint32_t blockIndex = getBlockIndex(leafNodePtr, _levels - 1);
-            while (blockIndex > 0)
-            {
-                markBlockAsAllocated(blockIndex);
-                blockIndex >>= 1;
-            }
-
-            leafNodePtr = (void*)((uint8_t*)leafNodePtr + _leafSize);
-        }
+        _arenaShift = _leafShift + levels - 1;
+        _arenaSize = (size_t)1 << _arenaShift;
+        _maxArenas = maxArenas;
 
-        //Now we need to build the list of free nodes. First, we calculate how
-        //many free nodes are left over. We'll use that number's binary
-        //representation to quickly determine the first free nodes.
-        uint32_t leafNodesLeft = totalLeafNodes - leafNodes;
+        //Offsets have to fit in 32 bits
+        NW_REQUIRE(((uint64_t)_arenaSize * _maxArenas) <= ((uint64_t)1 << 32));
 
-        //Now we work our way from the ones place up and mark certain blocks as
-        //free if the bit happens to be set.
-        uint32_t curLevel = _levels - 1;
-        while (leafNodesLeft > 0)
+        //Level n has 2^n blocks, small levels still get a whole word
+        _bitmapWords = 0;
+        for (uint32_t level = 0; level < _levels; level++)
         {
-            if ((leafNodesLeft & 1) == 1)
-            {
-                //Add block to free list
-                BuddyNode* node = (BuddyNode*)leafNodePtr;
-                node->next = nullptr;
-                node->prev = nullptr;
-                _freeLists[curLevel] = node;
-                leafNodePtr = (void*)((uint8_t*)leafNodePtr + getBlockSize(curLevel));
-            }
-
-            leafNodesLeft >>= 1;
-            curLevel--;
+            _levelWords[level] = _bitmapWords;
+            _bitmapWords += (level < 6) ? 1 : (1u << (level - 6));
         }
+
+        addArena();
     }
 
     void* BuddyAllocator::alloc(size_t size)
@@ -123,63 +88,53 @@ namespace memory
 #endif
 
         //Make sure we have enough space
-        if (size > _allocatedSize) { return nullptr; }
+        if (size > _arenaSize) { return nullptr; }
 
-        int level = getLevel(size);
-        void* ret = allocBlock(level);
-
-#ifdef VERIFY_BUDDY_ALLOCATOR
-        verify();
-#endif
-        return ret;
-    }
+        uint32_t level = getLevel(size);
+        uint32_t levelMask = (2u << level) - 1;     //This level and every larger one
 
-    void* BuddyAllocator::allocBlock(uint32_t level)
-    {
-        //If we don't have a free block, start splitting
-        if (_freeLists[level] == nullptr)
+        void* ret = nullptr;
+        for (uint32_t i = 0; i < _arenaCount && ret == nullptr; i++)
         {
-            if (level < 1)
+            uint32_t candidates = _arenas[i]->freeLevels & levelMask;
+            if (candidates != 0)
             {
-                //Unable to meet request
-                return nullptr;
+                //The smallest free block that fits is the one that splits the least
+                ret = allocFromArena(_arenas[i], level, 31 - bx::uint32_cntlz(candidates));
             }
-            else
-            {
-                //Get a block twice the size that we need
-                void* bigBlock = allocBlock(level - 1);
-                if (bigBlock == nullptr) { return nullptr; }
-
-                size_t blockSize = getBlockSize(level);
-                void* smallBlock1 = bigBlock;
-                BuddyNode* smallBlock2 = (BuddyNode*)((uint8_t*)bigBlock + blockSize);
-
-                //Add the second block to the free list
-                _freeLists[level] = smallBlock2;
-                smallBlock2->next = nullptr;
-                smallBlock2->prev = nullptr;
-
-                markBlockAsAllocated(getBlockIndex(smallBlock1, level));
+        }
 
-                return (void*)smallBlock1;
-            }
+        if (ret == nullptr && addArena())
+        {
+            ret = allocFromArena(_arenas[_arenaCount - 1], level, 0);
         }
-        else
+
+        if (ret != nullptr)
         {
-            BuddyNode* node = _freeLists[level];
+            _allocationCount++;
+            _usedBytes += getBlockSize(level);
+        }
 
-            //Update free list
-            BuddyNode* next = node->next;
-            _freeLists[level] = next;
-            if (next != nullptr)
-            {
-                next->prev = nullptr;
-            }
+#ifdef VERIFY_BUDDY_ALLOCATOR
+        verify();
+#endif
+        return ret;
+    }
 
-            markBlockAsAllocated(getBlockIndex(node, level));
+    void* BuddyAllocator::allocFromArena(Arena* arena, uint32_t level, uint32_t freeLevel)
+    {
+        uint32_t index = findFree(arena, freeLevel);
+        clearFree(arena, freeLevel, index);
 
-            return node;
+        //Split down to the requested size, keeping the left half and freeing the right
+        while (freeLevel < level)
+        {
+            freeLevel++;
+            index <<= 1;
+            setFree(arena, freeLevel, index + 1);
         }
+
+        return arena->memory + index * getBlockSize(level);
     }
 
     void BuddyAllocator::free(void* ptr, size_t size)
@@ -188,216 +143,177 @@ namespace memory
         verify();
 #endif
 
+        Arena* arena = _arenas[findArena(ptr)];
         uint32_t level = getLevel(size);
-        uint32_t levelIndex = getLevelIndex(ptr, level);
+        uint32_t index = (uint32_t)(((uint8_t*)ptr - arena->memory) / getBlockSize(level));
 
-        freeBlock(level, levelIndex);
+        _allocationCount--;
+        _usedBytes -= getBlockSize(level);
+
+        //Merge with the buddy for as long as it's free too
+        while (level > 0 && isFree(arena, level, index ^ 1))
+        {
+            clearFree(arena, level, index ^ 1);
+            index >>= 1;
+            level--;
+        }
+        setFree(arena, level, index);
 
 #ifdef VERIFY_BUDDY_ALLOCATOR
         verify();
 #endif
     }
 
-    void BuddyAllocator::freeBlock(uint32_t level, uint32_t levelIndex)
+    uint32_t BuddyAllocator::getOffset(const void* ptr) const
     {
-        uint32_t buddyLevelIndex = levelIndex ^ 1;
-        uint32_t buddyBlockIndex = getBlockIndex(buddyLevelIndex, level);
-
-        markBlockAsUnallocated(getBlockIndex(levelIndex, level));
-
-        if (isBlockAllocated(buddyBlockIndex))
-        {
-            //Cannot merge the buddies; add to free list
-            void* ptr = (char*)_memory + levelIndex * getBlockSize(level);
-
-            BuddyNode* node = (BuddyNode*)ptr;
-            node->next = _freeLists[level];
-            node->prev = nullptr;
+        uint32_t arenaIndex = findArena(ptr);
+        return (uint32_t)((arenaIndex << _arenaShift) + ((const uint8_t*)ptr - _arenas[arenaIndex]->memory));
+    }
 
-            if (node->next != nullptr)
-            {
-                node->next->prev = node;
-            }
+    size_t BuddyAllocator::getActualAllocSize(size_t size) const
+    {
+        return getBlockSize(getLevel(size));
+    }
 
-            _freeLists[level] = node;
-        }
-        else
+    BuddyStats BuddyAllocator::getStats() const
+    {
+        BuddyStats stats;
+        stats.arenaCount = _arenaCount;
+        stats.allocationCount = _allocationCount;
+        stats.freeBlockCount = 0;
+        stats.capacity = _arenaSize * _arenaCount;
+        stats.usedBytes = _usedBytes;
+        stats.freeBytes = 0;
+        stats.largestFreeBlock = 0;
+
+        for (uint32_t i = 0; i < _arenaCount; i++)
         {
-            //Remove the buddy from the free list. We're going to try to add
-            //the parent to the free list (and maybe it's parent, and so on...)
-            BuddyNode* currentNode = _freeLists[level];
-            while (getLevelIndex(currentNode, level) != buddyLevelIndex)
-            {
-                currentNode = currentNode->next;
-            }
-
-            //Remove from list
-            if (currentNode->prev == nullptr)
-            {
-                _freeLists[level] = currentNode->next;
-                if (currentNode->next != nullptr)
-                {
-                    currentNode->next->prev = nullptr;
-                }
-            }
-            else
+            const Arena* arena = _arenas[i];
+            for (uint32_t level = 0; level < _levels; level++)
             {
-                currentNode->prev->next = currentNode->next;
-                if (currentNode->next != nullptr)
+                uint32_t count = arena->freeCounts[level];
+                stats.freeBlockCount += count;
+                stats.freeBytes += count * getBlockSize(level);
+                if (count > 0 && getBlockSize(level) > stats.largestFreeBlock)
                 {
-                    currentNode->next->prev = currentNode->prev;
+                    stats.largestFreeBlock = getBlockSize(level);
                 }
             }
-
-            //Also mark buddy as free
-            markBlockAsUnallocated(buddyBlockIndex);
-
-            //Recurse
-            freeBlock(level - 1, levelIndex >> 1);
         }
-    }
 
-    void* BuddyAllocator::getBaseAddress()
-    {
-        return _memory;
+        return stats;
     }
 
-    size_t BuddyAllocator::getActualAllocSize(size_t size)
+
+
+    bool BuddyAllocator::addArena()
     {
-        int npot = nextPowerOfTwo((uint32_t)ceilf((float)size / (float)_leafSize));
-        return npot * _leafSize;
-    }
+        if (_arenaCount == _maxArenas) { return false; }
 
+        Arena* arena = new Arena();
+        arena->memory = (uint8_t*)malloc(_arenaSize);
+        arena->freeBits = (uint64_t*)calloc(_bitmapWords, sizeof(uint64_t));
+        memset(arena->freeCounts, 0, sizeof(arena->freeCounts));
+        memset(arena->firstWords, 0, sizeof(arena->firstWords));
+        arena->freeLevels = 0;
+        NW_REQUIRE(arena->memory != nullptr && arena->freeBits != nullptr);
 
+        //Starts out as one free block
+        setFree(arena, 0, 0);
 
-    bool BuddyAllocator::isBlockAllocated(uint32_t blockIndex)
-    {
-        uint32_t byte = blockIndex / 8;
-        uint32_t bit = blockIndex % 8;
-        return (((uint8_t*)_memory)[byte] >> bit) & 1;
+        _arenas[_arenaCount++] = arena;
+        return true;
     }
 
-    void BuddyAllocator::markBlockAsAllocated(uint32_t blockIndex)
+    uint32_t BuddyAllocator::findArena(const void* ptr) const
     {
-        uint32_t byte = blockIndex / 8;
-        uint32_t bit = blockIndex % 8;
-        ((uint8_t*)_memory)[byte] |= (1 << bit);
-    }
+        for (uint32_t i = 0; i < _arenaCount; i++)
+        {
+            const uint8_t* memory = _arenas[i]->memory;
+            if ((const uint8_t*)ptr >= memory && (const uint8_t*)ptr < memory + _arenaSize)
+            {
+                return i;
+            }
+        }
 
-    void BuddyAllocator::markBlockAsUnallocated(uint32_t blockIndex)
-    {
-        uint32_t byte = blockIndex / 8;
-        uint32_t bit = blockIndex % 8;
-        ((uint8_t*)_memory)[byte] &= ~(1 << bit);
+        NW_REQUIRE(false);     //Not allocated by this allocator
+        return 0;
     }
 
 
 
-    size_t BuddyAllocator::getBlockSize(uint32_t level)
+    inline bool BuddyAllocator::isFree(const Arena* arena, uint32_t level, uint32_t index) const
     {
-        return _allocatedSize / ((size_t)1 << level);
+        return (arena->freeBits[_levelWords[level] + (index >> 6)] >> (index & 63)) & 1;
     }
 
-    uint32_t BuddyAllocator::getLevel(size_t size)
+    inline void BuddyAllocator::setFree(Arena* arena, uint32_t level, uint32_t index)
     {
-        int npot = nextPowerOfTwo((uint32_t)ceilf((float)size / (float)_leafSize));
-        return _levels - 1 - (uint32_t)(log(npot) / log(2));
+        NW_ASSERT(!isFree(arena, level, index));
+        arena->freeBits[_levelWords[level] + (index >> 6)] |= (uint64_t)1 << (index & 63);
+        arena->freeCounts[level]++;
+        if ((index >> 6) < arena->firstWords[level]) { arena->firstWords[level] = index >> 6; }
+        arena->freeLevels |= 1u << level;
     }
 
-    inline uint32_t BuddyAllocator::getLevelIndex(void* ptr, uint32_t level)
+    inline void BuddyAllocator::clearFree(Arena* arena, uint32_t level, uint32_t index)
     {
-        return (uint32_t)(((char*)ptr - (char*)_memory) / getBlockSize(level));
+        NW_ASSERT(isFree(arena, level, index));
+        arena->freeBits[_levelWords[level] + (index >> 6)] &= ~((uint64_t)1 << (index & 63));
+        if (--arena->freeCounts[level] == 0)
+        {
+            arena->freeLevels &= ~(1u << level);
+        }
     }
 
-    inline uint32_t BuddyAllocator::getBlockIndex(uint32_t levelIndex, uint32_t level)
+    uint32_t BuddyAllocator::findFree(Arena* arena, uint32_t level)
     {
-        return levelIndex + (1 << level);
+        NW_ASSERT(arena->freeCounts[level] > 0);
+
+        const uint64_t* words = arena->freeBits + _levelWords[level];
+        uint32_t wordCount = (level < 6) ? 1 : (1u << (level - 6));
+        for (uint32_t i = arena->firstWords[level]; i < wordCount; i++)
+        {
+            if (words[i] != 0)
+            {
+                arena->firstWords[level] = i;
+                return (i << 6) + bx::uint64_cnttz(words[i]);
+            }
+        }
+
+        NW_REQUIRE(false);     //Free count doesn't match the bitmap
+        return 0;
     }
 
-    inline uint32_t BuddyAllocator::getBlockIndex(void* ptr, uint32_t level)
+    uint32_t BuddyAllocator::getLevel(size_t size) const
     {
-        return getBlockIndex(getLevelIndex(ptr, level), level);
+        size_t leaves = (size + _leafSize - 1) >> _leafShift;
+        return _levels - 1 - log2Ceil(leaves);
     }
 
 #ifdef VERIFY_BUDDY_ALLOCATOR
     void BuddyAllocator::verify()
     {
-        //Iterate through each bit of metadata
-        //Verify that the free lists are correct
-        uint32_t maxBlockIndex = (1 << _levels) - 1;
-        for (uint32_t blockIndex = 1; blockIndex < maxBlockIndex; blockIndex++)
+        for (uint32_t i = 0; i < _arenaCount; i++)
         {
-            uint32_t level = (uint32_t)(log(blockIndex) / log(2));
-            if (isBlockAllocated(blockIndex))
-            {
-                //Allocated: Make sure it's not in the free list
-                BuddyNode* current = _freeLists[level];
-                while (current != nullptr)
-                {
-                    if (getBlockIndex(current, level) == blockIndex)
-                    {
-                        //Shouldn't be in the list
-                        assert(false);
-                    }
-                    current = current->next;
-                }
-            }
-            else
+            const Arena* arena = _arenas[i];
+            for (uint32_t level = 0; level < _levels; level++)
             {
-                //Unallocated: Make sure it (or its parent) is in the free list
-                bool inFreeList = false;
-                uint32_t bIdx = blockIndex;
-                while (level > 0)
+                //Counts and the level mask match the bitmap
+                uint32_t count = 0;
+                for (uint32_t index = 0; index < (1u << level); index++)
                 {
-                    BuddyNode* current = _freeLists[level];
-                    while (current != nullptr)
-                    {
-                        if (getBlockIndex(current, level) == bIdx)
-                        {
-                            inFreeList = true;
-                            break;
-                        }
-                        current = current->next;
-                    }
-
-                    if (inFreeList) { break; }  //Break early
-                    if (isBlockAllocated(bIdx))
-                    {
-                        //Totally inaccurate, but eh...
-                        //Occurs when a large block is allocated
-                        //and the smaller block flags are not set
-                        inFreeList = true;
-                        break;
-                    }
-
-                    level--;
-                    bIdx >>= 1;
-                }
-
-                if (!inFreeList)
-                {
-                    //It should be there...
-                    assert(false);
-                }
-            }
-        }
+                    if (!isFree(arena, level, index)) { continue; }
+                    count++;
 
-        //Walk free lists to make sure that the pointers are valid
-        //If they're not, we'll crash...
-        for (int i = 0; i < _levels; i++)
-        {
-            BuddyNode* current = _freeLists[i];
-
-            //Walk forward
-            while (current != nullptr && current->next != nullptr)
-            {
-                current = current->next;
-            }
+                    //Free buddies are always merged
+                    NW_ASSERT(level == 0 || !isFree(arena, level, index ^ 1));
 
-            //Walk backward
-            while (current != nullptr)
-            {
-                current = current->prev;
+                    //A free block's parent is split, so it can't be free itself
+                    NW_ASSERT(level == 0 || !isFree(arena, level - 1, index >> 1));
+                }
+                NW_ASSERT(count == arena->freeCounts[level]);
+                NW_ASSERT(((arena->freeLevels >> level) & 1) == (count > 0 ? 1u : 0u));
             }
         }
     }
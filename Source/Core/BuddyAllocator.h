@@ -2,53 +2,157 @@
 #define MEMORY_BUDDY_ALLOCATOR_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include <mutex>
 
 //#define VERIFY_BUDDY_ALLOCATOR
 
 namespace memory
 {
-    struct BuddyNode;
+    struct BuddyStats
+    {
+        uint32_t arenaCount;
+        uint32_t allocationCount;
+        uint32_t freeBlockCount;
+        size_t capacity;            //Bytes across all arenas
+        size_t usedBytes;           //Bytes in allocated blocks, including rounding
+        size_t freeBytes;
+        size_t largestFreeBlock;
+
+        //0 when the free memory is a single block, approaching 1 as it gets
+        //split into many small ones
+        float getFragmentation() const
+        {
+            return (freeBytes == 0) ? 0.0f : 1.0f - (float)largestFreeBlock / (float)freeBytes;
+        }
+    };
+
+    //Buddy allocator made of equally sized arenas. When no arena has a free
+    //block that is large enough a new arena is added, so allocations only fail
+    //once maxArenas is reached or the request is larger than an arena.
+    //
+    //Each arena keeps a bitmap per level with a bit set for every free block,
+    //plus a mask of the levels that have any, so finding a block is a couple of
+    //bit scans rather than a walk of free lists.
+    //
+    //Memory handed out doesn't move when arenas are added, but there is no
+    //single base address either. Store offsets (getOffset) to get small,
+    //position independent handles.
     class BuddyAllocator
     {
+    public:
+        static const uint32_t MAX_LEVELS = 24;
+        static const uint32_t MAX_ARENAS = 64;
+
     private:
-        static const int MAX_LEVELS = 32;
+        struct Arena
+        {
+            uint8_t* memory;
+            uint64_t* freeBits;
+            uint32_t freeCounts[MAX_LEVELS];
+            uint32_t firstWords[MAX_LEVELS];    //No free blocks before this word of the level
+            uint32_t freeLevels;                //Bit per level with a free block
+        };
+
+        Arena* _arenas[MAX_ARENAS];
+        uint32_t _arenaCount;
+        uint32_t _maxArenas;
+
+        uint32_t _levelWords[MAX_LEVELS];   //First bitmap word of each level
+        uint32_t _bitmapWords;
 
-        void* _memory;
-        BuddyNode* _freeLists[MAX_LEVELS];
         size_t _leafSize;
-        size_t _allocatedSize;
+        uint32_t _leafShift;
+        size_t _arenaSize;
+        uint32_t _arenaShift;
         uint32_t _levels;
 
+        uint32_t _allocationCount;
+        size_t _usedBytes;
+
+        BuddyAllocator(const BuddyAllocator&);
+        BuddyAllocator& operator=(const BuddyAllocator&);
+
     public:
         BuddyAllocator();
         ~BuddyAllocator();
 
-        void init(size_t leafSize, uint32_t levels);
+        //Arenas are leafSize << (levels - 1) bytes, leafSize is rounded up to
+        //a power of two
+        void init(size_t leafSize, uint32_t levels, uint32_t maxArenas = MAX_ARENAS);
 
         void* alloc(size_t size);
         void free(void* ptr, size_t size);
 
-        void* getBaseAddress();
-        size_t getActualAllocSize(size_t size);
+        uint32_t getOffset(const void* ptr) const;
+        inline void* getPointer(uint32_t offset) const
+        {
+            return _arenas[offset >> _arenaShift]->memory + (offset & (_arenaSize - 1));
+        }
+
+        size_t getActualAllocSize(size_t size) const;
+        size_t getArenaSize() const { return _arenaSize; }
+        BuddyStats getStats() const;
 
     private:
-        void* allocBlock(uint32_t level);
-        void freeBlock(uint32_t level, uint32_t levelIndex);
+        bool addArena();
+        uint32_t findArena(const void* ptr) const;
+        void* allocFromArena(Arena* arena, uint32_t level, uint32_t freeLevel);
 
-        bool isBlockAllocated(uint32_t blockIndex);
-        void markBlockAsAllocated(uint32_t blockIndex);
-        void markBlockAsUnallocated(uint32_t blockIndex);
+        bool isFree(const Arena* arena, uint32_t level, uint32_t index) const;
+        void setFree(Arena* arena, uint32_t level, uint32_t index);
+        void clearFree(Arena* arena, uint32_t level, uint32_t index);
+        uint32_t findFree(Arena* arena, uint32_t level);
 
-        size_t getBlockSize(uint32_t level);
-        uint32_t getLevel(size_t size);
-        uint32_t getLevelIndex(void* ptr, uint32_t level);
-        uint32_t getBlockIndex(uint32_t levelIndex, uint32_t level);
-        uint32_t getBlockIndex(void* ptr, uint32_t level);
+        size_t getBlockSize(uint32_t level) const { return _arenaSize >> level; }
+        uint32_t getLevel(size_t size) const;
 
 #ifdef VERIFY_BUDDY_ALLOCATOR
         void verify();
 #endif
     };
+
+    //Buddy allocator for memory shared between threads. Offsets can be turned
+    //back into pointers without taking the lock, arenas never move.
+    class ConcurrentBuddyAllocator
+    {
+    private:
+        BuddyAllocator _allocator;
+        mutable std::mutex _mutex;
+
+    public:
+        void init(size_t leafSize, uint32_t levels, uint32_t maxArenas = BuddyAllocator::MAX_ARENAS)
+        {
+            _allocator.init(leafSize, levels, maxArenas);
+        }
+
+        void* alloc(size_t size)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _allocator.alloc(size);
+        }
+
+        void free(void* ptr, size_t size)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _allocator.free(ptr, size);
+        }
+
+        uint32_t getOffset(const void* ptr) const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _allocator.getOffset(ptr);
+        }
+
+        void* getPointer(uint32_t offset) const { return _allocator.getPointer(offset); }
+        size_t getActualAllocSize(size_t size) const { return _allocator.getActualAllocSize(size); }
+
+        BuddyStats getStats() const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _allocator.getStats();
+        }
+    };
 }
 
 #endif
@@ -52,6 +52,7 @@
 //Core library includes
 #include "Features.h"
 #include "CpuTiming.h"
+#include "Counters.h"
 #include "Hash.h"
 
 #endif
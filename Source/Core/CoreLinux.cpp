@@ -0,0 +1,19 @@
+#include "Core/Core.h"
+
+#if PLATFORM_LINUX
+#include <stdio.h>
+
+void assertFailure(const char* expression)
+{
+    fprintf(stderr, "Assertion failed: %s\n", expression);
+    fflush(stderr);
+
+#if defined(NW_DEVELOP)
+    __builtin_trap();
+#else
+    int* crash = nullptr;
+    *crash = 1;
+#endif
+}
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef CORE__CORE_LINUX_H
+#define CORE__CORE_LINUX_H
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#define NW_FORCEINLINE inline __attribute__((always_inline))
+#define NW_RETURN_ADDRESS() __builtin_return_address(0)
+
+
+void assertFailure(const char*);
+
+//Assertion macros
+// NW_ASSERT  : Removed on non-debug builds.
+#if defined(NW_DEBUG)
+    #define NW_ASSERT(expression) \
+        do { \
+            if (!(expression)) { assertFailure(#expression); } \
+        } while (0)
+#else
+    #define NW_ASSERT(cond) do { } while(0)
+#endif
+
+// NW_VERIFY  : Assertion is removed on non-develop builds, but code inside
+//              macro exists in all configs.
+#if defined(NW_DEVELOP)
+    #define NW_VERIFY(expression) \
+        do { \
+            if (!(expression)) { assertFailure(#expression); } \
+        } while (0)
+#else
+    #define NW_VERIFY(cond) ((void)(cond))
+#endif
+
+// NW_REQUIRE : Use for unrecoverable errors. Asserts on development builds.
+//              Crashes on release builds.
+#define NW_REQUIRE(expression) \
+    do { \
+        if (!(expression)) { assertFailure(#expression); } \
+    } while (0)
+
+
+
+//The MSVC aligned allocation functions the engine uses. The pointer malloc
+//returned is stored just before the aligned block.
+inline void* _aligned_offset_malloc(size_t size, size_t alignment, size_t offset)
+{
+    if (alignment < sizeof(void*)) { alignment = sizeof(void*); }
+
+    uint8_t* raw = (uint8_t*)malloc(size + alignment + sizeof(void*));
+    if (raw == nullptr) { return nullptr; }
+
+    uintptr_t start = (uintptr_t)raw + sizeof(void*) + offset;
+    uintptr_t aligned = (start + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    uint8_t* ptr = (uint8_t*)(aligned - offset);
+    memcpy(ptr - sizeof(void*), &raw, sizeof(void*));
+    return ptr;
+}
+
+inline void* _aligned_malloc(size_t size, size_t alignment)
+{
+    return _aligned_offset_malloc(size, alignment, 0);
+}
+
+inline void _aligned_free(void* ptr)
+{
+    if (ptr == nullptr) { return; }
+
+    void* raw;
+    memcpy(&raw, (uint8_t*)ptr - sizeof(void*), sizeof(void*));
+    free(raw);
+}
+
+template <typename T, size_t N>
+char (&nwCountofHelper(T (&)[N]))[N];
+#define _countof(array) (sizeof(nwCountofHelper(array)))
+
+//The MSVC checked CRT functions the engine uses
+inline int fopen_s(FILE** file, const char* fileName, const char* mode)
+{
+    *file = fopen(fileName, mode);
+    return (*file != nullptr) ? 0 : errno;
+}
+
+#define sprintf_s snprintf
+
+
+
+namespace nw
+{
+    //Atomic access to plain integer storage, for arrays that are otherwise
+    //resized and serialized as ordinary data. Relaxed ordering only.
+    NW_FORCEINLINE uint8_t atomicLoad(const uint8_t* ptr)
+    {
+        return __atomic_load_n(ptr, __ATOMIC_RELAXED);
+    }
+
+    NW_FORCEINLINE uint32_t atomicLoad(const uint32_t* ptr)
+    {
+        return __atomic_load_n(ptr, __ATOMIC_RELAXED);
+    }
+
+    //Returns true if *ptr was expected and has been replaced with desired
+    NW_FORCEINLINE bool atomicCompareExchange(uint8_t* ptr, uint8_t expected, uint8_t desired)
+    {
+        return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+
+    NW_FORCEINLINE bool atomicCompareExchange(uint32_t* ptr, uint32_t expected, uint32_t desired)
+    {
+        return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+
+    class Mutex
+    {
+    private:
+        pthread_mutex_t handle;
+
+        Mutex(const Mutex&);
+        Mutex& operator=(const Mutex&);
+
+    public:
+        NW_FORCEINLINE Mutex()
+        {
+            pthread_mutex_init(&handle, nullptr);
+        }
+
+        NW_FORCEINLINE ~Mutex()
+        {
+            pthread_mutex_destroy(&handle);
+        }
+
+        NW_FORCEINLINE void lock()
+        {
+            pthread_mutex_lock(&handle);
+        }
+
+        NW_FORCEINLINE bool tryLock()
+        {
+            return (pthread_mutex_trylock(&handle) == 0);
+        }
+
+        NW_FORCEINLINE void unlock()
+        {
+            pthread_mutex_unlock(&handle);
+        }
+    };
+}
+
+#endif
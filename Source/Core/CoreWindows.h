@@ -5,8 +5,10 @@
 #define NOMINMAX
 #include <windows.h>
 #include <assert.h>
+#include <intrin.h>
 
 #define NW_FORCEINLINE __forceinline
+#define NW_RETURN_ADDRESS() _ReturnAddress()
 
 
 void assertFailure(const char*);
@@ -50,6 +52,29 @@ void assertFailure(const char*);
 
 namespace nw
 {
+    //Atomic access to plain integer storage, for arrays that are otherwise
+    //resized and serialized as ordinary data. Relaxed ordering only.
+    NW_FORCEINLINE uint8_t atomicLoad(const uint8_t* ptr)
+    {
+        return (uint8_t)__iso_volatile_load8((const volatile char*)ptr);
+    }
+
+    NW_FORCEINLINE uint32_t atomicLoad(const uint32_t* ptr)
+    {
+        return (uint32_t)__iso_volatile_load32((const volatile int*)ptr);
+    }
+
+    //Returns true if *ptr was expected and has been replaced with desired
+    NW_FORCEINLINE bool atomicCompareExchange(uint8_t* ptr, uint8_t expected, uint8_t desired)
+    {
+        return (uint8_t)_InterlockedCompareExchange8((volatile char*)ptr, (char)desired, (char)expected) == expected;
+    }
+
+    NW_FORCEINLINE bool atomicCompareExchange(uint32_t* ptr, uint32_t expected, uint32_t desired)
+    {
+        return (uint32_t)_InterlockedCompareExchange((volatile long*)ptr, (long)desired, (long)expected) == expected;
+    }
+
     class Mutex
     {
     private:
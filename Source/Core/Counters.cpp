@@ -0,0 +1,190 @@
+#include "Core/Core.h"
+#include "Counters.h"
+#include <atomic>
+#include <mutex>
+#include <cstdio>
+#include <cinttypes>
+#include "Util/File.h"
+
+namespace counters
+{
+    const uint32_t MAX_THREADS = 64;
+
+    static const char* COUNTER_NAMES[COUNTER_COUNT] =
+    {
+        "moveEntities",
+        "collisionPairsTested",
+        "collisionPairsFound",
+        "tileIsFreeCalls",
+        "spriteEntities",
+        "scriptCalls",
+        "drawCalls",
+        "vertices",
+        "bytesDecompressed",
+        "assetsLoaded",
+    };
+
+    thread_local ThreadCounters* tCounters = nullptr;
+
+    static ThreadCounters* sThreads[MAX_THREADS];
+    static std::atomic<uint32_t> sThreadCount;
+    static std::mutex sRegisterMutex;
+    //Blocks of threads that have exited, free to hand to the next thread.
+    //Their last counts stay in the block until endFrame() folds them in.
+    static bool sReleased[MAX_THREADS];
+
+    //Gives the thread's block back when the thread exits, so recreating the
+    //job system doesn't use up the blocks
+    struct ThreadRelease
+    {
+        uint32_t index;
+
+        ThreadRelease() : index(MAX_THREADS) { }
+        ~ThreadRelease()
+        {
+            if (index == MAX_THREADS) { return; }
+
+            std::lock_guard<std::mutex> lock(sRegisterMutex);
+            sReleased[index] = true;
+            tCounters = nullptr;
+        }
+    };
+    static thread_local ThreadRelease tRelease;
+    static thread_local bool tRegisterFailed = false;   //Skips the lock on every count once full
+
+    //Ring of per frame totals
+    static uint64_t sHistory[COUNTER_HISTORY_FRAMES][COUNTER_COUNT];
+    static uint32_t sHistoryCount;
+    static uint32_t sHistoryNext;
+    static uint64_t sFrameIndex;    //Frames closed so far
+
+    ThreadCounters* registerThread()
+    {
+        if (tRegisterFailed) { return nullptr; }
+
+        std::lock_guard<std::mutex> lock(sRegisterMutex);
+
+        //Reuse the block of a thread that has exited before adding one
+        uint32_t threadCount = sThreadCount.load(std::memory_order_relaxed);
+        uint32_t index = 0;
+        while (index < threadCount && !sReleased[index])
+        {
+            index++;
+        }
+
+        if (index < threadCount)
+        {
+            sReleased[index] = false;
+        }
+        else
+        {
+            NW_ASSERT(index < MAX_THREADS);
+            if (index >= MAX_THREADS)
+            {
+                tRegisterFailed = true;
+                return nullptr;
+            }
+
+            ThreadCounters* threadCounters = new ThreadCounters;
+            memset(threadCounters, 0, sizeof(ThreadCounters));
+
+            sThreads[index] = threadCounters;
+            sThreadCount.store(index + 1, std::memory_order_release);
+        }
+
+        tRelease.index = index;
+        tCounters = sThreads[index];
+        return tCounters;
+    }
+
+    const char* getCounterName(Counter counter)
+    {
+        NW_ASSERT(counter < Counter::Count);
+        return COUNTER_NAMES[(uint32_t)counter];
+    }
+
+    void endFrame()
+    {
+        uint64_t* totals = sHistory[sHistoryNext];
+        memset(totals, 0, sizeof(sHistory[0]));
+
+        uint32_t threadCount = sThreadCount.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < threadCount; i++)
+        {
+            uint64_t* values = sThreads[i]->values;
+            for (uint32_t c = 0; c < COUNTER_COUNT; c++)
+            {
+                totals[c] += values[c];
+                values[c] = 0;
+            }
+        }
+
+        sHistoryNext = (sHistoryNext + 1) % COUNTER_HISTORY_FRAMES;
+        if (sHistoryCount < COUNTER_HISTORY_FRAMES) { sHistoryCount++; }
+        sFrameIndex++;
+    }
+
+    CounterStats getCounterStats(Counter counter)
+    {
+        NW_ASSERT(counter < Counter::Count);
+        uint32_t c = (uint32_t)counter;
+
+        CounterStats stats = { 0, 0, 0.0f, 0 };
+        if (sHistoryCount == 0) { return stats; }
+
+        uint32_t last = (sHistoryNext + COUNTER_HISTORY_FRAMES - 1) % COUNTER_HISTORY_FRAMES;
+        stats.lastFrame = sHistory[last][c];
+        stats.min = UINT64_MAX;
+
+        uint64_t total = 0;
+        for (uint32_t i = 0; i < sHistoryCount; i++)
+        {
+            uint64_t value = sHistory[i][c];
+            total += value;
+            if (value < stats.min) { stats.min = value; }
+            if (value > stats.max) { stats.max = value; }
+        }
+        stats.avg = (float)((double)total / sHistoryCount);
+        return stats;
+    }
+
+    void printCounterStats()
+    {
+        printf("%-40s %12s %12s %12s %12s\n", "Counter (per frame)", "Last", "Min", "Avg", "Max");
+        for (uint32_t c = 0; c < COUNTER_COUNT; c++)
+        {
+            CounterStats stats = getCounterStats((Counter)c);
+            printf("%-40s %12" PRIu64 " %12" PRIu64 " %12.1f %12" PRIu64 "\n", COUNTER_NAMES[c],
+                stats.lastFrame, stats.min, stats.avg, stats.max);
+        }
+    }
+
+    void writeCsv(const char* fileName)
+    {
+        eastl::string csv = "frame";
+        for (uint32_t c = 0; c < COUNTER_COUNT; c++)
+        {
+            csv += ',';
+            csv += COUNTER_NAMES[c];
+        }
+        csv += '\n';
+
+        char value[24];
+        uint32_t first = (sHistoryNext + COUNTER_HISTORY_FRAMES - sHistoryCount) % COUNTER_HISTORY_FRAMES;
+        for (uint32_t i = 0; i < sHistoryCount; i++)
+        {
+            const uint64_t* totals = sHistory[(first + i) % COUNTER_HISTORY_FRAMES];
+
+            snprintf(value, sizeof(value), "%" PRIu64, sFrameIndex - sHistoryCount + i);
+            csv += value;
+            for (uint32_t c = 0; c < COUNTER_COUNT; c++)
+            {
+                snprintf(value, sizeof(value), ",%" PRIu64, totals[c]);
+                csv += value;
+            }
+            csv += '\n';
+        }
+
+        util::file::writeAllText(fileName, csv.c_str());
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef CORE_COUNTERS_H
+#define CORE_COUNTERS_H
+
+#include <stdint.h>
+
+//Workload counters, fed by COUNT_WORK in profile builds. Where the profiler
+//says how long a frame took, these say how much work was in it.
+//
+//Every thread adds to its own block of counters, so counting is a plain add
+//with no lock or shared cache line. A thread's block goes to the next thread
+//that registers once it exits. endFrame() folds the blocks into the frame's
+//totals on the main thread and keeps a history of them.
+namespace counters
+{
+    enum class Counter : uint8_t
+    {
+        MoveEntities,           //Movers stepped, with or without world collision
+        CollisionPairsTested,
+        CollisionPairsFound,
+        TileIsFreeCalls,
+        SpriteEntities,         //Sprites put in the render list
+        ScriptCalls,
+        DrawCalls,
+        Vertices,
+        BytesDecompressed,
+        AssetsLoaded,
+        Count
+    };
+
+    static const uint32_t COUNTER_COUNT = (uint32_t)Counter::Count;
+    static const uint32_t COUNTER_HISTORY_FRAMES = 128;
+
+    //Over the frames in the history
+    struct CounterStats
+    {
+        uint64_t lastFrame;
+        uint64_t min;
+        float avg;
+        uint64_t max;
+    };
+
+    struct ThreadCounters
+    {
+        uint64_t values[COUNTER_COUNT];
+        uint8_t padding[64];    //Keeps the next thread's block off the last cache line
+    };
+
+    extern thread_local ThreadCounters* tCounters;
+    ThreadCounters* registerThread();
+
+    inline void add(Counter counter, uint64_t amount)
+    {
+        ThreadCounters* threadCounters = tCounters;
+        if (threadCounters == nullptr)
+        {
+            threadCounters = registerThread();
+            if (threadCounters == nullptr) { return; }
+        }
+        threadCounters->values[(uint32_t)counter] += amount;
+    }
+
+    const char* getCounterName(Counter counter);
+
+    //Closes the frame, from the main thread while no jobs are running
+    void endFrame();
+
+    CounterStats getCounterStats(Counter counter);
+    void printCounterStats();
+    //One row per frame in the history, oldest first
+    void writeCsv(const char* fileName);
+}
+
+#ifdef NW_PROFILE
+#define COUNT_WORK(counter, amount) counters::add(counters::Counter::counter, (amount))
+#else
+#define COUNT_WORK(counter, amount) ((void)0)
+#endif
+
+#endif
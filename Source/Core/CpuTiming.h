@@ -4,20 +4,37 @@
 const uint32_t PROF_COLOR_GRAPHICS = 0xFF1B00FF;
 
 #if defined(NW_PROFILE) && defined(_WIN64)
-
 #define USE_PIX
 #include <pix3.h>
+#endif
 
+#if defined(NW_PROFILE)
+#include "Profiler.h"
+
+//Records a zone for the built in profiler, and a PIX event where PIX is
+//available. The name has to outlive the frame, see profiler::internName().
 class ScopeCpuEvent
 {
+private:
+    const char* _name;
+    uint64_t _begin;
+
 public:
-    ScopeCpuEvent(uint32_t color, const char* name)
+    NW_FORCEINLINE ScopeCpuEvent(uint32_t color, const char* name) : _name(name)
     {
+#ifdef USE_PIX
         PIXBeginEvent(color, name);
+#else
+        NW_UNUSED(color);
+#endif
+        _begin = profiler::getTicks();
     }
-    ~ScopeCpuEvent()
+    NW_FORCEINLINE ~ScopeCpuEvent()
     {
+        profiler::recordZone(_name, _begin, profiler::getTicks());
+#ifdef USE_PIX
         PIXEndEvent();
+#endif
     }
 };
 
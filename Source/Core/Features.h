@@ -4,6 +4,19 @@
 #ifdef NW_DEVELOP
     #define NW_ASSET_COOK
     #define NW_EDITOR
+    #define NW_MEMORY_TRACKING
 #endif
 
+#ifdef NW_PROFILE
+    #define NW_BENCHMARKS
+#endif
+
+//64 bit entity handles with 32 bit generations, for games that churn through
+//entities fast enough to wrap the 8 bit generation. Scenes need to be recooked.
+//#define NW_ENTITY_64BIT
+
+//Counts heap allocations per call site on top of the per tag counters. Slow,
+//every allocation takes a lock. Resolve the addresses with a debugger.
+//#define NW_MEMORY_SITES
+
 #endif
@@ -0,0 +1,138 @@
+#include "Core/Core.h"
+#include "FrameArena.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace memory
+{
+    //Freed frame memory is filled with this so stale pointers stand out
+    const uint8_t FRAME_ARENA_POISON = 0xCD;
+
+    FrameArena g_FrameArena;
+
+    FrameArena::FrameArena() :
+        _current(0),
+        _capacity(0),
+        _highWaterMark(0),
+        _overflowCount(0)
+    {
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            _buffers[i].memory = nullptr;
+            _buffers[i].used.store(0);
+        }
+    }
+
+    FrameArena::~FrameArena()
+    {
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            std::free(_buffers[i].memory);
+            _buffers[i].memory = nullptr;
+        }
+    }
+
+    void FrameArena::init(size_t capacity)
+    {
+        NW_ASSERT(_buffers[0].memory == nullptr);
+
+        _capacity = capacity;
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            _buffers[i].memory = (uint8_t*)malloc(capacity);
+            NW_REQUIRE(_buffers[i].memory != nullptr);
+#ifdef NW_DEBUG
+            memset(_buffers[i].memory, FRAME_ARENA_POISON, capacity);
+#endif
+        }
+    }
+
+    void* FrameArena::alloc(size_t size, size_t alignment)
+    {
+        NW_ASSERT((alignment & (alignment - 1)) == 0);
+
+        Buffer& buffer = _buffers[_current];
+        if (buffer.memory == nullptr) { return nullptr; }
+
+        //Only bump the pointer if the allocation fits, so one large request
+        //doesn't use up the rest of the buffer
+        size_t used = buffer.used.load(std::memory_order_relaxed);
+        uintptr_t address;
+        size_t end;
+        do
+        {
+            address = ((uintptr_t)buffer.memory + used + alignment - 1) & ~(uintptr_t)(alignment - 1);
+            end = (size_t)(address - (uintptr_t)buffer.memory) + size;
+            if (end > _capacity) { return nullptr; }
+        }
+        while (!buffer.used.compare_exchange_weak(used, end, std::memory_order_relaxed));
+
+        return (void*)address;
+    }
+
+    bool FrameArena::owns(const void* ptr) const
+    {
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            const uint8_t* memory = _buffers[i].memory;
+            if (memory != nullptr && (const uint8_t*)ptr >= memory && (const uint8_t*)ptr < memory + _capacity)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void FrameArena::endFrame()
+    {
+        size_t used = _buffers[_current].used.load();
+        if (used > _highWaterMark) { _highWaterMark = used; }
+
+        //The other buffer holds the previous frame's data, which is done now
+        _current ^= 1;
+        Buffer& buffer = _buffers[_current];
+#ifdef NW_DEBUG
+        if (buffer.memory != nullptr) { memset(buffer.memory, FRAME_ARENA_POISON, buffer.used.load()); }
+#endif
+        buffer.used.store(0);
+    }
+
+    FrameArenaStats FrameArena::getStats() const
+    {
+        FrameArenaStats stats;
+        stats.capacity = _capacity;
+        stats.used = _buffers[_current].used.load();
+        stats.highWaterMark = (stats.used > _highWaterMark) ? stats.used : _highWaterMark;
+        stats.overflowCount = _overflowCount.load();
+        return stats;
+    }
+
+
+
+    void* FrameAllocator::allocate(size_t n, int flags)
+    {
+        return allocate(n, EASTL_ALLOCATOR_MIN_ALIGNMENT, 0, flags);
+    }
+
+    void* FrameAllocator::allocate(size_t n, size_t alignment, size_t offset, int flags)
+    {
+        NW_ASSERT(offset == 0);
+        if (alignment < EASTL_ALLOCATOR_MIN_ALIGNMENT) { alignment = EASTL_ALLOCATOR_MIN_ALIGNMENT; }
+
+        void* ptr = g_FrameArena.alloc(n, alignment);
+        if (ptr == nullptr)
+        {
+            g_FrameArena.recordOverflow();
+            ptr = eastl::allocator().allocate(n, alignment, offset, flags);
+        }
+        return ptr;
+    }
+
+    void FrameAllocator::deallocate(void* p, size_t n)
+    {
+        if (!g_FrameArena.owns(p))
+        {
+            eastl::allocator().deallocate(p, n);
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef MEMORY_FRAME_ARENA_H
+#define MEMORY_FRAME_ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <EASTL/allocator.h>
+#include <EASTL/vector.h>
+
+namespace memory
+{
+    struct FrameArenaStats
+    {
+        size_t capacity;        //Per buffer
+        size_t used;            //This frame so far
+        size_t highWaterMark;   //Most used in any one frame
+        uint32_t overflowCount; //Allocations that didn't fit and went to the heap
+    };
+
+    //Linear allocator for transient data. Allocating bumps a pointer and the
+    //memory is never freed individually, endFrame() resets it all at once.
+    //
+    //There are two buffers that swap every frame, so memory allocated during
+    //one frame stays valid until the end of the next one. Anything that needs
+    //to live longer than that doesn't belong here.
+    //
+    //Allocating is lock free and safe from jobs. endFrame() must only be called
+    //while nothing else is allocating.
+    class FrameArena
+    {
+    private:
+        struct Buffer
+        {
+            uint8_t* memory;
+            std::atomic<size_t> used;
+        };
+
+        Buffer _buffers[2];
+        uint32_t _current;
+        size_t _capacity;
+        size_t _highWaterMark;
+        std::atomic<uint32_t> _overflowCount;
+
+        FrameArena(const FrameArena&);
+        FrameArena& operator=(const FrameArena&);
+
+    public:
+        FrameArena();
+        ~FrameArena();
+
+        void init(size_t capacity);
+
+        //Returns null when the current buffer is full
+        void* alloc(size_t size, size_t alignment = 16);
+        bool owns(const void* ptr) const;
+
+        void endFrame();
+
+        FrameArenaStats getStats() const;
+
+        //Counted by allocators that fall back to the heap
+        void recordOverflow() { _overflowCount.fetch_add(1, std::memory_order_relaxed); }
+    };
+
+    //The arena the engine resets at the end of every frame
+    extern FrameArena g_FrameArena;
+
+    //EASTL allocator for containers that only live for a frame. Allocations
+    //that don't fit in the frame arena go to the heap instead, deallocating
+    //only frees those.
+    class FrameAllocator
+    {
+    public:
+        FrameAllocator(const char* = nullptr) { }
+        FrameAllocator(const FrameAllocator&, const char*) { }
+
+        void* allocate(size_t n, int flags = 0);
+        void* allocate(size_t n, size_t alignment, size_t offset, int flags = 0);
+        void deallocate(void* p, size_t n);
+
+        const char* get_name() const { return "FrameAllocator"; }
+        void set_name(const char*) { }
+    };
+
+    inline bool operator==(const FrameAllocator&, const FrameAllocator&) { return true; }
+    inline bool operator!=(const FrameAllocator&, const FrameAllocator&) { return false; }
+
+    template <typename T>
+    using FrameVector = eastl::vector<T, FrameAllocator>;
+}
+
+#endif
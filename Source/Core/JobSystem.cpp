@@ -0,0 +1,319 @@
+#include "Core/Core.h"
+#include "JobSystem.h"
+
+namespace nw
+{
+    static thread_local uint32_t sThreadIndex = 0;
+
+    JobSystem::JobSystem() :
+        _threadCount(1),
+        _queues(nullptr),
+        _workers(nullptr),
+        _queuedCount(0),
+        _sleepingCount(0),
+        _running(false)
+    {
+    }
+
+    JobSystem::~JobSystem()
+    {
+        shutdown();
+    }
+
+    void JobSystem::init(uint32_t workerCount)
+    {
+        NW_ASSERT(_queues == nullptr);
+
+        _threadCount = workerCount + 1;
+        _queues = new WorkerQueue[_threadCount];
+        _running.store(true);
+
+        if (workerCount > 0)
+        {
+            _workers = new std::thread[workerCount];
+            for (uint32_t i = 0; i < workerCount; i++)
+            {
+                _workers[i] = std::thread(&JobSystem::workerMain, this, i + 1);
+            }
+        }
+    }
+
+    void JobSystem::shutdown()
+    {
+        if (_queues == nullptr) { return; }
+
+        {
+            std::lock_guard<std::mutex> lock(_sleepMutex);
+            _running.store(false);
+        }
+        _sleepCond.notify_all();
+
+        for (uint32_t i = 0; i < _threadCount - 1; i++)
+        {
+            _workers[i].join();
+        }
+
+        delete[] _workers;
+        delete[] _queues;
+        _workers = nullptr;
+        _queues = nullptr;
+        _threadCount = 1;
+    }
+
+    uint32_t JobSystem::getDefaultWorkerCount()
+    {
+        uint32_t cores = std::thread::hardware_concurrency();
+        return (cores > 1) ? cores - 1 : 0;
+    }
+
+    void JobSystem::run(const Job& job)
+    {
+        if (job.counter != nullptr) { job.counter->fetch_add(1); }
+
+        if (isSingleThreaded())
+        {
+            execute(job);
+            return;
+        }
+
+        WorkerQueue& queue = _queues[sThreadIndex];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.push_back(job);
+        }
+        _queuedCount.fetch_add(1);
+
+        //Sleeping workers check the queued count under the sleep mutex,
+        //so taking it here makes sure the wake up can't be missed
+        if (_sleepingCount.load() > 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(_sleepMutex);
+            }
+            _sleepCond.notify_one();
+        }
+    }
+
+    void JobSystem::run(JobFn fn, void* data, JobCounter* counter)
+    {
+        Job job = { fn, data, 0, 1, counter };
+        run(job);
+    }
+
+    void JobSystem::parallelFor(JobFn fn, void* data, uint32_t count, uint32_t grainSize, JobCounter* counter)
+    {
+        if (count == 0) { return; }
+
+        if (grainSize == 0)
+        {
+            grainSize = count / (_threadCount * 4);
+            if (grainSize == 0) { grainSize = 1; }
+        }
+
+        //Single threaded mode takes the whole range at once
+        if (isSingleThreaded())
+        {
+            grainSize = count;
+        }
+
+        for (uint32_t begin = 0; begin < count; begin += grainSize)
+        {
+            uint32_t end = (count - begin > grainSize) ? begin + grainSize : count;
+            Job job = { fn, data, begin, end, counter };
+            run(job);
+        }
+    }
+
+    void JobSystem::wait(JobCounter* counter)
+    {
+        uint32_t threadIndex = sThreadIndex;
+        while (counter->load(std::memory_order_acquire) > 0)
+        {
+            if (!tryRunJob(threadIndex))
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    uint32_t JobSystem::getThreadIndex() const
+    {
+        return sThreadIndex;
+    }
+
+    void JobSystem::workerMain(uint32_t threadIndex)
+    {
+        sThreadIndex = threadIndex;
+
+        while (true)
+        {
+            if (tryRunJob(threadIndex)) { continue; }
+
+            std::unique_lock<std::mutex> lock(_sleepMutex);
+            _sleepingCount.fetch_add(1);
+            while (_queuedCount.load() == 0 && _running.load())
+            {
+                _sleepCond.wait(lock);
+            }
+            _sleepingCount.fetch_sub(1);
+
+            if (!_running.load()) { break; }
+        }
+    }
+
+    bool JobSystem::popJob(uint32_t threadIndex, Job& job)
+    {
+        if (_queuedCount.load() == 0) { return false; }
+
+        //Newest job from our own queue first, it's the most likely to be in cache
+        {
+            WorkerQueue& queue = _queues[threadIndex];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.jobs.empty())
+            {
+                job = queue.jobs.back();
+                queue.jobs.pop_back();
+                _queuedCount.fetch_sub(1);
+                return true;
+            }
+        }
+
+        //Then steal the oldest job from someone else
+        for (uint32_t i = 1; i < _threadCount; i++)
+        {
+            WorkerQueue& queue = _queues[(threadIndex + i) % _threadCount];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.jobs.empty())
+            {
+                job = queue.jobs.front();
+                queue.jobs.pop_front();
+                _queuedCount.fetch_sub(1);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool JobSystem::tryRunJob(uint32_t threadIndex)
+    {
+        Job job;
+        if (!popJob(threadIndex, job)) { return false; }
+
+        execute(job);
+        return true;
+    }
+
+    void JobSystem::execute(const Job& job)
+    {
+        job.fn(job.data, job.begin, job.end);
+        if (job.counter != nullptr) { job.counter->fetch_sub(1, std::memory_order_release); }
+    }
+
+
+
+    JobStage::JobStage() :
+        _taskCount(0),
+        _jobSystem(nullptr),
+        _counter(0)
+    {
+    }
+
+    void JobStage::add(const char* name, TaskFn fn, void* data, uint32_t reads, uint32_t writes)
+    {
+        NW_REQUIRE(_taskCount < MAX_TASKS);
+
+        Task& task = _tasks[_taskCount++];
+        task.name = name;
+        task.fn = fn;
+        task.data = data;
+        task.reads = reads;
+        task.writes = writes;
+        task.successors = 0;
+    }
+
+    void JobStage::execute(JobSystem& jobSystem)
+    {
+        //Dependencies only ever point to earlier tasks, so the order they
+        //were added in is always a valid order to run them in
+        if (jobSystem.isSingleThreaded())
+        {
+            for (uint32_t i = 0; i < _taskCount; i++)
+            {
+                SCOPED_CPU_EVENT(event)(0xFFFFFFFF, _tasks[i].name);
+                _tasks[i].fn(_tasks[i].data);
+            }
+            _taskCount = 0;
+            return;
+        }
+
+        _jobSystem = &jobSystem;
+
+        //A task waits on every earlier task it conflicts with
+        uint32_t ready = 0;
+        for (uint32_t i = 0; i < _taskCount; i++)
+        {
+            Task& task = _tasks[i];
+            uint32_t waitCount = 0;
+            for (uint32_t j = 0; j < i; j++)
+            {
+                Task& earlier = _tasks[j];
+                if ((earlier.writes & (task.reads | task.writes)) != 0 ||
+                    (earlier.reads & task.writes) != 0)
+                {
+                    earlier.successors |= 1u << i;
+                    waitCount++;
+                }
+            }
+            _waitCounts[i].store(waitCount);
+            if (waitCount == 0) { ready |= 1u << i; }
+        }
+
+        //Count every task up front so the stage can't look finished early.
+        //The ready set is taken before scheduling anything, since running
+        //tasks release (and schedule) their successors themselves.
+        _counter.store(_taskCount);
+        for (uint32_t i = 0; i < _taskCount; i++)
+        {
+            if (ready & (1u << i))
+            {
+                schedule(i);
+            }
+        }
+
+        jobSystem.wait(&_counter);
+        _taskCount = 0;
+    }
+
+    void JobStage::schedule(uint32_t taskIndex)
+    {
+        Job job = { runTask, this, taskIndex, taskIndex + 1, nullptr };
+        _jobSystem->run(job);
+    }
+
+    void JobStage::runTask(void* data, uint32_t begin, uint32_t)
+    {
+        JobStage* stage = (JobStage*)data;
+        Task& task = stage->_tasks[begin];
+        {
+            SCOPED_CPU_EVENT(event)(0xFFFFFFFF, task.name);
+            task.fn(task.data);
+        }
+
+        //Release the tasks that were waiting on this one
+        uint32_t successors = task.successors;
+        while (successors != 0)
+        {
+            uint32_t next = 0;
+            while ((successors & (1u << next)) == 0) { next++; }
+            successors &= ~(1u << next);
+
+            if (stage->_waitCounts[next].fetch_sub(1) == 1)
+            {
+                stage->schedule(next);
+            }
+        }
+
+        stage->_counter.fetch_sub(1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,141 @@
+#ifndef CORE_JOB_SYSTEM_H
+#define CORE_JOB_SYSTEM_H
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <EASTL/deque.h>
+
+namespace nw
+{
+    //Counts the jobs that haven't finished yet. Jobs are added to it when
+    //they are submitted and removed once they've run.
+    typedef std::atomic<uint32_t> JobCounter;
+
+    //Jobs work on the [begin, end) range of whatever data points to
+    typedef void (*JobFn)(void* data, uint32_t begin, uint32_t end);
+
+    struct Job
+    {
+        JobFn fn;
+        void* data;
+        uint32_t begin;
+        uint32_t end;
+        JobCounter* counter;
+    };
+
+    //Work stealing job system.
+    //
+    //Every thread (the main thread is thread 0) has its own queue. Jobs are
+    //pushed onto the queue of the thread that submits them, which works
+    //through its own queue newest first and steals the oldest jobs from the
+    //other queues when it runs dry.
+    //
+    //With no workers the job system runs in single threaded mode: jobs run
+    //immediately on the submitting thread in the order they are submitted,
+    //which makes runs deterministic for debugging.
+    class JobSystem
+    {
+    private:
+        struct WorkerQueue
+        {
+            std::mutex mutex;
+            eastl::deque<Job> jobs;
+        };
+
+        uint32_t _threadCount;
+        WorkerQueue* _queues;
+        std::thread* _workers;
+
+        std::atomic<uint32_t> _queuedCount;
+        std::atomic<uint32_t> _sleepingCount;
+        std::atomic<bool> _running;
+        std::mutex _sleepMutex;
+        std::condition_variable _sleepCond;
+
+        JobSystem(const JobSystem&);
+        JobSystem& operator=(const JobSystem&);
+
+    public:
+        JobSystem();
+        ~JobSystem();
+
+        //A worker count of 0 is the deterministic single threaded mode
+        void init(uint32_t workerCount);
+        void shutdown();
+
+        //Worker count that leaves one core for the main thread
+        static uint32_t getDefaultWorkerCount();
+
+        void run(const Job& job);
+        void run(JobFn fn, void* data, JobCounter* counter);
+
+        //Splits [0, count) into ranges of grainSize elements, each run as a job.
+        //A grain size of 0 picks one that gives every thread a few ranges.
+        void parallelFor(JobFn fn, void* data, uint32_t count, uint32_t grainSize, JobCounter* counter);
+
+        //Runs jobs on the calling thread until the counter reaches zero
+        void wait(JobCounter* counter);
+
+        //Index of the calling thread, 0 for the main thread
+        uint32_t getThreadIndex() const;
+        uint32_t getThreadCount() const { return _threadCount; }
+        bool isSingleThreaded() const { return _threadCount == 1; }
+
+    private:
+        void workerMain(uint32_t threadIndex);
+        bool popJob(uint32_t threadIndex, Job& job);
+        bool tryRunJob(uint32_t threadIndex);
+        static void execute(const Job& job);
+    };
+
+
+
+    //Tasks that declare the data they read and write as bit masks.
+    //Tasks that touch the same data, where at least one of them writes it,
+    //run in the order they were added. Everything else may run concurrently.
+    //Tasks are free to use the job system themselves. In single threaded
+    //mode the tasks simply run in the order they were added.
+    class JobStage
+    {
+    public:
+        typedef void (*TaskFn)(void* data);
+        static const uint32_t MAX_TASKS = 32;
+
+    private:
+        struct Task
+        {
+            const char* name;
+            TaskFn fn;
+            void* data;
+            uint32_t reads;
+            uint32_t writes;
+            uint32_t successors;    //Bit per task that waits on this one
+        };
+
+        Task _tasks[MAX_TASKS];
+        std::atomic<uint32_t> _waitCounts[MAX_TASKS];
+        uint32_t _taskCount;
+        JobSystem* _jobSystem;
+        JobCounter _counter;
+
+        JobStage(const JobStage&);
+        JobStage& operator=(const JobStage&);
+
+    public:
+        JobStage();
+
+        void add(const char* name, TaskFn fn, void* data, uint32_t reads, uint32_t writes);
+
+        //Runs every task added since the last call and waits for them to finish
+        void execute(JobSystem& jobSystem);
+
+    private:
+        static void runTask(void* data, uint32_t begin, uint32_t end);
+        void schedule(uint32_t taskIndex);
+    };
+}
+
+#endif
@@ -0,0 +1,205 @@
+#include "Core/Core.h"
+#include "MemoryTracker.h"
+#include <atomic>
+#include <mutex>
+#include <stdio.h>
+
+namespace memory
+{
+    static const char* MEMORY_TAG_NAMES[MEMORY_TAG_COUNT] =
+    {
+        "General",
+        "Scene",
+        "Script",
+        "Asset",
+        "Render"
+    };
+
+    struct TagCounters
+    {
+        std::atomic<size_t> liveBytes;
+        std::atomic<size_t> peakBytes;
+        std::atomic<uint32_t> liveCount;
+        std::atomic<uint64_t> totalCount;
+        uint64_t frameStartCount;
+        uint64_t lastFrameCount;
+    };
+
+    //Allocations happen before any static constructor runs, so everything
+    //here relies on zero initialisation
+    static TagCounters sTagCounters[MEMORY_TAG_COUNT];
+    static TagCounters sTotalCounters;
+    static thread_local MemoryTag sCurrentTag = MemoryTag::General;
+
+#ifdef NW_MEMORY_SITES
+    static const uint32_t SITE_TABLE_SIZE = 4096;
+    static MemorySite sSites[SITE_TABLE_SIZE];
+    static uint32_t sSiteOverflow;          //Allocations from sites that didn't fit in the table
+    static std::mutex sSiteMutex;
+
+    static void recordSite(const void* site, size_t size)
+    {
+        uint32_t hash = (uint32_t)((uintptr_t)site >> 2) * 2654435761u;
+
+        std::lock_guard<std::mutex> lock(sSiteMutex);
+        for (uint32_t i = 0; i < SITE_TABLE_SIZE; i++)
+        {
+            MemorySite& entry = sSites[(hash + i) & (SITE_TABLE_SIZE - 1)];
+            if (entry.address == site || entry.address == nullptr)
+            {
+                entry.address = site;
+                entry.count++;
+                entry.bytes += size;
+                return;
+            }
+        }
+        sSiteOverflow++;
+    }
+#endif
+
+    static void addAlloc(TagCounters& counters, size_t size)
+    {
+        size_t live = counters.liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+        counters.liveCount.fetch_add(1, std::memory_order_relaxed);
+        counters.totalCount.fetch_add(1, std::memory_order_relaxed);
+
+        size_t peak = counters.peakBytes.load(std::memory_order_relaxed);
+        while (live > peak && !counters.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) { }
+    }
+
+    static void removeAlloc(TagCounters& counters, size_t size)
+    {
+        counters.liveBytes.fetch_sub(size, std::memory_order_relaxed);
+        counters.liveCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    static MemoryTagStats getStats(const TagCounters& counters)
+    {
+        MemoryTagStats stats;
+        stats.liveBytes = counters.liveBytes.load(std::memory_order_relaxed);
+        stats.peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+        stats.liveCount = counters.liveCount.load(std::memory_order_relaxed);
+        stats.totalCount = counters.totalCount.load(std::memory_order_relaxed);
+        stats.lastFrameCount = counters.lastFrameCount;
+        return stats;
+    }
+
+    static void endFrame(TagCounters& counters)
+    {
+        uint64_t total = counters.totalCount.load(std::memory_order_relaxed);
+        counters.lastFrameCount = total - counters.frameStartCount;
+        counters.frameStartCount = total;
+    }
+
+
+
+    const char* getMemoryTagName(MemoryTag tag)
+    {
+        NW_ASSERT((uint32_t)tag < MEMORY_TAG_COUNT);
+        return MEMORY_TAG_NAMES[(uint32_t)tag];
+    }
+
+    MemoryTag getCurrentMemoryTag()
+    {
+        return sCurrentTag;
+    }
+
+    MemoryTag setCurrentMemoryTag(MemoryTag tag)
+    {
+        MemoryTag previous = sCurrentTag;
+        sCurrentTag = tag;
+        return previous;
+    }
+
+    void trackAlloc(MemoryTag tag, size_t size, const void* site)
+    {
+        addAlloc(sTagCounters[(uint32_t)tag], size);
+        addAlloc(sTotalCounters, size);
+#ifdef NW_MEMORY_SITES
+        recordSite(site, size);
+#else
+        NW_UNUSED(site);
+#endif
+    }
+
+    void trackFree(MemoryTag tag, size_t size)
+    {
+        removeAlloc(sTagCounters[(uint32_t)tag], size);
+        removeAlloc(sTotalCounters, size);
+    }
+
+    MemoryTagStats getMemoryTagStats(MemoryTag tag)
+    {
+        NW_ASSERT((uint32_t)tag < MEMORY_TAG_COUNT);
+        return getStats(sTagCounters[(uint32_t)tag]);
+    }
+
+    MemoryTagStats getTotalMemoryStats()
+    {
+        return getStats(sTotalCounters);
+    }
+
+    uint32_t getTopMemorySites(MemorySite* out, uint32_t maxSites)
+    {
+#ifdef NW_MEMORY_SITES
+        if (maxSites == 0) { return 0; }
+        std::lock_guard<std::mutex> lock(sSiteMutex);
+
+        //Insertion into a sorted list of the top sites so far
+        uint32_t found = 0;
+        for (uint32_t i = 0; i < SITE_TABLE_SIZE; i++)
+        {
+            const MemorySite& site = sSites[i];
+            if (site.address == nullptr) { continue; }
+            if (found == maxSites && site.count <= out[found - 1].count) { continue; }
+
+            uint32_t j = (found < maxSites) ? found++ : found - 1;
+            while (j > 0 && out[j - 1].count < site.count)
+            {
+                out[j] = out[j - 1];
+                j--;
+            }
+            out[j] = site;
+        }
+        return found;
+#else
+        NW_UNUSED(out);
+        NW_UNUSED(maxSites);
+        return 0;
+#endif
+    }
+
+    void endMemoryFrame()
+    {
+        for (uint32_t i = 0; i < MEMORY_TAG_COUNT; i++)
+        {
+            endFrame(sTagCounters[i]);
+        }
+        endFrame(sTotalCounters);
+    }
+
+    void printMemoryStats()
+    {
+        printf("%-8s %10s %10s %10s %12s %10s\n", "Tag", "Live KB", "Peak KB", "Live", "Allocations", "Per frame");
+        for (uint32_t i = 0; i <= MEMORY_TAG_COUNT; i++)
+        {
+            MemoryTagStats stats = (i < MEMORY_TAG_COUNT) ? getMemoryTagStats((MemoryTag)i) : getTotalMemoryStats();
+            printf("%-8s %10u %10u %10u %12llu %10llu\n",
+                (i < MEMORY_TAG_COUNT) ? MEMORY_TAG_NAMES[i] : "Total",
+                (uint32_t)(stats.liveBytes / 1024), (uint32_t)(stats.peakBytes / 1024), stats.liveCount,
+                (unsigned long long)stats.totalCount, (unsigned long long)stats.lastFrameCount);
+        }
+
+#ifdef NW_MEMORY_SITES
+        const uint32_t TOP_SITE_COUNT = 16;
+        MemorySite sites[TOP_SITE_COUNT];
+        uint32_t siteCount = getTopMemorySites(sites, TOP_SITE_COUNT);
+        printf("Top allocation sites:\n");
+        for (uint32_t i = 0; i < siteCount; i++)
+        {
+            printf("  %p %10u allocations %10u KB\n", sites[i].address, sites[i].count, (uint32_t)(sites[i].bytes / 1024));
+        }
+        if (sSiteOverflow > 0) { printf("  %u allocations from untracked sites\n", sSiteOverflow); }
+#endif
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef MEMORY_MEMORY_TRACKER_H
+#define MEMORY_MEMORY_TRACKER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace memory
+{
+    //Subsystem heap allocations are charged to, see ScopedMemoryTag
+    enum class MemoryTag : uint8_t
+    {
+        General,
+        Scene,
+        Script,
+        Asset,
+        Render,
+        Count
+    };
+
+    static const uint32_t MEMORY_TAG_COUNT = (uint32_t)MemoryTag::Count;
+
+    struct MemoryTagStats
+    {
+        size_t liveBytes;
+        size_t peakBytes;
+        uint32_t liveCount;
+        uint64_t totalCount;        //Allocations ever made
+        uint64_t lastFrameCount;    //Allocations made during the last full frame
+    };
+
+    struct MemorySite
+    {
+        const void* address;        //Return address of the allocating call
+        uint32_t count;
+        size_t bytes;
+    };
+
+    const char* getMemoryTagName(MemoryTag tag);
+
+    //Tag new allocations on the calling thread are charged to
+    MemoryTag getCurrentMemoryTag();
+    //Returns the previous tag
+    MemoryTag setCurrentMemoryTag(MemoryTag tag);
+
+    //Called by the operator new/delete overrides
+    void trackAlloc(MemoryTag tag, size_t size, const void* site);
+    void trackFree(MemoryTag tag, size_t size);
+
+    MemoryTagStats getMemoryTagStats(MemoryTag tag);
+    MemoryTagStats getTotalMemoryStats();
+    //Fills out with the sites that allocated most often, returns how many
+    //were written. Always 0 without NW_MEMORY_SITES.
+    uint32_t getTopMemorySites(MemorySite* out, uint32_t maxSites);
+
+    //Closes the frame used for the per frame allocation counts
+    void endMemoryFrame();
+    void printMemoryStats();
+
+    //Charges heap allocations made on this thread to a tag until the end of
+    //the scope. Scopes nest, the innermost wins.
+    class ScopedMemoryTag
+    {
+    private:
+#ifdef NW_MEMORY_TRACKING
+        MemoryTag _previous;
+#endif
+
+        ScopedMemoryTag(const ScopedMemoryTag&);
+        ScopedMemoryTag& operator=(const ScopedMemoryTag&);
+
+    public:
+#ifdef NW_MEMORY_TRACKING
+        ScopedMemoryTag(MemoryTag tag) : _previous(setCurrentMemoryTag(tag)) { }
+        ~ScopedMemoryTag() { setCurrentMemoryTag(_previous); }
+#else
+        ScopedMemoryTag(MemoryTag) { }
+#endif
+    };
+}
+
+#endif
@@ -1,67 +1,131 @@
 #include "Core/Core.h"
+#include "Core/MemoryTracker.h"
 #include <stddef.h>
+#include <cstddef>
 
-void* operator new[](size_t size, const char* /*name*/, int /*flags*/,
-                     unsigned /*debugFlags*/, const char* /*file*/, int /*line*/)
+//Plain new promises blocks aligned for any fundamental type, the aligned
+//malloc functions only round a request of 1 up to pointer size
+static const size_t DEFAULT_NEW_ALIGNMENT = alignof(std::max_align_t);
+
+#ifdef NW_MEMORY_TRACKING
+
+//Tracked blocks start with a header holding the size and tag, so delete can
+//credit the counters the allocation was charged to. The alignment offset is
+//moved past the header, so the caller's alignment still applies.
+struct AllocHeader
 {
-#if defined(_MSC_VER)
-    return _aligned_offset_malloc(size, 1, 0);
+    size_t size;
+    uint32_t tag;
+};
+
+static const size_t ALLOC_HEADER_SIZE = 16;
+
+static void* allocate(size_t size, size_t alignment, size_t alignmentOffset, const void* site)
+{
+    static_assert(sizeof(AllocHeader) <= ALLOC_HEADER_SIZE, "Header doesn't fit");
+
+    uint8_t* block = (uint8_t*)_aligned_offset_malloc(size + ALLOC_HEADER_SIZE, alignment, alignmentOffset + ALLOC_HEADER_SIZE);
+    if (block == nullptr) { return nullptr; }
+
+    AllocHeader header;
+    header.size = size;
+    header.tag = (uint32_t)memory::getCurrentMemoryTag();
+    memcpy(block, &header, sizeof(header));
+
+    memory::trackAlloc((memory::MemoryTag)header.tag, size, site);
+    return block + ALLOC_HEADER_SIZE;
+}
+
+static void deallocate(void* p)
+{
+    if (p == nullptr) { return; }
+
+    //Offset blocks from EASTL may leave the header unaligned
+    uint8_t* block = (uint8_t*)p - ALLOC_HEADER_SIZE;
+    AllocHeader header;
+    memcpy(&header, block, sizeof(header));
+
+    memory::trackFree((memory::MemoryTag)header.tag, header.size);
+    _aligned_free(block);
+}
+
 #else
-#error Not implemented
+
+static NW_FORCEINLINE void* allocate(size_t size, size_t alignment, size_t alignmentOffset, const void*)
+{
+    return _aligned_offset_malloc(size, alignment, alignmentOffset);
+}
+
+static NW_FORCEINLINE void deallocate(void* p)
+{
+    if (p) { _aligned_free(p); }
+}
+
 #endif
+
+void* operator new[](size_t size, const char* /*name*/, int /*flags*/,
+                     unsigned /*debugFlags*/, const char* /*file*/, int /*line*/)
+{
+    return allocate(size, DEFAULT_NEW_ALIGNMENT, 0, NW_RETURN_ADDRESS());
 }
 
 void* operator new[](size_t size, size_t alignment, size_t alignmentOffset, const char* /*name*/,
                      int flags, unsigned /*debugFlags*/, const char* /*file*/, int /*line*/)
 {
     NW_UNUSED(flags);
-#if defined(_MSC_VER)
-    return _aligned_offset_malloc(size, alignment, alignmentOffset);
-#else
-#error Not implemented
-#endif
+    return allocate(size, alignment, alignmentOffset, NW_RETURN_ADDRESS());
 }
 
 void* operator new(size_t size)
 {
-#if defined(_MSC_VER)
-    return _aligned_offset_malloc(size, 1, 0);
-#else
-#error Not implemented
-#endif
+    return allocate(size, DEFAULT_NEW_ALIGNMENT, 0, NW_RETURN_ADDRESS());
 }
 
 void* operator new[](size_t size)
 {
-#if defined(_MSC_VER)
-    return _aligned_offset_malloc(size, 1, 0);
-#else
-#error Not implemented
-#endif
+    return allocate(size, DEFAULT_NEW_ALIGNMENT, 0, NW_RETURN_ADDRESS());
+}
+
+//Some runtimes implement these with malloc rather than the overrides above,
+//which delete couldn't tell apart from a tracked block
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size, DEFAULT_NEW_ALIGNMENT, 0, NW_RETURN_ADDRESS());
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size, DEFAULT_NEW_ALIGNMENT, 0, NW_RETURN_ADDRESS());
 }
 
 void operator delete(void* p)
 {
-    if (p)
-    {
-#if defined(_MSC_VER)
-        return _aligned_free(p);
-#else
-#error Not implemented
-#endif
-    }
+    deallocate(p);
 }
 
 void operator delete[](void* p)
 {
-    if (p)
-    {
-#if defined(_MSC_VER)
-        return _aligned_free(p);
-#else
-#error Not implemented
-#endif
-    }
+    deallocate(p);
+}
+
+void operator delete(void* p, size_t /*size*/) noexcept
+{
+    deallocate(p);
+}
+
+void operator delete[](void* p, size_t /*size*/) noexcept
+{
+    deallocate(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    deallocate(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    deallocate(p);
 }
 
 
@@ -0,0 +1,397 @@
+#include "Core/Core.h"
+#include "Profiler.h"
+#include <atomic>
+#include <mutex>
+#include <cstdio>
+#include <time.h>
+#include <EASTL/hash_set.h>
+#include <EASTL/sort.h>
+#include <rapidjson/writer.h>
+#include <rapidjson/stringbuffer.h>
+#include "Util/File.h"
+
+namespace profiler
+{
+    const uint32_t ZONE_BUFFER_SIZE = 16 * 1024;    //Zones per thread between endFrame() calls, power of two
+    const uint32_t MAX_THREADS = 64;
+    const uint32_t ZONE_HISTORY_FRAMES = 128;
+    const uint32_t ZONE_CACHE_SIZE = 256;          //Power of two
+
+    struct ZoneEvent
+    {
+        const char* name;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    //Single producer ring, written by its thread and drained by endFrame()
+    struct ThreadBuffer
+    {
+        ZoneEvent events[ZONE_BUFFER_SIZE];
+        std::atomic<uint32_t> writeIndex;
+        std::atomic<uint32_t> readIndex;
+        std::atomic<uint32_t> dropped;      //Zones lost to a full buffer
+    };
+
+    struct Zone
+    {
+        const char* name;
+        uint64_t frameTicks;
+        uint32_t frameCalls;
+
+        float history[ZONE_HISTORY_FRAMES];     //Milliseconds per frame, in the frames it ran
+        uint32_t callHistory[ZONE_HISTORY_FRAMES];
+        uint32_t historyCount;
+        uint32_t historyNext;
+    };
+
+    struct ZoneCacheEntry
+    {
+        const char* name;
+        Zone* zone;
+    };
+
+    struct CapturedZone
+    {
+        ZoneEvent event;
+        uint32_t threadIndex;
+    };
+
+    static ThreadBuffer* sBuffers[MAX_THREADS];
+    static std::atomic<uint32_t> sBufferCount;
+    static std::mutex sRegisterMutex;
+    static thread_local ThreadBuffer* tBuffer = nullptr;
+
+    static uint64_t sStartTicks;
+    static uint64_t sStartNs;
+    static double sNsPerTick = 1.0;
+
+    //Zones are looked up by pointer first, the same name can come from
+    //several string literals
+    static eastl::vector<Zone*> sZones;
+    static eastl::hash_map<const char*, uint32_t> sZonesByPointer;
+    static eastl::hash_map<const char*, uint32_t, eastl::hash<const char*>, eastl::str_equal_to<const char*>> sZonesByName;
+    //Direct mapped by pointer in front of the maps, draining looks up every zone
+    static ZoneCacheEntry sZoneCache[ZONE_CACHE_SIZE];
+    static uint32_t sDroppedZones;
+
+    static eastl::vector<CapturedZone> sCapture;
+    static uint32_t sCaptureFramesLeft;
+    static eastl::string sCaptureFile;
+
+    static std::mutex sNameMutex;
+    static eastl::hash_set<const char*, eastl::hash<const char*>, eastl::str_equal_to<const char*>> sNames;
+
+    static uint64_t getWallNs()
+    {
+#ifdef PLATFORM_WINDOWS
+        LARGE_INTEGER counter, frequency;
+        QueryPerformanceCounter(&counter);
+        QueryPerformanceFrequency(&frequency);
+        return (uint64_t)((double)counter.QuadPart * 1000000000.0 / (double)frequency.QuadPart);
+#else
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+#endif
+    }
+
+    static void calibrate()
+    {
+        if (sStartNs == 0) { return; }
+        uint64_t elapsedTicks = getTicks() - sStartTicks;
+        uint64_t elapsedNs = getWallNs() - sStartNs;
+        if (elapsedTicks > 0) { sNsPerTick = (double)elapsedNs / (double)elapsedTicks; }
+    }
+
+    static ThreadBuffer* registerThread()
+    {
+        std::lock_guard<std::mutex> lock(sRegisterMutex);
+
+        uint32_t index = sBufferCount.load(std::memory_order_relaxed);
+        NW_ASSERT(index < MAX_THREADS);
+        if (index >= MAX_THREADS) { return nullptr; }
+
+        ThreadBuffer* buffer = new ThreadBuffer;
+        buffer->writeIndex.store(0);
+        buffer->readIndex.store(0);
+        buffer->dropped.store(0);
+
+        sBuffers[index] = buffer;
+        sBufferCount.store(index + 1, std::memory_order_release);
+        tBuffer = buffer;
+        return buffer;
+    }
+
+    static Zone* findZone(const char* name)
+    {
+        auto search = sZonesByPointer.find(name);
+        if (search != sZonesByPointer.end()) { return sZones[search->second]; }
+
+        uint32_t index;
+        auto nameSearch = sZonesByName.find(name);
+        if (nameSearch != sZonesByName.end())
+        {
+            index = nameSearch->second;
+        }
+        else
+        {
+            Zone* zone = new Zone;
+            memset(zone, 0, sizeof(Zone));
+            zone->name = name;
+
+            index = (uint32_t)sZones.size();
+            sZones.push_back(zone);
+            sZonesByName.insert(eastl::make_pair(name, index));
+        }
+        sZonesByPointer.insert(eastl::make_pair(name, index));
+        return sZones[index];
+    }
+
+    static Zone* getZone(const char* name)
+    {
+        ZoneCacheEntry& entry = sZoneCache[((uintptr_t)name >> 3) & (ZONE_CACHE_SIZE - 1)];
+        if (entry.name != name)
+        {
+            entry.name = name;
+            entry.zone = findZone(name);
+        }
+        return entry.zone;
+    }
+
+    static bool compareZoneStats(const ZoneStats& a, const ZoneStats& b)
+    {
+        return a.avgMs > b.avgMs;
+    }
+
+    static void writeTrace()
+    {
+        rapidjson::StringBuffer buf;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buf);
+
+        writer.StartObject();
+        writer.Key("displayTimeUnit");
+        writer.String("ms");
+        writer.Key("traceEvents");
+        writer.StartArray();
+
+        uint32_t threadCount = sBufferCount.load(std::memory_order_acquire);
+        char threadName[32];
+        for (uint32_t i = 0; i < threadCount; i++)
+        {
+            //The main thread registers first, in init()
+            if (i == 0) { snprintf(threadName, sizeof(threadName), "Main"); }
+            else { snprintf(threadName, sizeof(threadName), "Thread %u", i); }
+
+            writer.StartObject();
+            writer.Key("name"); writer.String("thread_name");
+            writer.Key("ph"); writer.String("M");
+            writer.Key("pid"); writer.Uint(0);
+            writer.Key("tid"); writer.Uint(i);
+            writer.Key("args");
+            writer.StartObject();
+            writer.Key("name"); writer.String(threadName);
+            writer.EndObject();
+            writer.EndObject();
+        }
+
+        //Complete events, in microseconds since init()
+        for (const CapturedZone& zone : sCapture)
+        {
+            double begin = ((double)(int64_t)(zone.event.begin - sStartTicks) * sNsPerTick) / 1000.0;
+            double duration = ticksToNs(zone.event.end - zone.event.begin) / 1000.0;
+
+            writer.StartObject();
+            writer.Key("name"); writer.String(zone.event.name);
+            writer.Key("ph"); writer.String("X");
+            writer.Key("ts"); writer.Double(begin);
+            writer.Key("dur"); writer.Double(duration);
+            writer.Key("pid"); writer.Uint(0);
+            writer.Key("tid"); writer.Uint(zone.threadIndex);
+            writer.EndObject();
+        }
+
+        writer.EndArray();
+        writer.EndObject();
+
+        util::file::writeAllText(sCaptureFile.c_str(), buf.GetString());
+        printf("Wrote %u profiler zones to %s\n", (uint32_t)sCapture.size(), sCaptureFile.c_str());
+
+        sCapture.clear();
+        sCapture.shrink_to_fit();
+    }
+
+
+
+    void init()
+    {
+        if (tBuffer == nullptr) { registerThread(); }
+
+        //Rough scale for the first frames, endFrame() refines it over time
+        sStartTicks = getTicks();
+        sStartNs = getWallNs();
+        while (getWallNs() - sStartNs < 1000000) { }
+        calibrate();
+    }
+
+    double ticksToNs(uint64_t ticks)
+    {
+        return (double)ticks * sNsPerTick;
+    }
+
+    void recordZone(const char* name, uint64_t begin, uint64_t end)
+    {
+        ThreadBuffer* buffer = tBuffer;
+        if (buffer == nullptr)
+        {
+            buffer = registerThread();
+            if (buffer == nullptr) { return; }
+        }
+
+        uint32_t write = buffer->writeIndex.load(std::memory_order_relaxed);
+        if (write - buffer->readIndex.load(std::memory_order_acquire) >= ZONE_BUFFER_SIZE)
+        {
+            buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        ZoneEvent& event = buffer->events[write & (ZONE_BUFFER_SIZE - 1)];
+        event.name = name;
+        event.begin = begin;
+        event.end = end;
+        buffer->writeIndex.store(write + 1, std::memory_order_release);
+    }
+
+    const char* internName(const char* name)
+    {
+        std::lock_guard<std::mutex> lock(sNameMutex);
+
+        auto search = sNames.find(name);
+        if (search != sNames.end()) { return *search; }
+
+        size_t length = strlen(name);
+        char* copy = new char[length + 1];
+        memcpy(copy, name, length + 1);
+        sNames.insert(copy);
+        return copy;
+    }
+
+    void endFrame()
+    {
+        calibrate();
+
+        uint32_t threadCount = sBufferCount.load(std::memory_order_acquire);
+        bool capturing = (sCaptureFramesLeft > 0);
+        for (uint32_t i = 0; i < threadCount; i++)
+        {
+            ThreadBuffer* buffer = sBuffers[i];
+            uint32_t read = buffer->readIndex.load(std::memory_order_relaxed);
+            uint32_t write = buffer->writeIndex.load(std::memory_order_acquire);
+            for (; read != write; read++)
+            {
+                const ZoneEvent& event = buffer->events[read & (ZONE_BUFFER_SIZE - 1)];
+
+                Zone* zone = getZone(event.name);
+                zone->frameTicks += event.end - event.begin;
+                zone->frameCalls++;
+
+                if (capturing)
+                {
+                    CapturedZone captured;
+                    captured.event = event;
+                    captured.threadIndex = i;
+                    sCapture.push_back(captured);
+                }
+            }
+            buffer->readIndex.store(write, std::memory_order_release);
+            sDroppedZones += buffer->dropped.exchange(0, std::memory_order_relaxed);
+        }
+
+        for (Zone* zone : sZones)
+        {
+            if (zone->frameCalls == 0) { continue; }
+
+            zone->history[zone->historyNext] = (float)(ticksToNs(zone->frameTicks) / 1000000.0);
+            zone->callHistory[zone->historyNext] = zone->frameCalls;
+            zone->historyNext = (zone->historyNext + 1) % ZONE_HISTORY_FRAMES;
+            if (zone->historyCount < ZONE_HISTORY_FRAMES) { zone->historyCount++; }
+
+            zone->frameTicks = 0;
+            zone->frameCalls = 0;
+        }
+
+        if (capturing && --sCaptureFramesLeft == 0)
+        {
+            writeTrace();
+        }
+    }
+
+    uint32_t getZoneStats(ZoneStats* out, uint32_t maxZones)
+    {
+        eastl::vector<ZoneStats> stats;
+        stats.reserve(sZones.size());
+
+        float times[ZONE_HISTORY_FRAMES];
+        for (const Zone* zone : sZones)
+        {
+            uint32_t count = zone->historyCount;
+            if (count == 0) { continue; }
+
+            float total = 0.0f;
+            uint32_t calls = 0;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                times[i] = zone->history[i];
+                total += times[i];
+                calls += zone->callHistory[i];
+            }
+            eastl::sort(times, times + count);
+
+            ZoneStats zoneStats;
+            zoneStats.name = zone->name;
+            zoneStats.callsPerFrame = (float)calls / (float)count;
+            zoneStats.minMs = times[0];
+            zoneStats.avgMs = total / (float)count;
+            zoneStats.p99Ms = times[(count * 99 + 99) / 100 - 1];
+            zoneStats.maxMs = times[count - 1];
+            stats.push_back(zoneStats);
+        }
+
+        eastl::sort(stats.begin(), stats.end(), compareZoneStats);
+
+        uint32_t written = (stats.size() < maxZones) ? (uint32_t)stats.size() : maxZones;
+        for (uint32_t i = 0; i < written; i++)
+        {
+            out[i] = stats[i];
+        }
+        return written;
+    }
+
+    void printZoneStats()
+    {
+        const uint32_t MAX_PRINTED_ZONES = 32;
+        ZoneStats stats[MAX_PRINTED_ZONES];
+        uint32_t count = getZoneStats(stats, MAX_PRINTED_ZONES);
+
+        printf("%-40s %8s %8s %8s %8s %8s\n", "Zone (ms per frame)", "Calls", "Min", "Avg", "P99", "Max");
+        for (uint32_t i = 0; i < count; i++)
+        {
+            printf("%-40s %8.1f %8.3f %8.3f %8.3f %8.3f\n", stats[i].name, stats[i].callsPerFrame,
+                stats[i].minMs, stats[i].avgMs, stats[i].p99Ms, stats[i].maxMs);
+        }
+        if (sDroppedZones > 0) { printf("%u zones dropped, the per thread buffers were full\n", sDroppedZones); }
+    }
+
+    void captureTrace(uint32_t frameCount, const char* fileName)
+    {
+        NW_ASSERT(frameCount > 0);
+        sCapture.clear();
+        sCaptureFramesLeft = frameCount;
+        sCaptureFile = fileName;
+    }
+
+    bool isCapturing()
+    {
+        return sCaptureFramesLeft > 0;
+    }
+}
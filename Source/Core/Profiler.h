@@ -0,0 +1,73 @@
+#ifndef CORE_PROFILER_H
+#define CORE_PROFILER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#else
+    #include <time.h>
+#endif
+
+//Built in CPU profiler, fed by SCOPED_CPU_EVENT in profile builds.
+//
+//Zones are written to a ring buffer owned by the thread that recorded them,
+//so recording never takes a lock. endFrame() drains every thread's buffer on
+//the main thread, adds the zones up per frame and keeps a history of frame
+//times for each zone. A capture writes the raw zones of the next frames out
+//as a Chrome trace (chrome://tracing, or ui.perfetto.dev).
+//
+//A zone costs two getTicks() reads plus a few ns of bookkeeping, "bench
+//profiler" prints both. Where rdtsc is slow (some VMs) the reads dominate.
+//
+//Zone names are stored as pointers and read back later, so they need to be
+//string literals or come from internName().
+namespace profiler
+{
+    struct ZoneStats
+    {
+        const char* name;
+        float callsPerFrame;
+        //Time spent in the zone per frame, over the frames it ran in
+        float minMs;
+        float avgMs;
+        float p99Ms;
+        float maxMs;
+    };
+
+    //Raw timestamp in an unspecified unit, see ticksToNs()
+    inline uint64_t getTicks()
+    {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+#endif
+    }
+
+    //Calibrates the timestamps, call once from the main thread
+    void init();
+    double ticksToNs(uint64_t ticks);
+
+    void recordZone(const char* name, uint64_t begin, uint64_t end);
+    //Returns a copy of name that lives as long as the program
+    const char* internName(const char* name);
+
+    //Collects the zones recorded since the last call, from the main thread
+    //while no jobs are running
+    void endFrame();
+
+    //Zones sorted by average time, returns how many were written
+    uint32_t getZoneStats(ZoneStats* out, uint32_t maxZones);
+    void printZoneStats();
+
+    //Records the next frameCount frames and writes them to fileName
+    void captureTrace(uint32_t frameCount, const char* fileName);
+    bool isCapturing();
+}
+
+#endif
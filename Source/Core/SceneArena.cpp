@@ -0,0 +1,175 @@
+#include "Core/Core.h"
+#include "SceneArena.h"
+#include <cstdlib>
+#include <bx/uint32_t.h>
+
+namespace memory
+{
+    //Chunk headers are padded so the memory after them stays aligned
+    const size_t CHUNK_HEADER_SIZE = 48;
+
+    SceneArena* SceneArena::sCurrent = nullptr;
+
+    SceneArena::SceneArena() :
+        _chunks(nullptr),
+        _cursor(nullptr),
+        _end(nullptr),
+        _reservedBytes(0),
+        _usedBytes(0),
+        _chunkCount(0)
+    {
+        static_assert(sizeof(Chunk) <= CHUNK_HEADER_SIZE && CHUNK_HEADER_SIZE % ALIGNMENT == 0, "Bad chunk header size");
+
+        for (uint32_t i = 0; i < SIZE_CLASS_COUNT; i++)
+        {
+            _freeLists[i] = nullptr;
+        }
+    }
+
+    SceneArena::~SceneArena()
+    {
+        NW_ASSERT(sCurrent != this);
+        release();
+    }
+
+    void* SceneArena::alloc(size_t size, size_t alignment)
+    {
+        NW_ASSERT(alignment <= ALIGNMENT);
+        NW_UNUSED(alignment);
+
+        if (size > MAX_SMALL_SIZE)
+        {
+            Chunk* chunk = allocChunk(size);
+            _usedBytes += size;
+            return (uint8_t*)chunk + CHUNK_HEADER_SIZE;
+        }
+
+        uint32_t sizeClass = getSizeClass(size);
+        size_t blockSize = (size_t)ALIGNMENT << sizeClass;
+        _usedBytes += blockSize;
+
+        FreeBlock* block = _freeLists[sizeClass];
+        if (block != nullptr)
+        {
+            _freeLists[sizeClass] = block->next;
+            return block;
+        }
+
+        //What's left of a chunk that can't fit the block is abandoned
+        if (_cursor == nullptr || (size_t)(_end - _cursor) < blockSize)
+        {
+            Chunk* chunk = allocChunk(CHUNK_SIZE - CHUNK_HEADER_SIZE);
+            _cursor = (uint8_t*)chunk + CHUNK_HEADER_SIZE;
+            _end = (uint8_t*)chunk + CHUNK_SIZE;
+        }
+
+        void* ptr = _cursor;
+        _cursor += blockSize;
+        return ptr;
+    }
+
+    void SceneArena::free(void* ptr, size_t size)
+    {
+        if (ptr == nullptr) { return; }
+
+        if (size > MAX_SMALL_SIZE)
+        {
+            _usedBytes -= size;
+            freeChunk((Chunk*)((uint8_t*)ptr - CHUNK_HEADER_SIZE));
+            return;
+        }
+
+        uint32_t sizeClass = getSizeClass(size);
+        _usedBytes -= (size_t)ALIGNMENT << sizeClass;
+
+        FreeBlock* block = (FreeBlock*)ptr;
+        block->next = _freeLists[sizeClass];
+        _freeLists[sizeClass] = block;
+    }
+
+    void SceneArena::release()
+    {
+        Chunk* chunk = _chunks;
+        while (chunk != nullptr)
+        {
+            Chunk* next = chunk->next;
+            std::free(chunk);
+            chunk = next;
+        }
+
+        _chunks = nullptr;
+        _cursor = nullptr;
+        _end = nullptr;
+        for (uint32_t i = 0; i < SIZE_CLASS_COUNT; i++)
+        {
+            _freeLists[i] = nullptr;
+        }
+        _reservedBytes = 0;
+        _usedBytes = 0;
+        _chunkCount = 0;
+    }
+
+    SceneArenaStats SceneArena::getStats() const
+    {
+        SceneArenaStats stats;
+        stats.reservedBytes = _reservedBytes;
+        stats.usedBytes = _usedBytes;
+        stats.chunkCount = _chunkCount;
+        return stats;
+    }
+
+    SceneArena::Chunk* SceneArena::allocChunk(size_t size)
+    {
+        Chunk* chunk = (Chunk*)malloc(CHUNK_HEADER_SIZE + size);
+        NW_REQUIRE(chunk != nullptr);
+
+        chunk->size = CHUNK_HEADER_SIZE + size;
+        chunk->prev = nullptr;
+        chunk->next = _chunks;
+        if (_chunks != nullptr) { _chunks->prev = chunk; }
+        _chunks = chunk;
+
+        _reservedBytes += chunk->size;
+        _chunkCount++;
+        return chunk;
+    }
+
+    void SceneArena::freeChunk(Chunk* chunk)
+    {
+        if (chunk->prev != nullptr) { chunk->prev->next = chunk->next; }
+        else { _chunks = chunk->next; }
+        if (chunk->next != nullptr) { chunk->next->prev = chunk->prev; }
+
+        _reservedBytes -= chunk->size;
+        _chunkCount--;
+        std::free(chunk);
+    }
+
+    uint32_t SceneArena::getSizeClass(size_t size)
+    {
+        //Class n holds blocks of ALIGNMENT << n bytes
+        if (size <= ALIGNMENT) { return 0; }
+        return 32 - bx::uint32_cntlz((uint32_t)((size - 1) / ALIGNMENT));
+    }
+
+
+
+    void* sceneAlloc(SceneArena* arena, size_t size, size_t alignment)
+    {
+        if (arena != nullptr)
+        {
+            return arena->alloc(size, alignment);
+        }
+        return _aligned_malloc(size, alignment);
+    }
+
+    void sceneFree(SceneArena* arena, void* ptr, size_t size)
+    {
+        if (arena != nullptr)
+        {
+            arena->free(ptr, size);
+            return;
+        }
+        _aligned_free(ptr);
+    }
+}
@@ -0,0 +1,135 @@
+#ifndef MEMORY_SCENE_ARENA_H
+#define MEMORY_SCENE_ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace memory
+{
+    struct SceneArenaStats
+    {
+        size_t reservedBytes;   //Taken from the heap
+        size_t usedBytes;       //In live blocks, including rounding
+        uint32_t chunkCount;
+    };
+
+    //Allocator for memory that lives as long as a scene does.
+    //
+    //Small blocks are rounded up to a power of two and carved out of large
+    //chunks. Freed blocks go on a free list per size and are reused, so a
+    //scene that keeps spawning and destroying entities settles into never
+    //touching the heap. Blocks too large for a chunk get a chunk of their own,
+    //which goes back to the heap as soon as it's freed.
+    //
+    //Destroying the arena releases every chunk at once, whatever is still
+    //allocated. Not thread safe; scene memory is only allocated on the main
+    //thread.
+    class SceneArena
+    {
+    public:
+        static const size_t CHUNK_SIZE = 256 * 1024;
+        static const size_t MAX_SMALL_SIZE = 16 * 1024;
+        static const size_t ALIGNMENT = 16;
+
+    private:
+        static const uint32_t SIZE_CLASS_COUNT = 11;    //16 B to MAX_SMALL_SIZE
+
+        struct Chunk
+        {
+            Chunk* next;
+            Chunk* prev;
+            size_t size;
+        };
+
+        struct FreeBlock
+        {
+            FreeBlock* next;
+        };
+
+        Chunk* _chunks;
+        uint8_t* _cursor;
+        uint8_t* _end;
+        FreeBlock* _freeLists[SIZE_CLASS_COUNT];
+
+        size_t _reservedBytes;
+        size_t _usedBytes;
+        uint32_t _chunkCount;
+
+        static SceneArena* sCurrent;
+
+        SceneArena(const SceneArena&);
+        SceneArena& operator=(const SceneArena&);
+
+    public:
+        SceneArena();
+        ~SceneArena();
+
+        void* alloc(size_t size, size_t alignment = ALIGNMENT);
+        void free(void* ptr, size_t size);
+
+        //Frees every chunk, along with anything still allocated from them
+        void release();
+
+        SceneArenaStats getStats() const;
+
+        //Arena that newly constructed SceneAllocators and SoA vectors use
+        static SceneArena* getCurrent() { return sCurrent; }
+
+        //Makes an arena current until end() is called or the binding is
+        //destroyed, then restores the previous one
+        class Binding
+        {
+        private:
+            SceneArena* _previous;
+            bool _bound;
+
+        public:
+            Binding(SceneArena& arena) : _previous(sCurrent), _bound(true) { sCurrent = &arena; }
+            ~Binding() { end(); }
+
+            void end()
+            {
+                if (_bound) { sCurrent = _previous; }
+                _bound = false;
+            }
+        };
+
+    private:
+        Chunk* allocChunk(size_t size);
+        void freeChunk(Chunk* chunk);
+        static uint32_t getSizeClass(size_t size);
+    };
+
+    //Allocate from the arena, or the heap if the arena is null
+    void* sceneAlloc(SceneArena* arena, size_t size, size_t alignment);
+    void sceneFree(SceneArena* arena, void* ptr, size_t size);
+
+    //EASTL allocator for scene owned containers. Uses the arena that was
+    //current when it was constructed, or the heap if there wasn't one (for
+    //systems used outside of a scene, like in the tools and benchmarks).
+    class SceneAllocator
+    {
+    private:
+        SceneArena* _arena;
+
+    public:
+        SceneAllocator(const char* = nullptr) : _arena(SceneArena::getCurrent()) { }
+        SceneAllocator(const SceneAllocator& other) : _arena(other._arena) { }
+        SceneAllocator(const SceneAllocator& other, const char*) : _arena(other._arena) { }
+        SceneAllocator& operator=(const SceneAllocator& other) { _arena = other._arena; return *this; }
+
+        void* allocate(size_t n, int = 0) { return sceneAlloc(_arena, n, SceneArena::ALIGNMENT); }
+        void* allocate(size_t n, size_t alignment, size_t, int = 0) { return sceneAlloc(_arena, n, alignment); }
+        void deallocate(void* p, size_t n) { sceneFree(_arena, p, n); }
+
+        const char* get_name() const { return "SceneAllocator"; }
+        void set_name(const char*) { }
+
+        SceneArena* getArena() const { return _arena; }
+    };
+
+    inline bool operator==(const SceneAllocator& a, const SceneAllocator& b) { return a.getArena() == b.getArena(); }
+    inline bool operator!=(const SceneAllocator& a, const SceneAllocator& b) { return a.getArena() != b.getArena(); }
+}
+
+#endif
@@ -1,6 +1,20 @@
 #ifndef MEMORY_SOA_VECTOR_H
 #define MEMORY_SOA_VECTOR_H
 
+#include "Core/SceneArena.h"
+
+//Storage comes from the scene arena that was current when the vector was
+//constructed, or the heap outside of a scene
+
+namespace memory
+{
+    struct SoaColumn
+    {
+        const char* name;
+        uint32_t elementSize;
+    };
+}
+
 #define CLASS_SOA_VECTOR2(className, type1, name1, type2, name2) \
     class className \
     { \
@@ -10,6 +24,8 @@
         void* _memory; \
         uint32_t _size; \
         uint32_t _capacity; \
+        bool _ownsMemory; \
+        memory::SceneArena* _arena; \
         void internalResize(uint32_t newCapacity) \
         { \
             const uint32_t TOTAL_ELEMENT_SIZE = sizeof(type1) + sizeof(type2); \
@@ -19,7 +35,7 @@
             type2* newName2 = nullptr; \
             if (newCapacity > 0) \
             { \
-                newMemory = _aligned_malloc(TOTAL_ELEMENT_SIZE * newCapacity, ALIGNMENT); \
+                newMemory = memory::sceneAlloc(_arena, TOTAL_ELEMENT_SIZE * newCapacity, ALIGNMENT); \
                 newName1 = (type1*)newMemory; \
                 newName2 = (type2*)(newName1 + newCapacity); \
             } \
@@ -29,8 +45,9 @@
                 memcpy(newName1, name1, sizeof(type1) * _size); \
                 memcpy(newName2, name2, sizeof(type2) * _size); \
             } \
-            _aligned_free(_memory); \
+            if (_ownsMemory) { memory::sceneFree(_arena, _memory, imageSize(_capacity)); } \
             _memory = newMemory; \
+            _ownsMemory = true; \
             name1 = newName1; \
             name2 = newName2; \
             _capacity = newCapacity; \
@@ -38,14 +55,14 @@
     public: \
         type1* name1; \
         type2* name2; \
-        className() : _memory(nullptr), _size(0), _capacity(0) { } \
-        className(uint32_t capacity) : _memory(nullptr), _size(0), _capacity(0) \
+        className() : _memory(nullptr), _size(0), _capacity(0), _ownsMemory(true), _arena(memory::SceneArena::getCurrent()) { } \
+        className(uint32_t capacity) : _memory(nullptr), _size(0), _capacity(0), _ownsMemory(true), _arena(memory::SceneArena::getCurrent()) \
         { \
             internalResize(capacity); \
         } \
         ~className() \
         { \
-            _aligned_free(_memory); \
+            if (_ownsMemory) { memory::sceneFree(_arena, _memory, imageSize(_capacity)); } \
             _size = 0; \
             _capacity = 0; \
         } \
@@ -77,8 +94,14 @@
             type1 t1 = name1[idx1]; name1[idx1] = name1[idx2]; name1[idx2] = t1; \
             type2 t2 = name2[idx1]; name2[idx1] = name2[idx2]; name2[idx2] = t2; \
         } \
-        inline uint32_t getSize() { return _size; } \
-        inline uint32_t capacity() { return _capacity; } \
+        inline uint32_t getSize() const { return _size; } \
+        inline uint32_t capacity() const { return _capacity; } \
+        /*Grows at most once, so pushes up to newCapacity don't reallocate*/ \
+        void reserve(uint32_t newCapacity) \
+        { \
+            if (newCapacity <= _capacity) { return; } \
+            internalResize((newCapacity > _capacity * 2) ? newCapacity : _capacity * 2); \
+        } \
         inline void setSize(uint32_t newSize) { assert(_size <= _capacity); _size = newSize; } \
         inline void resize(uint32_t newSize) \
         { \
@@ -86,6 +109,30 @@
             internalResize(newSize); \
             _size = newSize; \
         } \
+        /*Size and alignment of a memory block holding count elements of every column*/ \
+        static inline uint32_t imageSize(uint32_t count) { return (sizeof(type1) + sizeof(type2)) * count; } \
+        static inline uint32_t imageAlignment() { return alignof(type1); } \
+        /*Uses an external block laid out like internalResize() would lay out count elements.*/ \
+        /*The block is not freed by the container and is copied out on the first grow.*/ \
+        void adopt(void* memory, uint32_t count) \
+        { \
+            assert(((uintptr_t)memory % imageAlignment()) == 0); \
+            internalResize(0); \
+            _memory = memory; \
+            _ownsMemory = false; \
+            name1 = (type1*)memory; \
+            name2 = (type2*)(name1 + count); \
+            _size = count; \
+            _capacity = count; \
+        } \
+        inline bool ownsMemory() const { return _ownsMemory; } \
+        static const uint32_t COLUMN_COUNT = 2; \
+        /*Name and element size of every column, in layout order*/ \
+        static void getColumns(memory::SoaColumn* out) \
+        { \
+            out[0].name = #name1; out[0].elementSize = sizeof(type1); \
+            out[1].name = #name2; out[1].elementSize = sizeof(type2); \
+        } \
     }
 
 #define CLASS_SOA_VECTOR3(className, type1, name1, type2, name2, type3, name3) \
@@ -98,6 +145,8 @@
         void* _memory; \
         uint32_t _size; \
         uint32_t _capacity; \
+        bool _ownsMemory; \
+        memory::SceneArena* _arena; \
         void internalResize(uint32_t newCapacity) \
         { \
             const uint32_t TOTAL_ELEMENT_SIZE = sizeof(type1) + sizeof(type2) + sizeof(type3); \
@@ -108,7 +157,7 @@
             type3* newName3 = nullptr; \
             if (newCapacity > 0) \
             { \
-                newMemory = _aligned_malloc(TOTAL_ELEMENT_SIZE * newCapacity, ALIGNMENT); \
+                newMemory = memory::sceneAlloc(_arena, TOTAL_ELEMENT_SIZE * newCapacity, ALIGNMENT); \
                 newName1 = (type1*)newMemory; \
                 newName2 = (type2*)(newName1 + newCapacity); \
                 newName3 = (type3*)(newName2 + newCapacity); \
@@ -120,8 +169,9 @@
                 memcpy(newName2, name2, sizeof(type2) * _size); \
                 memcpy(newName3, name3, sizeof(type3) * _size); \
             } \
-            _aligned_free(_memory); \
+            if (_ownsMemory) { memory::sceneFree(_arena, _memory, imageSize(_capacity)); } \
             _memory = newMemory; \
+            _ownsMemory = true; \
             name1 = newName1; \
             name2 = newName2; \
             name3 = newName3; \
@@ -131,14 +181,14 @@
         type1* name1; \
         type2* name2; \
         type3* name3; \
-        className() : _memory(nullptr), _size(0), _capacity(0) { } \
-        className(uint32_t capacity) : _memory(nullptr), _size(0), _capacity(0) \
+        className() : _memory(nullptr), _size(0), _capacity(0), _ownsMemory(true), _arena(memory::SceneArena::getCurrent()) { } \
+        className(uint32_t capacity) : _memory(nullptr), _size(0), _capacity(0), _ownsMemory(true), _arena(memory::SceneArena::getCurrent()) \
         { \
             internalResize(capacity); \
         } \
         ~className() \
         { \
-            _aligned_free(_memory); \
+            if (_ownsMemory) { memory::sceneFree(_arena, _memory, imageSize(_capacity)); } \
             _size = 0; \
             _capacity = 0; \
         } \
@@ -173,8 +223,14 @@
             type2 t2 = name2[idx1]; name2[idx1] = name2[idx2]; name2[idx2] = t2; \
             type3 t3 = name3[idx1]; name3[idx1] = name3[idx2]; name3[idx2] = t3; \
         } \
-        inline uint32_t getSize() { return _size; } \
-        inline uint32_t capacity() { return _capacity; } \
+        inline uint32_t getSize() const { return _size; } \
+        inline uint32_t capacity() const { return _capacity; } \
+        /*Grows at most once, so pushes up to newCapacity don't reallocate*/ \
+        void reserve(uint32_t newCapacity) \
+        { \
+            if (newCapacity <= _capacity) { return; } \
+            internalResize((newCapacity > _capacity * 2) ? newCapacity : _capacity * 2); \
+        } \
         inline void setSize(uint32_t newSize) { assert(_size <= _capacity); _size = newSize; } \
         inline void resize(uint32_t newSize) \
         { \
@@ -182,6 +238,32 @@
             internalResize(newSize); \
             _size = newSize; \
         } \
+        /*Size and alignment of a memory block holding count elements of every column*/ \
+        static inline uint32_t imageSize(uint32_t count) { return (sizeof(type1) + sizeof(type2) + sizeof(type3)) * count; } \
+        static inline uint32_t imageAlignment() { return alignof(type1); } \
+        /*Uses an external block laid out like internalResize() would lay out count elements.*/ \
+        /*The block is not freed by the container and is copied out on the first grow.*/ \
+        void adopt(void* memory, uint32_t count) \
+        { \
+            assert(((uintptr_t)memory % imageAlignment()) == 0); \
+            internalResize(0); \
+            _memory = memory; \
+            _ownsMemory = false; \
+            name1 = (type1*)memory; \
+            name2 = (type2*)(name1 + count); \
+            name3 = (type3*)(name2 + count); \
+            _size = count; \
+            _capacity = count; \
+        } \
+        inline bool ownsMemory() const { return _ownsMemory; } \
+        static const uint32_t COLUMN_COUNT = 3; \
+        /*Name and element size of every column, in layout order*/ \
+        static void getColumns(memory::SoaColumn* out) \
+        { \
+            out[0].name = #name1; out[0].elementSize = sizeof(type1); \
+            out[1].name = #name2; out[1].elementSize = sizeof(type2); \
+            out[2].name = #name3; out[2].elementSize = sizeof(type3); \
+        } \
     }
 
 #define CLASS_SOA_VECTOR4(className, type1, name1, type2, name2, type3, name3, type4, name4) \
@@ -195,6 +277,8 @@
         void* _memory; \
         uint32_t _size; \
         uint32_t _capacity; \
+        bool _ownsMemory; \
+        memory::SceneArena* _arena; \
         void internalResize(uint32_t newCapacity) \
         { \
             const uint32_t TOTAL_ELEMENT_SIZE = sizeof(type1) + sizeof(type2) + sizeof(type3) + sizeof(type4); \
@@ -206,7 +290,7 @@
             type4* newName4 = nullptr; \
             if (newCapacity > 0) \
             { \
-                newMemory = _aligned_malloc(TOTAL_ELEMENT_SIZE * newCapacity, ALIGNMENT); \
+                newMemory = memory::sceneAlloc(_arena, TOTAL_ELEMENT_SIZE * newCapacity, ALIGNMENT); \
                 newName1 = (type1*)newMemory; \
                 newName2 = (type2*)(newName1 + newCapacity); \
                 newName3 = (type3*)(newName2 + newCapacity); \
@@ -220,8 +304,9 @@
                 memcpy(newName3, name3, sizeof(type3) * _size); \
                 memcpy(newName4, name4, sizeof(type4) * _size); \
             } \
-            _aligned_free(_memory); \
+            if (_ownsMemory) { memory::sceneFree(_arena, _memory, imageSize(_capacity)); } \
             _memory = newMemory; \
+            _ownsMemory = true; \
             name1 = newName1; \
             name2 = newName2; \
             name3 = newName3; \
@@ -233,14 +318,14 @@
         type2* name2; \
         type3* name3; \
         type4* name4; \
-        className() : _memory(nullptr), _size(0), _capacity(0) { } \
-        className(uint32_t capacity) : _memory(nullptr), _size(0), _capacity(0) \
+        className() : _memory(nullptr), _size(0), _capacity(0), _ownsMemory(true), _arena(memory::SceneArena::getCurrent()) { } \
+        className(uint32_t capacity) : _memory(nullptr), _size(0), _capacity(0), _ownsMemory(true), _arena(memory::SceneArena::getCurrent()) \
         { \
             internalResize(capacity); \
         } \
         ~className() \
         { \
-            _aligned_free(_memory); \
+            if (_ownsMemory) { memory::sceneFree(_arena, _memory, imageSize(_capacity)); } \
             _size = 0; \
             _capacity = 0; \
         } \
@@ -278,8 +363,14 @@
             type3 t3 = name3[idx1]; name3[idx1] = name3[idx2]; name3[idx2] = t3; \
             type4 t4 = name4[idx1]; name4[idx1] = name4[idx2]; name4[idx2] = t4; \
         } \
-        inline uint32_t getSize() { return _size; } \
-        inline uint32_t capacity() { return _capacity; } \
+        inline uint32_t getSize() const { return _size; } \
+        inline uint32_t capacity() const { return _capacity; } \
+        /*Grows at most once, so pushes up to newCapacity don't reallocate*/ \
+        void reserve(uint32_t newCapacity) \
+        { \
+            if (newCapacity <= _capacity) { return; } \
+            internalResize((newCapacity > _capacity * 2) ? newCapacity : _capacity * 2); \
+        } \
         inline void setSize(uint32_t newSize) { assert(_size <= _capacity); _size = newSize; } \
         inline void resize(uint32_t newSize) \
         { \
@@ -287,6 +378,34 @@
             internalResize(newSize); \
             _size = newSize; \
         } \
+        /*Size and alignment of a memory block holding count elements of every column*/ \
+        static inline uint32_t imageSize(uint32_t count) { return (sizeof(type1) + sizeof(type2) + sizeof(type3) + sizeof(type4)) * count; } \
+        static inline uint32_t imageAlignment() { return alignof(type1); } \
+        /*Uses an external block laid out like internalResize() would lay out count elements.*/ \
+        /*The block is not freed by the container and is copied out on the first grow.*/ \
+        void adopt(void* memory, uint32_t count) \
+        { \
+            assert(((uintptr_t)memory % imageAlignment()) == 0); \
+            internalResize(0); \
+            _memory = memory; \
+            _ownsMemory = false; \
+            name1 = (type1*)memory; \
+            name2 = (type2*)(name1 + count); \
+            name3 = (type3*)(name2 + count); \
+            name4 = (type4*)(name3 + count); \
+            _size = count; \
+            _capacity = count; \
+        } \
+        inline bool ownsMemory() const { return _ownsMemory; } \
+        static const uint32_t COLUMN_COUNT = 4; \
+        /*Name and element size of every column, in layout order*/ \
+        static void getColumns(memory::SoaColumn* out) \
+        { \
+            out[0].name = #name1; out[0].elementSize = sizeof(type1); \
+            out[1].name = #name2; out[1].elementSize = sizeof(type2); \
+            out[2].name = #name3; out[2].elementSize = sizeof(type3); \
+            out[3].name = #name4; out[3].elementSize = sizeof(type4); \
+        } \
     }
 
 #define CLASS_SOA_VECTOR5(className, type1, name1, type2, name2, type3, name3, type4, name4, type5, name5) \
@@ -301,6 +420,8 @@
         void* _memory; \
         uint32_t _size; \
         uint32_t _capacity; \
+        bool _ownsMemory; \
+        memory::SceneArena* _arena; \
         void internalResize(uint32_t newCapacity) \
         { \
             const uint32_t TOTAL_ELEMENT_SIZE = sizeof(type1) + sizeof(type2) + sizeof(type3) + sizeof(type4) + sizeof(type5); \
@@ -313,7 +434,7 @@
             type5* newName5 = nullptr; \
             if (newCapacity > 0) \
             { \
-                newMemory = _aligned_malloc(TOTAL_ELEMENT_SIZE * newCapacity, ALIGNMENT); \
+                newMemory = memory::sceneAlloc(_arena, TOTAL_ELEMENT_SIZE * newCapacity, ALIGNMENT); \
                 newName1 = (type1*)newMemory; \
                 newName2 = (type2*)(newName1 + newCapacity); \
                 newName3 = (type3*)(newName2 + newCapacity); \
@@ -329,8 +450,9 @@
                 memcpy(newName4, name4, sizeof(type4) * _size); \
                 memcpy(newName5, name5, sizeof(type5) * _size); \
             } \
-            _aligned_free(_memory); \
+            if (_ownsMemory) { memory::sceneFree(_arena, _memory, imageSize(_capacity)); } \
             _memory = newMemory; \
+            _ownsMemory = true; \
             name1 = newName1; \
             name2 = newName2; \
             name3 = newName3; \
@@ -344,14 +466,14 @@
         type3* name3; \
         type4* name4; \
         type5* name5; \
-        className() : _memory(nullptr), _size(0), _capacity(0) { } \
-        className(uint32_t capacity) : _memory(nullptr), _size(0), _capacity(0) \
+        className() : _memory(nullptr), _size(0), _capacity(0), _ownsMemory(true), _arena(memory::SceneArena::getCurrent()) { } \
+        className(uint32_t capacity) : _memory(nullptr), _size(0), _capacity(0), _ownsMemory(true), _arena(memory::SceneArena::getCurrent()) \
         { \
             internalResize(capacity); \
         } \
         ~className() \
         { \
-            _aligned_free(_memory); \
+            if (_ownsMemory) { memory::sceneFree(_arena, _memory, imageSize(_capacity)); } \
             _size = 0; \
             _capacity = 0; \
         } \
@@ -392,8 +514,14 @@
             type4 t4 = name4[idx1]; name4[idx1] = name4[idx2]; name4[idx2] = t4; \
             type5 t5 = name5[idx1]; name5[idx1] = name5[idx2]; name5[idx2] = t5; \
         } \
-        inline uint32_t getSize() { return _size; } \
-        inline uint32_t capacity() { return _capacity; } \
+        inline uint32_t getSize() const { return _size; } \
+        inline uint32_t capacity() const { return _capacity; } \
+        /*Grows at most once, so pushes up to newCapacity don't reallocate*/ \
+        void reserve(uint32_t newCapacity) \
+        { \
+            if (newCapacity <= _capacity) { return; } \
+            internalResize((newCapacity > _capacity * 2) ? newCapacity : _capacity * 2); \
+        } \
         inline void setSize(uint32_t newSize) { assert(_size <= _capacity); _size = newSize; } \
         inline void resize(uint32_t newSize) \
         { \
@@ -401,6 +529,36 @@
             internalResize(newSize); \
             _size = newSize; \
         } \
+        /*Size and alignment of a memory block holding count elements of every column*/ \
+        static inline uint32_t imageSize(uint32_t count) { return (sizeof(type1) + sizeof(type2) + sizeof(type3) + sizeof(type4) + sizeof(type5)) * count; } \
+        static inline uint32_t imageAlignment() { return alignof(type1); } \
+        /*Uses an external block laid out like internalResize() would lay out count elements.*/ \
+        /*The block is not freed by the container and is copied out on the first grow.*/ \
+        void adopt(void* memory, uint32_t count) \
+        { \
+            assert(((uintptr_t)memory % imageAlignment()) == 0); \
+            internalResize(0); \
+            _memory = memory; \
+            _ownsMemory = false; \
+            name1 = (type1*)memory; \
+            name2 = (type2*)(name1 + count); \
+            name3 = (type3*)(name2 + count); \
+            name4 = (type4*)(name3 + count); \
+            name5 = (type5*)(name4 + count); \
+            _size = count; \
+            _capacity = count; \
+        } \
+        inline bool ownsMemory() const { return _ownsMemory; } \
+        static const uint32_t COLUMN_COUNT = 5; \
+        /*Name and element size of every column, in layout order*/ \
+        static void getColumns(memory::SoaColumn* out) \
+        { \
+            out[0].name = #name1; out[0].elementSize = sizeof(type1); \
+            out[1].name = #name2; out[1].elementSize = sizeof(type2); \
+            out[2].name = #name3; out[2].elementSize = sizeof(type3); \
+            out[3].name = #name4; out[3].elementSize = sizeof(type4); \
+            out[4].name = #name5; out[4].elementSize = sizeof(type5); \
+        } \
     }
 
 #define CLASS_SOA_VECTOR6(className, type1, name1, type2, name2, type3, name3, type4, name4, type5, name5, type6, name6) \
@@ -416,6 +574,8 @@
         void* _memory; \
         uint32_t _size; \
         uint32_t _capacity; \
+        bool _ownsMemory; \
+        memory::SceneArena* _arena; \
         void internalResize(uint32_t newCapacity) \
         { \
             const uint32_t TOTAL_ELEMENT_SIZE = sizeof(type1) + sizeof(type2) + sizeof(type3) + sizeof(type4) + sizeof(type5) + sizeof(type6); \
@@ -429,7 +589,7 @@
             type6* newName6 = nullptr; \
             if (newCapacity > 0) \
             { \
-                newMemory = _aligned_malloc(TOTAL_ELEMENT_SIZE * newCapacity, ALIGNMENT); \
+                newMemory = memory::sceneAlloc(_arena, TOTAL_ELEMENT_SIZE * newCapacity, ALIGNMENT); \
                 newName1 = (type1*)newMemory; \
                 newName2 = (type2*)(newName1 + newCapacity); \
                 newName3 = (type3*)(newName2 + newCapacity); \
@@ -447,8 +607,9 @@
                 memcpy(newName5, name5, sizeof(type5) * _size); \
                 memcpy(newName6, name6, sizeof(type6) * _size); \
             } \
-            _aligned_free(_memory); \
+            if (_ownsMemory) { memory::sceneFree(_arena, _memory, imageSize(_capacity)); } \
             _memory = newMemory; \
+            _ownsMemory = true; \
             name1 = newName1; \
             name2 = newName2; \
             name3 = newName3; \
@@ -464,14 +625,14 @@
         type4* name4; \
         type5* name5; \
         type6* name6; \
-        className() : _memory(nullptr), _size(0), _capacity(0) { } \
-        className(uint32_t capacity) : _memory(nullptr), _size(0), _capacity(0) \
+        className() : _memory(nullptr), _size(0), _capacity(0), _ownsMemory(true), _arena(memory::SceneArena::getCurrent()) { } \
+        className(uint32_t capacity) : _memory(nullptr), _size(0), _capacity(0), _ownsMemory(true), _arena(memory::SceneArena::getCurrent()) \
         { \
             internalResize(capacity); \
         } \
         ~className() \
         { \
-            _aligned_free(_memory); \
+            if (_ownsMemory) { memory::sceneFree(_arena, _memory, imageSize(_capacity)); } \
             _size = 0; \
             _capacity = 0; \
         } \
@@ -515,8 +676,14 @@
             type5 t5 = name5[idx1]; name5[idx1] = name5[idx2]; name5[idx2] = t5; \
             type6 t6 = name6[idx1]; name6[idx1] = name6[idx2]; name6[idx2] = t6; \
         } \
-        inline uint32_t getSize() { return _size; } \
-        inline uint32_t capacity() { return _capacity; } \
+        inline uint32_t getSize() const { return _size; } \
+        inline uint32_t capacity() const { return _capacity; } \
+        /*Grows at most once, so pushes up to newCapacity don't reallocate*/ \
+        void reserve(uint32_t newCapacity) \
+        { \
+            if (newCapacity <= _capacity) { return; } \
+            internalResize((newCapacity > _capacity * 2) ? newCapacity : _capacity * 2); \
+        } \
         inline void setSize(uint32_t newSize) { assert(_size <= _capacity); _size = newSize; } \
         inline void resize(uint32_t newSize) \
         { \
@@ -524,6 +691,38 @@
             internalResize(newSize); \
             _size = newSize; \
         } \
+        /*Size and alignment of a memory block holding count elements of every column*/ \
+        static inline uint32_t imageSize(uint32_t count) { return (sizeof(type1) + sizeof(type2) + sizeof(type3) + sizeof(type4) + sizeof(type5) + sizeof(type6)) * count; } \
+        static inline uint32_t imageAlignment() { return alignof(type1); } \
+        /*Uses an external block laid out like internalResize() would lay out count elements.*/ \
+        /*The block is not freed by the container and is copied out on the first grow.*/ \
+        void adopt(void* memory, uint32_t count) \
+        { \
+            assert(((uintptr_t)memory % imageAlignment()) == 0); \
+            internalResize(0); \
+            _memory = memory; \
+            _ownsMemory = false; \
+            name1 = (type1*)memory; \
+            name2 = (type2*)(name1 + count); \
+            name3 = (type3*)(name2 + count); \
+            name4 = (type4*)(name3 + count); \
+            name5 = (type5*)(name4 + count); \
+            name6 = (type6*)(name5 + count); \
+            _size = count; \
+            _capacity = count; \
+        } \
+        inline bool ownsMemory() const { return _ownsMemory; } \
+        static const uint32_t COLUMN_COUNT = 6; \
+        /*Name and element size of every column, in layout order*/ \
+        static void getColumns(memory::SoaColumn* out) \
+        { \
+            out[0].name = #name1; out[0].elementSize = sizeof(type1); \
+            out[1].name = #name2; out[1].elementSize = sizeof(type2); \
+            out[2].name = #name3; out[2].elementSize = sizeof(type3); \
+            out[3].name = #name4; out[3].elementSize = sizeof(type4); \
+            out[4].name = #name5; out[4].elementSize = sizeof(type5); \
+            out[5].name = #name6; out[5].elementSize = sizeof(type6); \
+        } \
     }
 
 #define CLASS_SOA_VECTOR7(className, type1, name1, type2, name2, type3, name3, type4, name4, type5, name5, type6, name6, type7, name7) \
@@ -540,6 +739,8 @@
         void* _memory; \
         uint32_t _size; \
         uint32_t _capacity; \
+        bool _ownsMemory; \
+        memory::SceneArena* _arena; \
         void internalResize(uint32_t newCapacity) \
         { \
             const uint32_t TOTAL_ELEMENT_SIZE = sizeof(type1) + sizeof(type2) + sizeof(type3) + sizeof(type4) + sizeof(type5) + sizeof(type6) + sizeof(type7); \
@@ -554,7 +755,7 @@
             type7* newName7 = nullptr; \
             if (newCapacity > 0) \
             { \
-                newMemory = _aligned_malloc(TOTAL_ELEMENT_SIZE * newCapacity, ALIGNMENT); \
+                newMemory = memory::sceneAlloc(_arena, TOTAL_ELEMENT_SIZE * newCapacity, ALIGNMENT); \
                 newName1 = (type1*)newMemory; \
                 newName2 = (type2*)(newName1 + newCapacity); \
                 newName3 = (type3*)(newName2 + newCapacity); \
@@ -574,8 +775,9 @@
                 memcpy(newName6, name6, sizeof(type6) * _size); \
                 memcpy(newName7, name7, sizeof(type7) * _size); \
             } \
-            _aligned_free(_memory); \
+            if (_ownsMemory) { memory::sceneFree(_arena, _memory, imageSize(_capacity)); } \
             _memory = newMemory; \
+            _ownsMemory = true; \
             name1 = newName1; \
             name2 = newName2; \
             name3 = newName3; \
@@ -593,14 +795,14 @@
         type5* name5; \
         type6* name6; \
         type7* name7; \
-        className() : _memory(nullptr), _size(0), _capacity(0) { } \
-        className(uint32_t capacity) : _memory(nullptr), _size(0), _capacity(0) \
+        className() : _memory(nullptr), _size(0), _capacity(0), _ownsMemory(true), _arena(memory::SceneArena::getCurrent()) { } \
+        className(uint32_t capacity) : _memory(nullptr), _size(0), _capacity(0), _ownsMemory(true), _arena(memory::SceneArena::getCurrent()) \
         { \
             internalResize(capacity); \
         } \
         ~className() \
         { \
-            _aligned_free(_memory); \
+            if (_ownsMemory) { memory::sceneFree(_arena, _memory, imageSize(_capacity)); } \
             _size = 0; \
             _capacity = 0; \
         } \
@@ -647,8 +849,14 @@
             type6 t6 = name6[idx1]; name6[idx1] = name6[idx2]; name6[idx2] = t6; \
             type7 t7 = name7[idx1]; name7[idx1] = name7[idx2]; name7[idx2] = t7; \
         } \
-        inline uint32_t getSize() { return _size; } \
-        inline uint32_t capacity() { return _capacity; } \
+        inline uint32_t getSize() const { return _size; } \
+        inline uint32_t capacity() const { return _capacity; } \
+        /*Grows at most once, so pushes up to newCapacity don't reallocate*/ \
+        void reserve(uint32_t newCapacity) \
+        { \
+            if (newCapacity <= _capacity) { return; } \
+            internalResize((newCapacity > _capacity * 2) ? newCapacity : _capacity * 2); \
+        } \
         inline void setSize(uint32_t newSize) { assert(_size <= _capacity); _size = newSize; } \
         inline void resize(uint32_t newSize) \
         { \
@@ -656,6 +864,40 @@
             internalResize(newSize); \
             _size = newSize; \
         } \
+        /*Size and alignment of a memory block holding count elements of every column*/ \
+        static inline uint32_t imageSize(uint32_t count) { return (sizeof(type1) + sizeof(type2) + sizeof(type3) + sizeof(type4) + sizeof(type5) + sizeof(type6) + sizeof(type7)) * count; } \
+        static inline uint32_t imageAlignment() { return alignof(type1); } \
+        /*Uses an external block laid out like internalResize() would lay out count elements.*/ \
+        /*The block is not freed by the container and is copied out on the first grow.*/ \
+        void adopt(void* memory, uint32_t count) \
+        { \
+            assert(((uintptr_t)memory % imageAlignment()) == 0); \
+            internalResize(0); \
+            _memory = memory; \
+            _ownsMemory = false; \
+            name1 = (type1*)memory; \
+            name2 = (type2*)(name1 + count); \
+            name3 = (type3*)(name2 + count); \
+            name4 = (type4*)(name3 + count); \
+            name5 = (type5*)(name4 + count); \
+            name6 = (type6*)(name5 + count); \
+            name7 = (type7*)(name6 + count); \
+            _size = count; \
+            _capacity = count; \
+        } \
+        inline bool ownsMemory() const { return _ownsMemory; } \
+        static const uint32_t COLUMN_COUNT = 7; \
+        /*Name and element size of every column, in layout order*/ \
+        static void getColumns(memory::SoaColumn* out) \
+        { \
+            out[0].name = #name1; out[0].elementSize = sizeof(type1); \
+            out[1].name = #name2; out[1].elementSize = sizeof(type2); \
+            out[2].name = #name3; out[2].elementSize = sizeof(type3); \
+            out[3].name = #name4; out[3].elementSize = sizeof(type4); \
+            out[4].name = #name5; out[4].elementSize = sizeof(type5); \
+            out[5].name = #name6; out[5].elementSize = sizeof(type6); \
+            out[6].name = #name7; out[6].elementSize = sizeof(type7); \
+        } \
     }
 
 #define CLASS_SOA_VECTOR8(className, type1, name1, type2, name2, type3, name3, type4, name4, type5, name5, type6, name6, type7, name7, type8, name8) \
@@ -673,6 +915,8 @@
         void* _memory; \
         uint32_t _size; \
         uint32_t _capacity; \
+        bool _ownsMemory; \
+        memory::SceneArena* _arena; \
         void internalResize(uint32_t newCapacity) \
         { \
             const uint32_t TOTAL_ELEMENT_SIZE = sizeof(type1) + sizeof(type2) + sizeof(type3) + sizeof(type4) + sizeof(type5) + sizeof(type6) + sizeof(type7) + sizeof(type8); \
@@ -688,7 +932,7 @@
             type8* newName8 = nullptr; \
             if (newCapacity > 0) \
             { \
-                newMemory = _aligned_malloc(TOTAL_ELEMENT_SIZE * newCapacity, ALIGNMENT); \
+                newMemory = memory::sceneAlloc(_arena, TOTAL_ELEMENT_SIZE * newCapacity, ALIGNMENT); \
                 newName1 = (type1*)newMemory; \
                 newName2 = (type2*)(newName1 + newCapacity); \
                 newName3 = (type3*)(newName2 + newCapacity); \
@@ -710,8 +954,9 @@
                 memcpy(newName7, name7, sizeof(type7) * _size); \
                 memcpy(newName8, name8, sizeof(type8) * _size); \
             } \
-            _aligned_free(_memory); \
+            if (_ownsMemory) { memory::sceneFree(_arena, _memory, imageSize(_capacity)); } \
             _memory = newMemory; \
+            _ownsMemory = true; \
             name1 = newName1; \
             name2 = newName2; \
             name3 = newName3; \
@@ -731,14 +976,14 @@
         type6* name6; \
         type7* name7; \
         type8* name8; \
-        className() : _memory(nullptr), _size(0), _capacity(0) { } \
-        className(uint32_t capacity) : _memory(nullptr), _size(0), _capacity(0) \
+        className() : _memory(nullptr), _size(0), _capacity(0), _ownsMemory(true), _arena(memory::SceneArena::getCurrent()) { } \
+        className(uint32_t capacity) : _memory(nullptr), _size(0), _capacity(0), _ownsMemory(true), _arena(memory::SceneArena::getCurrent()) \
         { \
             internalResize(capacity); \
         } \
         ~className() \
         { \
-            _aligned_free(_memory); \
+            if (_ownsMemory) { memory::sceneFree(_arena, _memory, imageSize(_capacity)); } \
             _size = 0; \
             _capacity = 0; \
         } \
@@ -788,8 +1033,14 @@
             type7 t7 = name7[idx1]; name7[idx1] = name7[idx2]; name7[idx2] = t7; \
             type8 t8 = name8[idx1]; name8[idx1] = name8[idx2]; name8[idx2] = t8; \
         } \
-        inline uint32_t getSize() { return _size; } \
-        inline uint32_t capacity() { return _capacity; } \
+        inline uint32_t getSize() const { return _size; } \
+        inline uint32_t capacity() const { return _capacity; } \
+        /*Grows at most once, so pushes up to newCapacity don't reallocate*/ \
+        void reserve(uint32_t newCapacity) \
+        { \
+            if (newCapacity <= _capacity) { return; } \
+            internalResize((newCapacity > _capacity * 2) ? newCapacity : _capacity * 2); \
+        } \
         inline void setSize(uint32_t newSize) { assert(_size <= _capacity); _size = newSize; } \
         inline void resize(uint32_t newSize) \
         { \
@@ -797,6 +1048,42 @@
             internalResize(newSize); \
             _size = newSize; \
         } \
+        /*Size and alignment of a memory block holding count elements of every column*/ \
+        static inline uint32_t imageSize(uint32_t count) { return (sizeof(type1) + sizeof(type2) + sizeof(type3) + sizeof(type4) + sizeof(type5) + sizeof(type6) + sizeof(type7) + sizeof(type8)) * count; } \
+        static inline uint32_t imageAlignment() { return alignof(type1); } \
+        /*Uses an external block laid out like internalResize() would lay out count elements.*/ \
+        /*The block is not freed by the container and is copied out on the first grow.*/ \
+        void adopt(void* memory, uint32_t count) \
+        { \
+            assert(((uintptr_t)memory % imageAlignment()) == 0); \
+            internalResize(0); \
+            _memory = memory; \
+            _ownsMemory = false; \
+            name1 = (type1*)memory; \
+            name2 = (type2*)(name1 + count); \
+            name3 = (type3*)(name2 + count); \
+            name4 = (type4*)(name3 + count); \
+            name5 = (type5*)(name4 + count); \
+            name6 = (type6*)(name5 + count); \
+            name7 = (type7*)(name6 + count); \
+            name8 = (type8*)(name7 + count); \
+            _size = count; \
+            _capacity = count; \
+        } \
+        inline bool ownsMemory() const { return _ownsMemory; } \
+        static const uint32_t COLUMN_COUNT = 8; \
+        /*Name and element size of every column, in layout order*/ \
+        static void getColumns(memory::SoaColumn* out) \
+        { \
+            out[0].name = #name1; out[0].elementSize = sizeof(type1); \
+            out[1].name = #name2; out[1].elementSize = sizeof(type2); \
+            out[2].name = #name3; out[2].elementSize = sizeof(type3); \
+            out[3].name = #name4; out[3].elementSize = sizeof(type4); \
+            out[4].name = #name5; out[4].elementSize = sizeof(type5); \
+            out[5].name = #name6; out[5].elementSize = sizeof(type6); \
+            out[6].name = #name7; out[6].elementSize = sizeof(type7); \
+            out[7].name = #name8; out[7].elementSize = sizeof(type8); \
+        } \
     }
 
 #endif
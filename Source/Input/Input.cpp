@@ -2,10 +2,11 @@
 #include <cstdlib>
 #include "Input.h"
 #include "KeyBindings.h"
+#include "InputRecording.h"
 
 namespace input
 {
-    Input::Input() : _prevKeys(nullptr), _binds(nullptr)
+    Input::Input() : _prevKeys(nullptr), _binds(nullptr), _recording(nullptr)
     {
     }
 
@@ -19,18 +20,36 @@ namespace input
         SDL_GetKeyboardState(&_keysLen);
         _prevKeys = (bool*)malloc(2 * _keysLen);
         _nextKeys = _prevKeys + _keysLen;
+        clear();
 
         _binds = &binds;
     }
 
     void Input::update()
     {
+        memcpy(_prevKeys, _nextKeys, _keysLen * sizeof(bool));
+
+        if (_recording != nullptr && _recording->isReplaying())
+        {
+            _recording->replayKeys(_prevKeys, _nextKeys, _keysLen);
+            return;
+        }
+
         const uint8_t* keys = SDL_GetKeyboardState(nullptr);
         for (int i = 0; i < _keysLen; i++)
         {
-            _prevKeys[i] = _nextKeys[i];
             _nextKeys[i] = (keys[i] != 0);
         }
+
+        if (_recording != nullptr && _recording->isRecording())
+        {
+            _recording->recordKeys(_prevKeys, _nextKeys, _keysLen);
+        }
+    }
+
+    void Input::clear()
+    {
+        memset(_prevKeys, 0, 2 * _keysLen * sizeof(bool));
     }
 
     bool Input::moveLeft()
@@ -6,6 +6,7 @@
 namespace input
 {
     struct KeyBindings;
+    class InputRecording;
 
     class Input
     {
@@ -14,13 +15,19 @@ namespace input
         bool* _prevKeys;
         bool* _nextKeys;
         KeyBindings* _binds;
+        InputRecording* _recording;
 
     public:
         Input();
         ~Input();
 
-        void Input::init(KeyBindings& binds);
+        void init(KeyBindings& binds);
         void update();
+        //Releases every key, so a recorded session starts the same way it's replayed
+        void clear();
+
+        //Recordings get every update's keys, replays supply them instead of the keyboard
+        void setRecording(InputRecording* recording) { _recording = recording; }
 
         bool moveLeft();
         bool moveRight();
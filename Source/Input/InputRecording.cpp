@@ -0,0 +1,235 @@
+#include "Core/Core.h"
+#include "InputRecording.h"
+#include <cstdio>
+#include "Util/Archives.h"
+#include "Util/File.h"
+
+namespace input
+{
+    static const uint32_t RECORDING_MAGIC = 0x5249574E;   //"NWIR"
+    static const uint32_t RECORDING_VERSION = 1;
+
+    static void writeVarint(eastl::vector<uint8_t>& out, uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((uint8_t)value);
+    }
+
+    static uint32_t readVarint(const eastl::vector<uint8_t>& in, uint32_t& pos)
+    {
+        uint32_t value = 0;
+        uint32_t shift = 0;
+        uint8_t byte;
+        do
+        {
+            NW_REQUIRE(pos < in.size());    //Truncated recording
+            byte = in[pos++];
+            value |= (uint32_t)(byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        return value;
+    }
+
+    InputRecording::InputRecording() :
+        _mode(Mode::Off),
+        _seed(0),
+        _keysPos(0),
+        _framesPos(0),
+        _checksumIndex(0),
+        _frameCount(0),
+        _ticks(0),
+        _diverged(false)
+    {
+    }
+
+    void InputRecording::startRecording(uint32_t seed)
+    {
+        _mode = Mode::RecordPending;
+        _seed = seed;
+    }
+
+    void InputRecording::startReplay()
+    {
+        _mode = Mode::ReplayPending;
+    }
+
+    void InputRecording::beginSession(asset::AssetRef sceneRef)
+    {
+        if (_mode == Mode::RecordPending)
+        {
+            _mode = Mode::Recording;
+            _sceneRef = sceneRef;
+            _keys.clear();
+            _frames.clear();
+            _checksums.clear();
+            _frameCount = 0;
+        }
+        else
+        {
+            NW_ASSERT(_mode == Mode::ReplayPending);
+            NW_ASSERT(sceneRef == _sceneRef);
+            _mode = Mode::Replaying;
+            _keysPos = 0;
+            _framesPos = 0;
+            _checksumIndex = 0;
+            _diverged = false;
+        }
+        _ticks = 0;
+    }
+
+    void InputRecording::stop()
+    {
+        _mode = Mode::Off;
+    }
+
+    template <typename Archive>
+    void InputRecording::serialize(Archive& ar)
+    {
+        ar.serializeCustom(_sceneRef);
+        ar.serializeU32(_seed);
+        ar.serializeU32(_frameCount);
+        ar.serializeU32(_ticks);
+
+        uint32_t keysLen = (uint32_t)_keys.size();
+        uint32_t framesLen = (uint32_t)_frames.size();
+        uint32_t checksumsLen = (uint32_t)_checksums.size();
+        ar.serializeU32(keysLen);
+        ar.serializeU32(framesLen);
+        ar.serializeU32(checksumsLen);
+        if (ar.IsReading)
+        {
+            _keys.resize(keysLen);
+            _frames.resize(framesLen);
+            _checksums.resize(checksumsLen);
+        }
+        AR_SERIALIZE_ARRAY_U8(ar, _keys.data(), keysLen);
+        AR_SERIALIZE_ARRAY_U8(ar, _frames.data(), framesLen);
+        AR_SERIALIZE_ARRAY_U32(ar, _checksums.data(), checksumsLen);
+    }
+
+    bool InputRecording::save(const char* fileName)
+    {
+        util::EndianVectorWriteArchive ar;
+        uint32_t magic = RECORDING_MAGIC;
+        uint32_t version = RECORDING_VERSION;
+        ar.serializeU32(magic);
+        ar.serializeU32(version);
+        serialize(ar);
+
+        return util::file::writeAllBytes(fileName, ar.data(), ar.size());
+    }
+
+    bool InputRecording::load(const char* fileName)
+    {
+        eastl::vector<uint8_t> data;
+        if (!util::file::readAllBytes(fileName, data) || data.size() < 2 * sizeof(uint32_t))
+        {
+            return false;
+        }
+
+        util::MemoryReadArchive ar;
+        ar.init(data.data(), data.size());
+        ar.setMappingEnabled(false);
+
+        uint32_t magic, version;
+        ar.serializeU32(magic);
+        ar.serializeU32(version);
+        if (magic != RECORDING_MAGIC || version != RECORDING_VERSION)
+        {
+            printf("%s is not an input recording this build can replay\n", fileName);
+            return false;
+        }
+
+        serialize(ar);
+        _mode = Mode::Off;
+        return true;
+    }
+
+    void InputRecording::recordKeys(const bool* prevKeys, const bool* nextKeys, int keysLen)
+    {
+        uint32_t changed = 0;
+        for (int i = 0; i < keysLen; i++)
+        {
+            if (prevKeys[i] != nextKeys[i]) { changed++; }
+        }
+
+        writeVarint(_keys, changed);
+        for (int i = 0; i < keysLen && changed > 0; i++)
+        {
+            if (prevKeys[i] != nextKeys[i])
+            {
+                writeVarint(_keys, (uint32_t)i);
+                changed--;
+            }
+        }
+    }
+
+    void InputRecording::replayKeys(const bool* prevKeys, bool* nextKeys, int keysLen)
+    {
+        memcpy(nextKeys, prevKeys, keysLen * sizeof(bool));
+
+        //Updates past the end of the recording keep every key as it was
+        if (_keysPos >= _keys.size())
+        {
+            return;
+        }
+
+        uint32_t changed = readVarint(_keys, _keysPos);
+        for (uint32_t i = 0; i < changed; i++)
+        {
+            uint32_t scancode = readVarint(_keys, _keysPos);
+            NW_REQUIRE(scancode < (uint32_t)keysLen);
+            nextKeys[scancode] = !nextKeys[scancode];
+        }
+    }
+
+    void InputRecording::recordFrame(uint32_t elapsedTicks)
+    {
+        writeVarint(_frames, elapsedTicks);
+        _frameCount++;
+    }
+
+    bool InputRecording::replayFrame(uint32_t& elapsedTicks)
+    {
+        if (_framesPos >= _frames.size())
+        {
+            return false;
+        }
+
+        elapsedTicks = readVarint(_frames, _framesPos);
+        return true;
+    }
+
+    bool InputRecording::endTick()
+    {
+        if (_mode == Mode::Off) { return false; }
+
+        _ticks++;
+        return (_ticks % CHECKSUM_TICKS) == 0;
+    }
+
+    void InputRecording::checkState(uint32_t stateHash)
+    {
+        if (_mode == Mode::Recording)
+        {
+            _checksums.push_back(stateHash);
+            return;
+        }
+
+        //Replays that run past the recording have nothing to compare against
+        if (_checksumIndex >= _checksums.size() || _diverged)
+        {
+            return;
+        }
+
+        if (_checksums[_checksumIndex++] != stateHash)
+        {
+            printf("Replay diverged from the recording between ticks %u and %u\n", _ticks - CHECKSUM_TICKS, _ticks);
+            _diverged = true;
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef INPUT_INPUT_RECORDING_H
+#define INPUT_INPUT_RECORDING_H
+
+#include <stdint.h>
+#include <EASTL/vector.h>
+#include "Asset/AssetRef.h"
+
+namespace input
+{
+    //One play session's input, kept so it can be played back and give exactly
+    //the same simulation.
+    //
+    //A session starts with a scene load. Every Input::update() from then on
+    //stores the keys that changed since the previous one, and every frame
+    //stores how far the timer moved, which decides how many fixed updates
+    //ran in it. Scripts draw from rand(), so the seed it gets on load is
+    //stored too. A hash of the scene state is kept every CHECKSUM_TICKS fixed
+    //updates, so a replay that drifts says roughly when.
+    //
+    //Counts, scancodes and frame times are LEB128 varints, an idle tick costs
+    //one byte.
+    class InputRecording
+    {
+    public:
+        static const uint32_t CHECKSUM_TICKS = 60;
+
+    private:
+        enum class Mode { Off, RecordPending, ReplayPending, Recording, Replaying };
+
+        Mode _mode;
+        asset::AssetRef _sceneRef;
+        uint32_t _seed;
+
+        eastl::vector<uint8_t> _keys;       //Per Input::update(): changed count, then scancodes
+        eastl::vector<uint8_t> _frames;     //Per frame: elapsed milliseconds
+        eastl::vector<uint32_t> _checksums;
+
+        //Replay positions
+        uint32_t _keysPos;
+        uint32_t _framesPos;
+        uint32_t _checksumIndex;
+
+        uint32_t _frameCount;
+        uint32_t _ticks;            //Fixed updates recorded or replayed so far
+        bool _diverged;
+
+    public:
+        InputRecording();
+
+        //Both take effect at the next scene load, see beginSession(). Replays
+        //have to load getSceneRef().
+        void startRecording(uint32_t seed);
+        bool load(const char* fileName);
+        void startReplay();
+
+        bool isPending() const { return _mode == Mode::RecordPending || _mode == Mode::ReplayPending; }
+        void beginSession(asset::AssetRef sceneRef);
+
+        bool save(const char* fileName);
+        void stop();
+
+        bool isActive() const { return _mode == Mode::Recording || _mode == Mode::Replaying; }
+        bool isRecording() const { return _mode == Mode::Recording; }
+        bool isReplaying() const { return _mode == Mode::Replaying; }
+        asset::AssetRef getSceneRef() const { return _sceneRef; }
+        uint32_t getSeed() const { return _seed; }
+        uint32_t getTickCount() const { return _ticks; }
+        uint32_t getFrameCount() const { return _frameCount; }
+        bool hasDiverged() const { return _diverged; }
+
+        //Called from Input::update(). Replaying turns the previous keys into
+        //the recorded ones for this update.
+        void recordKeys(const bool* prevKeys, const bool* nextKeys, int keysLen);
+        void replayKeys(const bool* prevKeys, bool* nextKeys, int keysLen);
+
+        //Called once per frame with the timer's elapsed ticks. Replaying returns
+        //false once every recorded frame has been played.
+        void recordFrame(uint32_t elapsedTicks);
+        bool replayFrame(uint32_t& elapsedTicks);
+
+        //Called after every fixed update, returns true when checkState() wants the state hash
+        bool endTick();
+        void checkState(uint32_t stateHash);
+
+    private:
+        template <typename Archive>
+        void serialize(Archive& ar);
+    };
+}
+
+#endif
@@ -21,6 +21,58 @@ void cookMain()
 }
 #endif
 
+#ifdef NW_BENCHMARKS
+#include <cstdio>
+#include "Bench/Bench.h"
+
+//Usage: bench [name]
+void benchMain(int argc, char** argv)
+{
+    NW_ASSERT(SDL_Init(SDL_INIT_TIMER) == 0);
+
+    const char* name = (argc > 2) ? argv[2] : nullptr;
+    if (!bench::runBenchmarks(name))
+    {
+        printf("Unknown benchmark %s\n", name);
+    }
+}
+#endif
+
+#ifdef NW_HEADLESS
+#include <cstdio>
+#include <cstdlib>
+#include "Bench/Bench.h"
+
+//Usage: FairlightBench [ticks]
+//Runs the scene in Assets.cpk for that many fixed updates, then prints the time
+//spent in each zone per tick and the memory the scene ended up holding
+//Usage: FairlightBench replay <file>
+//Plays an input recording back at full speed, frame times go to replay_frames.json
+void headlessMain(int argc, char** argv)
+{
+    if (argc > 2 && strcmp(argv[1], "replay") == 0)
+    {
+        Application app(true);
+        if (app.replayInput(argv[2]))
+        {
+            while (app.isRunning())
+            {
+                app.update();
+            }
+        }
+        return;
+    }
+
+    uint32_t ticks = (argc > 1) ? (uint32_t)strtoul(argv[1], nullptr, 10) : 3600;
+
+    Application app(true);
+    bench::BenchTimer timer("Scene ticks");
+    app.runHeadless(ticks);
+    timer.stop(ticks);
+    app.printMemoryReport();
+}
+#endif
+
 
 int main(int argc, char** argv)
 {
@@ -31,14 +83,33 @@ int main(int argc, char** argv)
         exit(0);
     }
 #endif
-    NW_UNUSED(argc);
-    NW_UNUSED(argv);
-
+#ifdef NW_BENCHMARKS
+    if (argc > 1 && strcmp(argv[1], "bench") == 0)
+    {
+        benchMain(argc, argv);
+        exit(0);
+    }
+#endif
+#ifdef NW_HEADLESS
+    headlessMain(argc, argv);
+    return 0;
+#else
+    //Usage: Fairlight [record | replay <file>]
     Application app;
+    if (argc > 1 && strcmp(argv[1], "record") == 0)
+    {
+        app.recordInput();
+    }
+    else if (argc > 2 && strcmp(argv[1], "replay") == 0)
+    {
+        app.replayInput(argv[2]);
+    }
+
     while (app.isRunning())
     {
         app.update();
     }
 
     return 0;
+#endif
 }
@@ -78,17 +78,17 @@ namespace math
 
     inline float sinDeg(float theta)
     {
-        return std::sinf(theta * DEG2RAD);
+        return std::sin(theta * DEG2RAD);
     }
 
     inline float cosDeg(float theta)
     {
-        return std::cosf(theta * DEG2RAD);
+        return std::cos(theta * DEG2RAD);
     }
 
     inline float tanDeg(float theta)
     {
-        return std::tanf(theta * DEG2RAD);
+        return std::tan(theta * DEG2RAD);
     }
 
     inline bool floatEq(float lhs, float rhs)
@@ -2,6 +2,7 @@
 #define MATH_VECTOR2F_H
 
 #include "Math.h"
+#include "../Util/ArchiveTraits.h"
 
 namespace math
 {
@@ -33,6 +34,7 @@ namespace math
         {
         }
 
+        AR_BULK_SERIALIZABLE(8);
         template <typename Archive>
         void serialize(Archive& ar)
         {
@@ -3,6 +3,7 @@
 
 #include "Math.h"
 #include <stdint.h>
+#include "../Util/ArchiveTraits.h"
 
 namespace math
 {
@@ -34,6 +35,7 @@ namespace math
         {
         }
 
+        AR_BULK_SERIALIZABLE(8);
         template <typename Archive>
         void serialize(Archive& ar)
         {
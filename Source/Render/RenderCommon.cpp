@@ -10,10 +10,10 @@ namespace render
 
     eastl::vector<bgfx::TextureInfo> g_TextureInfoTable;
 
-    void initRendering(const bgfx::PlatformData& platformData)
+    void initRendering(const bgfx::PlatformData& platformData, bgfx::RendererType::Enum rendererType)
     {
         bgfx::setPlatformData(platformData);
-        bgfx::init(bgfx::RendererType::Direct3D11);
+        bgfx::init(rendererType);
 
         auto* caps = bgfx::getCaps();
         g_TextureInfoTable.resize(caps->limits.maxTextures);
@@ -53,6 +53,7 @@ namespace render
         info.height = (uint16_t)imageContainer->m_height;
         info.numMips = imageContainer->m_numMips;
         info.numLayers = imageContainer->m_numLayers;
+        info.storageSize = imageContainer->m_size;
         g_TextureInfoTable[handle.idx] = info;
 
         return handle;
@@ -13,7 +13,7 @@ const uint16_t VIEW_ID_POST = 1;
 
 namespace render
 {
-    void initRendering(const bgfx::PlatformData& platformData);
+    void initRendering(const bgfx::PlatformData& platformData, bgfx::RendererType::Enum rendererType);
 
     bgfx::TextureHandle createTexture(const void* data, uint32_t size, uint32_t flags = 0);
     bgfx::TextureInfo& getTextureInfo(bgfx::TextureHandle handle);
@@ -105,6 +105,8 @@ namespace render
         bgfx::setTexture(0, s_spriteTex, tex);
 
         bgfx::submit(VIEW_ID_SCENE, _spriteProgram);
+        COUNT_WORK(DrawCalls, 1);
+        COUNT_WORK(Vertices, 4);
     }
 
     void Renderer2d::submitSpriteBatch(SpriteBatcher& batcher, bgfx::DynamicVertexBufferHandle vertexBuffer)
@@ -134,6 +136,8 @@ namespace render
         bgfx::setTexture(0, s_spriteTex, tex);
 
         bgfx::submit(VIEW_ID_SCENE, _spriteProgram);
+        COUNT_WORK(DrawCalls, 1);
+        COUNT_WORK(Vertices, batcher.getVertexCount());
     }
 
     void SpriteBatcher::submitSprite(Vector2i pos, Vector2i isize, Vector2i texOffset)
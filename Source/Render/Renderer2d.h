@@ -73,7 +73,8 @@ namespace render
 
         uint8_t getDepth() { return _depth; }
         bgfx::TextureHandle getTexture() { return _texture; }
-        size_t getVertexCount() { return _vertices.size(); }
+        size_t getVertexCount() const { return _vertices.size(); }
+        size_t getVertexCapacity() const { return _vertices.capacity(); }
         SpriteVertex* getVertices() { return _vertices.data(); }
     };
 }
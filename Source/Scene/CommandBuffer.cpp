@@ -0,0 +1,103 @@
+#include "Core/Core.h"
+#include "CommandBuffer.h"
+
+namespace scene
+{
+    CommandBuffer::CommandBuffer()
+    {
+        memset(_createCounts, 0, sizeof(_createCounts));
+    }
+
+    void CommandBuffer::create(ComponentType type, Entity e)
+    {
+        push(Op::Create, type, e);
+        setPending(type, e, Pending::Created);
+        _createCounts[(uint32_t)type]++;
+    }
+
+    void CommandBuffer::createScript(Entity e, script::AngelType aType)
+    {
+        static_assert(sizeof(aType) <= sizeof(Command::value), "AngelType doesn't fit in a command.");
+
+        Command& cmd = push(Op::Create, ComponentType::Script, e);
+        memcpy(cmd.value, &aType, sizeof(aType));
+        setPending(ComponentType::Script, e, Pending::Created);
+        _createCounts[(uint32_t)ComponentType::Script]++;
+    }
+
+    void CommandBuffer::destroy(ComponentType type, Entity e)
+    {
+        push(Op::Destroy, type, e);
+        setPending(type, e, Pending::Destroyed);
+    }
+
+    void CommandBuffer::instantiate(uint32_t templateIndex, uint8_t components, const Entity* entities, uint32_t count,
+        const Vector2i* positions)
+    {
+        Instantiation inst;
+        inst.templateIndex = templateIndex;
+        inst.first = (uint32_t)_instantiated.size();
+        inst.count = count;
+        inst.firstPosition = UINT32_MAX;
+        _instantiated.insert(_instantiated.end(), entities, entities + count);
+        if (positions != nullptr)
+        {
+            inst.firstPosition = (uint32_t)_instantiatedPositions.size();
+            _instantiatedPositions.insert(_instantiatedPositions.end(), positions, positions + count);
+        }
+        _instantiations.push_back(inst);
+
+        for (uint32_t type = 0; type < COMPONENT_TYPE_COUNT; type++)
+        {
+            if ((components >> type & 1) == 0) { continue; }
+
+            _createCounts[type] += count;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                setPending((ComponentType)type, entities[i], Pending::Created);
+            }
+        }
+    }
+
+    void CommandBuffer::clear()
+    {
+        _commands.clear();
+        _instantiations.clear();
+        _instantiated.clear();
+        _instantiatedPositions.clear();
+        for (uint32_t index : _pendingIndices)
+        {
+            _pending[index] = 0;
+        }
+        _pendingIndices.clear();
+        memset(_createCounts, 0, sizeof(_createCounts));
+    }
+
+    CommandBuffer::Command& CommandBuffer::push(Op op, ComponentType type, Entity e)
+    {
+        _commands.push_back();
+        Command& cmd = _commands.back();
+        cmd.entity = e;
+        cmd.value[0] = 0;
+        cmd.value[1] = 0;
+        cmd.op = op;
+        cmd.component = type;
+        cmd.property = Property::None;
+        return cmd;
+    }
+
+    void CommandBuffer::setPending(ComponentType type, Entity e, Pending pending)
+    {
+        uint32_t index = e.index();
+        if (index >= _pending.size())
+        {
+            _pending.resize(index + 1, 0);
+        }
+
+        uint16_t& state = _pending[index];
+        if (state == 0) { _pendingIndices.push_back(index); }
+
+        uint32_t shift = (uint32_t)type * 2;
+        state = (uint16_t)((state & ~(3u << shift)) | ((uint32_t)pending << shift));
+    }
+}
@@ -0,0 +1,165 @@
+#ifndef SCENE_COMMAND_BUFFER_H
+#define SCENE_COMMAND_BUFFER_H
+
+#include <string.h>
+#include <EASTL/vector.h>
+#include "Math/Vector2i.h"
+#include "Math/Vector2f.h"
+#include "Script/AngelType.h"
+#include "Entity.h"
+
+using namespace math;
+
+namespace scene
+{
+    //Same order as the component bits in prefab data
+    enum class ComponentType : uint8_t
+    {
+        Tag,
+        Transform,
+        Sprite,
+        Movement,
+        Script,
+        Count
+    };
+
+    static const uint32_t COMPONENT_TYPE_COUNT = (uint32_t)ComponentType::Count;
+
+    //Records structural changes (component creation and destruction, prefab
+    //instances) and property writes so they can be applied in one batch at
+    //a sync point instead of in the middle of a system's update.
+    //
+    //The scene keeps one buffer per job system thread, so recording never
+    //needs a lock. Entities themselves are still created and destroyed
+    //immediately: the caller needs the handle right away, and neither
+    //touches component storage (destroyed entities are removed from the
+    //systems by Scene::handleDestroyed()).
+    class CommandBuffer
+    {
+    public:
+        enum class Op : uint8_t
+        {
+            Create,
+            Destroy,
+            Set
+        };
+
+        enum class Property : uint8_t
+        {
+            None,
+            TransformLocalPos,      //Vector2i
+            TransformWorldPos,      //Vector2i
+            SpriteSize,             //Vector2i
+            SpriteOffset,           //Vector2i
+            SpriteTexOffset,        //Vector2i
+            SpriteDepth,            //uint8_t
+            SpriteAlpha,            //uint8_t
+            SpriteTexture,          //AssetRef hash
+            SpriteHorFlip,          //bool
+            SpriteVerFlip,          //bool
+            SpriteRotation,         //int32_t
+            MovementSize,           //Vector2i
+            MovementOffset,         //Vector2i
+            MovementVelocity,       //Vector2f
+            MovementWorldCollision, //bool
+            TagAdd,                 //uint32_t
+            TagRemove               //uint32_t
+        };
+
+        struct Command
+        {
+            Entity entity;
+            uint32_t value[2];      //Property value, or the AngelType of a script create
+            Op op;
+            ComponentType component;
+            Property property;
+
+            template <typename T> T getValue() const
+            {
+                static_assert(sizeof(T) <= sizeof(value), "Value doesn't fit in a command.");
+                T result;
+                memcpy(&result, value, sizeof(T));
+                return result;
+            }
+        };
+
+        //Prefab instances, their entities and positions are stored in
+        //separate arrays so a whole batch is created with one call
+        struct Instantiation
+        {
+            uint32_t templateIndex;
+            uint32_t first;         //First of the instantiated entities
+            uint32_t count;
+            uint32_t firstPosition; //UINT32_MAX if the transforms start at the origin
+        };
+
+        //Change a buffer makes to a component before it is played back
+        enum class Pending : uint8_t
+        {
+            None,
+            Created,
+            Destroyed
+        };
+
+    private:
+        eastl::vector<Command> _commands;
+        eastl::vector<Instantiation> _instantiations;
+        eastl::vector<Entity> _instantiated;
+        eastl::vector<Vector2i> _instantiatedPositions;
+
+        //Pending state of every component type, two bits each, indexed by
+        //entity index. Entries the buffer touched are listed so clear()
+        //only resets those.
+        eastl::vector<uint16_t> _pending;
+        eastl::vector<uint32_t> _pendingIndices;
+        uint32_t _createCounts[COMPONENT_TYPE_COUNT];
+
+        static_assert(COMPONENT_TYPE_COUNT * 2 <= sizeof(uint16_t) * 8, "Pending state doesn't fit");
+
+    public:
+        CommandBuffer();
+
+        void create(ComponentType type, Entity e);
+        void createScript(Entity e, script::AngelType aType);
+        void destroy(ComponentType type, Entity e);
+        //Records prefab components (a mask of ComponentType bits) for entities
+        //that were just created. positions may be null.
+        void instantiate(uint32_t templateIndex, uint8_t components, const Entity* entities, uint32_t count,
+            const Vector2i* positions);
+
+        template <typename T>
+        void set(Property property, Entity e, const T& value)
+        {
+            static_assert(sizeof(T) <= sizeof(Command::value), "Value doesn't fit in a command.");
+            Command& cmd = push(Op::Set, ComponentType::Count, e);
+            cmd.property = property;
+            memcpy(cmd.value, &value, sizeof(T));
+        }
+
+        //Whether the component was created or destroyed since the last playback.
+        //The entity has to be alive.
+        Pending getPending(ComponentType type, Entity e) const
+        {
+            uint32_t index = e.index();
+            if (index >= _pending.size()) { return Pending::None; }
+            return (Pending)((_pending[index] >> ((uint32_t)type * 2)) & 3);
+        }
+
+        const eastl::vector<Command>& getCommands() const { return _commands; }
+        const eastl::vector<Instantiation>& getInstantiations() const { return _instantiations; }
+        const Entity* getInstantiated(const Instantiation& inst) const { return _instantiated.data() + inst.first; }
+        const Vector2i* getInstantiatedPositions(const Instantiation& inst) const
+        {
+            return (inst.firstPosition != UINT32_MAX) ? _instantiatedPositions.data() + inst.firstPosition : nullptr;
+        }
+        uint32_t getCreateCount(ComponentType type) const { return _createCounts[(uint32_t)type]; }
+        bool isEmpty() const { return _commands.empty() && _instantiations.empty(); }
+        void clear();
+
+    private:
+        Command& push(Op op, ComponentType type, Entity e);
+        void setPending(ComponentType type, Entity e, Pending pending);
+    };
+}
+
+#endif
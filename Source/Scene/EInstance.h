@@ -2,6 +2,7 @@
 #define SCENE_EINSTANCE_H
 
 #include <stdint.h>
+#include "Util/ArchiveTraits.h"
 
 namespace scene
 {
@@ -15,6 +16,7 @@ namespace scene
         bool isValid();
         bool operator==(const EInstance& other) const;
 
+        AR_BULK_SERIALIZABLE(4);
         template <typename Archive>
         void serialize(Archive& ar)
         {
@@ -3,15 +3,30 @@
 
 #include <stdint.h>
 #include <EASTL/functional.h>
+#include "Util/ArchiveTraits.h"
 
 namespace scene
 {
-    const uint32_t ENTITY_INDEX_BITS = 23;
-    const uint32_t ENTITY_INDEX_MASK = (1 << ENTITY_INDEX_BITS) - 1;
+#ifdef NW_ENTITY_64BIT
+    typedef uint64_t EntityId;
+    typedef uint32_t EntityGen;
+
+    const uint32_t ENTITY_INDEX_BITS = 31;
+    const uint32_t ENTITY_GEN_BITS = 32;
+#else
+    typedef uint32_t EntityId;
+    typedef uint8_t EntityGen;
 
-    //If this is increased beyond 8 bits, you need to update the EntityManager as well
+    const uint32_t ENTITY_INDEX_BITS = 23;
     const uint32_t ENTITY_GEN_BITS = 8;
-    const uint32_t ENTITY_GEN_MASK = (1 << ENTITY_GEN_BITS) - 1;
+#endif
+
+    const uint32_t ENTITY_INDEX_MASK = (uint32_t)((1ull << ENTITY_INDEX_BITS) - 1);
+    const uint32_t ENTITY_GEN_MASK = (uint32_t)((1ull << ENTITY_GEN_BITS) - 1);
+    const EntityId ENTITY_INVALID_ID = ~(EntityId)0;
+
+    static_assert(ENTITY_INDEX_BITS + ENTITY_GEN_BITS + 1 == sizeof(EntityId) * 8, "Entity bits don't fill the id");
+    static_assert(ENTITY_GEN_BITS <= sizeof(EntityGen) * 8, "EntityGen is too small for the generation");
 
     struct Entity
     {
@@ -20,17 +35,17 @@ namespace scene
         {
             struct
             {
-                uint32_t _index : ENTITY_INDEX_BITS;
-                uint32_t _gen : ENTITY_GEN_BITS;
-                uint32_t _invalidBit : 1;
+                EntityId _index : ENTITY_INDEX_BITS;
+                EntityId _gen : ENTITY_GEN_BITS;
+                EntityId _invalidBit : 1;
             };
-            uint32_t _id;
+            EntityId _id;
         };
 
     public:
-        Entity() : _id(UINT32_MAX) { }
-        Entity(uint32_t id) : _id(id) { }
-        Entity(uint32_t index, uint8_t gen)
+        Entity() : _id(ENTITY_INVALID_ID) { }
+        Entity(EntityId id) : _id(id) { }
+        Entity(uint32_t index, EntityGen gen)
         {
             NW_ASSERT(index <= ENTITY_INDEX_MASK);
             NW_ASSERT(gen <= ENTITY_GEN_MASK);
@@ -39,21 +54,25 @@ namespace scene
             _invalidBit = 0;
         }
 
-        uint32_t id() const { return _id; }
-        uint32_t index() const { return _index; }
-        uint8_t gen() const { return _gen; }
-        static_assert(ENTITY_GEN_BITS <= 8, "gen() is returning a uint8_t");
+        EntityId id() const { return _id; }
+        uint32_t index() const { return (uint32_t)_index; }
+        EntityGen gen() const { return (EntityGen)_gen; }
 
         bool isValid()
         {
-            NW_ASSERT((bool)_invalidBit == (_id == UINT32_MAX));
+            NW_ASSERT((bool)_invalidBit == (_id == ENTITY_INVALID_ID));
             return !_invalidBit;
         }
 
         bool operator==(Entity other) const { return _id == other._id; }
         bool operator!=(Entity other) const { return _id != other._id; }
 
+        AR_BULK_SERIALIZABLE(sizeof(EntityId));
+#ifdef NW_ENTITY_64BIT
+        template <typename Archive> void serialize(Archive& ar) { ar.serializeU64(_id); }
+#else
         template <typename Archive> void serialize(Archive& ar) { ar.serializeU32(_id); }
+#endif
     };
 }
 
@@ -75,7 +94,7 @@ namespace std
     {
         std::size_t operator()(const scene::Entity& k) const
         {
-            return std::hash<uint32_t>()(k.id());
+            return std::hash<scene::EntityId>()(k.id());
         }
     };
 }
@@ -3,13 +3,27 @@
 
 namespace scene
 {
+    const uint32_t INVALID_INDEX = UINT32_MAX;
+
+#ifdef NW_ENTITY_64BIT
+    //32 bit generations don't wrap in practice, so indices can be reused right away
+    const uint32_t MINIMUM_FREE_INDICES = 0;
+#else
     const uint32_t MINIMUM_FREE_INDICES = 1024;
+#endif
 
 #ifdef USE_ENTITY_DEBUG_NAMES
     EntityManager* EntityManager::sInstance = nullptr;
 #endif
 
-    EntityManager::EntityManager()
+    EntityManager::EntityManager() :
+        _freeHead(INVALID_INDEX),
+        _freeTail(INVALID_INDEX),
+        _freeCount(0),
+        _concurrent(false),
+        _concurrentFirst(0),
+        _concurrentMax(0),
+        _concurrentNext(0)
     {
 #ifdef USE_ENTITY_DEBUG_NAMES
         sInstance = this;
@@ -18,45 +32,64 @@ namespace scene
 
     bool EntityManager::alive(Entity e)
     {
-        return e.isValid() && _gens[e.index()] == e.gen();
+        //Rewinding can leave handles to indices that don't exist yet
+        return e.isValid() && e.index() < _gens.size() &&
+            nw::atomicLoad(&_gens[e.index()]) == e.gen();
     }
 
     Entity EntityManager::create()
     {
-        uint32_t index;
+        Entity e;
+        createMany(1, &e);
+        return e;
+    }
+
+    void EntityManager::createMany(uint32_t count, Entity* outEntities)
+    {
+        NW_ASSERT(!_concurrent);
 
-        if (_freeIndices.size() > MINIMUM_FREE_INDICES)
+        //Reuse free indices first, leaving the minimum in the queue
+        uint32_t reused = 0;
+        if (_freeCount > MINIMUM_FREE_INDICES)
         {
-            index = _freeIndices.front();
-            _freeIndices.pop_front();
+            reused = eastl::min(count, _freeCount - MINIMUM_FREE_INDICES);
         }
-        else
-        {
-            _gens.push_back(0);
-            index = (uint32_t)_gens.size() - 1;
 
-            NW_ASSERT(index <= ENTITY_INDEX_MASK);
+        for (uint32_t i = 0; i < reused; i++)
+        {
+            uint32_t index = popFree();
+            if (outEntities != nullptr) { outEntities[i] = Entity(index, _gens[index]); }
         }
 
-#ifdef USE_ENTITY_DEBUG_NAMES
-        //printf("Entity created (%d, %d)\n", index, _gens[index]);
-        _debugNames.reserve(index + 1);
-        if (_debugNames.size() < _debugNames.capacity())
+        //The rest are appended as one range
+        uint32_t first = (uint32_t)_gens.size();
+        uint32_t fresh = count - reused;
+        if (fresh > 0)
         {
-            _debugNames.resize(_debugNames.capacity());
+            NW_ASSERT(first + fresh - 1 <= ENTITY_INDEX_MASK);
+            _gens.resize(first + fresh, 0);
+            _nextFree.resize(first + fresh, INVALID_INDEX);
+
+            if (outEntities != nullptr)
+            {
+                for (uint32_t i = 0; i < fresh; i++)
+                {
+                    outEntities[reused + i] = Entity(first + i, 0);
+                }
+            }
         }
-#endif
 
-        return Entity(index, _gens[index]);
+        growDebugNames();
     }
 
     void EntityManager::destroy(Entity e)
     {
+        NW_ASSERT(!_concurrent);
         NW_ASSERT(alive(e));
 
         auto index = e.index();
-        _gens[index]++;  //Increment gen to destroy
-        _freeIndices.push_back(index);
+        _gens[index] = (EntityGen)((_gens[index] + 1) & ENTITY_GEN_MASK);  //Increment gen to destroy
+        pushFree(index);
 
         //Keep track of the destroyed entities
         _destroyed.push_back(e);
@@ -67,6 +100,158 @@ namespace scene
 #endif
     }
 
+    void EntityManager::destroyMany(const Entity* entities, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            destroy(entities[i]);
+        }
+    }
+
+    void EntityManager::beginConcurrent(uint32_t threadCount, uint32_t maxCreates)
+    {
+        NW_ASSERT(!_concurrent);
+        _concurrent = true;
+
+        //Take free indices off the front of the queue, then append fresh ones for the rest
+        uint32_t reused = 0;
+        if (_freeCount > MINIMUM_FREE_INDICES)
+        {
+            reused = eastl::min(maxCreates, _freeCount - MINIMUM_FREE_INDICES);
+        }
+
+        _concurrentFree.resize(reused);
+        for (uint32_t i = 0; i < reused; i++)
+        {
+            _concurrentFree[i] = popFree();
+        }
+
+        _concurrentFirst = (uint32_t)_gens.size();
+        uint32_t fresh = maxCreates - reused;
+        NW_ASSERT(fresh == 0 || _concurrentFirst + fresh - 1 <= ENTITY_INDEX_MASK);
+        _gens.resize(_concurrentFirst + fresh, 0);
+        _nextFree.resize(_concurrentFirst + fresh, INVALID_INDEX);
+        growDebugNames();
+
+        _concurrentMax = maxCreates;
+        _concurrentNext.store(0, std::memory_order_relaxed);
+
+        if (_threadDestroyed.size() < threadCount)
+        {
+            _threadDestroyed.resize(threadCount);
+        }
+    }
+
+    void EntityManager::endConcurrent()
+    {
+        NW_ASSERT(_concurrent);
+        _concurrent = false;
+
+        uint32_t used = eastl::min(_concurrentNext.load(std::memory_order_relaxed), _concurrentMax);
+        uint32_t reused = (uint32_t)_concurrentFree.size();
+
+        //Unused free indices go back to the front of the queue, in their old order
+        for (uint32_t i = reused; i > used; i--)
+        {
+            uint32_t index = _concurrentFree[i - 1];
+            _nextFree[index] = _freeHead;
+            _freeHead = index;
+            if (_freeCount == 0) { _freeTail = index; }
+            _freeCount++;
+        }
+
+        //Unused fresh indices are at the end, so they can just be dropped
+        uint32_t freshUsed = (used > reused) ? used - reused : 0;
+        _gens.resize(_concurrentFirst + freshUsed);
+        _nextFree.resize(_concurrentFirst + freshUsed);
+
+        //Merging in thread order keeps the destroyed list independent of timing within a thread
+        for (ThreadDestroyed& thread : _threadDestroyed)
+        {
+            for (Entity e : thread.entities)
+            {
+                pushFree(e.index());
+                _destroyed.push_back(e);
+#ifdef USE_ENTITY_DEBUG_NAMES
+                _debugNames[e.index()].clear();
+#endif
+            }
+            thread.entities.clear();
+        }
+        _concurrentFree.clear();
+    }
+
+    Entity EntityManager::createConcurrent()
+    {
+        NW_ASSERT(_concurrent);
+
+        uint32_t slot = _concurrentNext.fetch_add(1, std::memory_order_relaxed);
+        NW_REQUIRE(slot < _concurrentMax);    //More entities created than reserved by beginConcurrent()
+
+        uint32_t reused = (uint32_t)_concurrentFree.size();
+        uint32_t index = (slot < reused) ? _concurrentFree[slot] : _concurrentFirst + (slot - reused);
+
+        //Nothing else can hold a live handle to a reserved index, so the generation is stable
+        return Entity(index, nw::atomicLoad(&_gens[index]));
+    }
+
+    bool EntityManager::destroyConcurrent(uint32_t threadIndex, Entity e)
+    {
+        NW_ASSERT(_concurrent);
+        NW_ASSERT(threadIndex < _threadDestroyed.size());
+
+        if (!e.isValid() || e.index() >= _gens.size()) { return false; }
+
+        //Only the thread that moves the generation on owns the destruction
+        EntityGen gen = e.gen();
+        EntityGen next = (EntityGen)((gen + 1) & ENTITY_GEN_MASK);
+        if (!nw::atomicCompareExchange(&_gens[e.index()], gen, next))
+        {
+            return false;
+        }
+
+        _threadDestroyed[threadIndex].entities.push_back(e);
+        return true;
+    }
+
+    void EntityManager::pushFree(uint32_t index)
+    {
+        //Queue the index at the back of the free list
+        _nextFree[index] = INVALID_INDEX;
+        if (_freeCount == 0)
+        {
+            _freeHead = index;
+        }
+        else
+        {
+            _nextFree[_freeTail] = index;
+        }
+        _freeTail = index;
+        _freeCount++;
+    }
+
+    uint32_t EntityManager::popFree()
+    {
+        NW_ASSERT(_freeCount > 0);
+        uint32_t index = _freeHead;
+        _freeHead = _nextFree[index];
+        _nextFree[index] = INVALID_INDEX;
+        _freeCount--;
+        if (_freeCount == 0) { _freeTail = INVALID_INDEX; }
+        return index;
+    }
+
+    void EntityManager::growDebugNames()
+    {
+#ifdef USE_ENTITY_DEBUG_NAMES
+        _debugNames.reserve(_gens.size());
+        if (_debugNames.size() < _debugNames.capacity())
+        {
+            _debugNames.resize(_debugNames.capacity());
+        }
+#endif
+    }
+
     eastl::vector<Entity>& EntityManager::pollDestroyed()
     {
         return _destroyed;
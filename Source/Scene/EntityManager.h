@@ -1,8 +1,9 @@
 #ifndef SCENE_ENTITY_MANAGER_H
 #define SCENE_ENTITY_MANAGER_H
 
+#include <atomic>
 #include <EASTL/vector.h>
-#include <EASTL/bonus/ring_buffer.h>
+#include "Util/Archives.h"
 #include "Entity.h"
 
 #ifdef NW_DEVELOP
@@ -17,15 +18,36 @@ namespace scene
         //Keeps track of the generation alive at each index.
         //An entity is alive if gens[index] is the same as the entity's gen.
         //When an entity is destroyed, we simply increment the gen counter.
-        eastl::vector<uint8_t> _gens;
+        //The generations are plain integers so the vector can grow on the
+        //main thread; anything that can run during a concurrent section uses
+        //nw::atomicLoad() and nw::atomicCompareExchange() on them.
+        eastl::vector<EntityGen> _gens;
 
-        //To keep the generation from wrapping around too frequently, a list
-        //of free indices is used to keep them from being reused too often.
-        eastl::ring_buffer<uint32_t> _freeIndices;
+        //To keep the generation from wrapping around too frequently, free
+        //indices are reused in the order they were freed (and only once
+        //enough of them have piled up). The queue is threaded through
+        //_nextFree, which is kept the same size as _gens, so recycling an
+        //index never allocates.
+        eastl::vector<uint32_t> _nextFree;
+        uint32_t _freeHead;
+        uint32_t _freeTail;
+        uint32_t _freeCount;
 
         //Keeps track of which entities have destroyed since clearDestroyed() was called
         eastl::vector<Entity> _destroyed;
 
+        //State of the concurrent section, see beginConcurrent()
+        struct alignas(64) ThreadDestroyed
+        {
+            eastl::vector<Entity> entities;
+        };
+        bool _concurrent;
+        eastl::vector<uint32_t> _concurrentFree;    //Free indices handed out first
+        uint32_t _concurrentFirst;                  //First of the fresh indices appended to _gens
+        uint32_t _concurrentMax;
+        std::atomic<uint32_t> _concurrentNext;
+        eastl::vector<ThreadDestroyed> _threadDestroyed;
+
 #ifdef USE_ENTITY_DEBUG_NAMES
         static EntityManager* sInstance;    //Static instance used for natvis
         eastl::vector<eastl::string> _debugNames;
@@ -37,9 +59,60 @@ namespace scene
         Entity create();
         void destroy(Entity e);
 
+        //Creates count entities, written to outEntities if it isn't null.
+        //Entities that don't reuse a free index get consecutive indices.
+        void createMany(uint32_t count, Entity* outEntities);
+        void destroyMany(const Entity* entities, uint32_t count);
+
         eastl::vector<Entity>& pollDestroyed();
         void clearDestroyed();
 
+        //Between beginConcurrent() and endConcurrent(), worker threads may
+        //create up to maxCreates entities and destroy entities from up to
+        //threadCount threads. Everything else, including create() and
+        //destroy(), stays on the main thread and outside the section.
+        //alive() can be called from any thread.
+        //
+        //Indices are reserved up front and handed out with an atomic counter.
+        //Destroying swaps the generation atomically, so an entity destroyed
+        //by two threads at once is only destroyed by one of them. Destroyed
+        //entities are kept per thread and merged into the destroyed list
+        //(and the free list) in thread order by endConcurrent().
+        void beginConcurrent(uint32_t threadCount, uint32_t maxCreates);
+        void endConcurrent();
+        Entity createConcurrent();
+        //Returns false if the entity was already destroyed
+        bool destroyConcurrent(uint32_t threadIndex, Entity e);
+
+        //Generations and free indices, written every tick by the rewind buffer
+        template <typename Archive>
+        void serialize(Archive& ar)
+        {
+            uint32_t gensLen = (uint32_t)_gens.size();
+            ar.serializeU32(gensLen);
+            if (ar.IsReading)
+            {
+                _gens.resize(gensLen);
+                _nextFree.resize(gensLen);
+            }
+#ifdef NW_ENTITY_64BIT
+            AR_SERIALIZE_ARRAY_U32(ar, _gens.data(), gensLen);
+#else
+            AR_SERIALIZE_ARRAY_U8(ar, _gens.data(), gensLen);
+#endif
+            AR_SERIALIZE_ARRAY_U32(ar, _nextFree.data(), gensLen);
+
+            ar.serializeU32(_freeHead);
+            ar.serializeU32(_freeTail);
+            ar.serializeU32(_freeCount);
+        }
+
+    private:
+        void pushFree(uint32_t index);
+        uint32_t popFree();
+        void growDebugNames();
+
+    public:
 #ifdef USE_ENTITY_DEBUG_NAMES
         void setDebugName(Entity en, const char* name);
         const char* getDebugName(Entity en) { return _debugNames[en.index()].c_str(); }
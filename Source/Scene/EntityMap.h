@@ -0,0 +1,77 @@
+#ifndef SCENE_ENTITY_MAP_H
+#define SCENE_ENTITY_MAP_H
+
+#include <stdint.h>
+#include <EASTL/vector.h>
+#include <EASTL/sort.h>
+#include <EASTL/functional.h>
+#include <EASTL/hash_map.h>
+#include "Core/SceneArena.h"
+#include "Entity.h"
+#include "EInstance.h"
+
+namespace scene
+{
+    //Entity -> instance map of a system. Nodes come from the scene arena, so
+    //entity churn recycles them instead of going to the heap.
+    typedef eastl::hash_map<Entity, EInstance, eastl::hash<Entity>, eastl::equal_to<Entity>, memory::SceneAllocator> EntityInstanceMap;
+
+    //Adds a range of a system's entity column to its entity -> instance map.
+    //The buckets are sized once up front so the inserts never trigger a rehash.
+    template <typename Map>
+    void populateEntityMap(Map& map, const Entity* entities, uint32_t length, uint32_t firstIndex = 0)
+    {
+        uint32_t bucketCount = map.rehash_policy().GetBucketCount((uint32_t)map.size() + length);
+        if (bucketCount > map.bucket_count()) { map.rehash(bucketCount); }
+        for (uint32_t i = 0; i < length; i++)
+        {
+            map.insert(typename Map::value_type(entities[firstIndex + i], EInstance(firstIndex + i)));
+        }
+    }
+
+    //Scratch space for removing a batch of destroyed entities from a system.
+    //Owned by the scene and reused by every system.
+    struct DestroyBatch
+    {
+        eastl::vector<uint32_t> indices;    //Instances to remove, highest first
+        eastl::vector<uint32_t> moved;      //Slots that received a surviving instance
+    };
+
+    //Removes the destroyed entities a system has from its map and collects their
+    //instances. Sorted highest first, swap-removing them in order only ever
+    //moves surviving instances down.
+    template <typename Map>
+    void collectDestroyed(Map& map, const Entity* destroyed, size_t destroyedLen, DestroyBatch& batch)
+    {
+        batch.indices.clear();
+        batch.moved.clear();
+
+        for (size_t i = 0; i < destroyedLen; i++)
+        {
+            auto result = map.find(destroyed[i]);
+            if (result != map.end())
+            {
+                batch.indices.push_back(result->second.index);
+                map.erase(result);
+            }
+        }
+
+        eastl::sort(batch.indices.begin(), batch.indices.end(), eastl::greater<uint32_t>());
+    }
+
+    //Points the map at the final slot of every instance moved while compacting
+    template <typename Map>
+    void fixupEntityMap(Map& map, const Entity* entities, uint32_t size, const DestroyBatch& batch)
+    {
+        for (uint32_t index : batch.moved)
+        {
+            //Slots past the end were vacated again by a later removal
+            if (index < size)
+            {
+                map.find(entities[index])->second = EInstance(index);
+            }
+        }
+    }
+}
+
+#endif
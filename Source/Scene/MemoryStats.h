@@ -0,0 +1,104 @@
+#ifndef SCENE_MEMORY_STATS_H
+#define SCENE_MEMORY_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Core/SoaVector.h"
+#include "Core/SceneArena.h"
+#include "Core/BuddyAllocator.h"
+
+namespace scene
+{
+    //Memory one system holds. Used bytes are what its live instances need,
+    //reserved bytes everything allocated for them, the difference is slack.
+    struct SystemMemoryStats
+    {
+        static const uint32_t MAX_COLUMNS = 8;
+
+        const char* name;
+
+        //Component storage, every column shares the size and capacity
+        uint32_t size;
+        uint32_t capacity;
+        bool inImage;           //Columns still point into the scene image
+        uint32_t columnCount;
+        memory::SoaColumn columns[MAX_COLUMNS];
+
+        //Entity -> instance map, every node is live
+        uint32_t mapBuckets;
+        size_t mapBucketBytes;
+        size_t mapNodeBytes;
+
+        //Everything else: tags, tile layers, indices, per frame lists
+        size_t otherUsedBytes;
+        size_t otherReservedBytes;
+
+        size_t getColumnBytes(uint32_t count) const
+        {
+            size_t bytes = 0;
+            for (uint32_t i = 0; i < columnCount; i++) { bytes += (size_t)columns[i].elementSize * count; }
+            return bytes;
+        }
+        size_t getUsedBytes() const { return getColumnBytes(size) + mapNodeBytes + otherUsedBytes; }
+        size_t getReservedBytes() const
+        {
+            return getColumnBytes(capacity) + mapBucketBytes + mapNodeBytes + otherReservedBytes;
+        }
+    };
+
+    struct SceneMemoryStats
+    {
+        static const uint32_t MAX_SYSTEMS = 8;
+
+        uint32_t systemCount;
+        SystemMemoryStats systems[MAX_SYSTEMS];
+
+        uint32_t tileCount;     //In each tile map layer
+        memory::BuddyStats tagBuddy;
+        size_t prefabDataBytes;
+        size_t prefabDataReservedBytes;
+        size_t prefabMapBytes;
+        size_t prefabTemplateBytes;
+        size_t imageBytes;      //Decompressed scene asset
+        memory::SceneArenaStats arena;
+
+        SystemMemoryStats& addSystem(const char* name)
+        {
+            NW_ASSERT(systemCount < MAX_SYSTEMS);
+            SystemMemoryStats& system = systems[systemCount++];
+            memset(&system, 0, sizeof(system));
+            system.name = name;
+            return system;
+        }
+    };
+
+    //Helpers for the systems' getMemoryStats()
+    template <typename Storage>
+    void addStorageStats(SystemMemoryStats& stats, const Storage& storage)
+    {
+        static_assert(Storage::COLUMN_COUNT <= SystemMemoryStats::MAX_COLUMNS, "Too many columns to report");
+        stats.size = storage.getSize();
+        stats.capacity = storage.capacity();
+        stats.inImage = !storage.ownsMemory();
+        stats.columnCount = Storage::COLUMN_COUNT;
+        Storage::getColumns(stats.columns);
+    }
+
+    template <typename Map>
+    void addMapStats(SystemMemoryStats& stats, const Map& map)
+    {
+        //A map that never had an element points at a shared one bucket array
+        stats.mapBuckets = (uint32_t)map.bucket_count();
+        stats.mapBucketBytes = (map.bucket_count() > 1) ? (map.bucket_count() + 1) * sizeof(void*) : 0;
+        stats.mapNodeBytes = map.size() * sizeof(typename Map::node_type);
+    }
+
+    template <typename Vector>
+    void addVectorStats(SystemMemoryStats& stats, const Vector& vec)
+    {
+        stats.otherUsedBytes += vec.size() * sizeof(typename Vector::value_type);
+        stats.otherReservedBytes += vec.capacity() * sizeof(typename Vector::value_type);
+    }
+}
+
+#endif
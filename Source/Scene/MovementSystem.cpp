@@ -1,4 +1,5 @@
 #include "Core/Core.h"
+#include "Core/JobSystem.h"
 #include "MovementSystem.h"
 #include "TransformSystem.h"
 #include "TileSystem.h"
@@ -13,12 +14,13 @@ namespace scene
     {
         CollisionPair* pair1 = (CollisionPair*)void1;
         CollisionPair* pair2 = (CollisionPair*)void2;
-        return (int)(pair1->e1.id() - pair2->e1.id());
+        if (pair1->e1.id() < pair2->e1.id()) { return -1; }
+        return pair1->e1.id() > pair2->e1.id() ? 1 : 0;
     }
 
 
 
-    MovementSystem::MovementSystem() : _worldCollLen(0)
+    MovementSystem::MovementSystem() : _worldCollLen(0), _version(0)
     {
     }
 
@@ -46,18 +48,19 @@ namespace scene
         return IntRect(x + rect.left, y + rect.top, rect.width, rect.height);
     }
 
-    void MovementSystem::update(float dt, TransformSystem& trSystem, const TileSystem& tileSystem)
+    void MovementSystem::update(float dt, TransformSystem& trSystem, const TileSystem& tileSystem, nw::JobSystem& jobSystem)
     {
         SCOPED_CPU_EVENT(event)(0xFFFFFFFF, "MovementSystem::update");
 
         updateWorldColl(dt, trSystem, tileSystem);
         updateNonWorldColl(dt, trSystem, tileSystem);
-        recordCollisions(trSystem);
+        recordCollisions(trSystem, jobSystem);
     }
 
     void MovementSystem::updateWorldColl(float dt, TransformSystem& trSystem, const TileSystem& tileSystem)
     {
         SCOPED_CPU_EVENT(event)(0xFFFFFFFF, "MovementSystem::updateWorldColl");
+        COUNT_WORK(MoveEntities, _worldCollLen);
 
         //World colliders grouped at front of array
         for (uint32_t idx = 0; idx < _worldCollLen; idx++)
@@ -144,6 +147,7 @@ namespace scene
         NW_UNUSED(tileSystem);
 
         SCOPED_CPU_EVENT(event)(0xFFFFFFFF, "MovementSystem::updateNonWorldColl");
+        COUNT_WORK(MoveEntities, _data.getSize() - _worldCollLen);
 
         //Non world colliders grouped at end of array
         for (uint32_t idx = _worldCollLen; idx < _data.getSize(); idx++)
@@ -165,43 +169,90 @@ namespace scene
         }
     }
 
-    void MovementSystem::recordCollisions(TransformSystem& trSystem)
+    //Rows of the collision triangle per job. Early rows are the longest,
+    //so keep the ranges small enough for stealing to even things out.
+    const uint32_t COLLISION_GRAIN = 32;
+
+    struct MovementSystem::CollisionJob
+    {
+        MovementSystem* moveSystem;
+        TransformSystem* trSystem;
+        uint32_t grainSize;
+    };
+
+    void MovementSystem::recordCollisions(TransformSystem& trSystem, nw::JobSystem& jobSystem)
     {
         SCOPED_CPU_EVENT(event)(0xFFFFFFFF, "MovementSystem::recordCollisions");
 
         _collisionPairs.clear();
 
+        //Each job records its pairs separately, merged in range order so
+        //the result doesn't depend on how the jobs were scheduled
+        uint32_t size = _data.getSize();
+        uint32_t grainSize = jobSystem.isSingleThreaded() ? size : COLLISION_GRAIN;
+        uint32_t rangeCount = (size > 0) ? (size + grainSize - 1) / grainSize : 0;
+        if (_rangePairs.size() < rangeCount)
+        {
+            _rangePairs.resize(rangeCount);
+        }
+
         //TODO: Something better than n^2 checks
-        for (uint32_t idx1 = 0; idx1 < _data.getSize(); idx1++)
+        CollisionJob job = { this, &trSystem, grainSize };
+        nw::JobCounter counter(0);
+        jobSystem.parallelFor(recordCollisionsRange, &job, size, grainSize, &counter);
+        jobSystem.wait(&counter);
+
+        for (uint32_t i = 0; i < rangeCount; i++)
+        {
+            _collisionPairs.insert(_collisionPairs.end(), _rangePairs[i].begin(), _rangePairs[i].end());
+        }
+
+        //Sort the pairs for later
+        if (_collisionPairs.size() > 0)
         {
-            IntRect rect1 = getCollRect(trSystem, EInstance(idx1));
+            SCOPED_CPU_EVENT(sortEvent)(0xFFFFFFFF, "Sorting");
 
-            for (uint32_t idx2 = idx1 + 1; idx2 < _data.getSize(); idx2++)
+            qsort(&_collisionPairs[0], _collisionPairs.size(), sizeof(CollisionPair), compareCollisionPairs);
+        }
+    }
+
+    void MovementSystem::recordCollisionsRange(void* data, uint32_t begin, uint32_t end)
+    {
+        CollisionJob* job = (CollisionJob*)data;
+        MovementSystem& moveSystem = *job->moveSystem;
+        TransformSystem& trSystem = *job->trSystem;
+        const uint32_t size = moveSystem._data.getSize();
+        const Entity* entities = moveSystem._data.entities;
+
+        eastl::vector<CollisionPair>& pairs = moveSystem._rangePairs[begin / job->grainSize];
+        pairs.clear();
+
+        for (uint32_t idx1 = begin; idx1 < end; idx1++)
+        {
+            IntRect rect1 = moveSystem.getCollRect(trSystem, EInstance(idx1));
+
+            for (uint32_t idx2 = idx1 + 1; idx2 < size; idx2++)
             {
-                IntRect rect2 = getCollRect(trSystem, EInstance(idx2));
+                IntRect rect2 = moveSystem.getCollRect(trSystem, EInstance(idx2));
 
                 if (rect1.intersects(rect2))
                 {
                     //Store the pair both ways
                     CollisionPair pair;
-                    pair.e1 = _data.entities[idx1];
-                    pair.e2 = _data.entities[idx2];
-                    _collisionPairs.push_back(pair);
+                    pair.e1 = entities[idx1];
+                    pair.e2 = entities[idx2];
+                    pairs.push_back(pair);
 
-                    pair.e1 = _data.entities[idx2];
-                    pair.e2 = _data.entities[idx1];
-                    _collisionPairs.push_back(pair);
+                    pair.e1 = entities[idx2];
+                    pair.e2 = entities[idx1];
+                    pairs.push_back(pair);
                 }
             }
         }
 
-        //Sort the pairs for later
-        if (_collisionPairs.size() > 0)
-        {
-            SCOPED_CPU_EVENT(sortEvent)(0xFFFFFFFF, "Sorting");
-
-            qsort(&_collisionPairs[0], _collisionPairs.size(), sizeof(CollisionPair), compareCollisionPairs);
-        }
+        //Row idx1 tests every mover after it
+        COUNT_WORK(CollisionPairsTested, (uint64_t)(end - begin) * (2 * size - begin - end - 1) / 2);
+        COUNT_WORK(CollisionPairsFound, pairs.size() / 2);
     }
 
 
@@ -270,6 +321,15 @@ namespace scene
 
         //Remove last
         _data.pop();
+        _version++;
+    }
+
+    void MovementSystem::clear()
+    {
+        _map.clear();
+        _data.setSize(0);
+        _worldCollLen = 0;
+        _version++;
     }
 
     const uint8_t* MovementSystem::instantiate(Entity e, const uint8_t* data)
@@ -292,6 +352,47 @@ namespace scene
         return data;
     }
 
+    const uint8_t* MovementSystem::compileTemplate(const uint8_t* data, Template& tmpl)
+    {
+        memcpy(&tmpl.size, data, sizeof(tmpl.size)); data += sizeof(tmpl.size);
+        memcpy(&tmpl.offset, data, sizeof(tmpl.offset)); data += sizeof(tmpl.offset);
+        memcpy(&tmpl.velocity, data, sizeof(tmpl.velocity)); data += sizeof(tmpl.velocity);
+        memcpy(&tmpl.worldColl, data, sizeof(tmpl.worldColl)); data += sizeof(tmpl.worldColl);
+
+        return data;
+    }
+
+    void MovementSystem::createMany(const Entity* entities, uint32_t count, const Template& tmpl)
+    {
+        uint32_t first = _data.getSize();
+        _data.reserve(first + count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            _data.push(entities[i], tmpl.size, tmpl.offset, tmpl.velocity, Vector2f(0, 0));
+        }
+
+        //World collision entities are grouped at the front, so the block is
+        //swapped into place with the same number of rows from the non-WC range
+        if (tmpl.worldColl)
+        {
+            uint32_t nonWc = first - _worldCollLen;
+            uint32_t moved = (nonWc < count) ? nonWc : count;
+            for (uint32_t i = 0; i < moved; i++)
+            {
+                uint32_t wcIdx = _worldCollLen + i;
+                uint32_t tailIdx = first + count - moved + i;
+                _data.swap(wcIdx, tailIdx);
+                _map[_data.entities[tailIdx]] = EInstance(tailIdx);
+            }
+
+            first = _worldCollLen;
+            _worldCollLen += count;
+            _version++;
+        }
+
+        populateEntityMap(_map, _data.entities, count, first);
+    }
+
     void MovementSystem::moveInstance(EInstance dst, EInstance src)
     {
         _data.move(dst.index, src.index);
@@ -307,17 +408,55 @@ namespace scene
         //Update map with new entity positions
         _map[e1] = inst2;
         _map[e2] = inst1;
+        _version++;
     }
 
-    void MovementSystem::handleDestroyed(const Entity* destroyed, size_t destroyedLen)
+    void MovementSystem::handleDestroyed(const Entity* destroyed, size_t destroyedLen, DestroyBatch& batch)
     {
-        for (size_t i = 0; i < destroyedLen; i++)
+        collectDestroyed(_map, destroyed, destroyedLen, batch);
+
+        //Removals from the non-WC range come first since they have the highest
+        //indices. A WC removal is filled from the end of the WC range, which is
+        //then filled from the end of the array, like destroy() does.
+        uint32_t size = _data.getSize();
+        for (uint32_t index : batch.indices)
         {
-            auto result = _map.find(destroyed[i]);
-            if (result != _map.end())
+            uint32_t last = --size;
+            if (index < _worldCollLen)
             {
-                destroy(result->first);
+                uint32_t lastWc = --_worldCollLen;
+                if (index != lastWc)
+                {
+                    moveInstance(EInstance(index), EInstance(lastWc));
+                    batch.moved.push_back(index);
+                }
+                if (lastWc != last)
+                {
+                    moveInstance(EInstance(lastWc), EInstance(last));
+                    batch.moved.push_back(lastWc);
+                }
             }
+            else if (index != last)
+            {
+                moveInstance(EInstance(index), EInstance(last));
+                batch.moved.push_back(index);
+            }
+        }
+        _data.setSize(size);
+
+        fixupEntityMap(_map, _data.entities, size, batch);
+        _version++;
+    }
+
+    void MovementSystem::getMemoryStats(SystemMemoryStats& stats) const
+    {
+        addStorageStats(stats, _data);
+        addMapStats(stats, _map);
+        addVectorStats(stats, _collisionPairs);
+        addVectorStats(stats, _rangePairs);
+        for (const auto& pairs : _rangePairs)
+        {
+            addVectorStats(stats, pairs);
         }
     }
 
@@ -10,8 +10,11 @@
 #include "Math/IntRect.h"
 #include "Entity.h"
 #include "EInstance.h"
+#include "EntityMap.h"
+#include "MemoryStats.h"
 
 namespace asset { class PackFile; class AssetManager; }
+namespace nw { class JobSystem; }
 using namespace asset;
 using namespace math;
 
@@ -25,12 +28,15 @@ namespace scene
     class MovementSystem
     {
     private:
-        eastl::hash_map<Entity, EInstance> _map;
+        EntityInstanceMap _map;
 
         //Number of entities that have world collision enabled
         //All WC enabled entities are grouped at the beginning of the array
         uint32_t _worldCollLen;
 
+        //Bumped whenever existing instances move or are removed
+        uint32_t _version;
+
         CLASS_SOA_VECTOR5(Storage,
             Entity, entities,
             Vector2i, size,
@@ -40,8 +46,18 @@ namespace scene
         Storage _data;
 
         eastl::vector<CollisionPair> _collisionPairs;
+        eastl::vector<eastl::vector<CollisionPair>> _rangePairs;   //Pairs found by each collision job
 
     public:
+        //Prefab movement component, compiled once when the scene is loaded
+        struct Template
+        {
+            Vector2i size;
+            Vector2i offset;
+            Vector2f velocity;
+            bool worldColl;
+        };
+
         MovementSystem();
 
         template <typename Archive>
@@ -55,30 +71,37 @@ namespace scene
                 return;
             }
 
-            //If we're reading, then preallocate some space
-            if (ar.IsReading)
-            {
-                _data.resize(length + 128);
-                _data.setSize(length);
+            ar.serializeU32(_worldCollLen);
 
-                memset(_data.partialPos, 0, sizeof(_data.partialPos[0]) * length);
+            //Columns are stored exactly as they are laid out in memory, so a
+            //loaded scene image is used in place (and copied out on first grow)
+            ar.serializeAlign(Storage::imageAlignment());
+            void* image = ar.mapBytes(Storage::imageSize(length));
+            if (image != nullptr)
+            {
+                _data.adopt(image, length);
             }
+            else
+            {
+                //Reads that can't map (rewinds) copy into the existing storage
+                if (ar.IsReading)
+                {
+                    if (_data.capacity() < length) { _data.resize(length); }
+                    _data.setSize(length);
+                }
 
-            ar.serializeU32(_worldCollLen);
-
-            //Serialize fields
-            AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.entities, length);
-            AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.size, length);
-            AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.offset, length);
-            AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.velocity, length);
+                AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.entities, length);
+                AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.size, length);
+                AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.offset, length);
+                AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.velocity, length);
+                AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.partialPos, length);   //Always zero when cooked
+            }
 
             //Add entities to map
             if (ar.IsReading)
             {
-                for (uint32_t i = 0; i < length; i++)
-                {
-                    _map[_data.entities[i]] = i;
-                }
+                populateEntityMap(_map, _data.entities, length);
+                _version++;
             }
         }
 
@@ -86,18 +109,26 @@ namespace scene
         uint8_t* convertToPrefab(Entity e, uint8_t* buffer);
 #endif
 
-        void update(float dt, TransformSystem& trSystem, const TileSystem& tileSystem);
+        void update(float dt, TransformSystem& trSystem, const TileSystem& tileSystem, nw::JobSystem& jobSystem);
         void updateWorldColl(float dt, TransformSystem& trSystem, const TileSystem& tileSystem);
         void updateNonWorldColl(float dt, TransformSystem& trSystem, const TileSystem& tileSystem);
-        void recordCollisions(TransformSystem& trSystem);
+        void recordCollisions(TransformSystem& trSystem, nw::JobSystem& jobSystem);
 
         bool exists(Entity e);
         EInstance create(Entity e);
+        void reserve(uint32_t count) { _data.reserve(_data.getSize() + count); }
         EInstance createOrGetInstance(Entity e);
         void destroy(Entity e);
+        void clear();
         const uint8_t* instantiate(Entity e, const uint8_t* data);
+        const uint8_t* compileTemplate(const uint8_t* data, Template& tmpl);
+        void createMany(const Entity* entities, uint32_t count, const Template& tmpl);
 
-        void handleDestroyed(const Entity* destroyed, size_t destroyedLen);
+        void handleDestroyed(const Entity* destroyed, size_t destroyedLen, DestroyBatch& batch);
+        void getMemoryStats(SystemMemoryStats& stats) const;
+
+        //An instance looked up at one version stays valid while the version is unchanged
+        uint32_t getVersion() const { return _version; }
 
         EInstance getInstance(Entity e)
         {
@@ -121,6 +152,9 @@ namespace scene
         IntRect getCollRect(TransformSystem& tr, EInstance ei);
 
     private:
+        struct CollisionJob;
+        static void recordCollisionsRange(void* data, uint32_t begin, uint32_t end);
+
         void moveInstance(EInstance dst, EInstance src);
         void swapInstances(EInstance inst1, EInstance inst2);
 
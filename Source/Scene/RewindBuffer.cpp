@@ -0,0 +1,118 @@
+#include "Core/Core.h"
+#include "RewindBuffer.h"
+#include "Scene.h"
+#include "Core/Hash.h"
+
+namespace scene
+{
+    RewindBuffer::RewindBuffer() :
+        _head(0),
+        _hasState(false)
+    {
+    }
+
+    void RewindBuffer::init(uint32_t maxTicks, uint32_t maxBytes)
+    {
+        _storage.resize(maxBytes);
+        _frames.set_capacity(maxTicks);
+        clear();
+    }
+
+    void RewindBuffer::clear()
+    {
+        _frames.clear();
+        _head = 0;
+        _hasState = false;
+    }
+
+    void RewindBuffer::capture(Scene& scene)
+    {
+        SCOPED_CPU_EVENT(event)(0xFFFFFFFF, "RewindBuffer::capture");
+
+        _archive.begin();
+        scene.captureState(_archive);
+
+        //The first state has nothing to rewind to
+        if (!_hasState)
+        {
+            _hasState = true;
+            return;
+        }
+
+        _archive.encodeDelta(_delta);
+        uint32_t size = (uint32_t)_delta.size();
+
+        //A single tick that doesn't fit breaks the chain, so start over from here
+        if (size > _storage.size())
+        {
+            _frames.clear();
+            _head = 0;
+            return;
+        }
+
+        uint8_t* dest = reserve(size);
+        memcpy(dest, _delta.data(), size);
+
+        //Pushing onto a full ring drops the oldest tick
+        _frames.push_back(Frame{ _head, size });
+        _head += size;
+    }
+
+    uint32_t RewindBuffer::rewind(Scene& scene, asset::AssetManager& assetMan, uint32_t ticks)
+    {
+        SCOPED_CPU_EVENT(event)(0xFFFFFFFF, "RewindBuffer::rewind");
+
+        if (ticks > _frames.size()) { ticks = (uint32_t)_frames.size(); }
+        if (ticks == 0) { return 0; }
+
+        //The rewound ticks are consumed, the next capture continues from the restored state
+        eastl::vector<uint8_t>& state = _archive.getState();
+        for (uint32_t i = 0; i < ticks; i++)
+        {
+            Frame frame = _frames.back();
+            util::applyDelta(state, &_storage[frame.offset], frame.size);
+
+            _frames.pop_back();
+            _head = frame.offset;
+        }
+
+        scene.restoreState(assetMan, state.data(), state.size());
+        return ticks;
+    }
+
+    uint32_t RewindBuffer::getStateHash()
+    {
+        const eastl::vector<uint8_t>& state = _archive.getState();
+        return XXH32(state.data(), state.size(), 0);
+    }
+
+    uint8_t* RewindBuffer::reserve(uint32_t size)
+    {
+        const uint32_t capacity = (uint32_t)_storage.size();
+
+        //Evict the oldest ticks until there's a contiguous gap at the head.
+        //Deltas only make sense as an unbroken chain, so eviction is strictly oldest first.
+        while (!_frames.empty())
+        {
+            uint32_t oldest = _frames.front().offset;
+            if (oldest < _head)
+            {
+                //Everything after the head is free
+                if (_head + size <= capacity) { break; }
+                _head = 0;
+            }
+            else
+            {
+                if (_head + size <= oldest) { break; }
+                _frames.pop_front();
+            }
+        }
+
+        if (_frames.empty() && _head + size > capacity)
+        {
+            _head = 0;
+        }
+
+        return &_storage[_head];
+    }
+}
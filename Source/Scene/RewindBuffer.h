@@ -0,0 +1,59 @@
+#ifndef SCENE_REWIND_BUFFER_H
+#define SCENE_REWIND_BUFFER_H
+
+#include <EASTL/vector.h>
+#include <EASTL/bonus/ring_buffer.h>
+#include "Util/DeltaArchive.h"
+
+namespace asset { class AssetManager; }
+
+namespace scene
+{
+    class Scene;
+
+    //Bounded history of scene states, captured once per fixed update.
+    //
+    //Only the latest state is kept in full. Every tick before it is stored
+    //as the delta against the tick that followed it, so rewinding walks
+    //backwards from the latest state applying one delta per tick.
+    //Deltas live in a fixed size byte ring; the oldest ticks are dropped
+    //once either the tick or the byte budget runs out.
+    class RewindBuffer
+    {
+    private:
+        struct Frame
+        {
+            uint32_t offset;
+            uint32_t size;
+        };
+
+        util::DeltaWriteArchive _archive;
+        eastl::vector<uint8_t> _delta;      //Scratch space for the delta being encoded
+
+        eastl::vector<uint8_t> _storage;
+        eastl::ring_buffer<Frame> _frames;
+        uint32_t _head;                     //Where the next delta is written into _storage
+        bool _hasState;
+
+    public:
+        RewindBuffer();
+
+        void init(uint32_t maxTicks, uint32_t maxBytes);
+        void clear();
+
+        void capture(Scene& scene);
+
+        //Restores the scene to the state it had the given number of ticks ago.
+        //Returns the number of ticks actually rewound, which is limited by the history kept.
+        uint32_t rewind(Scene& scene, asset::AssetManager& assetMan, uint32_t ticks);
+
+        uint32_t getTickCount() const { return (uint32_t)_frames.size(); }
+        //Hash of the last captured state, for comparing runs
+        uint32_t getStateHash();
+
+    private:
+        uint8_t* reserve(uint32_t size);
+    };
+}
+
+#endif
@@ -1,17 +1,63 @@
 #include "Core/Core.h"
+#include "Core/JobSystem.h"
 #include "Scene.h"
 #include "Asset/PackFile.h"
 #include "Asset/AssetManager.h"
 #include "Render/RenderCommon.h"
 #include "Render/RenderManager.h"
 #include "Util/Archives.h"
+#include "Util/DeltaArchive.h"
+#include "Core/FrameArena.h"
 
 namespace scene
 {
+    //Data touched by the render stage tasks, see nw::JobStage
+    const uint32_t RENDER_RES_TRANSFORMS = 1 << 0;
+    const uint32_t RENDER_RES_SPRITES = 1 << 1;
+    const uint32_t RENDER_RES_TILES = 1 << 2;
+    const uint32_t RENDER_RES_SPRITE_LIST = 1 << 3;
+    const uint32_t RENDER_RES_TILE_BATCHES = 1 << 4;
+
+    struct RenderTaskData
+    {
+        Scene* scene;
+        nw::JobSystem* jobSystem;
+        IntRect view;
+    };
+
+    static void buildSpriteListTask(void* data)
+    {
+        RenderTaskData* task = (RenderTaskData*)data;
+        task->scene->getSpriteSystem().buildRenderList(task->scene->getTransformSystem(), *task->jobSystem);
+    }
+
+    static void buildTileBatchesTask(void* data)
+    {
+        RenderTaskData* task = (RenderTaskData*)data;
+        task->scene->getTileSystem().buildBatches(task->view);
+    }
+
     Scene::Scene() :
+        _arenaBinding(_arena),
         _deltaTime(0),
-        _sceneTime(0)
+        _sceneTime(0),
+        _commandBuffers(1),
+        _image(nullptr),
+        _imageSize(0)
+    {
+        //Every scene owned container has picked up the arena by now
+        _arenaBinding.end();
+    }
+
+    Scene::~Scene()
     {
+        for (auto& tmpl : _prefabTemplates)
+        {
+            _scriptSystem.releaseTemplate(tmpl.script);
+        }
+
+        //The image and everything else allocated from the arena goes when
+        //_arena is destroyed, after the members
     }
 
     template <typename Archive>
@@ -23,7 +69,7 @@ namespace scene
         ar.serializeU32(soundsLen);
 
         //Read asset hashes
-        eastl::vector<AssetRef> textures, sounds;
+        memory::FrameVector<AssetRef> textures, sounds;
         if (texturesLen > 0)
         {
             textures.resize(texturesLen);
@@ -51,7 +97,11 @@ namespace scene
     void Scene::serialize(Archive& ar)
     {
         AR_SERIALIZE_MAP(ar, _prefabMap, serializeCustom, serializeCustom);
-        AR_SERIALIZE_VECTOR(ar, _prefabData, serializeU8);
+
+        uint32_t prefabDataLen = (uint32_t)_prefabData.size();
+        ar.serializeU32(prefabDataLen);
+        if (ar.IsReading) { _prefabData.resize(prefabDataLen); }
+        AR_SERIALIZE_ARRAY_U8(ar, _prefabData.data(), prefabDataLen);
 
         _tagSystem.serialize(ar);
         _trSystem.serialize(ar);
@@ -61,48 +111,144 @@ namespace scene
         _tileSystem.serialize(ar);
     }
 
-    void Scene::load(AssetManager& assetMan, PackFile& pack, const FileSpan& span, script::AngelState& angelState)
+    void Scene::load(AssetManager& assetMan, PackFile& pack, AssetRef sceneRef, script::AngelState& angelState, SceneSnapshot* snapshot)
     {
-        void* memory = malloc(span.size);
+        NW_ASSERT(_image == nullptr);
+        const FileSpan span = pack.getFileSpan(sceneRef);
 
-        _tagSystem.init();
-        _scriptSystem.init(angelState);
+        //The decompressed image is kept for the lifetime of the scene since
+        //systems use their columns straight out of it
+        _image = _arena.alloc(span.size);
+        _imageSize = span.size;
 
         pack.lock();
-        pack.decompress(span, memory);
+        pack.decompress(span, _image);
         pack.unlock();
 
-        util::MemoryReadArchive ar;
-        ar.init(memory, span.size);
-
-        uint32_t entityCount;
-        ar.serializeU32(entityCount);
-
-        if (ar.IsReading)
+        //Systems modify the image as soon as they adopt it, so copy it beforehand
+        if (snapshot != nullptr)
         {
-            for (uint32_t i = 0; i < entityCount; i++)
-            {
-                _entityManager.create();
-            }
+            snapshot->clear();
+            const uint8_t* image = (const uint8_t*)_image;
+            snapshot->_image.assign(image, image + span.size);
         }
 
-        serialize(ar);
+        util::MemoryReadArchive ar;
+        ar.init(_image, span.size);
+        loadImage(ar, angelState, nullptr);
 
         //Load scene assets (reads remainder of scene file)
         pack.lock();
         loadAssets(assetMan, ar);
         pack.unlock();
 
+        prepare(assetMan);
+
+        if (snapshot != nullptr)
+        {
+            _scriptSystem.saveSnapshot(snapshot->_scriptObjects);
+            snapshot->_sceneRef = sceneRef;
+            snapshot->_isValid = true;
+        }
+    }
+
+    void Scene::load(AssetManager& assetMan, const SceneSnapshot& snapshot, script::AngelState& angelState)
+    {
+        SCOPED_CPU_EVENT(event)(0xFFFFFFFF, "Scene::load (snapshot)");
+        NW_ASSERT(_image == nullptr);
+        NW_ASSERT(snapshot.isValid());
+
+        size_t size = snapshot._image.size();
+        _image = _arena.alloc(size);
+        _imageSize = size;
+        memcpy(_image, snapshot._image.data(), size);
+
+        util::MemoryReadArchive ar;
+        ar.init(_image, size);
+        loadImage(ar, angelState, &snapshot._scriptObjects);
+
+        //Every asset the scene uses is still resident from the original load,
+        //so the asset list at the end of the image is skipped
+        prepare(assetMan);
+    }
+
+    void Scene::loadImage(util::MemoryReadArchive& ar, script::AngelState& angelState,
+        const eastl::vector<asIScriptObject*>* scriptObjects)
+    {
+        _tagSystem.init();
+        _scriptSystem.init(angelState);
+
+        uint32_t version;
+        ar.serializeU32(version);
+        NW_REQUIRE(version == IMAGE_VERSION);   //Scene was cooked with an older format
+
+        uint32_t entityCount;
+        ar.serializeU32(entityCount);
+
+        _entityManager.createMany(entityCount, nullptr);
+
+        _scriptSystem.setSnapshotObjects(scriptObjects);
+        serialize(ar);
+        _scriptSystem.setSnapshotObjects(nullptr);
+    }
+
+    void Scene::prepare(AssetManager& assetMan)
+    {
         _spriteSystem.prepare(assetMan);
         _tileSystem.prepare(assetMan);
         _camSystem.prepare(_tileSystem);
 
-        free(memory);
+        compilePrefabs(assetMan);
+    }
+
+    void Scene::compilePrefabs(AssetManager& assetMan)
+    {
+        SCOPED_CPU_EVENT(event)(0xFFFFFFFF, "Scene::compilePrefabs");
+
+        _prefabTemplates.reserve(_prefabMap.size());
+        for (auto& pair : _prefabMap)
+        {
+            PrefabData& prefab = pair.second;
+            const uint8_t* data = &_prefabData[prefab.offset];
+
+            PrefabTemplate tmpl;
+            tmpl.components = *data++;
+            tmpl.script.prototype = nullptr;
+
+            //Same component order as instantiate(). Transforms have no prefab data.
+            if (tmpl.components >> 0 & 1)
+            {
+                data = _tagSystem.compileTemplate(data, tmpl.tag);
+            }
+
+            if (tmpl.components >> 2 & 1)
+            {
+                data = _spriteSystem.compileTemplate(assetMan, data, tmpl.sprite);
+            }
+
+            if (tmpl.components >> 3 & 1)
+            {
+                data = _moveSystem.compileTemplate(data, tmpl.movement);
+            }
+
+            if (tmpl.components >> 4 & 1)
+            {
+                data = _scriptSystem.compileTemplate(data, tmpl.script);
+            }
+
+            prefab.templateIndex = (uint32_t)_prefabTemplates.size();
+            _prefabTemplates.push_back(tmpl);
+        }
     }
 
 #ifdef NW_ASSET_COOK
     void Scene::save(EndianVectorWriteArchive& ar, uint32_t entityCount)
     {
+        //The image is used in place on load, so it is always written in native order
+        NW_ASSERT(ar.size() == 0);
+
+        uint32_t version = IMAGE_VERSION;
+        ar.serializeU32(version);
         ar.serializeU32(entityCount);
 
         serialize(ar);
@@ -112,48 +258,313 @@ namespace scene
     {
         //Store the offset
         _prefabMap.insert(eastl::make_pair(
-            ref, PrefabData{ (uint32_t)_prefabData.size() }));
+            ref, PrefabData((uint32_t)_prefabData.size())));
 
-        for (uint32_t i = 0; i < length; i++)
-        {
-            _prefabData.push_back(buffer[i]);
-        }
+        _prefabData.insert(_prefabData.end(), buffer, buffer + length);
     }
 #endif
 
+    template <typename Archive>
+    void Scene::serializeState(Archive& ar)
+    {
+        ar.serializeU32(_sceneTime);
+
+        _entityManager.serialize(ar);
+        _tagSystem.serialize(ar);
+        _trSystem.serialize(ar);
+        _spriteSystem.serialize(ar);
+        _moveSystem.serialize(ar);
+    }
+
+    void Scene::captureState(util::DeltaWriteArchive& ar)
+    {
+        SCOPED_CPU_EVENT(event)(0xFFFFFFFF, "Scene::captureState");
+        serializeState(ar);
+    }
+
+    void Scene::restoreState(AssetManager& assetMan, const uint8_t* state, size_t length)
+    {
+        SCOPED_CPU_EVENT(event)(0xFFFFFFFF, "Scene::restoreState");
+
+        _tagSystem.clear();
+        _trSystem.clear();
+        _spriteSystem.clear();
+        _moveSystem.clear();
+
+        //The state is overwritten by the next capture, so nothing may be mapped from it
+        util::MemoryReadArchive ar;
+        ar.init(state, length);
+        ar.setMappingEnabled(false);
+        serializeState(ar);
+
+        //Texture handles aren't part of the state
+        _spriteSystem.prepare(assetMan);
+
+        //Script objects keep their current state, but lose entities that
+        //didn't exist yet at the restored tick
+        _scriptSystem.destroyDead(_entityManager);
+    }
+
     void Scene::handleInstantiated(AssetManager& assetMan)
     {
         _spriteSystem.handleInstantiated(assetMan);
     }
 
-    void Scene::update(AssetManager& assetMan, uint32_t deltaTime)
+    void Scene::update(AssetManager& assetMan, uint32_t deltaTime, nw::JobSystem& jobSystem)
     {
         SCOPED_CPU_EVENT(event)(0xFFFFFFFF, "Scene::update");
 
         _deltaTime = deltaTime;
         _sceneTime += deltaTime;
 
-        _moveSystem.update(getDeltaTime(), _trSystem, _tileSystem);
+        //Every job system thread gets its own command buffer
+        if (_commandBuffers.size() < jobSystem.getThreadCount())
+        {
+            _commandBuffers.resize(jobSystem.getThreadCount());
+        }
+
+        _moveSystem.update(getDeltaTime(), _trSystem, _tileSystem, jobSystem);
+        playbackCommands();
+
+        //Scripts record their structural changes, so the system storage
+        //doesn't move under the update loop
         _scriptSystem.update();
+        playbackCommands();
 
         //Call again in case the script system has created entities
         handleInstantiated(assetMan);
 
         //Handle destroyed entities
-        //Transform system is first since it dumps children on the destroyed list
-        _trSystem.handleDestroyed(_entityManager);
+        handleDestroyed();
+    }
+
+    void Scene::handleDestroyed()
+    {
+        SCOPED_CPU_EVENT(event)(0xFFFFFFFF, "Scene::handleDestroyed");
+
+        //Children are added to the destroyed list before any system sees it
+        _trSystem.expandDestroyed(_entityManager);
         const auto& destroyed = _entityManager.pollDestroyed();
         if (destroyed.size() > 0)
         {
-            _spriteSystem.handleDestroyed(destroyed.data(), destroyed.size());
-            _moveSystem.handleDestroyed(destroyed.data(), destroyed.size());
-            _scriptSystem.handleDestroyed(destroyed.data(), destroyed.size());
-            _tagSystem.handleDestroyed(destroyed.data(), destroyed.size());
+            //Each system removes the whole list in one pass
+            _trSystem.handleDestroyed(destroyed.data(), destroyed.size(), _destroyBatch);
+            _spriteSystem.handleDestroyed(destroyed.data(), destroyed.size(), _destroyBatch);
+            _moveSystem.handleDestroyed(destroyed.data(), destroyed.size(), _destroyBatch);
+            _scriptSystem.handleDestroyed(destroyed.data(), destroyed.size(), _destroyBatch);
+            _tagSystem.handleDestroyed(destroyed.data(), destroyed.size(), _destroyBatch);
         }
         _entityManager.clearDestroyed();
     }
 
-    void Scene::render(RenderManager& renderManager)
+    void Scene::playbackCommands()
+    {
+        SCOPED_CPU_EVENT(event)(0xFFFFFFFF, "Scene::playbackCommands");
+
+        const uint32_t bufferCount = (uint32_t)_commandBuffers.size();
+        uint32_t createCounts[COMPONENT_TYPE_COUNT] = { };
+        bool hasCommands = false;
+        for (uint32_t i = 0; i < bufferCount; i++)
+        {
+            hasCommands |= !_commandBuffers[i].isEmpty();
+            for (uint32_t type = 0; type < COMPONENT_TYPE_COUNT; type++)
+            {
+                createCounts[type] += _commandBuffers[i].getCreateCount((ComponentType)type);
+            }
+        }
+
+        if (!hasCommands) { return; }
+
+        //Each system grows once for all the components created in the batch
+        _tagSystem.reserve(createCounts[(uint32_t)ComponentType::Tag]);
+        _trSystem.reserve(createCounts[(uint32_t)ComponentType::Transform]);
+        _spriteSystem.reserve(createCounts[(uint32_t)ComponentType::Sprite]);
+        _moveSystem.reserve(createCounts[(uint32_t)ComponentType::Movement]);
+        _scriptSystem.reserve(createCounts[(uint32_t)ComponentType::Script]);
+
+        //Prefab instances first, so creates, destroys and writes recorded for
+        //their components afterwards find them
+        for (uint32_t i = 0; i < bufferCount; i++)
+        {
+            applyInstantiations(_commandBuffers[i]);
+        }
+
+        //Creates and destroys are applied one system at a time. Within a
+        //system they keep the order they were recorded in (buffers in thread order).
+        for (uint32_t type = 0; type < COMPONENT_TYPE_COUNT; type++)
+        {
+            for (uint32_t i = 0; i < bufferCount; i++)
+            {
+                for (const auto& cmd : _commandBuffers[i].getCommands())
+                {
+                    if ((cmd.op == CommandBuffer::Op::Create || cmd.op == CommandBuffer::Op::Destroy) &&
+                        (uint32_t)cmd.component == type)
+                    {
+                        applyStructuralCommand(cmd);
+                    }
+                }
+            }
+        }
+
+        //Writes go after the creates so they can target components created
+        //in the same batch
+        for (uint32_t i = 0; i < bufferCount; i++)
+        {
+            for (const auto& cmd : _commandBuffers[i].getCommands())
+            {
+                if (cmd.op == CommandBuffer::Op::Set)
+                {
+                    applyWriteCommand(cmd);
+                }
+            }
+            _commandBuffers[i].clear();
+        }
+    }
+
+    void Scene::applyInstantiations(const CommandBuffer& commands)
+    {
+        for (const auto& inst : commands.getInstantiations())
+        {
+            const PrefabTemplate& tmpl = _prefabTemplates[inst.templateIndex];
+            const Entity* entities = commands.getInstantiated(inst);
+            const Vector2i* positions = commands.getInstantiatedPositions(inst);
+
+            uint32_t aliveCount = 0;
+            for (uint32_t i = 0; i < inst.count; i++)
+            {
+                aliveCount += _entityManager.alive(entities[i]) ? 1 : 0;
+            }
+
+            if (aliveCount == inst.count)
+            {
+                instantiateTemplate(tmpl, entities, inst.count, positions);
+                continue;
+            }
+
+            //Entities destroyed since they were recorded don't get components
+            for (uint32_t i = 0; i < inst.count; i++)
+            {
+                if (_entityManager.alive(entities[i]))
+                {
+                    instantiateTemplate(tmpl, &entities[i], 1, (positions != nullptr) ? &positions[i] : nullptr);
+                }
+            }
+        }
+    }
+
+    void Scene::applyStructuralCommand(const CommandBuffer::Command& cmd)
+    {
+        //The entity may have been destroyed since the command was recorded
+        Entity e = cmd.entity;
+        if (!_entityManager.alive(e)) { return; }
+
+        bool create = (cmd.op == CommandBuffer::Op::Create);
+        switch (cmd.component)
+        {
+        case ComponentType::Tag:
+            if (create && !_tagSystem.exists(e)) { _tagSystem.create(e); }
+            else if (!create && _tagSystem.exists(e)) { _tagSystem.destroy(e); }
+            break;
+        case ComponentType::Transform:
+            if (create && !_trSystem.exists(e)) { _trSystem.create(e); }
+            else if (!create && _trSystem.exists(e)) { _trSystem.destroy(e); }
+            break;
+        case ComponentType::Sprite:
+            if (create && !_spriteSystem.exists(e)) { _spriteSystem.create(e); }
+            else if (!create && _spriteSystem.exists(e)) { _spriteSystem.destroy(e); }
+            break;
+        case ComponentType::Movement:
+            if (create && !_moveSystem.exists(e)) { _moveSystem.create(e); }
+            else if (!create && _moveSystem.exists(e)) { _moveSystem.destroy(e); }
+            break;
+        case ComponentType::Script:
+            if (create && !_scriptSystem.exists(e)) { _scriptSystem.create(e, cmd.getValue<script::AngelType>()); }
+            else if (!create && _scriptSystem.exists(e)) { _scriptSystem.destroy(e); }
+            break;
+        default:
+            NW_ASSERT(false);
+            break;
+        }
+    }
+
+    void Scene::applyWriteCommand(const CommandBuffer::Command& cmd)
+    {
+        typedef CommandBuffer::Property Property;
+
+        //Writes to components that didn't survive the batch are dropped
+        Entity e = cmd.entity;
+        if (!_entityManager.alive(e)) { return; }
+
+        switch (cmd.property)
+        {
+        case Property::TransformLocalPos:
+            if (_trSystem.exists(e)) { _trSystem.setLocalPos(_trSystem.getInstance(e), cmd.getValue<Vector2i>()); }
+            break;
+        case Property::TransformWorldPos:
+            if (_trSystem.exists(e)) { _trSystem.setWorldPos(_trSystem.getInstance(e), cmd.getValue<Vector2i>()); }
+            break;
+        case Property::SpriteSize:
+            if (_spriteSystem.exists(e)) { _spriteSystem.setSize(_spriteSystem.getInstance(e), cmd.getValue<Vector2i>()); }
+            break;
+        case Property::SpriteOffset:
+            if (_spriteSystem.exists(e)) { _spriteSystem.setOffset(_spriteSystem.getInstance(e), cmd.getValue<Vector2i>()); }
+            break;
+        case Property::SpriteTexOffset:
+            if (_spriteSystem.exists(e)) { _spriteSystem.setTexOffset(_spriteSystem.getInstance(e), cmd.getValue<Vector2i>()); }
+            break;
+        case Property::SpriteDepth:
+            if (_spriteSystem.exists(e)) { _spriteSystem.setDepth(_spriteSystem.getInstance(e), cmd.getValue<uint8_t>()); }
+            break;
+        case Property::SpriteAlpha:
+            if (_spriteSystem.exists(e)) { _spriteSystem.setAlpha(_spriteSystem.getInstance(e), cmd.getValue<uint8_t>()); }
+            break;
+        case Property::SpriteTexture:
+            if (_spriteSystem.exists(e)) { _spriteSystem.setTextureRef(_spriteSystem.getInstance(e), AssetRef(cmd.getValue<uint32_t>())); }
+            break;
+        case Property::SpriteHorFlip:
+            if (_spriteSystem.exists(e)) { _spriteSystem.setHorFlip(_spriteSystem.getInstance(e), cmd.getValue<bool>()); }
+            break;
+        case Property::SpriteVerFlip:
+            if (_spriteSystem.exists(e)) { _spriteSystem.setVerFlip(_spriteSystem.getInstance(e), cmd.getValue<bool>()); }
+            break;
+        case Property::SpriteRotation:
+            if (_spriteSystem.exists(e)) { _spriteSystem.setRotation(_spriteSystem.getInstance(e), cmd.getValue<int32_t>()); }
+            break;
+        case Property::MovementSize:
+            if (_moveSystem.exists(e)) { _moveSystem.setSize(_moveSystem.getInstance(e), cmd.getValue<Vector2i>()); }
+            break;
+        case Property::MovementOffset:
+            if (_moveSystem.exists(e)) { _moveSystem.setOffset(_moveSystem.getInstance(e), cmd.getValue<Vector2i>()); }
+            break;
+        case Property::MovementVelocity:
+            if (_moveSystem.exists(e)) { _moveSystem.setVelocity(_moveSystem.getInstance(e), cmd.getValue<Vector2f>()); }
+            break;
+        case Property::MovementWorldCollision:
+            if (_moveSystem.exists(e)) { _moveSystem.setWorldCollision(_moveSystem.getInstance(e), cmd.getValue<bool>()); }
+            break;
+        case Property::TagAdd:
+            if (_tagSystem.exists(e))
+            {
+                EInstance ei = _tagSystem.getInstance(e);
+                uint32_t tag = cmd.getValue<uint32_t>();
+                if (!_tagSystem.hasTag(ei, tag)) { _tagSystem.addTag(ei, tag); }
+            }
+            break;
+        case Property::TagRemove:
+            if (_tagSystem.exists(e))
+            {
+                EInstance ei = _tagSystem.getInstance(e);
+                uint32_t tag = cmd.getValue<uint32_t>();
+                if (_tagSystem.hasTag(ei, tag)) { _tagSystem.removeTag(ei, tag); }
+            }
+            break;
+        default:
+            NW_ASSERT(false);
+            break;
+        }
+    }
+
+    void Scene::render(RenderManager& renderManager, nw::JobSystem& jobSystem)
     {
         SCOPED_CPU_EVENT(event)(PROF_COLOR_GRAPHICS, "Scene::render");
 
@@ -164,17 +575,30 @@ namespace scene
 
         bgfx::touch(VIEW_ID_SCENE);
 
+        //Draw data is built on the job system, only submitting it needs the render thread
+        RenderTaskData taskData = { this, &jobSystem, _camSystem.getView() };
+        nw::JobStage stage;
+        stage.add("SpriteSystem::buildRenderList", buildSpriteListTask, &taskData,
+            RENDER_RES_TRANSFORMS | RENDER_RES_SPRITES, RENDER_RES_SPRITE_LIST);
+        stage.add("TileSystem::buildBatches", buildTileBatchesTask, &taskData,
+            RENDER_RES_TILES, RENDER_RES_TILE_BATCHES);
+        stage.execute(jobSystem);
+
         Renderer2d renderer = renderManager.getRenderer2d();
         renderer.setView(_camSystem.getView());
-        _tileSystem.render(renderer, _camSystem.getView());
-        _spriteSystem.render(_trSystem, renderer);
+        _tileSystem.submitBatches(renderer);
+        _spriteSystem.submitRenderList(renderer);
     }
 
 
 
-    Scene::PrefabData Scene::getPrefab(AssetRef ref)
+    bool Scene::getPrefab(AssetRef ref, PrefabData& outPrefab) const
     {
-        return _prefabMap[ref];
+        auto it = _prefabMap.find(ref);
+        if (it == _prefabMap.end()) { return false; }
+
+        outPrefab = it->second;
+        return true;
     }
 
     Entity Scene::instantiate(PrefabData prefab)
@@ -186,6 +610,13 @@ namespace scene
 
     void Scene::instantiate(Entity e, PrefabData prefab)
     {
+        if (prefab.templateIndex != UINT32_MAX)
+        {
+            instantiateTemplate(_prefabTemplates[prefab.templateIndex], &e, 1, nullptr);
+            return;
+        }
+
+        //Templates only exist once a scene is prepared, so cooking parses the prefab directly
         uint8_t components = _prefabData[prefab.offset];
         const uint8_t* data = &_prefabData[prefab.offset + 1];
 
@@ -214,4 +645,127 @@ namespace scene
             data = _scriptSystem.instantiate(e, data);
         }
     }
+
+    void Scene::instantiateMany(PrefabData prefab, uint32_t count, const Vector2i* positions, Entity* outEntities)
+    {
+        SCOPED_CPU_EVENT(event)(0xFFFFFFFF, "Scene::instantiateMany");
+        NW_ASSERT(prefab.templateIndex != UINT32_MAX);
+
+        Entity* entities = outEntities;
+        if (entities == nullptr)
+        {
+            _spawned.resize(count);
+            entities = _spawned.data();
+        }
+
+        _entityManager.createMany(count, entities);
+
+        instantiateTemplate(_prefabTemplates[prefab.templateIndex], entities, count, positions);
+    }
+
+    void Scene::recordInstantiate(CommandBuffer& commands, PrefabData prefab, uint32_t count, const Vector2i* positions,
+        Entity* outEntities)
+    {
+        NW_ASSERT(prefab.templateIndex != UINT32_MAX);
+        NW_ASSERT(outEntities != nullptr);
+
+        _entityManager.createMany(count, outEntities);
+        commands.instantiate(prefab.templateIndex, _prefabTemplates[prefab.templateIndex].components,
+            outEntities, count, positions);
+    }
+
+    void Scene::instantiateTemplate(const PrefabTemplate& tmpl, const Entity* entities, uint32_t count, const Vector2i* positions)
+    {
+        if (tmpl.components >> 0 & 1)
+        {
+            _tagSystem.createMany(entities, count, tmpl.tag);
+        }
+
+        if (tmpl.components >> 1 & 1)
+        {
+            _trSystem.createMany(entities, count, positions);
+        }
+
+        if (tmpl.components >> 2 & 1)
+        {
+            _spriteSystem.createMany(entities, count, tmpl.sprite);
+        }
+
+        if (tmpl.components >> 3 & 1)
+        {
+            _moveSystem.createMany(entities, count, tmpl.movement);
+        }
+
+        if (tmpl.components >> 4 & 1)
+        {
+            _scriptSystem.createMany(entities, count, tmpl.script);
+        }
+    }
+
+    void Scene::getMemoryStats(SceneMemoryStats& stats) const
+    {
+        memset(&stats, 0, sizeof(stats));
+
+        _trSystem.getMemoryStats(stats.addSystem("Transform"));
+        _spriteSystem.getMemoryStats(stats.addSystem("Sprite"));
+        _moveSystem.getMemoryStats(stats.addSystem("Movement"));
+        _scriptSystem.getMemoryStats(stats.addSystem("Script"));
+        _tagSystem.getMemoryStats(stats.addSystem("Tag"));
+        _tileSystem.getMemoryStats(stats.addSystem("Tile"));
+        Vector2i tileMapSize = _tileSystem.getSize();
+        stats.tileCount = (uint32_t)(tileMapSize.x * tileMapSize.y);
+        stats.tagBuddy = _tagSystem.getBuddyStats();
+
+        stats.prefabDataBytes = _prefabData.size();
+        stats.prefabDataReservedBytes = _prefabData.capacity();
+        SystemMemoryStats prefabMap = {};
+        addMapStats(prefabMap, _prefabMap);
+        stats.prefabMapBytes = prefabMap.mapBucketBytes + prefabMap.mapNodeBytes;
+        stats.prefabTemplateBytes = _prefabTemplates.capacity() * sizeof(PrefabTemplate);
+
+        stats.imageBytes = _imageSize;
+        stats.arena = _arena.getStats();
+    }
+
+    void Scene::printMemoryStats() const
+    {
+        SceneMemoryStats stats;
+        getMemoryStats(stats);
+
+        printf("%-12s %10s %10s %10s %10s %10s %10s\n", "System (KB)", "Size", "Capacity", "Columns", "Map", "Other", "Slack");
+        size_t totalUsed = 0;
+        size_t totalReserved = 0;
+        for (uint32_t i = 0; i < stats.systemCount; i++)
+        {
+            const SystemMemoryStats& system = stats.systems[i];
+            size_t used = system.getUsedBytes();
+            size_t reserved = system.getReservedBytes();
+            totalUsed += used;
+            totalReserved += reserved;
+
+            printf("%-12s %10u %10u %10.1f %10.1f %10.1f %10.1f%s\n", system.name, system.size, system.capacity,
+                system.getColumnBytes(system.capacity) / 1024.0, (system.mapBucketBytes + system.mapNodeBytes) / 1024.0,
+                system.otherReservedBytes / 1024.0, (reserved - used) / 1024.0, system.inImage ? " (in image)" : "");
+
+            //Columns only get their own line when they're holding slack
+            for (uint32_t c = 0; c < system.columnCount && system.capacity > system.size; c++)
+            {
+                const memory::SoaColumn& column = system.columns[c];
+                printf("    %-20s %4u bytes each, %.1f KB of %.1f KB used\n", column.name, column.elementSize,
+                    (double)column.elementSize * system.size / 1024.0, (double)column.elementSize * system.capacity / 1024.0);
+            }
+        }
+        printf("Systems: %.1f KB used of %.1f KB reserved\n", totalUsed / 1024.0, totalReserved / 1024.0);
+        printf("Tile map: %u tiles per layer\n", stats.tileCount);
+
+        printf("Tag buddy allocator: %.1f KB used of %.1f KB in %u arenas, %.0f%% fragmented\n",
+            stats.tagBuddy.usedBytes / 1024.0, stats.tagBuddy.capacity / 1024.0, stats.tagBuddy.arenaCount,
+            stats.tagBuddy.getFragmentation() * 100.0f);
+        printf("Prefabs: %.1f KB data (%.1f KB reserved), %.1f KB map, %.1f KB templates\n",
+            stats.prefabDataBytes / 1024.0, stats.prefabDataReservedBytes / 1024.0,
+            stats.prefabMapBytes / 1024.0, stats.prefabTemplateBytes / 1024.0);
+        printf("Scene image: %.1f KB\n", stats.imageBytes / 1024.0);
+        printf("Scene arena: %.1f KB used of %.1f KB reserved in %u chunks\n",
+            stats.arena.usedBytes / 1024.0, stats.arena.reservedBytes / 1024.0, stats.arena.chunkCount);
+    }
 }
@@ -10,9 +10,15 @@
 #include "TagSystem.h"
 #include "TileSystem.h"
 #include "CameraSystem.h"
+#include "CommandBuffer.h"
+#include "SceneSnapshot.h"
+#include "MemoryStats.h"
+#include "Core/SceneArena.h"
 
 namespace asset { class AssetManager; struct FileSpan; }
 namespace render { class RenderManager; }
+namespace nw { class JobSystem; }
+namespace util { class DeltaWriteArchive; }
 using namespace asset;
 using namespace render;
 
@@ -27,11 +33,28 @@ namespace scene
         {
             //Offset into the scene's prefab data array
             uint32_t offset;
+            //Index into the compiled templates, invalid until the scene is prepared
+            uint32_t templateIndex;
+
+            PrefabData() : offset(0), templateIndex(UINT32_MAX) { }
+            explicit PrefabData(uint32_t dataOffset) : offset(dataOffset), templateIndex(UINT32_MAX) { }
 
             template <typename Archive> void serialize(Archive& ar) { ar.serializeU32(offset); }
         };
 
     private:
+        //Bump whenever the layout of the cooked scene image changes
+#ifdef NW_ENTITY_64BIT
+        static const uint32_t IMAGE_VERSION = 0x10001;  //Entity columns are twice as wide
+#else
+        static const uint32_t IMAGE_VERSION = 1;
+#endif
+
+        //Declared first so it is current while the members below are
+        //constructed and outlives all of them
+        memory::SceneArena _arena;
+        memory::SceneArena::Binding _arenaBinding;
+
         uint32_t _deltaTime;
         uint32_t _sceneTime;
 
@@ -44,27 +67,74 @@ namespace scene
         TileSystem _tileSystem;
         CameraSystem _camSystem;
 
-        eastl::vector<uint8_t> _prefabData;
+        //Prefab data compiled into per system rows when the scene is prepared,
+        //so spawning doesn't have to parse the prefab byte stream
+        struct PrefabTemplate
+        {
+            uint8_t components;
+            TagSystem::Template tag;
+            SpriteSystem::Template sprite;
+            MovementSystem::Template movement;
+            ScriptSystem::Template script;
+        };
+
+        eastl::vector<uint8_t, memory::SceneAllocator> _prefabData;
         //Maps prefab hash to offset into _prefabData
-        eastl::hash_map<AssetRef, PrefabData> _prefabMap;
+        eastl::hash_map<AssetRef, PrefabData, eastl::hash<AssetRef>, eastl::equal_to<AssetRef>, memory::SceneAllocator> _prefabMap;
+        eastl::vector<PrefabTemplate, memory::SceneAllocator> _prefabTemplates;
+        eastl::vector<Entity, memory::SceneAllocator> _spawned;     //Scratch list for instantiateMany()
+        DestroyBatch _destroyBatch;         //Scratch space shared by the systems' handleDestroyed()
+        eastl::vector<CommandBuffer> _commandBuffers;   //One per job system thread
+
+        //Decompressed scene asset, allocated from the arena. Kept for the
+        //lifetime of the scene since system columns and tile layers point
+        //straight into it.
+        void* _image;
+        size_t _imageSize;
 
     public:
         Scene();
+        ~Scene();
+
+        memory::SceneArenaStats getArenaStats() const { return _arena.getStats(); }
+        //Every system's storage, map and extras, plus the prefabs and image
+        void getMemoryStats(SceneMemoryStats& stats) const;
+        void printMemoryStats() const;
 
         template <typename Archive> void serialize(Archive& ar);
-        void load(AssetManager& assetMan, PackFile& pack, const FileSpan& span, script::AngelState& angelState);
+        //Loads a scene from the pack, optionally saving its post-load state into snapshot
+        void load(AssetManager& assetMan, PackFile& pack, AssetRef sceneRef, script::AngelState& angelState, SceneSnapshot* snapshot = nullptr);
+        void load(AssetManager& assetMan, const SceneSnapshot& snapshot, script::AngelState& angelState);
 #ifdef NW_ASSET_COOK
         void save(EndianVectorWriteArchive& ar, uint32_t entityCount);
         void addPrefab(AssetRef ref, const uint8_t* buffer, uint32_t length);
 #endif
 
+        //Per tick state used for rewinding. Covers entities and every system
+        //with plain data components; script objects are not captured.
+        void captureState(util::DeltaWriteArchive& ar);
+        void restoreState(AssetManager& assetMan, const uint8_t* state, size_t length);
+
         void handleInstantiated(AssetManager& assetMan);
-        void update(AssetManager& assetMan, uint32_t deltaTime);
-        void render(RenderManager& renderManager);
+        void update(AssetManager& assetMan, uint32_t deltaTime, nw::JobSystem& jobSystem);
+        //Removes every entity destroyed since the last call from all systems
+        void handleDestroyed();
+        //Sync point: applies everything recorded into the command buffers
+        void playbackCommands();
+        void render(RenderManager& renderManager, nw::JobSystem& jobSystem);
 
-        PrefabData getPrefab(AssetRef ref);
+        //False if the scene has no prefab with that ref
+        bool getPrefab(AssetRef ref, PrefabData& outPrefab) const;
         Entity instantiate(PrefabData prefab);
         void instantiate(Entity e, PrefabData prefab);
+        //Spawns count instances of a prefab, placing their transforms at positions
+        //(if not null). The new entities are written to outEntities if not null.
+        void instantiateMany(PrefabData prefab, uint32_t count, const Vector2i* positions, Entity* outEntities);
+        //Creates the entities right away and records their components into
+        //commands, for callers that run while systems are being updated.
+        //Needs a prepared scene; outEntities may not be null.
+        void recordInstantiate(CommandBuffer& commands, PrefabData prefab, uint32_t count, const Vector2i* positions,
+            Entity* outEntities);
 
         inline float getTime() { return (float)_sceneTime / 1000.0f; }
         inline float getDeltaTime() { return (float)_deltaTime / 1000.0f; }
@@ -77,6 +147,19 @@ namespace scene
         inline TagSystem& getTagSystem() { return _tagSystem; }
         inline TileSystem& getTileSystem() { return _tileSystem; }
         inline CameraSystem& getCameraSystem() { return _camSystem; }
+        //Command buffer of the calling thread, scripts always use the main thread's
+        inline CommandBuffer& getCommandBuffer(uint32_t threadIndex = 0) { return _commandBuffers[threadIndex]; }
+
+    private:
+        template <typename Archive> void serializeState(Archive& ar);
+        void loadImage(util::MemoryReadArchive& ar, script::AngelState& angelState,
+            const eastl::vector<asIScriptObject*>* scriptObjects);
+        void prepare(AssetManager& assetMan);
+        void compilePrefabs(AssetManager& assetMan);
+        void instantiateTemplate(const PrefabTemplate& tmpl, const Entity* entities, uint32_t count, const Vector2i* positions);
+        void applyInstantiations(const CommandBuffer& commands);
+        void applyStructuralCommand(const CommandBuffer::Command& cmd);
+        void applyWriteCommand(const CommandBuffer::Command& cmd);
     };
 }
 
@@ -0,0 +1,27 @@
+#include "Core/Core.h"
+#include "SceneSnapshot.h"
+#include <angelscript.h>
+
+namespace scene
+{
+    SceneSnapshot::SceneSnapshot() :
+        _isValid(false)
+    {
+    }
+
+    SceneSnapshot::~SceneSnapshot()
+    {
+        clear();
+    }
+
+    void SceneSnapshot::clear()
+    {
+        for (asIScriptObject* obj : _scriptObjects)
+        {
+            if (obj != nullptr) { obj->Release(); }
+        }
+        _scriptObjects.clear();
+        _image.clear();
+        _isValid = false;
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef SCENE_SCENE_SNAPSHOT_H
+#define SCENE_SCENE_SNAPSHOT_H
+
+#include <EASTL/vector.h>
+#include "Asset/AssetRef.h"
+
+class asIScriptObject;
+
+namespace scene
+{
+    //State of a scene directly after it was loaded. Restoring from a snapshot
+    //skips decompression, asset loading and script variable overrides, which
+    //makes restarting a scene little more than a memcpy.
+    class SceneSnapshot
+    {
+        friend class Scene;
+
+    private:
+        asset::AssetRef _sceneRef;
+        bool _isValid;
+
+        //Untouched copy of the decompressed scene image
+        eastl::vector<uint8_t> _image;
+
+        //Copies of the script component objects, with overrides applied but before init().
+        //Null for objects that can hold handles, those are built from the image again.
+        eastl::vector<asIScriptObject*> _scriptObjects;
+
+    public:
+        SceneSnapshot();
+        ~SceneSnapshot();
+
+        void clear();
+
+        bool isValid() const { return _isValid; }
+        bool isOf(asset::AssetRef sceneRef) const { return _isValid && _sceneRef == sceneRef; }
+    };
+}
+
+#endif
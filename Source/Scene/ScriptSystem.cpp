@@ -1,16 +1,19 @@
 #include "Core/Core.h"
 #include "ScriptSystem.h"
+#include "EntityManager.h"
 #include <angelscript.h>
 #include "Script/AngelState.h"
 #include "Script/AngelArray.h"
 #include "Asset/PackFile.h"
 #include "Asset/AssetManager.h"
 #include "Util/Archives.h"
+#include "Core/MemoryTracker.h"
 
 namespace scene
 {
     ScriptSystem::ScriptSystem()
         : _angelState(nullptr)
+        , _snapshotObjects(nullptr)
 #ifdef NW_ASSET_COOK
         , _isCooking(false)
 #endif
@@ -37,6 +40,101 @@ namespace scene
         }
     }
 
+    void ScriptSystem::createSnapshotScriptObjects(uint32_t instanceCount, char* overrideData, uint32_t overrideSize)
+    {
+        NW_ASSERT(_snapshotObjects->size() == _data.getSize());
+        asIScriptEngine* engine = _angelState->getScriptEngine();
+
+        bool anyLoaded = false;
+        for (uint32_t i = 0; i < _data.getSize(); i++)
+        {
+            asIScriptObject* source = (*_snapshotObjects)[i];
+            if (source != nullptr)
+            {
+                _data.object[i] = (asIScriptObject*)engine->CreateScriptObjectCopy(source, source->GetObjectType());
+            }
+            else
+            {
+                //Not copyable, built the same way a normal load does
+                asIScriptObject* obj = createObjectOfType(_data.aType[i]);
+                _data.object[i] = obj;
+                setObjectEntity(obj, getEntity(EInstance(i)));
+                anyLoaded = true;
+            }
+        }
+
+        if (anyLoaded)
+        {
+            handleOverrides(instanceCount, overrideData, overrideSize);
+        }
+    }
+
+    //A copy made with CreateScriptObjectCopy() shares every handle the
+    //original holds, directly or inside its value members and arrays. Types
+    //that can hold one aren't kept in snapshots.
+    static bool canHoldHandles(asIScriptEngine* engine, int typeId)
+    {
+        if (typeId & asTYPEID_OBJHANDLE) { return true; }
+        if ((typeId & asTYPEID_MASK_OBJECT) == 0) { return false; }
+
+        asITypeInfo* type = engine->GetTypeInfoById(typeId);
+        if (type == nullptr) { return false; }
+
+        asDWORD flags = type->GetFlags();
+        if (flags & asOBJ_SCRIPT_OBJECT)
+        {
+            for (asUINT i = 0; i < type->GetPropertyCount(); i++)
+            {
+                int propTypeId;
+                type->GetProperty(i, nullptr, &propTypeId);
+                if (canHoldHandles(engine, propTypeId)) { return true; }
+            }
+            return false;
+        }
+
+        if (flags & asOBJ_TEMPLATE)
+        {
+            for (asUINT i = 0; i < type->GetSubTypeCount(); i++)
+            {
+                if (canHoldHandles(engine, type->GetSubTypeId(i))) { return true; }
+            }
+            return false;
+        }
+
+        //Registered types that can be part of a reference cycle hold handles
+        //(dictionary, ref)
+        return (flags & asOBJ_GC) != 0;
+    }
+
+    void ScriptSystem::saveSnapshot(eastl::vector<asIScriptObject*>& objects)
+    {
+        asIScriptEngine* engine = _angelState->getScriptEngine();
+
+        //Objects that could share a handle with the live one are left null
+        //and built from the image again on restore
+        eastl::hash_map<int, bool> typeHoldsHandles;
+        objects.resize(_data.getSize());
+        for (uint32_t i = 0; i < _data.getSize(); i++)
+        {
+            asIScriptObject* obj = _data.object[i];
+            int typeId = obj->GetTypeId();
+
+            bool holdsHandles;
+            auto it = typeHoldsHandles.find(typeId);
+            if (it != typeHoldsHandles.end())
+            {
+                holdsHandles = it->second;
+            }
+            else
+            {
+                holdsHandles = canHoldHandles(engine, typeId);
+                typeHoldsHandles.insert(eastl::make_pair(typeId, holdsHandles));
+            }
+
+            objects[i] = holdsHandles ? nullptr : (asIScriptObject*)engine->CreateScriptObjectCopy(obj, obj->GetObjectType());
+        }
+    }
+
     void ScriptSystem::handleOverrides(uint32_t instanceCount, char* data, uint32_t dataSize)
     {
         util::MemoryReadArchive ar;
@@ -48,24 +146,31 @@ namespace scene
             uint32_t size = 0;
             ar.serializeCustom(ei);
             ar.serializeU32(size);
-            handleInstanceOverrides(ar, ei, size);
+
+            //Copies from a snapshot already have their overrides applied
+            if (_snapshotObjects != nullptr && (*_snapshotObjects)[ei.index] != nullptr)
+            {
+                ar.serializePadding(size);
+                continue;
+            }
+
+            handleInstanceOverrides(ar, getObject(ei), getAngelType(ei), size);
         }
     }
 
-    void ScriptSystem::handleInstanceOverrides(util::MemoryReadArchive& ar, EInstance ei, uint32_t size)
+    void ScriptSystem::handleInstanceOverrides(util::MemoryReadArchive& ar, asIScriptObject* obj, script::AngelType aType, uint32_t size)
     {
         const char* start = ar.currentPtr();
         const char* end = start + size;
 
-        script::AngelType aType = getAngelType(ei);
         while (ar.currentPtr() < end)
         {
-            serializeVariable(ar, ei, aType, nullptr);
+            serializeVariable(ar, obj, aType, nullptr);
         }
         NW_ASSERT(ar.currentPtr() == end);
     }
 
-    void ScriptSystem::serializeVariable(util::MemoryReadArchive& ar, EInstance ei, script::AngelType parentType, void* dest)
+    void ScriptSystem::serializeVariable(util::MemoryReadArchive& ar, asIScriptObject* obj, script::AngelType parentType, void* dest)
     {
         //Read name hash and type
         uint32_t nameHash;
@@ -91,7 +196,6 @@ namespace scene
             //If dest is null, that means that this is the script component object
             if (dest == nullptr)
             {
-                asIScriptObject* obj = getObject(ei);
                 NW_ASSERT(obj != nullptr);
                 dest = obj->GetAddressOfProperty(propIndex);
             }
@@ -100,7 +204,7 @@ namespace scene
                 dest = (char*)dest + offset;
             }
 
-            serializeValue(ar, ei, parentType, dest, runtimeTypeId);
+            serializeValue(ar, obj, parentType, dest, runtimeTypeId);
         }
         else
         {
@@ -114,7 +218,7 @@ namespace scene
         }
     }
 
-    void ScriptSystem::serializeValue(util::MemoryReadArchive& ar, EInstance ei, script::AngelType parentType, void* dest, int propTypeId)
+    void ScriptSystem::serializeValue(util::MemoryReadArchive& ar, asIScriptObject* obj, script::AngelType parentType, void* dest, int propTypeId)
     {
         asITypeInfo* propTypeInfo = _angelState->getScriptEngine()->GetTypeInfoById(propTypeId);
 
@@ -161,7 +265,7 @@ namespace scene
 
                 for (uint32_t i = 0; i < arraySize; i++)
                 {
-                    serializeValue(ar, ei, parentType, output->At(i), subTypeId);
+                    serializeValue(ar, obj, parentType, output->At(i), subTypeId);
                 }
             }
             else
@@ -171,7 +275,7 @@ namespace scene
 
                 for (uint32_t i = 0; i < propCount; i++)
                 {
-                    serializeVariable(ar, ei, _angelState->getAngelTypeFromTypeId(propTypeId), dest);
+                    serializeVariable(ar, obj, _angelState->getAngelTypeFromTypeId(propTypeId), dest);
                 }
             }
             break;
@@ -208,6 +312,7 @@ namespace scene
     void ScriptSystem::update()
     {
         SCOPED_CPU_EVENT(event)(0xFFFFFFFF, "ScriptSystem::update");
+        memory::ScopedMemoryTag tag(memory::MemoryTag::Script);
 
         _angelState->startExecution();
 
@@ -228,9 +333,9 @@ namespace scene
 
         _needInit.clear();
 
-        //Save the value (it changes when entities are added)
-        uint32_t length = _data.getSize();
-        for (size_t i = 0; i < length; i++)
+        //Scripts record structural changes into the command buffer, so the
+        //component storage doesn't change while they run
+        for (uint32_t i = 0; i < _data.getSize(); i++)
         {
             //TODO: Separate array of entities that need update called
             //Then we can cut out the branch
@@ -376,34 +481,156 @@ namespace scene
             //Serialize the overriden variables
             util::MemoryReadArchive ar;
             ar.init(data, varOverrideSize);
-            handleInstanceOverrides(ar, ei, varOverrideSize);
+            handleInstanceOverrides(ar, getObject(ei), aType, varOverrideSize);
             data += varOverrideSize;
         }
 
         return data;
     }
 
+    const uint8_t* ScriptSystem::compileTemplate(const uint8_t* data, Template& tmpl)
+    {
+        uint32_t varOverrideSize;
+        memcpy(&tmpl.aType, data, sizeof(tmpl.aType)); data += sizeof(tmpl.aType);
+        memcpy(&varOverrideSize, data, sizeof(varOverrideSize)); data += sizeof(varOverrideSize);
+
+        //The prefab data outlives the template, so the overrides are kept in place
+        tmpl.overrides = data;
+        tmpl.overrideSize = varOverrideSize;
+        tmpl.holdsHandles = false;
+
+        tmpl.prototype = createObjectOfType(tmpl.aType);
+        if (tmpl.prototype != nullptr)
+        {
+            util::MemoryReadArchive ar;
+            ar.init(data, varOverrideSize);
+            handleInstanceOverrides(ar, tmpl.prototype, tmpl.aType, varOverrideSize);
+
+            asIScriptEngine* engine = _angelState->getScriptEngine();
+            tmpl.holdsHandles = canHoldHandles(engine, tmpl.prototype->GetTypeId());
+        }
+        data += varOverrideSize;
+
+        return data;
+    }
+
+    void ScriptSystem::createMany(const Entity* entities, uint32_t count, const Template& tmpl)
+    {
+        //Matches create(), which skips types that aren't components
+        if (tmpl.prototype == nullptr)
+        {
+            return;
+        }
+
+        asIScriptEngine* engine = _angelState->getScriptEngine();
+        asITypeInfo* type = tmpl.prototype->GetObjectType();
+
+        uint32_t first = _data.getSize();
+        _data.reserve(first + count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            asIScriptObject* obj;
+            if (tmpl.holdsHandles)
+            {
+                //A copy would share the prototype's handles
+                obj = createObjectOfType(tmpl.aType);
+
+                util::MemoryReadArchive ar;
+                ar.init(tmpl.overrides, tmpl.overrideSize);
+                handleInstanceOverrides(ar, obj, tmpl.aType, tmpl.overrideSize);
+            }
+            else
+            {
+                obj = (asIScriptObject*)engine->CreateScriptObjectCopy(tmpl.prototype, type);
+            }
+
+            setObjectEntity(obj, entities[i]);
+            _data.push(obj, nullptr, entities[i], tmpl.aType);
+        }
+
+        populateEntityMap(_map, _data.entities, count, first);
+        _needInit.insert(_needInit.end(), entities, entities + count);
+    }
+
+    void ScriptSystem::releaseTemplate(Template& tmpl)
+    {
+        if (tmpl.prototype != nullptr)
+        {
+            tmpl.prototype->Release();
+            tmpl.prototype = nullptr;
+        }
+    }
+
     void ScriptSystem::moveInstance(EInstance dst, EInstance src)
     {
         _data.move(dst.index, src.index);
     }
 
-    void ScriptSystem::handleDestroyed(const Entity* destroyed, size_t destroyedLen)
+    void ScriptSystem::handleDestroyed(const Entity* destroyed, size_t destroyedLen, DestroyBatch& batch)
     {
+        //Most entities that die (bullets, particles) have no script
+        if (_data.getSize() == 0)
+        {
+            return;
+        }
+
+        collectDestroyed(_map, destroyed, destroyedLen, batch);
+        if (batch.indices.empty())
+        {
+            return;
+        }
+
         _angelState->startExecution();
 
-        for (size_t i = 0; i < destroyedLen; i++)
+        //Decrement the ref counts
+        for (uint32_t index : batch.indices)
+        {
+            _data.object[index]->Release();
+        }
+
+        uint32_t size = _data.getSize();
+        for (uint32_t index : batch.indices)
         {
-            auto result = _map.find(destroyed[i]);
-            if (result != _map.end())
+            uint32_t last = --size;
+            if (index != last)
             {
-                //Call disposal function
-                //TODO
-                //uint32_t offset = _data.dispose[result->second.index];
-                //if (offset != UINT32_MAX) { callFn(destroyed[i], offset); }
+                moveInstance(EInstance(index), EInstance(last));
+                batch.moved.push_back(index);
+
+#ifdef NW_ASSET_COOK
+                if (_isCooking) { _variableOverrides[index] = _variableOverrides[last]; }
+#endif
+            }
+        }
+        _data.setSize(size);
+#ifdef NW_ASSET_COOK
+        if (_isCooking) { _variableOverrides.resize(size); }
+#endif
+
+        fixupEntityMap(_map, _data.entities, size, batch);
+
+        _angelState->endExecution();
+    }
+
+    void ScriptSystem::getMemoryStats(SystemMemoryStats& stats) const
+    {
+        //The script objects themselves belong to the script engine
+        addStorageStats(stats, _data);
+        addMapStats(stats, _map);
+        addVectorStats(stats, _needInit);
+    }
 
-                //Destroy the component
-                destroy(result->first);
+    void ScriptSystem::destroyDead(EntityManager& entityManager)
+    {
+        _angelState->startExecution();
+
+        //Walk backwards so the swap in destroy() only moves checked components
+        for (uint32_t i = _data.getSize(); i-- > 0;)
+        {
+            Entity e = _data.entities[i];
+            if (!entityManager.alive(e))
+            {
+                destroy(e);
             }
         }
 
@@ -416,17 +643,21 @@ namespace scene
     {
         NW_UNUSED(e);
 
-#ifdef NW_DEVELOP
-        char buffer[256];
-        snprintf(buffer, sizeof(buffer), "%s::%s", obj->GetObjectType()->GetName(), fn->GetName());
-        SCOPED_CPU_EVENT(event)(0xFFFFFFFF, buffer);
-#endif
-
         auto* ctx = _angelState->getScriptContext();
 
+#ifdef NW_PROFILE
+        script::ScriptProfiler& profiler = _angelState->getProfiler();
+        uint64_t begin = profiler.beginCall(ctx, fn);
+#endif
+
+        COUNT_WORK(ScriptCalls, 1);
         ctx->Prepare(fn);
         ctx->SetObject(obj);
         int r = ctx->Execute();
+
+#ifdef NW_PROFILE
+        profiler.endCall(fn, begin);
+#endif
         if (r > 0)
         {
             printf("Error executing %s : %s\n", fn->GetName(), ctx->GetExceptionString());
@@ -9,6 +9,8 @@
 #include "Script/AngelType.h"
 #include "Entity.h"
 #include "EInstance.h"
+#include "EntityMap.h"
+#include "MemoryStats.h"
 
 class asIScriptFunction;
 class asIScriptObject;
@@ -17,6 +19,8 @@ namespace script { class AngelState; }
 
 namespace scene
 {
+    class EntityManager;
+
     class ScriptSystem
     {
     private:
@@ -25,7 +29,7 @@ namespace scene
 
         asITypeInfo* _componentBaseClass;
 
-        eastl::hash_map<Entity, EInstance> _map;
+        EntityInstanceMap _map;
 
         //Init, update, and dispose are indices into the _scriptStr array in
         //case the vector is resized (when new script functions are added).
@@ -39,6 +43,9 @@ namespace scene
         //The list of entities that need their init() called
         eastl::vector<Entity> _needInit;
 
+        //Set while a scene is restored from a snapshot; objects are copied from here
+        const eastl::vector<asIScriptObject*>* _snapshotObjects;
+
 #ifdef NW_ASSET_COOK
         bool _isCooking;
 
@@ -51,6 +58,19 @@ namespace scene
 #endif
 
     public:
+        //Prefab script component. The prototype is created once with the
+        //prefab's variable overrides applied and copied for every instance.
+        //Types that can hold handles can't be copied, so their instances are
+        //built and have the overrides replayed instead.
+        struct Template
+        {
+            script::AngelType aType;
+            asIScriptObject* prototype;
+            const uint8_t* overrides;
+            uint32_t overrideSize;
+            bool holdsHandles;
+        };
+
         ScriptSystem();
 
         void init(script::AngelState& angel);
@@ -80,26 +100,27 @@ namespace scene
             //Add entities to map
             if (ar.IsReading)
             {
-                for (uint32_t i = 0; i < length; i++)
-                {
-                    _map[_data.entities[i]] = i;
-                    _needInit.push_back(_data.entities[i]);
-                }
+                populateEntityMap(_map, _data.entities, length);
+                _needInit.insert(_needInit.end(), _data.entities, _data.entities + length);
                 memset(_data.object, 0, sizeof(*_data.object) * length);
 
-                //Read variable overrides into separate memory
+                //Variable overrides are read straight out of the archive's memory
                 //Kinda hacky, but I'd rather not have to include the angelscript headers
                 uint32_t overrideTotalSize;
                 uint32_t instanceCount;
                 ar.serializeU32(overrideTotalSize);
                 ar.serializeU32(instanceCount);
+                char* overrideData = (char*)ar.mapBytes(overrideTotalSize);
 
-                eastl::vector<char> overrideData;
-                overrideData.resize(overrideTotalSize);
-                AR_SERIALIZE_ARRAY_CHAR(ar, overrideData.data(), overrideTotalSize);
-
-                createLoadedScriptObjects();
-                handleOverrides(instanceCount, overrideData.data(), overrideTotalSize);
+                if (_snapshotObjects != nullptr)
+                {
+                    createSnapshotScriptObjects(instanceCount, overrideData, overrideTotalSize);
+                }
+                else
+                {
+                    createLoadedScriptObjects();
+                    handleOverrides(instanceCount, overrideData, overrideTotalSize);
+                }
             }
 #ifdef NW_ASSET_COOK
             else
@@ -140,6 +161,9 @@ namespace scene
 
         void handleOverrides(uint32_t instanceCount, char* data, uint32_t dataSize);
 
+        void setSnapshotObjects(const eastl::vector<asIScriptObject*>* objects) { _snapshotObjects = objects; }
+        void saveSnapshot(eastl::vector<asIScriptObject*>& objects);
+
 #ifdef NW_ASSET_COOK
         void setCooking(bool cooking) { _isCooking = cooking; }
         void addVariableOverride(EInstance ei, const void* data, uint32_t size);
@@ -150,10 +174,17 @@ namespace scene
 
         bool exists(Entity e) { return _map.find(e) != _map.end(); }
         EInstance create(Entity e, script::AngelType aType);
+        void reserve(uint32_t count) { _data.reserve(_data.getSize() + count); }
         void destroy(Entity e);
         const uint8_t* instantiate(Entity e, const uint8_t* data);
+        const uint8_t* compileTemplate(const uint8_t* data, Template& tmpl);
+        void createMany(const Entity* entities, uint32_t count, const Template& tmpl);
+        void releaseTemplate(Template& tmpl);
 
-        void handleDestroyed(const Entity* destroyed, size_t destroyedLen);
+        void handleDestroyed(const Entity* destroyed, size_t destroyedLen, DestroyBatch& batch);
+        void getMemoryStats(SystemMemoryStats& stats) const;
+        //Removes components of entities that are no longer alive (after a rewind)
+        void destroyDead(EntityManager& entityManager);
 
         EInstance getInstance(Entity e)
         {
@@ -167,12 +198,13 @@ namespace scene
 
     private:
         void createLoadedScriptObjects();
+        void createSnapshotScriptObjects(uint32_t instanceCount, char* overrideData, uint32_t overrideSize);
         asIScriptObject* createObjectOfType(script::AngelType aType);
         void setObjectEntity(asIScriptObject* obj, Entity e);
 
-        void handleInstanceOverrides(util::MemoryReadArchive& ar, EInstance ei, uint32_t size);
-        void serializeVariable(util::MemoryReadArchive& ar, EInstance ei, script::AngelType parentType, void* dest);
-        void serializeValue(util::MemoryReadArchive& ar, EInstance ei, script::AngelType parentType, void* dest, int propTypeId);
+        void handleInstanceOverrides(util::MemoryReadArchive& ar, asIScriptObject* obj, script::AngelType aType, uint32_t size);
+        void serializeVariable(util::MemoryReadArchive& ar, asIScriptObject* obj, script::AngelType parentType, void* dest);
+        void serializeValue(util::MemoryReadArchive& ar, asIScriptObject* obj, script::AngelType parentType, void* dest, int propTypeId);
 
         void moveInstance(EInstance dst, EInstance src);
 
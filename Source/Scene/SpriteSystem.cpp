@@ -1,4 +1,5 @@
 #include "Core/Core.h"
+#include "Core/JobSystem.h"
 #include "SpriteSystem.h"
 #include "TransformSystem.h"
 #include "Asset/PackFile.h"
@@ -57,19 +58,58 @@ namespace scene
         _instantiated.clear();
     }
 
-    void SpriteSystem::render(TransformSystem& trSystem, Renderer2d& renderer)
+    //Sprites per render list job
+    const uint32_t RENDER_LIST_GRAIN = 256;
+
+    struct SpriteSystem::RenderListJob
+    {
+        SpriteSystem* spriteSystem;
+        TransformSystem* trSystem;
+    };
+
+    void SpriteSystem::buildRenderList(TransformSystem& trSystem, nw::JobSystem& jobSystem)
+    {
+        SCOPED_CPU_EVENT(event)(PROF_COLOR_GRAPHICS, "SpriteSystem::buildRenderList");
+        COUNT_WORK(SpriteEntities, _data.getSize());
+
+        _renderList.resize(_data.getSize());
+
+        RenderListJob job = { this, &trSystem };
+        nw::JobCounter counter(0);
+        jobSystem.parallelFor(buildRenderListRange, &job, _data.getSize(), RENDER_LIST_GRAIN, &counter);
+        jobSystem.wait(&counter);
+    }
+
+    void SpriteSystem::buildRenderListRange(void* data, uint32_t begin, uint32_t end)
+    {
+        RenderListJob* job = (RenderListJob*)data;
+        Storage& sprites = job->spriteSystem->_data;
+        TransformSystem& trSystem = *job->trSystem;
+        SpriteDraw* draws = job->spriteSystem->_renderList.data();
+
+        for (uint32_t i = begin; i < end; i++)
+        {
+            SpriteDraw& draw = draws[i];
+            draw.pos = trSystem.getWorldPos(trSystem.getInstance(sprites.entities[i])) + sprites.offset[i];
+            draw.size = sprites.size[i];
+            draw.texOffset = sprites.texOffset[i];
+            draw.texFlip = Vector2i(
+                sprites.misc[i].horTexFlip ? -1 : 1,
+                sprites.misc[i].verTexFlip ? -1 : 1);
+            draw.texture = sprites.texture[i];
+            draw.depth = sprites.misc[i].depth;
+            draw.alpha = sprites.misc[i].alpha;
+            draw.rotation = sprites.misc[i].rotation * 90.0f;
+        }
+    }
+
+    void SpriteSystem::submitRenderList(Renderer2d& renderer)
     {
-        SCOPED_CPU_EVENT(event)(PROF_COLOR_GRAPHICS, "SpriteSystem::render");
-        for (size_t i = 0; i < _data.getSize(); i++)
+        SCOPED_CPU_EVENT(event)(PROF_COLOR_GRAPHICS, "SpriteSystem::submitRenderList");
+        for (const SpriteDraw& draw : _renderList)
         {
-            Vector2i texFlip(
-                _data.misc[i].horTexFlip ? -1 : 1,
-                _data.misc[i].verTexFlip ? -1 : 1);
-            float rotation = _data.misc[i].rotation * 90.0f;
-            renderer.submitSprite(
-                trSystem.getWorldPos(trSystem.getInstance(_data.entities[i])) + _data.offset[i],
-                _data.size[i], _data.misc[i].depth, _data.misc[i].alpha,
-                _data.texture[i], _data.texOffset[i], texFlip, rotation);
+            renderer.submitSprite(draw.pos, draw.size, draw.depth, draw.alpha,
+                draw.texture, draw.texOffset, draw.texFlip, draw.rotation);
         }
     }
 
@@ -110,6 +150,13 @@ namespace scene
         _map.erase(e);
     }
 
+    void SpriteSystem::clear()
+    {
+        _map.clear();
+        _data.setSize(0);
+        _instantiated.clear();
+    }
+
     const uint8_t* SpriteSystem::instantiate(Entity e, const uint8_t* data)
     {
         EInstance ei = create(e);
@@ -136,20 +183,65 @@ namespace scene
         return data;
     }
 
+    const uint8_t* SpriteSystem::compileTemplate(AssetManager& assetMan, const uint8_t* data, Template& tmpl)
+    {
+        memcpy(&tmpl.size, data, sizeof(tmpl.size)); data += sizeof(tmpl.size);
+        memcpy(&tmpl.offset, data, sizeof(tmpl.offset)); data += sizeof(tmpl.offset);
+        memcpy(&tmpl.misc.depth, data, sizeof(tmpl.misc.depth)); data += sizeof(tmpl.misc.depth);
+        memcpy(&tmpl.misc.alpha, data, sizeof(tmpl.misc.alpha)); data += sizeof(tmpl.misc.alpha);
+        memcpy(&tmpl.textureRef.hash, data, sizeof(tmpl.textureRef.hash)); data += sizeof(tmpl.textureRef.hash);   //HACK UNTIL PROPER SERIALIZATION
+        memcpy(&tmpl.texOffset, data, sizeof(tmpl.texOffset)); data += sizeof(tmpl.texOffset);
+        tmpl.misc._flags = 0;
+
+        //Prefab textures are loaded with the scene, so the handle never changes
+        tmpl.texture = assetMan.getTexture(tmpl.textureRef);
+
+        return data;
+    }
+
+    void SpriteSystem::createMany(const Entity* entities, uint32_t count, const Template& tmpl)
+    {
+        uint32_t first = _data.getSize();
+        _data.reserve(first + count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            _data.push(entities[i],
+                tmpl.size, tmpl.offset, tmpl.texOffset,
+                tmpl.textureRef, tmpl.texture,
+                tmpl.misc);
+        }
+
+        populateEntityMap(_map, _data.entities, count, first);
+    }
+
     void SpriteSystem::moveInstance(EInstance dst, EInstance src)
     {
         _data.move(dst.index, src.index);
     }
 
-    void SpriteSystem::handleDestroyed(const Entity* destroyed, size_t destroyedLen)
+    void SpriteSystem::handleDestroyed(const Entity* destroyed, size_t destroyedLen, DestroyBatch& batch)
     {
-        for (size_t i = 0; i < destroyedLen; i++)
+        collectDestroyed(_map, destroyed, destroyedLen, batch);
+
+        uint32_t size = _data.getSize();
+        for (uint32_t index : batch.indices)
         {
-            auto result = _map.find(destroyed[i]);
-            if (result != _map.end())
+            uint32_t last = --size;
+            if (index != last)
             {
-                destroy(result->first);
+                moveInstance(EInstance(index), EInstance(last));
+                batch.moved.push_back(index);
             }
         }
+        _data.setSize(size);
+
+        fixupEntityMap(_map, _data.entities, size, batch);
+    }
+
+    void SpriteSystem::getMemoryStats(SystemMemoryStats& stats) const
+    {
+        addStorageStats(stats, _data);
+        addMapStats(stats, _map);
+        addVectorStats(stats, _renderList);
     }
 }
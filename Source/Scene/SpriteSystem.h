@@ -10,9 +10,12 @@
 #include "Math/Vector2i.h"
 #include "Entity.h"
 #include "EInstance.h"
+#include "EntityMap.h"
+#include "MemoryStats.h"
 
 namespace asset { class PackFile; }
 namespace render { class Renderer2d; }
+namespace nw { class JobSystem; }
 using namespace math;
 using namespace render;
 
@@ -23,7 +26,7 @@ namespace scene
     class SpriteSystem
     {
     private:
-        eastl::hash_map<Entity, EInstance> _map;
+        EntityInstanceMap _map;
         struct Misc
         {
             uint8_t depth;
@@ -38,6 +41,7 @@ namespace scene
                 };
                 uint8_t _flags;
             };
+            AR_BULK_SERIALIZABLE(3);
             template <typename Archive>
             void serialize(Archive& ar)
             {
@@ -56,11 +60,43 @@ namespace scene
             Misc, misc);
         Storage _data;
 
+        //Everything needed to submit a sprite, built by buildRenderList()
+        struct SpriteDraw
+        {
+            Vector2i pos;
+            Vector2i size;
+            Vector2i texOffset;
+            Vector2i texFlip;
+            bgfx::TextureHandle texture;
+            uint8_t depth;
+            uint8_t alpha;
+            float rotation;
+        };
+        eastl::vector<SpriteDraw> _renderList;
+
+        //Space reserved for the texture column in the scene image
+        static const uint32_t IMAGE_TEXTURE_SIZE = 2;
+        static_assert(sizeof(bgfx::TextureHandle) == IMAGE_TEXTURE_SIZE, "Scene image layout depends on the texture handle size");
+
+        //Asset refs carry a name index in develop builds, which forces the copying path
+        static const bool IMAGE_IN_PLACE = util::IsBulkSerializable<asset::AssetRef>::value;
+
         //Keeps track of which components have been instantiated this frame
         //Used primarily so that we can get their texture references in one place
         eastl::vector<Entity> _instantiated;
 
     public:
+        //Prefab sprite component, compiled once the scene's textures are loaded
+        struct Template
+        {
+            Vector2i size;
+            Vector2i offset;
+            Vector2i texOffset;
+            asset::AssetRef textureRef;
+            bgfx::TextureHandle texture;
+            Misc misc;
+        };
+
         SpriteSystem();
 
         template <typename Archive>
@@ -74,30 +110,35 @@ namespace scene
                 return;
             }
 
-            //If we're reading, then preallocate some space
-            if (ar.IsReading)
+            //Columns are stored exactly as they are laid out in memory. Builds where every
+            //column matches its serialized form use a loaded scene image in place.
+            ar.serializeAlign(Storage::imageAlignment());
+            void* image = (IMAGE_IN_PLACE) ? ar.mapBytes(Storage::imageSize(length)) : nullptr;
+            if (image != nullptr)
             {
-                _data.resize(length + 128);
-                _data.setSize(length);
-
-                memset(_data.texture, 0, length * sizeof(_data.texture[0]));
+                _data.adopt(image, length);
             }
+            else
+            {
+                if (ar.IsReading)
+                {
+                    _data.resize(length + 128);
+                    _data.setSize(length);
+                }
 
-            //Serialize fields
-            AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.entities, length);
-            AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.size, length);
-            AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.offset, length);
-            AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.textureRef, length);
-            AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.texOffset, length);
-            AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.misc, length);
+                AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.entities, length);
+                AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.size, length);
+                AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.offset, length);
+                AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.texOffset, length);
+                AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.textureRef, length);
+                ar.serializePadding(IMAGE_TEXTURE_SIZE * length);   //Filled in by prepare()
+                AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.misc, length);
+            }
 
             //Add entities to map
             if (ar.IsReading)
             {
-                for (uint32_t i = 0; i < length; i++)
-                {
-                    _map[_data.entities[i]] = i;
-                }
+                populateEntityMap(_map, _data.entities, length);
             }
         }
 
@@ -107,19 +148,28 @@ namespace scene
 #endif
 
         void handleInstantiated(asset::AssetManager& assetMan);
-        void render(TransformSystem& trSystem, Renderer2d& renderer);
+        //Resolves every sprite into the render list. Only reads the transforms,
+        //so it can run alongside anything that doesn't write them.
+        void buildRenderList(TransformSystem& trSystem, nw::JobSystem& jobSystem);
+        //Submits the render list, which has to happen on the render thread
+        void submitRenderList(Renderer2d& renderer);
 
         bool exists(Entity e) { return _map.find(e) != _map.end(); }
         EInstance create(Entity e);
+        void reserve(uint32_t count) { _data.reserve(_data.getSize() + count); }
         EInstance createOrGetInstance(Entity e)
         {
             if (exists(e)) { return getInstance(e); }
             else { return create(e); }
         }
         void destroy(Entity e);
+        void clear();
         const uint8_t* instantiate(Entity e, const uint8_t* data);
+        const uint8_t* compileTemplate(asset::AssetManager& assetMan, const uint8_t* data, Template& tmpl);
+        void createMany(const Entity* entities, uint32_t count, const Template& tmpl);
 
-        void handleDestroyed(const Entity* destroyed, size_t destroyedLen);
+        void handleDestroyed(const Entity* destroyed, size_t destroyedLen, DestroyBatch& batch);
+        void getMemoryStats(SystemMemoryStats& stats) const;
 
         inline EInstance getInstance(Entity e)
         {
@@ -149,6 +199,9 @@ namespace scene
         inline void setRotation(EInstance ei, int rotation) { _data.misc[ei.index].rotation = rotation / 90; }
 
     private:
+        struct RenderListJob;
+        static void buildRenderListRange(void* data, uint32_t begin, uint32_t end);
+
         void moveInstance(EInstance dst, EInstance src);
 
         inline Entity getEntity(EInstance ei) { return _data.entities[ei.index]; }
@@ -1,13 +1,49 @@
 #include "Core/Core.h"
 #include "TagSystem.h"
 #include "Asset/PackFile.h"
+#include <EASTL/sort.h>
+#include <EASTL/algorithm.h>
 
 namespace scene
 {
-    //16 * 2 ^ 12 = 65k
+    //Arenas of 16 * 2 ^ 11 = 32k, more are added as the scene needs them
     const size_t TAG_BUDDY_LEVELS = 12;
     const size_t TAG_LEAF_SIZE = 16;
 
+    static bool entityLess(Entity a, Entity b)
+    {
+        return a.id() < b.id();
+    }
+
+    //Merges a sorted batch into a sorted list in place. EASTL has no
+    //inplace_merge, so the list is filled from the back, moving each of its
+    //entities once.
+    static void mergeSorted(eastl::vector<Entity>& list, const Entity* batch, uint32_t count)
+    {
+        size_t i = list.size();
+        size_t j = count;
+        list.resize(i + count);
+
+        Entity* out = list.data() + list.size();
+        while (j > 0)
+        {
+            if (i > 0 && entityLess(batch[j - 1], list[i - 1])) { *--out = list[--i]; }
+            else { *--out = batch[--j]; }
+        }
+    }
+
+    //Matches entities in a sorted batch
+    struct InSortedBatch
+    {
+        const Entity* first;
+        const Entity* last;
+
+        bool operator()(Entity e) const
+        {
+            return eastl::binary_search(first, last, e, entityLess);
+        }
+    };
+
     TagSystem::TagSystem()
     {
     }
@@ -64,6 +100,8 @@ namespace scene
         const EInstance lastInst(_data.getSize() - 1);
         const Entity lastEntity = getEntity(lastInst);
 
+        indexRemoveAll(ei);
+
         //Free the block memory
         size_t oldSize = sizeof(uint32_t) * (2 + getCapacity(ei));
         uint32_t* oldBlock = getPointer(ei);
@@ -80,6 +118,19 @@ namespace scene
         _map.erase(e);
     }
 
+    void TagSystem::clear()
+    {
+        for (uint32_t i = 0; i < _data.getSize(); i++)
+        {
+            EInstance ei(i);
+            _buddy.free(getPointer(ei), sizeof(uint32_t) * (2 + getCapacity(ei)));
+        }
+
+        _map.clear();
+        _data.setSize(0);
+        _index.clear();
+    }
+
     const uint8_t* TagSystem::instantiate(Entity e, const uint8_t* data)
     {
         uint32_t tagsLen;
@@ -91,21 +142,134 @@ namespace scene
         memcpy(getTags(ei), data, tagsLen * sizeof(uint32_t));
         data += tagsLen * sizeof(uint32_t);
 
+        for (uint32_t i = 0; i < tagsLen; i++)
+        {
+            indexAdd(getTags(ei)[i], e);
+        }
+
+        return data;
+    }
+
+    const uint8_t* TagSystem::compileTemplate(const uint8_t* data, Template& tmpl)
+    {
+        memcpy(&tmpl.count, data, sizeof(tmpl.count)); data += sizeof(tmpl.count);
+        tmpl.tags = data;
+        data += tmpl.count * sizeof(uint32_t);
+
         return data;
     }
 
+    void TagSystem::createMany(const Entity* entities, uint32_t count, const Template& tmpl)
+    {
+        size_t allocSize = (tmpl.count + 2) * sizeof(uint32_t);
+        allocSize = _buddy.getActualAllocSize(allocSize);
+        const uint32_t capacity = (uint32_t)(allocSize / sizeof(uint32_t)) - 2;
+
+        uint32_t first = _data.getSize();
+        _data.reserve(first + count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t* mem = (uint32_t*)_buddy.alloc(allocSize);
+            mem[0] = tmpl.count;
+            mem[1] = capacity;
+            memcpy(&mem[2], tmpl.tags, tmpl.count * sizeof(uint32_t));
+
+            _data.push(entities[i], getOffset(mem));
+        }
+
+        populateEntityMap(_map, _data.entities, count, first);
 
+        if (tmpl.count == 0)
+        {
+            return;
+        }
 
-    void TagSystem::handleDestroyed(const Entity* destroyed, size_t destroyedLen)
+        //Sort the batch once and merge it into each list, rather than
+        //inserting every entity in place
+        FrameVector<Entity> sorted;
+        sorted.assign(entities, entities + count);
+        eastl::sort(sorted.begin(), sorted.end(), entityLess);
+
+        for (uint32_t t = 0; t < tmpl.count; t++)
+        {
+            uint32_t tag;
+            memcpy(&tag, tmpl.tags + t * sizeof(tag), sizeof(tag));
+            mergeSorted(_index[tag], sorted.data(), count);
+        }
+    }
+
+
+
+    void TagSystem::handleDestroyed(const Entity* destroyed, size_t destroyedLen, DestroyBatch& batch)
     {
-        for (size_t i = 0; i < destroyedLen; i++)
+        collectDestroyed(_map, destroyed, destroyedLen, batch);
+
+        //Gather the tagged entities and the tags they had, then filter each
+        //touched list once instead of erasing the entities one at a time
+        FrameVector<Entity> tagged;
+        FrameVector<uint32_t> touched;
+        for (uint32_t index : batch.indices)
+        {
+            EInstance ei(index);
+            uint32_t len = getLength(ei);
+            if (len > 0)
+            {
+                uint32_t* tags = getTags(ei);
+                tagged.push_back(getEntity(ei));
+                touched.insert(touched.end(), tags, tags + len);
+            }
+            _buddy.free(getPointer(ei), sizeof(uint32_t) * (2 + getCapacity(ei)));
+        }
+
+        if (!touched.empty())
+        {
+            eastl::sort(tagged.begin(), tagged.end(), entityLess);
+            eastl::sort(touched.begin(), touched.end());
+            touched.erase(eastl::unique(touched.begin(), touched.end()), touched.end());
+
+            InSortedBatch dead = { tagged.data(), tagged.data() + tagged.size() };
+            for (uint32_t tag : touched)
+            {
+                //Empty lists are kept, tags tend to come back
+                eastl::vector<Entity>& list = _index[tag];
+                list.erase(eastl::remove_if(list.begin(), list.end(), dead), list.end());
+            }
+        }
+
+        uint32_t size = _data.getSize();
+        for (uint32_t index : batch.indices)
         {
-            auto result = _map.find(destroyed[i]);
-            if (result != _map.end())
+            uint32_t last = --size;
+            if (index != last)
             {
-                destroy(result->first);
+                moveInstance(EInstance(index), EInstance(last));
+                batch.moved.push_back(index);
             }
         }
+        _data.setSize(size);
+
+        fixupEntityMap(_map, _data.entities, size, batch);
+    }
+
+    void TagSystem::getMemoryStats(SystemMemoryStats& stats) const
+    {
+        addStorageStats(stats, _data);
+        addMapStats(stats, _map);
+
+        //Tag lists live in the buddy allocator, rounded up to its block sizes
+        memory::BuddyStats buddy = _buddy.getStats();
+        stats.otherUsedBytes += buddy.usedBytes;
+        stats.otherReservedBytes += buddy.capacity;
+
+        //Tag index, a map of its own plus a list per tag
+        SystemMemoryStats index = {};
+        addMapStats(index, _index);
+        stats.otherUsedBytes += index.mapNodeBytes;
+        stats.otherReservedBytes += index.mapBucketBytes + index.mapNodeBytes;
+        for (const auto& entry : _index)
+        {
+            addVectorStats(stats, entry.second);
+        }
     }
 
 
@@ -144,6 +308,8 @@ namespace scene
         //Add tag
         tags[len] = tag;
         getLength(ei)++;
+
+        indexAdd(tag, getEntity(ei));
     }
 
     void TagSystem::removeTag(EInstance ei, uint32_t tag)
@@ -151,7 +317,6 @@ namespace scene
         uint32_t len = getLength(ei);
         uint32_t* tags = getTags(ei);
 
-        //Don't add it if it already exists
         for (uint32_t i = 0; i < len; i++)
         {
             if (tags[i] == tag)
@@ -159,6 +324,9 @@ namespace scene
                 //Swap and pop the last element
                 tags[i] = tags[len - 1];
                 getLength(ei)--;
+
+                indexRemove(tag, getEntity(ei));
+                return;
             }
         }
     }
@@ -178,8 +346,90 @@ namespace scene
         return false;
     }
 
+    const eastl::vector<Entity>& TagSystem::query(uint32_t tag) const
+    {
+        static const eastl::vector<Entity> empty;
+
+        auto it = _index.find(tag);
+        return (it != _index.end()) ? it->second : empty;
+    }
+
+    void TagSystem::queryAll(const uint32_t* tags, uint32_t tagCount, FrameVector<Entity>& out) const
+    {
+        out.clear();
+        if (tagCount == 0) { return; }
+
+        //Walk the shortest list and binary search the others
+        const eastl::vector<Entity>* shortest = &query(tags[0]);
+        for (uint32_t t = 1; t < tagCount; t++)
+        {
+            const eastl::vector<Entity>& list = query(tags[t]);
+            if (list.size() < shortest->size()) { shortest = &list; }
+        }
+
+        for (Entity e : *shortest)
+        {
+            bool inAll = true;
+            for (uint32_t t = 0; t < tagCount && inAll; t++)
+            {
+                const eastl::vector<Entity>& list = query(tags[t]);
+                if (&list == shortest) { continue; }
+                inAll = eastl::binary_search(list.begin(), list.end(), e, entityLess);
+            }
+
+            if (inAll) { out.push_back(e); }
+        }
+    }
+
     void TagSystem::moveInstance(EInstance dst, EInstance src)
     {
         _data.move(dst.index, src.index);
     }
+
+    void TagSystem::indexAdd(uint32_t tag, Entity e)
+    {
+        eastl::vector<Entity>& list = _index[tag];
+        list.insert(eastl::lower_bound(list.begin(), list.end(), e, entityLess), e);
+    }
+
+    void TagSystem::indexRemove(uint32_t tag, Entity e)
+    {
+        //Empty lists are kept, tags tend to come back
+        eastl::vector<Entity>& list = _index[tag];
+        auto it = eastl::lower_bound(list.begin(), list.end(), e, entityLess);
+        NW_ASSERT(it != list.end() && *it == e);
+        list.erase(it);
+    }
+
+    void TagSystem::indexRemoveAll(EInstance ei)
+    {
+        Entity e = getEntity(ei);
+        uint32_t len = getLength(ei);
+        uint32_t* tags = getTags(ei);
+        for (uint32_t i = 0; i < len; i++)
+        {
+            indexRemove(tags[i], e);
+        }
+    }
+
+    void TagSystem::rebuildIndex()
+    {
+        _index.clear();
+
+        for (uint32_t i = 0; i < _data.getSize(); i++)
+        {
+            EInstance ei(i);
+            uint32_t len = getLength(ei);
+            uint32_t* tags = getTags(ei);
+            for (uint32_t t = 0; t < len; t++)
+            {
+                _index[tags[t]].push_back(getEntity(ei));
+            }
+        }
+
+        for (auto& entry : _index)
+        {
+            eastl::sort(entry.second.begin(), entry.second.end(), entityLess);
+        }
+    }
 }
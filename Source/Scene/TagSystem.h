@@ -5,10 +5,13 @@
 #include <EASTL/vector.h>
 #include "Core/BuddyAllocator.h"
 #include "Core/SoaVector.h"
+#include "Core/FrameArena.h"
 #include "Core/Features.h"
 #include "Util/Archives.h"
 #include "Entity.h"
 #include "EInstance.h"
+#include "EntityMap.h"
+#include "MemoryStats.h"
 
 namespace asset { class PackFile; class AssetManager; }
 using namespace asset;
@@ -20,15 +23,26 @@ namespace scene
     class TagSystem
     {
     private:
-        eastl::hash_map<Entity, EInstance> _map;
+        EntityInstanceMap _map;
         CLASS_SOA_VECTOR2(Storage,
             Entity, entities,
-            uint32_t, tagsOffset);   //Stored as byte offsets into the buddy allocator to reduce pointer patching
+            uint32_t, tagsOffset);   //Buddy allocator offsets, which stay valid as it grows
         Storage _data;
 
         BuddyAllocator _buddy;
 
+        //Tag -> every entity that has it, sorted by id so queries can intersect
+        //lists without hashing. Kept up to date by every add, remove and destroy.
+        eastl::hash_map<uint32_t, eastl::vector<Entity>> _index;
+
     public:
+        //Prefab tag component, compiled once when the scene is loaded
+        struct Template
+        {
+            const uint8_t* tags;    //Points into the scene's prefab data
+            uint32_t count;
+        };
+
         TagSystem();
         void init();
 
@@ -43,15 +57,26 @@ namespace scene
                 return;
             }
 
-            //If we're reading, then preallocate some space
-            if (ar.IsReading)
+            //Columns are stored exactly as they are laid out in memory, so a
+            //loaded scene image is used in place (and copied out on first grow)
+            ar.serializeAlign(Storage::imageAlignment());
+            void* image = ar.mapBytes(Storage::imageSize(length));
+            if (image != nullptr)
             {
-                _data.resize(length + 128);
-                _data.setSize(length);
+                _data.adopt(image, length);
             }
+            else
+            {
+                //Reads that can't map (rewinds) copy into the existing storage
+                if (ar.IsReading)
+                {
+                    if (_data.capacity() < length) { _data.resize(length); }
+                    _data.setSize(length);
+                }
 
-            //Serialize fields
-            AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.entities, length);
+                AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.entities, length);
+                ar.serializePadding(sizeof(_data.tagsOffset[0]) * length); //Allocated below
+            }
 
             //TODO: Come up with a faster way to save/load data in bulk?
             for (uint32_t i = 0; i < length; i++)
@@ -83,10 +108,8 @@ namespace scene
             //Add entities to map
             if (ar.IsReading)
             {
-                for (uint32_t i = 0; i < length; i++)
-                {
-                    _map[_data.entities[i]] = i;
-                }
+                populateEntityMap(_map, _data.entities, length);
+                rebuildIndex();
             }
         }
 
@@ -96,15 +119,21 @@ namespace scene
 
         bool exists(Entity e) { return _map.find(e) != _map.end(); }
         EInstance create(Entity e, uint32_t tagCount = 0);
+        void reserve(uint32_t count) { _data.reserve(_data.getSize() + count); }
         EInstance createOrGetInstance(Entity e)
         {
             if (exists(e)) { return getInstance(e); }
             else { return create(e); }
         }
         void destroy(Entity e);
+        void clear();
         const uint8_t* instantiate(Entity e, const uint8_t* data);
+        const uint8_t* compileTemplate(const uint8_t* data, Template& tmpl);
+        void createMany(const Entity* entities, uint32_t count, const Template& tmpl);
 
-        void handleDestroyed(const Entity* destroyed, size_t destroyedLen);
+        void handleDestroyed(const Entity* destroyed, size_t destroyedLen, DestroyBatch& batch);
+        void getMemoryStats(SystemMemoryStats& stats) const;
+        memory::BuddyStats getBuddyStats() const { return _buddy.getStats(); }
 
         EInstance getInstance(Entity e)
         {
@@ -116,6 +145,11 @@ namespace scene
         void removeTag(EInstance ei, uint32_t tag);
         bool hasTag(EInstance ei, uint32_t tag);
 
+        //Entities that have the tag, sorted by id
+        const eastl::vector<Entity>& query(uint32_t tag) const;
+        //Entities that have every one of the tags. The results are frame memory.
+        void queryAll(const uint32_t* tags, uint32_t tagCount, FrameVector<Entity>& out) const;
+
         uint32_t& getLength(EInstance ei) { return getPointer(ei)[0]; }
         uint32_t& getCapacity(EInstance ei) { return getPointer(ei)[1]; }
         uint32_t* getTags(EInstance ei) { return &getPointer(ei)[2]; }
@@ -123,16 +157,21 @@ namespace scene
     private:
         void moveInstance(EInstance dst, EInstance src);
 
+        void indexAdd(uint32_t tag, Entity e);
+        void indexRemove(uint32_t tag, Entity e);
+        void indexRemoveAll(EInstance ei);
+        void rebuildIndex();
+
         Entity getEntity(EInstance ei) { return _data.entities[ei.index]; }
 
         uint32_t* getPointer(EInstance ei)
         {
-            return (uint32_t*)((uintptr_t)_buddy.getBaseAddress() + _data.tagsOffset[ei.index]);
+            return (uint32_t*)_buddy.getPointer(_data.tagsOffset[ei.index]);
         }
 
         uint32_t getOffset(uint32_t* ptr)
         {
-            return (uint32_t)((uintptr_t)ptr - (uintptr_t)_buddy.getBaseAddress());
+            return _buddy.getOffset(ptr);
         }
     };
 }
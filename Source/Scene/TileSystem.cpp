@@ -15,15 +15,19 @@ namespace scene
     TileSystem::TileSystem() :
         _fgTiles(nullptr),
         _bgTiles(nullptr),
-        _collision(nullptr)
+        _collision(nullptr),
+        _ownsTiles(true)
     {
     }
 
     TileSystem::~TileSystem()
     {
-        free(_fgTiles);
-        free(_bgTiles);
-        free(_collision);
+        if (_ownsTiles)
+        {
+            free(_fgTiles);
+            free(_bgTiles);
+            free(_collision);
+        }
     }
 
     void TileSystem::prepare(asset::AssetManager& assetMan)
@@ -41,7 +45,7 @@ namespace scene
         }
     }
 
-#ifdef NW_ASSET_COOK
+#if defined(NW_ASSET_COOK) || defined(NW_BENCHMARKS)
     void TileSystem::setTileMap(AssetRef ref)
     {
         _tileMapAsset = ref;
@@ -72,17 +76,22 @@ namespace scene
     }
 #endif
 
-    void TileSystem::render(Renderer2d& renderer, const IntRect& view)
+    void TileSystem::buildBatches(const IntRect& view)
     {
-        SCOPED_CPU_EVENT(event)(PROF_COLOR_GRAPHICS, "TileSystem::render");
-        renderLayer(renderer, _vertexBuffers[0], view, _fgTiles, FOREGROUND_DEPTH);
-        renderLayer(renderer, _vertexBuffers[1], view, _bgTiles, BACKGROUND_DEPTH);
+        SCOPED_CPU_EVENT(event)(PROF_COLOR_GRAPHICS, "TileSystem::buildBatches");
+        buildLayer(_batchers[0], view, _fgTiles, FOREGROUND_DEPTH);
+        buildLayer(_batchers[1], view, _bgTiles, BACKGROUND_DEPTH);
     }
 
-    void TileSystem::renderLayer(Renderer2d& renderer, bgfx::DynamicVertexBufferHandle vertexBuffer, const IntRect& view, uint16_t* layer, uint8_t depth)
+    void TileSystem::submitBatches(Renderer2d& renderer)
     {
-        SCOPED_CPU_EVENT(event)(PROF_COLOR_GRAPHICS, "TileSystem::renderLayer");
+        SCOPED_CPU_EVENT(event)(PROF_COLOR_GRAPHICS, "TileSystem::submitBatches");
+        renderer.submitSpriteBatch(_batchers[0], _vertexBuffers[0]);
+        renderer.submitSpriteBatch(_batchers[1], _vertexBuffers[1]);
+    }
 
+    void TileSystem::buildLayer(SpriteBatcher& batcher, const IntRect& view, const uint16_t* layer, uint8_t depth)
+    {
         const bgfx::TextureInfo& info = getTextureInfo(_tileMap);
         uint32_t tileMapWidth = info.width / TILE_SIZE;
         uint32_t x1 = max(view.left / TILE_SIZE, 0);
@@ -90,25 +99,7 @@ namespace scene
         uint32_t y1 = max(view.top / TILE_SIZE, 0);
         uint32_t y2 = min((view.top + view.height) / TILE_SIZE + 1, _height);
 
-#if 0
-        for (uint32_t y = y1; y < y2; y++)
-        {
-            for (uint32_t x = x1; x < x2; x++)
-            {
-                uint16_t tile = layer[x + y * _width];
-                if (tile > 0)
-                {
-                    tile--;
-                    renderer.submitSprite(
-                        Vector2i(x * TILE_SIZE + TILE_SIZE / 2, y * TILE_SIZE + TILE_SIZE / 2),
-                        Vector2i(TILE_SIZE, TILE_SIZE), depth, 255, _tileMap,
-                        Vector2i((tile % tileMapWidth) * TILE_SIZE, (tile / tileMapWidth) * TILE_SIZE),
-                        Vector2i(1, 1), 0);
-                }
-            }
-        }
-#else
-        SpriteBatcher batcher;
+        batcher.reset();
         batcher.reserveVertices((x2 - x1 + 1) * (y2 - y1 + 1));
         batcher.setDepth(depth);
         batcher.setTexture(_tileMap);
@@ -128,9 +119,6 @@ namespace scene
                 }
             }
         }
-
-        renderer.submitSpriteBatch(batcher, vertexBuffer);
-#endif
     }
 
     Vector2i TileSystem::getSize() const
@@ -146,6 +134,8 @@ namespace scene
 
     bool TileSystem::isFree(IntRect rect) const
     {
+        COUNT_WORK(TileIsFreeCalls, 1);
+
         //Check tiles
         int x1 = rect.left / TILE_SIZE;
         int y1 = rect.top / TILE_SIZE;
@@ -166,6 +156,22 @@ namespace scene
         return true;
     }
 
+    void TileSystem::getMemoryStats(SystemMemoryStats& stats) const
+    {
+        //Foreground, background and collision layers. Tiles aren't instances,
+        //so size and capacity stay 0 and the scene reports the tile count.
+        size_t layerBytes = (size_t)_width * _height * (sizeof(uint16_t) * 2 + sizeof(uint8_t));
+        stats.inImage = !_ownsTiles;
+        stats.otherUsedBytes = layerBytes;
+        stats.otherReservedBytes = layerBytes;
+
+        for (const SpriteBatcher& batcher : _batchers)
+        {
+            stats.otherUsedBytes += batcher.getVertexCount() * sizeof(SpriteVertex);
+            stats.otherReservedBytes += batcher.getVertexCapacity() * sizeof(SpriteVertex);
+        }
+    }
+
     bool TileSystem::intersects(int tileX, int tileY, IntRect other) const
     {
         IntRect self(tileX * TILE_SIZE, tileY * TILE_SIZE, TILE_SIZE, TILE_SIZE);
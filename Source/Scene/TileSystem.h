@@ -8,8 +8,8 @@
 #include "../Tile/Tile.h"
 #include "../Math/Vector2i.h"
 #include "../Math/IntRect.h"
-
-namespace render { class Renderer2d; }
+#include "../Render/Renderer2d.h"
+#include "MemoryStats.h"
 using namespace math;
 using namespace tile;
 using namespace render;
@@ -22,12 +22,14 @@ namespace scene
         uint16_t* _fgTiles; //Foreground (used for collision data)
         uint16_t* _bgTiles; //Background
         uint8_t* _collision;
+        bool _ownsTiles;    //False when the layers point into the scene image
         uint32_t _width;
         uint32_t _height;
 
         asset::AssetRef _tileMapAsset;
         bgfx::TextureHandle _tileMap;
         bgfx::DynamicVertexBufferHandle _vertexBuffers[2];
+        SpriteBatcher _batchers[2];     //Foreground and background, filled by buildBatches()
 
     public:
         TileSystem();
@@ -43,21 +45,27 @@ namespace scene
             ar.serializeU32(_width);
             ar.serializeU32(_height);
 
-            //Allocate space if needed and read tiles
+            //Tiles are never modified at runtime, so a loaded scene image is used in place
             uint32_t size = _width * _height;
+            ar.serializeAlign(alignof(uint16_t));
             if (ar.IsReading)
             {
-                _fgTiles = (uint16_t*)malloc(sizeof(uint16_t) * size);
-                _bgTiles = (uint16_t*)malloc(sizeof(uint16_t) * size);
-                _collision = (uint8_t*)malloc(sizeof(uint8_t) * size);
+                _fgTiles = (uint16_t*)ar.mapBytes(sizeof(uint16_t) * size);
+                _bgTiles = (uint16_t*)ar.mapBytes(sizeof(uint16_t) * size);
+                _collision = (uint8_t*)ar.mapBytes(sizeof(uint8_t) * size);
+                _ownsTiles = false;
+            }
+            else
+            {
+                AR_SERIALIZE_ARRAY_U16(ar, _fgTiles, size);
+                AR_SERIALIZE_ARRAY_U16(ar, _bgTiles, size);
+                AR_SERIALIZE_ARRAY_U8(ar, _collision, size);
             }
-            AR_SERIALIZE_ARRAY_U16(ar, _fgTiles, size);
-            AR_SERIALIZE_ARRAY_U16(ar, _bgTiles, size);
-            AR_SERIALIZE_ARRAY_U8(ar, _collision, size);
         }
 
         void prepare(asset::AssetManager& assetMan);
-#ifdef NW_ASSET_COOK
+        //Also used by the benchmarks to generate tile maps
+#if defined(NW_ASSET_COOK) || defined(NW_BENCHMARKS)
         void setTileMap(asset::AssetRef ref);
         void setSize(uint32_t width, uint32_t height);
         void setForegroundTile(uint32_t x, uint32_t y, uint16_t tile);
@@ -65,13 +73,17 @@ namespace scene
         void setCollision(uint32_t x, uint32_t y, uint8_t collision);
 #endif
 
-        void render(Renderer2d& renderer, const IntRect& view);
+        //Building the batches only reads the tiles so it can run on any thread.
+        //Submitting them has to happen on the render thread.
+        void buildBatches(const IntRect& view);
+        void submitBatches(Renderer2d& renderer);
 
         Vector2i getSize() const;
         TileCollision getCollision(uint32_t x, uint32_t y) const;
         bool isFree(IntRect rect) const;
+        void getMemoryStats(SystemMemoryStats& stats) const;
     private:
-        void renderLayer(Renderer2d& renderer, bgfx::DynamicVertexBufferHandle vertexBuffer, const IntRect& view, uint16_t* layer, uint8_t depth);
+        void buildLayer(SpriteBatcher& batcher, const IntRect& view, const uint16_t* layer, uint8_t depth);
         bool intersects(int tileX, int tileY, IntRect other) const;
         bool pointBelowLine(Vector2i point, Vector2i linePoint, float slope) const;
     };
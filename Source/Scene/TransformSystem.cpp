@@ -7,7 +7,7 @@ using namespace asset;
 
 namespace scene
 {
-    TransformSystem::TransformSystem()
+    TransformSystem::TransformSystem() : _version(0)
     {
     }
 
@@ -71,6 +71,14 @@ namespace scene
         //Update the keys in the map
         _map[lastEntity] = ei;
         _map.erase(e);
+        _version++;
+    }
+
+    void TransformSystem::clear()
+    {
+        _map.clear();
+        _data.setSize(0);
+        _version++;
     }
 
     void TransformSystem::removeChild(EInstance ei)
@@ -102,6 +110,24 @@ namespace scene
         return data;
     }
 
+    void TransformSystem::createMany(const Entity* entities, uint32_t count, const Vector2i* positions)
+    {
+        EInstance none;
+        HierarchyData hierData = { none, none, none, none };
+
+        uint32_t first = _data.getSize();
+        _data.reserve(first + count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            //Without a parent the world position is the local one
+            Vector2i pos = (positions != nullptr) ? positions[i] : Vector2i(0, 0);
+            TransformData trData = { pos, pos };
+            _data.push(entities[i], trData, hierData);
+        }
+
+        populateEntityMap(_map, _data.entities, count, first);
+    }
+
     void TransformSystem::moveInstance(EInstance dst, EInstance src)
     {
         uint32_t srcIdx = src.index;
@@ -131,40 +157,73 @@ namespace scene
             {
                 _data.hierData[nextSib.index].prevSib = dst;
             }
+            //Update the children to point to their new parent
+            EInstance child = _data.hierData[srcIdx].firstChild;
+            while (child.isValid())
+            {
+                _data.hierData[child.index].parent = dst;
+                child = _data.hierData[child.index].nextSib;
+            }
         }
     }
 
-    void TransformSystem::handleDestroyed(EntityManager& entityManager)
+    void TransformSystem::expandDestroyed(EntityManager& entityManager)
     {
-        auto& entities = entityManager.pollDestroyed();
-
-        //Save the length; if we destroy something with children, we dump the
-        //children on the end of the list. We don't want to process them twice.
-        //TODO: This totally falls apart if we delete everything manually
-        size_t length = entities.size();
-        for (size_t i = 0; i < length; i++)
+        //Children are appended to the list being walked, so grandchildren are
+        //reached without recursing. The list is indexed since it may grow.
+        auto& destroyed = entityManager.pollDestroyed();
+        for (size_t i = 0; i < destroyed.size(); i++)
         {
-            auto result = _map.find(entities[i]);
-            if (result != _map.end())
+            auto result = _map.find(destroyed[i]);
+            if (result == _map.end())
             {
-                //Dump children on the destroyed list
-                handleDestroyedChildren(entityManager, result->second.index);
+                continue;
+            }
 
-                destroy(result->first);
+            EInstance child = _data.hierData[result->second.index].firstChild;
+            while (child.isValid())
+            {
+                //Children that were destroyed directly are already on the list
+                Entity childEntity = getEntity(child);
+                if (entityManager.alive(childEntity))
+                {
+                    entityManager.destroy(childEntity);
+                }
+                child = _data.hierData[child.index].nextSib;
             }
         }
     }
 
-    void TransformSystem::handleDestroyedChildren(EntityManager& entityManager, EInstance ei)
+    void TransformSystem::handleDestroyed(const Entity* destroyed, size_t destroyedLen, DestroyBatch& batch)
     {
-        EInstance child = _data.hierData[ei.index].firstChild;
-        while (child.isValid())
+        collectDestroyed(_map, destroyed, destroyedLen, batch);
+
+        //Unlink everything first so survivors only point at survivors while compacting
+        for (uint32_t index : batch.indices)
+        {
+            removeChild(EInstance(index));
+        }
+
+        uint32_t size = _data.getSize();
+        for (uint32_t index : batch.indices)
         {
-            EInstance next = _data.hierData[child.index].nextSib;
-            handleDestroyedChildren(entityManager, child);
-            entityManager.destroy(getEntity(child));
-            child = next;
+            uint32_t last = --size;
+            if (index != last)
+            {
+                moveInstance(EInstance(index), EInstance(last));
+                batch.moved.push_back(index);
+            }
         }
+        _data.setSize(size);
+
+        fixupEntityMap(_map, _data.entities, size, batch);
+        _version++;
+    }
+
+    void TransformSystem::getMemoryStats(SystemMemoryStats& stats) const
+    {
+        addStorageStats(stats, _data);
+        addMapStats(stats, _map);
     }
 
     void TransformSystem::setLocalPos(EInstance ei, const Vector2i& localPos)
@@ -8,6 +8,8 @@
 #include "Util/Archives.h"
 #include "Entity.h"
 #include "EInstance.h"
+#include "EntityMap.h"
+#include "MemoryStats.h"
 
 namespace asset { class PackFile; }
 using namespace asset;
@@ -21,13 +23,14 @@ namespace scene
     class TransformSystem
     {
     private:
-        eastl::hash_map<Entity, EInstance> _map;
+        EntityInstanceMap _map;
 
         struct TransformData
         {
             Vector2i localPos;
             Vector2i worldPos;
 
+            AR_BULK_SERIALIZABLE(16);
             template <typename Archive>
             void serialize(Archive& ar)
             {
@@ -43,6 +46,7 @@ namespace scene
             EInstance nextSib;
             EInstance prevSib;
 
+            AR_BULK_SERIALIZABLE(16);
             template <typename Archive>
             void serialize(Archive& ar)
             {
@@ -59,6 +63,8 @@ namespace scene
             HierarchyData, hierData);
         Storage _data;
 
+        uint32_t _version;
+
     public:
         TransformSystem();
 
@@ -73,45 +79,65 @@ namespace scene
                 return;
             }
 
-            //If we're reading, then preallocate some space
-            if (ar.IsReading)
+            //Columns are stored exactly as they are laid out in memory, so a
+            //loaded scene image is used in place (and copied out on first grow)
+            ar.serializeAlign(Storage::imageAlignment());
+            void* image = ar.mapBytes(Storage::imageSize(length));
+            if (image != nullptr)
             {
-                _data.resize(length + 128);
-                _data.setSize(length);
+                _data.adopt(image, length);
             }
+            else
+            {
+                //Reads that can't map (rewinds) copy into the existing storage
+                if (ar.IsReading)
+                {
+                    if (_data.capacity() < length) { _data.resize(length); }
+                    _data.setSize(length);
+                }
 
-            //Serialize fields
-            AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.entities, length);
-            AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.trData, length);
-            AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.hierData, length);
+                AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.entities, length);
+                AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.trData, length);
+                AR_SERIALIZE_ARRAY_CUSTOM(ar, _data.hierData, length);
+            }
 
             //Add entities to map
             if (ar.IsReading)
             {
-                for (uint32_t i = 0; i < length; i++)
-                {
-                    _map[_data.entities[i]] = i;
-                }
+                populateEntityMap(_map, _data.entities, length);
+                _version++;
             }
         }
 
         inline bool exists(Entity e) { return _map.find(e) != _map.end(); }
         EInstance create(Entity e);
+        //Makes room for count more components, so a batch of creates grows the storage once
+        void reserve(uint32_t count) { _data.reserve(_data.getSize() + count); }
         inline EInstance createOrGetInstance(Entity e)
         {
             if (exists(e)) { return getInstance(e); }
             else { return create(e); }
         }
         void destroy(Entity e);
+        //Removes every component, used before restoring a rewound state
+        void clear();
         const uint8_t* instantiate(Entity e, const uint8_t* data);
+        //Creates unparented transforms at the given positions (or the origin if null)
+        void createMany(const Entity* entities, uint32_t count, const Vector2i* positions);
+
+        //Destroys the children of every destroyed entity, all the way down
+        void expandDestroyed(EntityManager& entityManager);
+        void handleDestroyed(const Entity* destroyed, size_t destroyedLen, DestroyBatch& batch);
+        void getMemoryStats(SystemMemoryStats& stats) const;
 
-        void handleDestroyed(EntityManager& entityManager);
-        void handleDestroyedChildren(EntityManager& entityManager, EInstance ei);
+        //Changes whenever instances move or are removed, creates leave it alone
+        uint32_t getVersion() const { return _version; }
 
+        //Only reads the map, so jobs can look up transforms concurrently
         inline EInstance getInstance(Entity e)
         {
             NW_ASSERT(exists(e));
-            return _map[e];
+            return _map.find(e)->second;
         }
         inline Entity getEntity(EInstance ei) { return _data.entities[ei.index]; }
         inline Vector2i getLocalPos(EInstance ei) { return _data.trData[ei.index].localPos; }
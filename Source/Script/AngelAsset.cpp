@@ -15,7 +15,7 @@ namespace script
 
     void angelAsset_RegisterTypes(asIScriptEngine* engine, AssetManager** assetManager)
     {
-        AS_VERIFY(engine->RegisterObjectType("AssetRef", sizeof(AssetRef), asOBJ_VALUE | asOBJ_POD | asGetTypeTraits<AssetRef>()));
+        AS_VERIFY(engine->RegisterObjectType("AssetRef", sizeof(AssetRef), asOBJ_VALUE | asOBJ_POD | asOBJ_APP_CLASS_ALLINTS | asGetTypeTraits<AssetRef>()));
         //HACK: This shouldn't be needed eventually
         AS_VERIFY(engine->RegisterObjectBehaviour("AssetRef", asBEHAVE_CONSTRUCT, "void f(uint id)", asFUNCTION(angelAsset_AssetRef_Construct), asCALL_CDECL_OBJFIRST));
 
@@ -0,0 +1,100 @@
+#ifndef SCRIPT_ANGEL_COMPONENT_REF_H
+#define SCRIPT_ANGEL_COMPONENT_REF_H
+
+#include <angelscript.h>
+#include "AngelState.h"
+#include "Scene/Entity.h"
+#include "Scene/EInstance.h"
+#include "Scene/EntityManager.h"
+#include "Scene/CommandBuffer.h"
+
+namespace script
+{
+    //Scripts record component creation and destruction into the command
+    //buffer, so the component bindings all answer for the state after the
+    //next sync point: exists() is true for a component created this batch
+    //and false for one destroyed this batch. Writes to a component created
+    //this batch are recorded too. Reads need a component that has been
+    //played back, and raise an exception for one that is still pending.
+    enum class ComponentAccess : uint8_t
+    {
+        Missing,    //Doesn't exist after the next sync point
+        Recorded,   //Created this batch, writes go to the command buffer
+        Direct      //Exists now and stays, reads and writes go to the system
+    };
+
+    template <typename System>
+    ComponentAccess getComponentAccess(System* system, scene::ComponentType type, scene::Entity en)
+    {
+        switch (AngelState::getCurrent()->getCommandBuffer()->getPending(type, en))
+        {
+        case scene::CommandBuffer::Pending::Created:
+            return ComponentAccess::Recorded;
+        case scene::CommandBuffer::Pending::Destroyed:
+            return ComponentAccess::Missing;
+        default:
+            return system->exists(en) ? ComponentAccess::Direct : ComponentAccess::Missing;
+        }
+    }
+
+    //Script handle to an entity's component (MovementRef, TransformRef).
+    //Caches the instance so repeated calls skip the entity -> instance hash
+    //lookup. The instance is only looked up again once the system's version
+    //changes, which happens whenever its instances move or are removed.
+    struct ComponentRef
+    {
+        scene::Entity entity;
+        scene::EInstance ei;
+        uint32_t version;
+    };
+
+    inline void angelComponentRef_DefaultConstruct(ComponentRef* ref)
+    {
+        new (ref) ComponentRef();
+        ref->version = UINT32_MAX;
+    }
+
+    //Makes sure the cached instance is current. Sets a script exception and
+    //returns false if the entity or its component is gone, or the component
+    //is destroyed (or replaced) at the next sync point.
+    template <typename System>
+    bool resolveComponentRef(System* system, scene::ComponentType type, ComponentRef* ref, const char* missingMessage)
+    {
+        if (!AngelState::getCurrent()->getEntityManager()->alive(ref->entity))
+        {
+            asGetActiveContext()->SetException("Entity is not alive.");
+            return false;
+        }
+
+        if (AngelState::getCurrent()->getCommandBuffer()->getPending(type, ref->entity) != scene::CommandBuffer::Pending::None)
+        {
+            asGetActiveContext()->SetException(missingMessage);
+            return false;
+        }
+
+        if (ref->version != system->getVersion())
+        {
+            if (!system->exists(ref->entity))
+            {
+                asGetActiveContext()->SetException(missingMessage);
+                return false;
+            }
+            ref->ei = system->getInstance(ref->entity);
+            ref->version = system->getVersion();
+        }
+
+        return true;
+    }
+
+    template <typename System>
+    ComponentRef makeComponentRef(System* system, scene::Entity en)
+    {
+        ComponentRef ref;
+        ref.entity = en;
+        ref.ei = system->getInstance(en);
+        ref.version = system->getVersion();
+        return ref;
+    }
+}
+
+#endif
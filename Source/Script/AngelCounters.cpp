@@ -0,0 +1,47 @@
+#include "Core/Core.h"
+#include <angelscript.h>
+#include "AngelState.h"
+
+using namespace counters;
+
+namespace script
+{
+#ifdef NW_PROFILE
+    //Counters are looked up by index so a debug overlay can list them all
+    //without knowing the names up front
+    uint32_t angelCounters_getCount()
+    {
+        return COUNTER_COUNT;
+    }
+
+    std::string angelCounters_getName(uint32_t index)
+    {
+        if (index >= COUNTER_COUNT) { return std::string(); }
+        return getCounterName((Counter)index);
+    }
+
+    uint64_t angelCounters_getLastFrame(uint32_t index)
+    {
+        return (index < COUNTER_COUNT) ? getCounterStats((Counter)index).lastFrame : 0;
+    }
+
+    float angelCounters_getAverage(uint32_t index)
+    {
+        return (index < COUNTER_COUNT) ? getCounterStats((Counter)index).avg : 0.0f;
+    }
+
+    uint64_t angelCounters_getMax(uint32_t index)
+    {
+        return (index < COUNTER_COUNT) ? getCounterStats((Counter)index).max : 0;
+    }
+
+    void angelCounters_RegisterTypes(asIScriptEngine* engine)
+    {
+        AS_VERIFY(engine->RegisterGlobalFunction("uint getCounterCount()", asFUNCTION(angelCounters_getCount), asCALL_CDECL));
+        AS_VERIFY(engine->RegisterGlobalFunction("string getCounterName(uint)", asFUNCTION(angelCounters_getName), asCALL_CDECL));
+        AS_VERIFY(engine->RegisterGlobalFunction("uint64 getCounterLastFrame(uint)", asFUNCTION(angelCounters_getLastFrame), asCALL_CDECL));
+        AS_VERIFY(engine->RegisterGlobalFunction("float getCounterAverage(uint)", asFUNCTION(angelCounters_getAverage), asCALL_CDECL));
+        AS_VERIFY(engine->RegisterGlobalFunction("uint64 getCounterMax(uint)", asFUNCTION(angelCounters_getMax), asCALL_CDECL));
+    }
+#endif
+}
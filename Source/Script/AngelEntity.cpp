@@ -13,7 +13,7 @@ namespace script
         new (en) Entity();
     }
 
-    void angelEntity_Entity_Construct(Entity* en, uint32_t id)
+    void angelEntity_Entity_Construct(Entity* en, EntityId id)
     {
         new (en) Entity(id);
     }
@@ -31,8 +31,13 @@ namespace script
 
     void angelEntity_RegisterTypes(asIScriptEngine* engine, EntityManager** entityManager)
     {
-        AS_VERIFY(engine->RegisterObjectType("Entity", sizeof(Entity), asOBJ_VALUE | asOBJ_POD | asGetTypeTraits<Entity>()));
+        AS_VERIFY(engine->RegisterObjectType("Entity", sizeof(Entity), asOBJ_VALUE | asOBJ_POD | asOBJ_APP_CLASS_ALLINTS | asGetTypeTraits<Entity>()));
         AS_VERIFY(engine->RegisterObjectBehaviour("Entity", asBEHAVE_CONSTRUCT, "void f()", asFUNCTION(angelEntity_Entity_DefaultConstruct), asCALL_CDECL_OBJFIRST));
+#ifdef NW_ENTITY_64BIT
+        AS_VERIFY(engine->RegisterObjectBehaviour("Entity", asBEHAVE_CONSTRUCT, "void f(uint64 id)", asFUNCTION(angelEntity_Entity_Construct), asCALL_CDECL_OBJFIRST));
+#else
+        AS_VERIFY(engine->RegisterObjectBehaviour("Entity", asBEHAVE_CONSTRUCT, "void f(uint id)", asFUNCTION(angelEntity_Entity_Construct), asCALL_CDECL_OBJFIRST));
+#endif
         AS_VERIFY(engine->RegisterObjectMethod("Entity", "bool isValid()", asMETHOD(Entity, isValid), asCALL_THISCALL));
         AS_VERIFY(engine->RegisterObjectMethod("Entity", "bool opEquals(Entity other)", asMETHOD(Entity, operator==), asCALL_THISCALL));
 
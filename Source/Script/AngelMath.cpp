@@ -1,6 +1,6 @@
 #include "Core/Core.h"
 #include <angelscript.h>
-#include <scriptmath\scriptmath.h>
+#include <scriptmath/scriptmath.h>
 #include "AngelState.h"
 #include "../Math/Math.h"
 #include "../Math/Vector2f.h"
@@ -85,7 +85,8 @@ namespace script
         AS_VERIFY(engine->RegisterGlobalFunction("float floatMin(float, float)", asFUNCTIONPR(math::min, (float, float), float), asCALL_CDECL));
         AS_VERIFY(engine->RegisterGlobalFunction("float floatMax(float, float)", asFUNCTIONPR(math::max, (float, float), float), asCALL_CDECL));
 
-        AS_VERIFY(engine->RegisterObjectType("Vector2f", sizeof(Vector2f), asOBJ_VALUE | asOBJ_POD | asGetTypeTraits<Vector2f>()));
+        //The ALLINTS/ALLFLOATS flags tell AngelScript how GCC passes these by value on x64
+        AS_VERIFY(engine->RegisterObjectType("Vector2f", sizeof(Vector2f), asOBJ_VALUE | asOBJ_POD | asOBJ_APP_CLASS_ALLFLOATS | asGetTypeTraits<Vector2f>()));
         AS_VERIFY(engine->RegisterObjectProperty("Vector2f", "float x", asOFFSET(Vector2f, x)));
         AS_VERIFY(engine->RegisterObjectProperty("Vector2f", "float y", asOFFSET(Vector2f, y)));
         AS_VERIFY(engine->RegisterObjectBehaviour("Vector2f", asBEHAVE_CONSTRUCT, "void f()", asFUNCTION(angelMath_Vector2f_DefaultConstruct), asCALL_CDECL_OBJFIRST));
@@ -103,7 +104,7 @@ namespace script
         AS_VERIFY(engine->RegisterObjectMethod("Vector2f", "Vector2f opDiv(int divisor)", asMETHOD(Vector2f, operator/), asCALL_THISCALL));
 
 
-        AS_VERIFY(engine->RegisterObjectType("Vector2i", sizeof(Vector2i), asOBJ_VALUE | asOBJ_POD | asGetTypeTraits<Vector2i>()));
+        AS_VERIFY(engine->RegisterObjectType("Vector2i", sizeof(Vector2i), asOBJ_VALUE | asOBJ_POD | asOBJ_APP_CLASS_ALLINTS | asGetTypeTraits<Vector2i>()));
         AS_VERIFY(engine->RegisterObjectProperty("Vector2i", "int x", asOFFSET(Vector2i, x)));
         AS_VERIFY(engine->RegisterObjectProperty("Vector2i", "int y", asOFFSET(Vector2i, y)));
         AS_VERIFY(engine->RegisterObjectBehaviour("Vector2i", asBEHAVE_CONSTRUCT, "void f()", asFUNCTION(angelMath_Vector2i_DefaultConstruct), asCALL_CDECL_OBJFIRST));
@@ -121,7 +122,7 @@ namespace script
         AS_VERIFY(engine->RegisterObjectMethod("Vector2i", "Vector2i opDiv(int divisor)", asMETHOD(Vector2i, operator/), asCALL_THISCALL));
 
 
-        AS_VERIFY(engine->RegisterObjectType("IntRect", sizeof(IntRect), asOBJ_VALUE | asOBJ_POD | asGetTypeTraits<Vector2i>()));
+        AS_VERIFY(engine->RegisterObjectType("IntRect", sizeof(IntRect), asOBJ_VALUE | asOBJ_POD | asOBJ_APP_CLASS_ALLINTS | asGetTypeTraits<Vector2i>()));
         AS_VERIFY(engine->RegisterObjectProperty("IntRect", "int left", asOFFSET(IntRect, left)));
         AS_VERIFY(engine->RegisterObjectProperty("IntRect", "int top", asOFFSET(IntRect, top)));
         AS_VERIFY(engine->RegisterObjectProperty("IntRect", "int width", asOFFSET(IntRect, width)));
@@ -2,87 +2,103 @@
 #include <angelscript.h>
 #include "AngelState.h"
 #include "AngelMacros.h"
+#include "AngelComponentRef.h"
 #include "Scene/EntityManager.h"
 #include "Scene/MovementSystem.h"
+#include "Scene/CommandBuffer.h"
 
 using namespace scene;
 
 namespace script
 {
+    //State after the next sync point, see ComponentAccess
+    static ComponentAccess movementAccess(MovementSystem* moveSys, Entity en)
+    {
+        return getComponentAccess(moveSys, ComponentType::Movement, en);
+    }
+
     bool angelMovement_exists(MovementSystem* moveSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, false);
-        return moveSys->exists(en);
+        return movementAccess(moveSys, en) != ComponentAccess::Missing;
     }
 
     void angelMovement_create(MovementSystem* moveSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(!moveSys->exists(en), "Cannot create movement component; it already exists.");
-        moveSys->create(en);
+        SCRIPT_ASSERT(movementAccess(moveSys, en) == ComponentAccess::Missing, "Cannot create movement component; it already exists.");
+        AngelState::getCurrent()->getCommandBuffer()->create(ComponentType::Movement, en);
     }
 
     void angelMovement_destroy(MovementSystem* moveSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(moveSys->exists(en), "Cannot destroy non-existent movement component.");
-        moveSys->create(en);
+        SCRIPT_ASSERT(movementAccess(moveSys, en) != ComponentAccess::Missing, "Cannot destroy non-existent movement component.");
+        AngelState::getCurrent()->getCommandBuffer()->destroy(ComponentType::Movement, en);
     }
 
     Vector2i angelMovement_getSize(MovementSystem* moveSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, Vector2i());
-        SCRIPT_ASSERT_RETVAL(moveSys->exists(en), "Entity doesn't have movement component.", Vector2i());
+        SCRIPT_ASSERT_RETVAL(movementAccess(moveSys, en) == ComponentAccess::Direct, "Entity doesn't have movement component.", Vector2i());
         return moveSys->getSize(moveSys->getInstance(en));
     }
 
     Vector2i angelMovement_getOffset(MovementSystem* moveSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, Vector2i());
-        SCRIPT_ASSERT_RETVAL(moveSys->exists(en), "Entity doesn't have movement component.", Vector2i());
+        SCRIPT_ASSERT_RETVAL(movementAccess(moveSys, en) == ComponentAccess::Direct, "Entity doesn't have movement component.", Vector2i());
         return moveSys->getOffset(moveSys->getInstance(en));
     }
 
     Vector2f angelMovement_getVelocity(MovementSystem* moveSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, Vector2f());
-        SCRIPT_ASSERT_RETVAL(moveSys->exists(en), "Entity doesn't have movement component.", Vector2f());
+        SCRIPT_ASSERT_RETVAL(movementAccess(moveSys, en) == ComponentAccess::Direct, "Entity doesn't have movement component.", Vector2f());
         return moveSys->getVelocity(moveSys->getInstance(en));
     }
 
     bool angelMovement_getWorldCollision(MovementSystem* moveSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, false);
-        SCRIPT_ASSERT_RETVAL(moveSys->exists(en), "Entity doesn't have movement component.", false);
+        SCRIPT_ASSERT_RETVAL(movementAccess(moveSys, en) == ComponentAccess::Direct, "Entity doesn't have movement component.", false);
         return moveSys->getWorldCollision(moveSys->getInstance(en));
     }
 
     void angelMovement_setSize(MovementSystem* moveSys, Entity en, Vector2i size)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(moveSys->exists(en), "Entity doesn't have movement component.");
-        moveSys->setSize(moveSys->getInstance(en), size);
+        ComponentAccess access = movementAccess(moveSys, en);
+        SCRIPT_ASSERT(access != ComponentAccess::Missing, "Entity doesn't have movement component.");
+        if (access == ComponentAccess::Recorded) { AngelState::getCurrent()->getCommandBuffer()->set(CommandBuffer::Property::MovementSize, en, size); }
+        else { moveSys->setSize(moveSys->getInstance(en), size); }
     }
 
     void angelMovement_setOffset(MovementSystem* moveSys, Entity en, Vector2i offset)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(moveSys->exists(en), "Entity doesn't have movement component.");
-        moveSys->setOffset(moveSys->getInstance(en), offset);
+        ComponentAccess access = movementAccess(moveSys, en);
+        SCRIPT_ASSERT(access != ComponentAccess::Missing, "Entity doesn't have movement component.");
+        if (access == ComponentAccess::Recorded) { AngelState::getCurrent()->getCommandBuffer()->set(CommandBuffer::Property::MovementOffset, en, offset); }
+        else { moveSys->setOffset(moveSys->getInstance(en), offset); }
     }
 
     void angelMovement_setVelocity(MovementSystem* moveSys, Entity en, Vector2f velocity)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(moveSys->exists(en), "Entity doesn't have movement component.");
-        moveSys->setVelocity(moveSys->getInstance(en), velocity);
+        ComponentAccess access = movementAccess(moveSys, en);
+        SCRIPT_ASSERT(access != ComponentAccess::Missing, "Entity doesn't have movement component.");
+        if (access == ComponentAccess::Recorded) { AngelState::getCurrent()->getCommandBuffer()->set(CommandBuffer::Property::MovementVelocity, en, velocity); }
+        else { moveSys->setVelocity(moveSys->getInstance(en), velocity); }
     }
 
     void angelMovement_setWorldCollision(MovementSystem* moveSys, Entity en, bool worldColl)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(moveSys->exists(en), "Entity doesn't have movement component.");
-        moveSys->setWorldCollision(moveSys->getInstance(en), worldColl);
+        ComponentAccess access = movementAccess(moveSys, en);
+        SCRIPT_ASSERT(access != ComponentAccess::Missing, "Entity doesn't have movement component.");
+        if (access == ComponentAccess::Recorded) { AngelState::getCurrent()->getCommandBuffer()->set(CommandBuffer::Property::MovementWorldCollision, en, worldColl); }
+        else { moveSys->setWorldCollision(moveSys->getInstance(en), worldColl); }
     }
 
     bool angelMovement_intersectsWorld(MovementSystem* moveSys, Entity en)
@@ -104,9 +120,109 @@ namespace script
         *e2 = pair.e2;
     }
 
+    ComponentRef angelMovement_getRef(MovementSystem* moveSys, Entity en)
+    {
+        SCRIPT_ASSERT_ALIVE_RETVAL(en, ComponentRef());
+        SCRIPT_ASSERT_RETVAL(movementAccess(moveSys, en) == ComponentAccess::Direct, "Entity doesn't have movement component.", ComponentRef());
+        return makeComponentRef(moveSys, en);
+    }
+
+    //MovementRef methods. The component exists while the ref resolves, so
+    //writes go straight to the system instead of the command buffer.
+    static bool resolveMovementRef(ComponentRef* ref)
+    {
+        return resolveComponentRef(AngelState::getCurrent()->getMovementSystem(), ComponentType::Movement, ref, "Entity doesn't have movement component.");
+    }
+
+    Entity angelMovementRef_getEntity(ComponentRef* ref)
+    {
+        return ref->entity;
+    }
+
+    bool angelMovementRef_isValid(ComponentRef* ref)
+    {
+        MovementSystem* moveSys = AngelState::getCurrent()->getMovementSystem();
+        return AngelState::getCurrent()->getEntityManager()->alive(ref->entity) &&
+            movementAccess(moveSys, ref->entity) == ComponentAccess::Direct;
+    }
+
+    Vector2i angelMovementRef_getSize(ComponentRef* ref)
+    {
+        if (!resolveMovementRef(ref)) { return Vector2i(); }
+        return AngelState::getCurrent()->getMovementSystem()->getSize(ref->ei);
+    }
+
+    Vector2i angelMovementRef_getOffset(ComponentRef* ref)
+    {
+        if (!resolveMovementRef(ref)) { return Vector2i(); }
+        return AngelState::getCurrent()->getMovementSystem()->getOffset(ref->ei);
+    }
+
+    Vector2f angelMovementRef_getVelocity(ComponentRef* ref)
+    {
+        if (!resolveMovementRef(ref)) { return Vector2f(); }
+        return AngelState::getCurrent()->getMovementSystem()->getVelocity(ref->ei);
+    }
+
+    bool angelMovementRef_getWorldCollision(ComponentRef* ref)
+    {
+        if (!resolveMovementRef(ref)) { return false; }
+        return AngelState::getCurrent()->getMovementSystem()->getWorldCollision(ref->ei);
+    }
+
+    void angelMovementRef_getAll(ComponentRef* ref, Vector2i* size, Vector2i* offset, Vector2f* velocity, bool* worldColl)
+    {
+        if (!resolveMovementRef(ref)) { return; }
+        MovementSystem* moveSys = AngelState::getCurrent()->getMovementSystem();
+        *size = moveSys->getSize(ref->ei);
+        *offset = moveSys->getOffset(ref->ei);
+        *velocity = moveSys->getVelocity(ref->ei);
+        *worldColl = moveSys->getWorldCollision(ref->ei);
+    }
+
+    void angelMovementRef_setSize(ComponentRef* ref, Vector2i size)
+    {
+        if (!resolveMovementRef(ref)) { return; }
+        AngelState::getCurrent()->getMovementSystem()->setSize(ref->ei, size);
+    }
+
+    void angelMovementRef_setOffset(ComponentRef* ref, Vector2i offset)
+    {
+        if (!resolveMovementRef(ref)) { return; }
+        AngelState::getCurrent()->getMovementSystem()->setOffset(ref->ei, offset);
+    }
+
+    void angelMovementRef_setVelocity(ComponentRef* ref, Vector2f velocity)
+    {
+        if (!resolveMovementRef(ref)) { return; }
+        AngelState::getCurrent()->getMovementSystem()->setVelocity(ref->ei, velocity);
+    }
+
+    void angelMovementRef_setWorldCollision(ComponentRef* ref, bool worldColl)
+    {
+        //Moves the instance, so the ref looks it up again on its next use
+        if (!resolveMovementRef(ref)) { return; }
+        AngelState::getCurrent()->getMovementSystem()->setWorldCollision(ref->ei, worldColl);
+    }
+
     void angelMovement_RegisterTypes(asIScriptEngine* engine, scene::MovementSystem** moveSys)
     {
+        AS_VERIFY(engine->RegisterObjectType("MovementRef", sizeof(ComponentRef), asOBJ_VALUE | asOBJ_POD | asOBJ_APP_CLASS_ALLINTS | asGetTypeTraits<ComponentRef>()));
+        AS_VERIFY(engine->RegisterObjectBehaviour("MovementRef", asBEHAVE_CONSTRUCT, "void f()", asFUNCTION(angelComponentRef_DefaultConstruct), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("MovementRef", "Entity getEntity() const", asFUNCTION(angelMovementRef_getEntity), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("MovementRef", "bool isValid() const", asFUNCTION(angelMovementRef_isValid), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("MovementRef", "Vector2i getSize()", asFUNCTION(angelMovementRef_getSize), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("MovementRef", "Vector2i getOffset()", asFUNCTION(angelMovementRef_getOffset), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("MovementRef", "Vector2f getVelocity()", asFUNCTION(angelMovementRef_getVelocity), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("MovementRef", "bool getWorldCollision()", asFUNCTION(angelMovementRef_getWorldCollision), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("MovementRef", "void getAll(Vector2i &out size, Vector2i &out offset, Vector2f &out velocity, bool &out worldColl)", asFUNCTION(angelMovementRef_getAll), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("MovementRef", "void setSize(Vector2i)", asFUNCTION(angelMovementRef_setSize), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("MovementRef", "void setOffset(Vector2i)", asFUNCTION(angelMovementRef_setOffset), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("MovementRef", "void setVelocity(Vector2f)", asFUNCTION(angelMovementRef_setVelocity), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("MovementRef", "void setWorldCollision(bool)", asFUNCTION(angelMovementRef_setWorldCollision), asCALL_CDECL_OBJFIRST));
+
         AS_VERIFY(engine->RegisterObjectType("CMovementSystem", sizeof(MovementSystem), asOBJ_REF | asOBJ_NOCOUNT));
+        AS_VERIFY(engine->RegisterObjectMethod("CMovementSystem", "MovementRef getRef(Entity)", asFUNCTION(angelMovement_getRef), asCALL_CDECL_OBJFIRST));
         AS_VERIFY(engine->RegisterObjectMethod("CMovementSystem", "bool exists(Entity)", asFUNCTION(angelMovement_exists), asCALL_CDECL_OBJFIRST));
         AS_VERIFY(engine->RegisterObjectMethod("CMovementSystem", "void create(Entity)", asFUNCTION(angelMovement_create), asCALL_CDECL_OBJFIRST));
         AS_VERIFY(engine->RegisterObjectMethod("CMovementSystem", "void destroy(Entity)", asFUNCTION(angelMovement_destroy), asCALL_CDECL_OBJFIRST));
@@ -1,23 +1,85 @@
 #include "Core/Core.h"
 #include <angelscript.h>
 #include "AngelState.h"
+#include "AngelArray.h"
+#include "AngelMacros.h"
 #include "../Scene/Scene.h"
 
 using namespace scene;
 
 namespace script
 {
+    //The entities are alive right away, their components are created at the
+    //next sync point (see ComponentAccess)
     Entity angelScene_instantiate(Scene* scene, AssetRef prefabRef)
     {
-        return scene->instantiate(scene->getPrefab(prefabRef));
+        Scene::PrefabData prefab;
+        SCRIPT_ASSERT_RETVAL(scene->getPrefab(prefabRef, prefab), "Prefab is not in this scene.", Entity());
+        SCRIPT_ASSERT_RETVAL(prefab.templateIndex != UINT32_MAX, "Scene is not prepared.", Entity());
+
+        Entity e;
+        scene->recordInstantiate(*AngelState::getCurrent()->getCommandBuffer(), prefab, 1, nullptr, &e);
+        return e;
+    }
+
+    CScriptArray* angelScene_instantiateMany(Scene* scene, AssetRef prefabRef, const CScriptArray& positions)
+    {
+        Scene::PrefabData prefab;
+        SCRIPT_ASSERT_RETVAL(scene->getPrefab(prefabRef, prefab), "Prefab is not in this scene.", nullptr);
+        SCRIPT_ASSERT_RETVAL(prefab.templateIndex != UINT32_MAX, "Scene is not prepared.", nullptr);
+
+        //Both are arrays of POD value types, so their elements are contiguous
+        uint32_t count = positions.GetSize();
+        CScriptArray* entities = AngelState::getCurrent()->createEntityArray(nullptr, count);
+        if (count > 0)
+        {
+            scene->recordInstantiate(*AngelState::getCurrent()->getCommandBuffer(), prefab, count,
+                (const Vector2i*)positions.At(0), (Entity*)entities->At(0));
+        }
+        return entities;
+    }
+
+    //Systems are looked up by index like the counters, so a debug overlay can
+    //list them all. Every call gathers the stats again, which is cheap.
+    uint32_t angelScene_getMemorySystemCount(Scene* scene)
+    {
+        SceneMemoryStats stats;
+        scene->getMemoryStats(stats);
+        return stats.systemCount;
+    }
+
+    std::string angelScene_getMemorySystemName(Scene* scene, uint32_t index)
+    {
+        SceneMemoryStats stats;
+        scene->getMemoryStats(stats);
+        return (index < stats.systemCount) ? stats.systems[index].name : std::string();
+    }
+
+    uint64_t angelScene_getMemoryUsed(Scene* scene, uint32_t index)
+    {
+        SceneMemoryStats stats;
+        scene->getMemoryStats(stats);
+        return (index < stats.systemCount) ? stats.systems[index].getUsedBytes() : 0;
+    }
+
+    uint64_t angelScene_getMemoryReserved(Scene* scene, uint32_t index)
+    {
+        SceneMemoryStats stats;
+        scene->getMemoryStats(stats);
+        return (index < stats.systemCount) ? stats.systems[index].getReservedBytes() : 0;
     }
 
     void angelScene_RegisterTypes(asIScriptEngine* engine, Scene** scene)
     {
         AS_VERIFY(engine->RegisterObjectType("CScene", sizeof(Entity), asOBJ_REF | asOBJ_NOCOUNT));
         AS_VERIFY(engine->RegisterObjectMethod("CScene", "Entity instantiate(AssetRef)", asFUNCTION(angelScene_instantiate), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("CScene", "array<Entity>@ instantiateMany(AssetRef, const array<Vector2i>&in)", asFUNCTION(angelScene_instantiateMany), asCALL_CDECL_OBJFIRST));
         AS_VERIFY(engine->RegisterObjectMethod("CScene", "float getTime()", asMETHOD(Scene, getTime), asCALL_THISCALL));
         AS_VERIFY(engine->RegisterObjectMethod("CScene", "float getDeltaTime()", asMETHOD(Scene, getDeltaTime), asCALL_THISCALL));
+        AS_VERIFY(engine->RegisterObjectMethod("CScene", "uint getMemorySystemCount()", asFUNCTION(angelScene_getMemorySystemCount), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("CScene", "string getMemorySystemName(uint)", asFUNCTION(angelScene_getMemorySystemName), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("CScene", "uint64 getMemoryUsed(uint)", asFUNCTION(angelScene_getMemoryUsed), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("CScene", "uint64 getMemoryReserved(uint)", asFUNCTION(angelScene_getMemoryReserved), asCALL_CDECL_OBJFIRST));
         AS_VERIFY(engine->RegisterGlobalProperty("CScene@ Scene", scene));
     }
 }
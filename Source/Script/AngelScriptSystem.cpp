@@ -2,38 +2,47 @@
 #include <angelscript.h>
 #include "AngelState.h"
 #include "AngelMacros.h"
+#include "AngelComponentRef.h"
 #include "AngelHandle.h"
 #include "Scene/EntityManager.h"
 #include "Scene/ScriptSystem.h"
+#include "Scene/CommandBuffer.h"
 
 using namespace scene;
 
 namespace script
 {
+    static ComponentAccess scriptAccess(ScriptSystem* scriptSys, Entity en)
+    {
+        return getComponentAccess(scriptSys, ComponentType::Script, en);
+    }
+
     bool angelScript_exists(ScriptSystem* scriptSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, false);
-        return scriptSys->exists(en);
+        return scriptAccess(scriptSys, en) != ComponentAccess::Missing;
     }
 
     void angelScript_create(ScriptSystem* scriptSys, Entity en, const std::string& typeName)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(!scriptSys->exists(en), "Cannot create script component; it already exists.");
+        SCRIPT_ASSERT(scriptAccess(scriptSys, en) == ComponentAccess::Missing, "Cannot create script component; it already exists.");
         AngelType type(typeName.c_str());
         SCRIPT_ASSERT(AngelState::getCurrent()->getTypeIdFromAngelType(type) != -1, "Cannot create script; type doesn't exist.");
-        scriptSys->create(en, type);
+        AngelState::getCurrent()->getCommandBuffer()->createScript(en, type);
     }
 
     void angelScript_destroy(ScriptSystem* scriptSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(scriptSys->exists(en), "Cannot destroy non-existent script component.");
-        scriptSys->destroy(en);
+        SCRIPT_ASSERT(scriptAccess(scriptSys, en) != ComponentAccess::Missing, "Cannot destroy non-existent script component.");
+        AngelState::getCurrent()->getCommandBuffer()->destroy(ComponentType::Script, en);
     }
 
     CScriptHandle angelScript_getComponent(ScriptSystem* scriptSys, Entity en)
     {
+        SCRIPT_ASSERT_ALIVE_RETVAL(en, CScriptHandle());
+        SCRIPT_ASSERT_RETVAL(scriptAccess(scriptSys, en) == ComponentAccess::Direct, "Entity doesn't have script component.", CScriptHandle());
         EInstance ei = scriptSys->getInstance(en);
         asIScriptObject* obj = scriptSys->getObject(ei);
         CScriptHandle handle;
@@ -2,136 +2,161 @@
 #include <angelscript.h>
 #include "AngelState.h"
 #include "AngelMacros.h"
+#include "AngelComponentRef.h"
 #include "Scene/EntityManager.h"
 #include "Scene/SpriteSystem.h"
+#include "Scene/CommandBuffer.h"
 
 using namespace scene;
 
 namespace script
 {
+    static ComponentAccess spriteAccess(SpriteSystem* spriteSys, Entity en)
+    {
+        return getComponentAccess(spriteSys, ComponentType::Sprite, en);
+    }
+
     bool angelSprite_exists(SpriteSystem* spriteSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, false);
-        return spriteSys->exists(en);
+        return spriteAccess(spriteSys, en) != ComponentAccess::Missing;
     }
 
     void angelSprite_create(SpriteSystem* spriteSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(!spriteSys->exists(en), "Cannot create sprite component; it already exists.");
-        spriteSys->create(en);
+        SCRIPT_ASSERT(spriteAccess(spriteSys, en) == ComponentAccess::Missing, "Cannot create sprite component; it already exists.");
+        AngelState::getCurrent()->getCommandBuffer()->create(ComponentType::Sprite, en);
     }
 
     void angelSprite_destroy(SpriteSystem* spriteSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(spriteSys->exists(en), "Cannot destroy non-existent sprite component.");
-        spriteSys->create(en);
+        SCRIPT_ASSERT(spriteAccess(spriteSys, en) != ComponentAccess::Missing, "Cannot destroy non-existent sprite component.");
+        AngelState::getCurrent()->getCommandBuffer()->destroy(ComponentType::Sprite, en);
     }
 
     Vector2i angelSprite_getSize(SpriteSystem* spriteSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, Vector2i());
-        SCRIPT_ASSERT_RETVAL(spriteSys->exists(en), "Entity doesn't have sprite component.", Vector2i());
+        SCRIPT_ASSERT_RETVAL(spriteAccess(spriteSys, en) == ComponentAccess::Direct, "Entity doesn't have sprite component.", Vector2i());
         return spriteSys->getSize(spriteSys->getInstance(en));
     }
 
     Vector2i angelSprite_getOffset(SpriteSystem* spriteSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, Vector2i());
-        SCRIPT_ASSERT_RETVAL(spriteSys->exists(en), "Entity doesn't have sprite component.", Vector2i());
+        SCRIPT_ASSERT_RETVAL(spriteAccess(spriteSys, en) == ComponentAccess::Direct, "Entity doesn't have sprite component.", Vector2i());
         return spriteSys->getOffset(spriteSys->getInstance(en));
     }
 
     uint8_t angelSprite_getDepth(SpriteSystem* spriteSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, 0);
-        SCRIPT_ASSERT_RETVAL(spriteSys->exists(en), "Entity doesn't have sprite component.", 0);
+        SCRIPT_ASSERT_RETVAL(spriteAccess(spriteSys, en) == ComponentAccess::Direct, "Entity doesn't have sprite component.", 0);
         return spriteSys->getDepth(spriteSys->getInstance(en));
     }
 
     uint8_t angelSprite_getAlpha(SpriteSystem* spriteSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, 0);
-        SCRIPT_ASSERT_RETVAL(spriteSys->exists(en), "Entity doesn't have sprite component.", 0);
+        SCRIPT_ASSERT_RETVAL(spriteAccess(spriteSys, en) == ComponentAccess::Direct, "Entity doesn't have sprite component.", 0);
         return spriteSys->getAlpha(spriteSys->getInstance(en));
     }
 
     Vector2i angelSprite_getTexOffset(SpriteSystem* spriteSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, Vector2i());
-        SCRIPT_ASSERT_RETVAL(spriteSys->exists(en), "Entity doesn't have sprite component.", Vector2i());
+        SCRIPT_ASSERT_RETVAL(spriteAccess(spriteSys, en) == ComponentAccess::Direct, "Entity doesn't have sprite component.", Vector2i());
         return spriteSys->getTexOffset(spriteSys->getInstance(en));
     }
 
     asset::AssetRef angelSprite_getTexture(SpriteSystem* spriteSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, asset::AssetRef());
-        SCRIPT_ASSERT_RETVAL(spriteSys->exists(en), "Entity doesn't have sprite component.", asset::AssetRef());
+        SCRIPT_ASSERT_RETVAL(spriteAccess(spriteSys, en) == ComponentAccess::Direct, "Entity doesn't have sprite component.", asset::AssetRef());
         return spriteSys->getTextureRef(spriteSys->getInstance(en));
     }
 
     void angelSprite_setSize(SpriteSystem* spriteSys, Entity en, Vector2i size)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(spriteSys->exists(en), "Entity doesn't have sprite component.");
-        spriteSys->setSize(spriteSys->getInstance(en), size);
+        ComponentAccess access = spriteAccess(spriteSys, en);
+        SCRIPT_ASSERT(access != ComponentAccess::Missing, "Entity doesn't have sprite component.");
+        if (access == ComponentAccess::Recorded) { AngelState::getCurrent()->getCommandBuffer()->set(CommandBuffer::Property::SpriteSize, en, size); }
+        else { spriteSys->setSize(spriteSys->getInstance(en), size); }
     }
 
     void angelSprite_setOffset(SpriteSystem* spriteSys, Entity en, Vector2i offset)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(spriteSys->exists(en), "Entity doesn't have sprite component.");
-        spriteSys->setOffset(spriteSys->getInstance(en), offset);
+        ComponentAccess access = spriteAccess(spriteSys, en);
+        SCRIPT_ASSERT(access != ComponentAccess::Missing, "Entity doesn't have sprite component.");
+        if (access == ComponentAccess::Recorded) { AngelState::getCurrent()->getCommandBuffer()->set(CommandBuffer::Property::SpriteOffset, en, offset); }
+        else { spriteSys->setOffset(spriteSys->getInstance(en), offset); }
     }
 
     void angelSprite_setDepth(SpriteSystem* spriteSys, Entity en, uint8_t depth)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(spriteSys->exists(en), "Entity doesn't have sprite component.");
-        spriteSys->setDepth(spriteSys->getInstance(en), depth);
+        ComponentAccess access = spriteAccess(spriteSys, en);
+        SCRIPT_ASSERT(access != ComponentAccess::Missing, "Entity doesn't have sprite component.");
+        if (access == ComponentAccess::Recorded) { AngelState::getCurrent()->getCommandBuffer()->set(CommandBuffer::Property::SpriteDepth, en, depth); }
+        else { spriteSys->setDepth(spriteSys->getInstance(en), depth); }
     }
 
     void angelSprite_setAlpha(SpriteSystem* spriteSys, Entity en, uint8_t alpha)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(spriteSys->exists(en), "Entity doesn't have sprite component.");
-        spriteSys->setAlpha(spriteSys->getInstance(en), alpha);
+        ComponentAccess access = spriteAccess(spriteSys, en);
+        SCRIPT_ASSERT(access != ComponentAccess::Missing, "Entity doesn't have sprite component.");
+        if (access == ComponentAccess::Recorded) { AngelState::getCurrent()->getCommandBuffer()->set(CommandBuffer::Property::SpriteAlpha, en, alpha); }
+        else { spriteSys->setAlpha(spriteSys->getInstance(en), alpha); }
     }
 
     void angelSprite_setTexOffset(SpriteSystem* spriteSys, Entity en, Vector2i texOffset)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(spriteSys->exists(en), "Entity doesn't have sprite component.");
-        spriteSys->setTexOffset(spriteSys->getInstance(en), texOffset);
+        ComponentAccess access = spriteAccess(spriteSys, en);
+        SCRIPT_ASSERT(access != ComponentAccess::Missing, "Entity doesn't have sprite component.");
+        if (access == ComponentAccess::Recorded) { AngelState::getCurrent()->getCommandBuffer()->set(CommandBuffer::Property::SpriteTexOffset, en, texOffset); }
+        else { spriteSys->setTexOffset(spriteSys->getInstance(en), texOffset); }
     }
 
     void angelSprite_setTexture(SpriteSystem* spriteSys, Entity en, asset::AssetRef ref)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(spriteSys->exists(en), "Entity doesn't have sprite component.");
-        spriteSys->setTextureRef(spriteSys->getInstance(en), ref);
+        ComponentAccess access = spriteAccess(spriteSys, en);
+        SCRIPT_ASSERT(access != ComponentAccess::Missing, "Entity doesn't have sprite component.");
+        if (access == ComponentAccess::Recorded) { AngelState::getCurrent()->getCommandBuffer()->set(CommandBuffer::Property::SpriteTexture, en, ref.hash); }
+        else { spriteSys->setTextureRef(spriteSys->getInstance(en), ref); }
     }
 
     void angelSprite_setHorFlip(SpriteSystem* spriteSys, Entity en, bool horFlip)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(spriteSys->exists(en), "Entity doesn't have sprite component.");
-        spriteSys->setHorFlip(spriteSys->getInstance(en), horFlip);
+        ComponentAccess access = spriteAccess(spriteSys, en);
+        SCRIPT_ASSERT(access != ComponentAccess::Missing, "Entity doesn't have sprite component.");
+        if (access == ComponentAccess::Recorded) { AngelState::getCurrent()->getCommandBuffer()->set(CommandBuffer::Property::SpriteHorFlip, en, horFlip); }
+        else { spriteSys->setHorFlip(spriteSys->getInstance(en), horFlip); }
     }
 
     void angelSprite_setVerFlip(SpriteSystem* spriteSys, Entity en, bool verFlip)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(spriteSys->exists(en), "Entity doesn't have sprite component.");
-        spriteSys->setVerFlip(spriteSys->getInstance(en), verFlip);
+        ComponentAccess access = spriteAccess(spriteSys, en);
+        SCRIPT_ASSERT(access != ComponentAccess::Missing, "Entity doesn't have sprite component.");
+        if (access == ComponentAccess::Recorded) { AngelState::getCurrent()->getCommandBuffer()->set(CommandBuffer::Property::SpriteVerFlip, en, verFlip); }
+        else { spriteSys->setVerFlip(spriteSys->getInstance(en), verFlip); }
     }
 
     void angelSprite_setRotation(SpriteSystem* spriteSys, Entity en, int32_t rotation)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(spriteSys->exists(en), "Entity doesn't have sprite component.");
-        spriteSys->setRotation(spriteSys->getInstance(en), rotation);
+        ComponentAccess access = spriteAccess(spriteSys, en);
+        SCRIPT_ASSERT(access != ComponentAccess::Missing, "Entity doesn't have sprite component.");
+        if (access == ComponentAccess::Recorded) { AngelState::getCurrent()->getCommandBuffer()->set(CommandBuffer::Property::SpriteRotation, en, rotation); }
+        else { spriteSys->setRotation(spriteSys->getInstance(en), rotation); }
     }
 
     void angelSprite_RegisterTypes(asIScriptEngine* engine, scene::SpriteSystem** spriteSys)
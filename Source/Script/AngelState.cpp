@@ -10,6 +10,7 @@
 #include "Asset/AssetManager.h"
 #include "Asset/AssetType.h"
 #include "Scene/Scene.h"
+#include "Util/Archives.h"
 
 using namespace asset;
 
@@ -83,7 +84,8 @@ namespace script
 
     void AngelState::init()
     {
-        AS_VERIFY(_scriptEngine = asCreateScriptEngine());
+        _scriptEngine = asCreateScriptEngine();
+        NW_REQUIRE(_scriptEngine != nullptr);
         AS_VERIFY(_scriptEngine->SetMessageCallback(asFUNCTION(messageCallback), 0, asCALL_CDECL));
 
         _scriptContext = _scriptEngine->CreateContext();
@@ -106,9 +108,26 @@ namespace script
         angelTile_RegisterTypes(_scriptEngine, &_tileSystem);
         angelCamera_RegisterTypes(_scriptEngine, &_cameraSystem);
         angelPostProcess_RegisterTypes(_scriptEngine, &_postProcessingManager);
+#ifdef NW_PROFILE
+        angelCounters_RegisterTypes(_scriptEngine);
+#endif
 
         AS_VERIFY(_scriptEngine->RegisterGlobalFunction("void print(string)", asFUNCTION(print), asCALL_CDECL));
         AS_VERIFY(_scriptEngine->RegisterGlobalFunction("uint strhash(const string &in)", asFUNCTION(strhash), asCALL_CDECL));
+
+        //Instanced by the bindings registered above, so it lives as long as the engine
+        _entityArrayType = _scriptEngine->GetTypeInfoByDecl("array<Entity>");
+        NW_ASSERT(_entityArrayType != nullptr);
+    }
+
+    CScriptArray* AngelState::createEntityArray(const scene::Entity* entities, uint32_t count)
+    {
+        CScriptArray* result = CScriptArray::Create(_entityArrayType, count);
+        if (entities != nullptr && count > 0)
+        {
+            memcpy(result->At(0), entities, count * sizeof(scene::Entity));
+        }
+        return result;
     }
 
     void AngelState::setScene(scene::Scene& scene)
@@ -124,6 +143,12 @@ namespace script
         _cameraSystem = &scene.getCameraSystem();
     }
 
+    scene::CommandBuffer* AngelState::getCommandBuffer()
+    {
+        //Not cached, the scene resizes its buffers to match the job system
+        return &_scene->getCommandBuffer();
+    }
+
     void AngelState::startCompiling()
     {
         NW_ASSERT(!_isCompiling);
@@ -144,31 +169,24 @@ namespace script
         int r = (_scriptBuilder.BuildModule());
         NW_REQUIRE(r >= 0);
 
-        //Manually cache primitive types
-        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::Bool), asTYPEID_BOOL));
-        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::Int8), asTYPEID_INT8));
-        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::Int16), asTYPEID_INT16));
-        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::Int32), asTYPEID_INT32));
-        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::Int64), asTYPEID_INT64));
-        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::UInt8), asTYPEID_UINT8));
-        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::UInt16), asTYPEID_UINT16));
-        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::UInt32), asTYPEID_UINT32));
-        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::UInt64), asTYPEID_UINT64));
-        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::Float32), asTYPEID_FLOAT));
-        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::Float64), asTYPEID_DOUBLE));
+        cachePrimitiveTypes();
 
         //Cache registered types
         for (uint32_t i = 0; i < _scriptEngine->GetObjectTypeCount(); i++)
         {
             asITypeInfo* typeInfo = _scriptEngine->GetObjectTypeByIndex(i);
-            cacheType(typeInfo);
+            cacheType(typeInfo, TypeSource::Engine, i);
         }
 
         //Cache template instantiations
+        uint32_t templateIndex = 0;
         for (const auto& decl : g_templateInstances)
         {
             asITypeInfo* typeInfo = _scriptEngine->GetTypeInfoByDecl(decl.c_str());
-            cacheType(typeInfo);
+            cacheType(typeInfo, TypeSource::Template, templateIndex++);
+#ifdef NW_ASSET_COOK
+            _templateDecls.push_back(decl);
+#endif
         }
 
         //Cache module types
@@ -176,13 +194,204 @@ namespace script
         for (uint32_t i = 0; i < module->GetObjectTypeCount(); i++)
         {
             asITypeInfo* typeInfo = module->GetObjectTypeByIndex(i);
-            cacheType(typeInfo);
+            cacheType(typeInfo, TypeSource::Module, i);
         }
 
+#ifdef NW_PROFILE
+        _profiler.assignZones(module);
+#endif
+
         _isCompiling = false;
     }
 
-    void AngelState::cacheType(asITypeInfo* typeInfo)
+    //Reads the module straight out of the cooked asset
+    class BytecodeReadStream : public asIBinaryStream
+    {
+    private:
+        const uint8_t* _data;
+        size_t _size;
+        size_t _position;
+
+    public:
+        BytecodeReadStream(const void* data, size_t size) :
+            _data((const uint8_t*)data),
+            _size(size),
+            _position(0)
+        {
+        }
+
+        void Read(void* ptr, asUINT size)
+        {
+            NW_REQUIRE(_position + size <= _size);
+            memcpy(ptr, _data + _position, size);
+            _position += size;
+        }
+
+        void Write(const void*, asUINT) { NW_ASSERT(false); }
+    };
+
+    void AngelState::loadBytecode(const void* data, size_t size)
+    {
+        NW_ASSERT(!_isCompiling);
+
+        util::MemoryReadArchive ar;
+        ar.init(data, size);
+
+        uint32_t bytecodeSize;
+        ar.serializeU32(bytecodeSize);
+        BytecodeReadStream stream(ar.currentPtr(), bytecodeSize);
+        asIScriptModule* module = _scriptEngine->GetModule(MODULE_NAME, asGM_ALWAYS_CREATE);
+        AS_VERIFY(module->LoadByteCode(&stream));
+        ar.serializePadding(bytecodeSize);
+
+        cachePrimitiveTypes();
+
+        //There are only a few template instances, so they're looked up by declaration
+        uint32_t templateCount;
+        ar.serializeU32(templateCount);
+        eastl::vector<int> templateIds(templateCount);
+        eastl::string decl;
+        for (uint32_t i = 0; i < templateCount; i++)
+        {
+            uint32_t declLen;
+            ar.serializeU32(declLen);
+            decl.resize(declLen);
+            ar.serializeBytes(&decl[0], declLen);
+
+            asITypeInfo* typeInfo = _scriptEngine->GetTypeInfoByDecl(decl.c_str());
+            NW_REQUIRE(typeInfo != nullptr);
+            templateIds[i] = typeInfo->GetTypeId();
+        }
+
+        uint32_t typeCount;
+        ar.serializeU32(typeCount);
+        eastl::vector<int> typeIds(typeCount);
+        for (uint32_t i = 0; i < typeCount; i++)
+        {
+            AngelType aType;
+            uint32_t source;
+            uint32_t index;
+            ar.serializeCustom(aType);
+            ar.serializeU32(source);
+            ar.serializeU32(index);
+
+            switch ((TypeSource)source)
+            {
+            case TypeSource::Engine: typeIds[i] = _scriptEngine->GetObjectTypeByIndex(index)->GetTypeId(); break;
+            case TypeSource::Template: typeIds[i] = templateIds[index]; break;
+            case TypeSource::Module: typeIds[i] = module->GetObjectTypeByIndex(index)->GetTypeId(); break;
+            default: NW_REQUIRE(false); break;
+            }
+
+            _typeMap.insert(eastl::make_pair(aType, typeIds[i]));
+        }
+
+        uint32_t propCount;
+        ar.serializeU32(propCount);
+        for (uint32_t i = 0; i < propCount; i++)
+        {
+            uint32_t typeEntry;
+            uint32_t propIndex;
+            AngelPropertyKey key;
+            ar.serializeU32(typeEntry);
+            ar.serializeU32(key.propNameHash);
+            ar.serializeCustom(key.propType);
+            ar.serializeU32(propIndex);
+
+            key.typeId = typeIds[typeEntry];
+            _propIndexMap.insert(eastl::make_pair(key, (int)propIndex));
+        }
+
+#ifdef NW_PROFILE
+        _profiler.assignZones(module);
+#endif
+    }
+
+#ifdef NW_ASSET_COOK
+    class BytecodeWriteStream : public asIBinaryStream
+    {
+    private:
+        eastl::vector<uint8_t>& _output;
+
+    public:
+        explicit BytecodeWriteStream(eastl::vector<uint8_t>& output) : _output(output) { }
+
+        void Write(const void* ptr, asUINT size)
+        {
+            const uint8_t* bytes = (const uint8_t*)ptr;
+            _output.insert(_output.end(), bytes, bytes + size);
+        }
+
+        void Read(void*, asUINT) { NW_ASSERT(false); }
+    };
+
+    void AngelState::saveBytecode(util::EndianVectorWriteArchive& ar)
+    {
+        NW_ASSERT(!_isCompiling);
+
+        eastl::vector<uint8_t> bytecode;
+        BytecodeWriteStream stream(bytecode);
+        AS_VERIFY(_scriptEngine->GetModule(MODULE_NAME)->SaveByteCode(&stream));
+
+        uint32_t bytecodeSize = (uint32_t)bytecode.size();
+        ar.serializeU32(bytecodeSize);
+        ar.serializeBytes(bytecode.data(), bytecodeSize);
+
+        uint32_t templateCount = (uint32_t)_templateDecls.size();
+        ar.serializeU32(templateCount);
+        for (const auto& decl : _templateDecls)
+        {
+            uint32_t declLen = (uint32_t)decl.size();
+            ar.serializeU32(declLen);
+            ar.serializeBytes(decl.data(), declLen);
+        }
+
+        //Properties refer to their type by its position in the type list
+        eastl::hash_map<int, uint32_t> typeEntries;
+        uint32_t typeCount = (uint32_t)_typeCacheEntries.size();
+        ar.serializeU32(typeCount);
+        for (uint32_t i = 0; i < typeCount; i++)
+        {
+            TypeCacheEntry& entry = _typeCacheEntries[i];
+            uint32_t source = (uint32_t)entry.source;
+            ar.serializeCustom(entry.aType);
+            ar.serializeU32(source);
+            ar.serializeU32(entry.index);
+
+            typeEntries[getTypeIdFromAngelType(entry.aType)] = i;
+        }
+
+        uint32_t propCount = (uint32_t)_propIndexMap.size();
+        ar.serializeU32(propCount);
+        for (const auto& pair : _propIndexMap)
+        {
+            AngelPropertyKey key = pair.first;
+            uint32_t typeEntry = typeEntries[key.typeId];
+            uint32_t propIndex = (uint32_t)pair.second;
+            ar.serializeU32(typeEntry);
+            ar.serializeU32(key.propNameHash);
+            ar.serializeCustom(key.propType);
+            ar.serializeU32(propIndex);
+        }
+    }
+#endif
+
+    void AngelState::cachePrimitiveTypes()
+    {
+        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::Bool), asTYPEID_BOOL));
+        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::Int8), asTYPEID_INT8));
+        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::Int16), asTYPEID_INT16));
+        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::Int32), asTYPEID_INT32));
+        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::Int64), asTYPEID_INT64));
+        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::UInt8), asTYPEID_UINT8));
+        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::UInt16), asTYPEID_UINT16));
+        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::UInt32), asTYPEID_UINT32));
+        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::UInt64), asTYPEID_UINT64));
+        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::Float32), asTYPEID_FLOAT));
+        _typeMap.insert(eastl::make_pair(AngelType(AngelType::Type::Float64), asTYPEID_DOUBLE));
+    }
+
+    void AngelState::cacheType(asITypeInfo* typeInfo, TypeSource source, uint32_t index)
     {
         eastl::string typeDecl = getTypeInfoDecl(typeInfo);
         AngelType aType(typeDecl.c_str());
@@ -197,6 +406,13 @@ namespace script
 
         //Cache types
         _typeMap.insert(eastl::make_pair(aType, typeInfo->GetTypeId()));
+#ifdef NW_ASSET_COOK
+        TypeCacheEntry entry = { aType, source, index };
+        _typeCacheEntries.push_back(entry);
+#else
+        NW_UNUSED(source);
+        NW_UNUSED(index);
+#endif
 
         //Cache property indices
         for (uint32_t propIndex = 0; propIndex < typeInfo->GetPropertyCount(); propIndex++)
@@ -4,12 +4,19 @@
 #include <angelscript.h>
 #include <scriptbuilder/scriptbuilder.h>
 #include <EASTL/hash_map.h>
+#include <EASTL/vector.h>
+#include <EASTL/string.h>
+#include "Core/Features.h"
 #include "AngelType.h"
+#include "ScriptProfiler.h"
 
+class CScriptArray;
 namespace asset { class AssetManager; }
+namespace util { class EndianVectorWriteArchive; }
 namespace render { class PostProcessingManager; }
 namespace scene
 {
+    struct Entity;
     class Scene;
     class EntityManager;
     class TagSystem;
@@ -19,6 +26,7 @@ namespace scene
     class ScriptSystem;
     class TileSystem;
     class CameraSystem;
+    class CommandBuffer;
 }
 namespace path { class PathManager; }
 namespace input { class Input; }
@@ -104,6 +112,34 @@ namespace script
         //Constant time lookup of property indices based on name hash and type
         eastl::hash_map<AngelPropertyKey, int> _propIndexMap;
 
+        //array<Entity>, returned by the scene and tag bindings
+        asITypeInfo* _entityArrayType;
+
+        //Type ids are handed out at runtime, so the caches saved along with the
+        //module bytecode record where each type can be found instead
+        enum class TypeSource : uint32_t
+        {
+            Engine,     //Index into the engine's registered object types
+            Template,   //Index into the saved template instance declarations
+            Module      //Index into the module's object types
+        };
+
+#ifdef NW_ASSET_COOK
+        struct TypeCacheEntry
+        {
+            AngelType aType;
+            TypeSource source;
+            uint32_t index;
+        };
+
+        eastl::vector<TypeCacheEntry> _typeCacheEntries;
+        eastl::vector<eastl::string> _templateDecls;
+#endif
+
+#ifdef NW_PROFILE
+        ScriptProfiler _profiler;
+#endif
+
     public:
         AngelState() :
             _isCompiling(false),
@@ -121,7 +157,8 @@ namespace script
             _tileSystem(nullptr),
             _cameraSystem(nullptr),
             _pathManager(nullptr),
-            _input(nullptr)
+            _input(nullptr),
+            _entityArrayType(nullptr)
         {
         }
 
@@ -135,8 +172,18 @@ namespace script
         void addScriptSection(const char* name, const char* section);
         void endCompiling();
 
+        //Loads the module and type caches saved by saveBytecode() instead of
+        //compiling script sections
+        void loadBytecode(const void* data, size_t size);
+#ifdef NW_ASSET_COOK
+        void saveBytecode(util::EndianVectorWriteArchive& ar);
+#endif
+
         asIScriptEngine* getScriptEngine() { return _scriptEngine; }
         asIScriptContext* getScriptContext() { return _scriptContext; }
+#ifdef NW_PROFILE
+        ScriptProfiler& getProfiler() { return _profiler; }
+#endif
 
         asset::AssetManager* getAssetManager() { return _assetManager; }
         render::PostProcessingManager* getPostProcessingManager() { return _postProcessingManager; }
@@ -149,6 +196,8 @@ namespace script
         scene::ScriptSystem* getScriptSystem() { return _scriptSystem; }
         scene::TileSystem* getTileSystem() { return _tileSystem; }
         scene::CameraSystem* getCameraSystem() { return _cameraSystem; }
+        //Scripts record structural changes here, see Scene::playbackCommands()
+        scene::CommandBuffer* getCommandBuffer();
         path::PathManager* getPathManager() { return _pathManager; }
         input::Input* getInput() { return _input; }
 
@@ -190,6 +239,10 @@ namespace script
             }
         }
 
+        //Copies entities into a new script array, or leaves the elements
+        //invalid if entities is null
+        CScriptArray* createEntityArray(const scene::Entity* entities, uint32_t count);
+
         int getPropertyIndex(AngelType objType, uint32_t propNameHash, AngelType propType)
         {
             AngelPropertyKey key;
@@ -208,7 +261,8 @@ namespace script
         }
 
     private:
-        void cacheType(asITypeInfo* typeInfo);
+        void cachePrimitiveTypes();
+        void cacheType(asITypeInfo* typeInfo, TypeSource source, uint32_t index);
     };
 
     void angelMath_RegisterTypes(asIScriptEngine* engine);
@@ -225,6 +279,9 @@ namespace script
     void angelTile_RegisterTypes(asIScriptEngine* engine, scene::TileSystem** tileSys);
     void angelCamera_RegisterTypes(asIScriptEngine* engine, scene::CameraSystem** camSys);
     void angelPostProcess_RegisterTypes(asIScriptEngine* engine, render::PostProcessingManager** postMan);
+#ifdef NW_PROFILE
+    void angelCounters_RegisterTypes(asIScriptEngine* engine);
+#endif
 }
 
 #define AS_VERIFY(s) NW_VERIFY((s) >= 0);
@@ -2,44 +2,58 @@
 #include <angelscript.h>
 #include "AngelState.h"
 #include "AngelMacros.h"
+#include "AngelComponentRef.h"
+#include "AngelArray.h"
 #include "Scene/EntityManager.h"
 #include "Scene/TagSystem.h"
+#include "Scene/CommandBuffer.h"
 
 using namespace scene;
 
 namespace script
 {
+    static ComponentAccess tagAccess(TagSystem* tagSys, Entity en)
+    {
+        return getComponentAccess(tagSys, ComponentType::Tag, en);
+    }
+
     bool angelTag_exists(TagSystem* tagSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, false);
-        return tagSys->exists(en);
+        return tagAccess(tagSys, en) != ComponentAccess::Missing;
     }
 
     void angelTag_create(TagSystem* tagSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(!tagSys->exists(en), "Cannot create tag component; it already exists.");
-        tagSys->create(en);
+        SCRIPT_ASSERT(tagAccess(tagSys, en) == ComponentAccess::Missing, "Cannot create tag component; it already exists.");
+        AngelState::getCurrent()->getCommandBuffer()->create(ComponentType::Tag, en);
     }
 
     void angelTag_destroy(TagSystem* tagSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(tagSys->exists(en), "Cannot destroy non-existent tag component.");
-        tagSys->create(en);
+        SCRIPT_ASSERT(tagAccess(tagSys, en) != ComponentAccess::Missing, "Cannot destroy non-existent tag component.");
+        AngelState::getCurrent()->getCommandBuffer()->destroy(ComponentType::Tag, en);
     }
 
     bool angelTag_hasTag(TagSystem* tagSys, Entity en, uint32_t tag)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, false);
-        SCRIPT_ASSERT_RETVAL(tagSys->exists(en), "Entity does not have tag component.", false);
+        SCRIPT_ASSERT_RETVAL(tagAccess(tagSys, en) == ComponentAccess::Direct, "Entity does not have tag component.", false);
         return tagSys->hasTag(tagSys->getInstance(en), tag);
     }
 
     void angelTag_addTag(TagSystem* tagSys, Entity en, uint32_t tag)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(tagSys->exists(en), "Entity does not have tag component.");
+        ComponentAccess access = tagAccess(tagSys, en);
+        SCRIPT_ASSERT(access != ComponentAccess::Missing, "Entity does not have tag component.");
+        if (access == ComponentAccess::Recorded)
+        {
+            AngelState::getCurrent()->getCommandBuffer()->set(CommandBuffer::Property::TagAdd, en, tag);
+            return;
+        }
         EInstance ei = tagSys->getInstance(en);
         SCRIPT_ASSERT(!tagSys->hasTag(ei, tag), "Entity already has specified tag.");
         tagSys->addTag(ei, tag);
@@ -48,12 +62,35 @@ namespace script
     void angelTag_removeTag(TagSystem* tagSys, Entity en, uint32_t tag)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(tagSys->exists(en), "Entity does not have tag component.");
+        ComponentAccess access = tagAccess(tagSys, en);
+        SCRIPT_ASSERT(access != ComponentAccess::Missing, "Entity does not have tag component.");
+        if (access == ComponentAccess::Recorded)
+        {
+            AngelState::getCurrent()->getCommandBuffer()->set(CommandBuffer::Property::TagRemove, en, tag);
+            return;
+        }
         EInstance ei = tagSys->getInstance(en);
         SCRIPT_ASSERT(tagSys->hasTag(ei, tag), "Entity already does not have specified tag.");
         tagSys->removeTag(ei, tag);
     }
 
+    //Queries only see tags that have been played back, not ones still
+    //waiting in the command buffer
+    CScriptArray* angelTag_query(TagSystem* tagSys, uint32_t tag)
+    {
+        const eastl::vector<Entity>& entities = tagSys->query(tag);
+        return AngelState::getCurrent()->createEntityArray(entities.data(), (uint32_t)entities.size());
+    }
+
+    CScriptArray* angelTag_queryAll(TagSystem* tagSys, const CScriptArray& tags)
+    {
+        memory::FrameVector<Entity> result;
+
+        uint32_t tagCount = tags.GetSize();
+        tagSys->queryAll((tagCount > 0) ? (const uint32_t*)tags.At(0) : nullptr, tagCount, result);
+        return AngelState::getCurrent()->createEntityArray(result.data(), (uint32_t)result.size());
+    }
+
     void angelTag_RegisterTypes(asIScriptEngine* engine, scene::TagSystem** tagSys)
     {
         AS_VERIFY(engine->RegisterObjectType("CTagSystem", sizeof(TagSystem), asOBJ_REF | asOBJ_NOCOUNT));
@@ -63,6 +100,8 @@ namespace script
         AS_VERIFY(engine->RegisterObjectMethod("CTagSystem", "bool hasTag(Entity, uint)", asFUNCTION(angelTag_hasTag), asCALL_CDECL_OBJFIRST));
         AS_VERIFY(engine->RegisterObjectMethod("CTagSystem", "void addTag(Entity, uint)", asFUNCTION(angelTag_addTag), asCALL_CDECL_OBJFIRST));
         AS_VERIFY(engine->RegisterObjectMethod("CTagSystem", "void removeTag(Entity, uint)", asFUNCTION(angelTag_removeTag), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("CTagSystem", "array<Entity>@ query(uint)", asFUNCTION(angelTag_query), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("CTagSystem", "array<Entity>@ queryAll(const array<uint>&in)", asFUNCTION(angelTag_queryAll), asCALL_CDECL_OBJFIRST));
         AS_VERIFY(engine->RegisterGlobalProperty("CTagSystem@ Tag", tagSys));
     }
 }
@@ -2,99 +2,177 @@
 #include <angelscript.h>
 #include "AngelState.h"
 #include "AngelMacros.h"
+#include "AngelComponentRef.h"
 #include "Scene/EntityManager.h"
 #include "Scene/TransformSystem.h"
+#include "Scene/CommandBuffer.h"
 
 using namespace scene;
 
 namespace script
 {
+    static ComponentAccess transformAccess(TransformSystem* trSys, Entity en)
+    {
+        return getComponentAccess(trSys, ComponentType::Transform, en);
+    }
+
     bool angelTransform_exists(TransformSystem* trSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, false);
-        return trSys->exists(en);
+        return transformAccess(trSys, en) != ComponentAccess::Missing;
     }
 
     void angelTransform_create(TransformSystem* trSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(!trSys->exists(en), "Cannot create transform component; it already exists.");
-        trSys->create(en);
+        SCRIPT_ASSERT(transformAccess(trSys, en) == ComponentAccess::Missing, "Cannot create transform component; it already exists.");
+        AngelState::getCurrent()->getCommandBuffer()->create(ComponentType::Transform, en);
     }
 
     void angelTransform_destroy(TransformSystem* trSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(trSys->exists(en), "Cannot destroy non-existent transform component.");
-        trSys->create(en);
+        SCRIPT_ASSERT(transformAccess(trSys, en) != ComponentAccess::Missing, "Cannot destroy non-existent transform component.");
+        AngelState::getCurrent()->getCommandBuffer()->destroy(ComponentType::Transform, en);
     }
 
     Vector2i angelTransform_getLocalPos(TransformSystem* trSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, Vector2i());
-        SCRIPT_ASSERT_RETVAL(trSys->exists(en), "Entity doesn't have transform component.", Vector2i());
+        SCRIPT_ASSERT_RETVAL(transformAccess(trSys, en) == ComponentAccess::Direct, "Entity doesn't have transform component.", Vector2i());
         return trSys->getLocalPos(trSys->getInstance(en));
     }
 
     Vector2i angelTransform_getWorldPos(TransformSystem* trSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, Vector2i());
-        SCRIPT_ASSERT_RETVAL(trSys->exists(en), "Entity doesn't have transform component.", Vector2i());
+        SCRIPT_ASSERT_RETVAL(transformAccess(trSys, en) == ComponentAccess::Direct, "Entity doesn't have transform component.", Vector2i());
         return trSys->getWorldPos(trSys->getInstance(en));
     }
 
     Entity angelTransform_getParent(TransformSystem* trSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, Entity());
-        SCRIPT_ASSERT_RETVAL(trSys->exists(en), "Entity doesn't have transform component.", Entity());
+        SCRIPT_ASSERT_RETVAL(transformAccess(trSys, en) == ComponentAccess::Direct, "Entity doesn't have transform component.", Entity());
         return trSys->getEntity(trSys->getParent(trSys->getInstance(en)));
     }
 
     Entity angelTransform_getFirstChild(TransformSystem* trSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, Entity());
-        SCRIPT_ASSERT_RETVAL(trSys->exists(en), "Entity doesn't have transform component.", Entity());
+        SCRIPT_ASSERT_RETVAL(transformAccess(trSys, en) == ComponentAccess::Direct, "Entity doesn't have transform component.", Entity());
         return trSys->getEntity(trSys->getFirstChild(trSys->getInstance(en)));
     }
 
     Entity angelTransform_getNextSib(TransformSystem* trSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, Entity());
-        SCRIPT_ASSERT_RETVAL(trSys->exists(en), "Entity doesn't have transform component.", Entity());
+        SCRIPT_ASSERT_RETVAL(transformAccess(trSys, en) == ComponentAccess::Direct, "Entity doesn't have transform component.", Entity());
         return trSys->getEntity(trSys->getNextSib(trSys->getInstance(en)));
     }
 
     Entity angelTransform_getPrevSib(TransformSystem* trSys, Entity en)
     {
         SCRIPT_ASSERT_ALIVE_RETVAL(en, Entity());
-        SCRIPT_ASSERT_RETVAL(trSys->exists(en), "Entity doesn't have transform component.", Entity());
+        SCRIPT_ASSERT_RETVAL(transformAccess(trSys, en) == ComponentAccess::Direct, "Entity doesn't have transform component.", Entity());
         return trSys->getEntity(trSys->getPrevSib(trSys->getInstance(en)));
     }
 
     void angelTransform_setLocalPos(TransformSystem* trSys, Entity en, Vector2i pos)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(trSys->exists(en), "Entity doesn't have transform component.");
-        trSys->setLocalPos(trSys->getInstance(en), pos);
+        ComponentAccess access = transformAccess(trSys, en);
+        SCRIPT_ASSERT(access != ComponentAccess::Missing, "Entity doesn't have transform component.");
+        if (access == ComponentAccess::Recorded) { AngelState::getCurrent()->getCommandBuffer()->set(CommandBuffer::Property::TransformLocalPos, en, pos); }
+        else { trSys->setLocalPos(trSys->getInstance(en), pos); }
     }
 
     void angelTransform_setWorldPos(TransformSystem* trSys, Entity en, Vector2i pos)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(trSys->exists(en), "Entity doesn't have transform component.");
-        trSys->setWorldPos(trSys->getInstance(en), pos);
+        ComponentAccess access = transformAccess(trSys, en);
+        SCRIPT_ASSERT(access != ComponentAccess::Missing, "Entity doesn't have transform component.");
+        if (access == ComponentAccess::Recorded) { AngelState::getCurrent()->getCommandBuffer()->set(CommandBuffer::Property::TransformWorldPos, en, pos); }
+        else { trSys->setWorldPos(trSys->getInstance(en), pos); }
     }
 
     void angelTransform_setParent(TransformSystem* trSys, Entity en, Entity parent)
     {
         SCRIPT_ASSERT_ALIVE(en);
-        SCRIPT_ASSERT(trSys->exists(en), "Entity doesn't have transform component.");
+        SCRIPT_ASSERT(transformAccess(trSys, en) == ComponentAccess::Direct, "Entity doesn't have transform component.");
         trSys->setParent(trSys->getInstance(en), trSys->getInstance(parent));
     }
 
+    ComponentRef angelTransform_getRef(TransformSystem* trSys, Entity en)
+    {
+        SCRIPT_ASSERT_ALIVE_RETVAL(en, ComponentRef());
+        SCRIPT_ASSERT_RETVAL(transformAccess(trSys, en) == ComponentAccess::Direct, "Entity doesn't have transform component.", ComponentRef());
+        return makeComponentRef(trSys, en);
+    }
+
+    static bool resolveTransformRef(ComponentRef* ref)
+    {
+        return resolveComponentRef(AngelState::getCurrent()->getTransformSystem(), ComponentType::Transform, ref, "Entity doesn't have transform component.");
+    }
+
+    Entity angelTransformRef_getEntity(ComponentRef* ref)
+    {
+        return ref->entity;
+    }
+
+    bool angelTransformRef_isValid(ComponentRef* ref)
+    {
+        TransformSystem* trSys = AngelState::getCurrent()->getTransformSystem();
+        return AngelState::getCurrent()->getEntityManager()->alive(ref->entity) &&
+            transformAccess(trSys, ref->entity) == ComponentAccess::Direct;
+    }
+
+    Vector2i angelTransformRef_getLocalPos(ComponentRef* ref)
+    {
+        if (!resolveTransformRef(ref)) { return Vector2i(); }
+        return AngelState::getCurrent()->getTransformSystem()->getLocalPos(ref->ei);
+    }
+
+    Vector2i angelTransformRef_getWorldPos(ComponentRef* ref)
+    {
+        if (!resolveTransformRef(ref)) { return Vector2i(); }
+        return AngelState::getCurrent()->getTransformSystem()->getWorldPos(ref->ei);
+    }
+
+    void angelTransformRef_getPositions(ComponentRef* ref, Vector2i* localPos, Vector2i* worldPos)
+    {
+        if (!resolveTransformRef(ref)) { return; }
+        TransformSystem* trSys = AngelState::getCurrent()->getTransformSystem();
+        *localPos = trSys->getLocalPos(ref->ei);
+        *worldPos = trSys->getWorldPos(ref->ei);
+    }
+
+    void angelTransformRef_setLocalPos(ComponentRef* ref, Vector2i pos)
+    {
+        if (!resolveTransformRef(ref)) { return; }
+        AngelState::getCurrent()->getTransformSystem()->setLocalPos(ref->ei, pos);
+    }
+
+    void angelTransformRef_setWorldPos(ComponentRef* ref, Vector2i pos)
+    {
+        if (!resolveTransformRef(ref)) { return; }
+        AngelState::getCurrent()->getTransformSystem()->setWorldPos(ref->ei, pos);
+    }
+
     void angelTransform_RegisterTypes(asIScriptEngine* engine, scene::TransformSystem** trSys)
     {
+        AS_VERIFY(engine->RegisterObjectType("TransformRef", sizeof(ComponentRef), asOBJ_VALUE | asOBJ_POD | asOBJ_APP_CLASS_ALLINTS | asGetTypeTraits<ComponentRef>()));
+        AS_VERIFY(engine->RegisterObjectBehaviour("TransformRef", asBEHAVE_CONSTRUCT, "void f()", asFUNCTION(angelComponentRef_DefaultConstruct), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("TransformRef", "Entity getEntity() const", asFUNCTION(angelTransformRef_getEntity), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("TransformRef", "bool isValid() const", asFUNCTION(angelTransformRef_isValid), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("TransformRef", "Vector2i getLocalPos()", asFUNCTION(angelTransformRef_getLocalPos), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("TransformRef", "Vector2i getWorldPos()", asFUNCTION(angelTransformRef_getWorldPos), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("TransformRef", "void getPositions(Vector2i &out localPos, Vector2i &out worldPos)", asFUNCTION(angelTransformRef_getPositions), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("TransformRef", "void setLocalPos(Vector2i)", asFUNCTION(angelTransformRef_setLocalPos), asCALL_CDECL_OBJFIRST));
+        AS_VERIFY(engine->RegisterObjectMethod("TransformRef", "void setWorldPos(Vector2i)", asFUNCTION(angelTransformRef_setWorldPos), asCALL_CDECL_OBJFIRST));
+
         AS_VERIFY(engine->RegisterObjectType("CTransformSystem", sizeof(TransformSystem), asOBJ_REF | asOBJ_NOCOUNT));
+        AS_VERIFY(engine->RegisterObjectMethod("CTransformSystem", "TransformRef getRef(Entity)", asFUNCTION(angelTransform_getRef), asCALL_CDECL_OBJFIRST));
         AS_VERIFY(engine->RegisterObjectMethod("CTransformSystem", "bool exists(Entity)", asFUNCTION(angelTransform_exists), asCALL_CDECL_OBJFIRST));
         AS_VERIFY(engine->RegisterObjectMethod("CTransformSystem", "void create(Entity)", asFUNCTION(angelTransform_create), asCALL_CDECL_OBJFIRST));
         AS_VERIFY(engine->RegisterObjectMethod("CTransformSystem", "void destroy(Entity)", asFUNCTION(angelTransform_destroy), asCALL_CDECL_OBJFIRST));
@@ -5,6 +5,7 @@
 #include <string.h>
 #include <EASTL/functional.h>
 #include "Core/xxhash/xxhash.h"
+#include "Util/ArchiveTraits.h"
 
 namespace script
 {
@@ -71,6 +72,7 @@ namespace script
         bool operator==(AngelType other) const { return type == other.type && nameHash == other.nameHash; }
         bool operator!=(AngelType other) const { return type != other.type && nameHash != other.nameHash; }
 
+        AR_BULK_SERIALIZABLE(8);
         template <typename Archive>
         void serialize(Archive& ar)
         {
@@ -0,0 +1,286 @@
+#include "Core/Core.h"
+#include "ScriptProfiler.h"
+
+#ifdef NW_PROFILE
+#include <stdio.h>
+#include <EASTL/sort.h>
+#include <EASTL/string.h>
+#include "Core/Profiler.h"
+#include "Util/File.h"
+
+namespace script
+{
+    static const uint32_t NO_ZONE = 0xFFFFFFFF;
+    static const uint32_t MAX_HOTSPOT_LINES = 50;
+
+    struct TicksGreater
+    {
+        const eastl::vector<uint64_t>* ticks;
+        bool operator()(uint32_t a, uint32_t b) const { return (*ticks)[a] > (*ticks)[b]; }
+    };
+
+    ScriptProfiler::ScriptProfiler() :
+        _lineProfiling(false),
+        _pendingLineProfiling(false),
+        _lineTicks(0),
+        _lineZone(NO_ZONE),
+        _line(0),
+        _lineSection(nullptr)
+    {
+        _stack.reserve(32);
+    }
+
+    void ScriptProfiler::assignZones(asIScriptModule* module)
+    {
+        for (uint32_t i = 0; i < module->GetFunctionCount(); i++)
+        {
+            getZone(module->GetFunctionByIndex(i));
+        }
+
+        //Methods are called through their virtual stub, while the call stack
+        //shows the implementation. Both get the same zone.
+        for (uint32_t i = 0; i < module->GetObjectTypeCount(); i++)
+        {
+            asITypeInfo* type = module->GetObjectTypeByIndex(i);
+            for (uint32_t m = 0; m < type->GetMethodCount(); m++)
+            {
+                getZone(type->GetMethodByIndex(m, true));
+                getZone(type->GetMethodByIndex(m, false));
+            }
+        }
+    }
+
+    uint32_t ScriptProfiler::addZone(asIScriptFunction* fn)
+    {
+        char buffer[256];
+        const char* objectName = fn->GetObjectName();
+        if (objectName != nullptr)
+        {
+            snprintf(buffer, sizeof(buffer), "%s::%s", objectName, fn->GetName());
+        }
+        else
+        {
+            snprintf(buffer, sizeof(buffer), "%s", fn->GetName());
+        }
+
+        //Interned names are unique, so they double as the key
+        const char* name = profiler::internName(buffer);
+        uint32_t zone;
+        auto result = _zonesByName.find(name);
+        if (result != _zonesByName.end())
+        {
+            zone = result->second;
+        }
+        else
+        {
+            zone = (uint32_t)_zones.size();
+            FunctionZone fz = { name, 0, 0, 0 };
+            _zones.push_back(fz);
+            _zonesByName.insert(eastl::make_pair(name, zone));
+        }
+
+        fn->SetUserData((void*)(uintptr_t)(zone + 1), FUNCTION_ZONE);
+        return zone;
+    }
+
+    uint64_t ScriptProfiler::beginCall(asIScriptContext* ctx, asIScriptFunction* fn)
+    {
+        NW_UNUSED(fn);
+        if (_pendingLineProfiling != _lineProfiling)
+        {
+            applyLineProfiling(ctx);
+        }
+
+        return profiler::getTicks();
+    }
+
+    void ScriptProfiler::endCall(asIScriptFunction* fn, uint64_t begin)
+    {
+        uint64_t now = profiler::getTicks();
+        uint32_t zone = getZone(fn);
+
+        if (_lineProfiling)
+        {
+            //The line callback already pushed the function, close what's left
+            endLine(now);
+            popStack(0, now);
+        }
+        else
+        {
+            FunctionZone& fz = _zones[zone];
+            fz.calls++;
+            fz.inclusiveTicks += now - begin;
+            fz.exclusiveTicks += now - begin;
+        }
+
+        profiler::recordZone(_zones[zone].name, begin, now);
+    }
+
+    void ScriptProfiler::applyLineProfiling(asIScriptContext* ctx)
+    {
+        if (_pendingLineProfiling)
+        {
+            NW_VERIFY(ctx->SetLineCallback(asFUNCTION(lineCallback), this, asCALL_CDECL) >= 0);
+        }
+        else
+        {
+            ctx->ClearLineCallback();
+        }
+        _lineProfiling = _pendingLineProfiling;
+    }
+
+    void ScriptProfiler::lineCallback(asIScriptContext* ctx, void* profiler)
+    {
+        ((ScriptProfiler*)profiler)->onLine(ctx);
+    }
+
+    void ScriptProfiler::onLine(asIScriptContext* ctx)
+    {
+        uint64_t now = profiler::getTicks();
+        endLine(now);
+
+        //Match the shadow stack against the context's call stack from the
+        //bottom, then pop the functions that returned and push the new ones
+        uint32_t depth = ctx->GetCallstackSize();
+        uint32_t common = 0;
+        while (common < _stack.size() && common < depth &&
+               _stack[common].fn == ctx->GetFunction(depth - 1 - common))
+        {
+            common++;
+        }
+
+        popStack(common, now);
+        for (uint32_t i = common; i < depth; i++)
+        {
+            StackEntry entry;
+            entry.fn = ctx->GetFunction(depth - 1 - i);
+            entry.zone = getZone(entry.fn);
+            entry.enterTicks = now;
+            entry.childTicks = 0;
+            _stack.push_back(entry);
+            _zones[entry.zone].calls++;
+        }
+
+        _lineZone = _stack.empty() ? NO_ZONE : _stack.back().zone;
+        _line = ctx->GetLineNumber(0, nullptr, &_lineSection);
+
+        //Leave our own bookkeeping out of the next line
+        _lineTicks = profiler::getTicks();
+    }
+
+    void ScriptProfiler::endLine(uint64_t now)
+    {
+        if (_lineZone == NO_ZONE) { return; }
+
+        uint64_t key = ((uint64_t)_lineZone << 32) | (uint32_t)_line;
+        LineStats stats = { _lineZone, _line, _lineSection, 0, 0 };
+        LineStats& line = _lines.insert(eastl::make_pair(key, stats)).first->second;
+        line.ticks += now - _lineTicks;
+        line.samples++;
+
+        _lineZone = NO_ZONE;
+    }
+
+    void ScriptProfiler::popStack(uint32_t depth, uint64_t now)
+    {
+        while (_stack.size() > depth)
+        {
+            const StackEntry& entry = _stack.back();
+            uint64_t inclusive = now - entry.enterTicks;
+
+            FunctionZone& fz = _zones[entry.zone];
+            fz.inclusiveTicks += inclusive;
+            fz.exclusiveTicks += inclusive - entry.childTicks;
+
+            _stack.pop_back();
+            if (!_stack.empty())
+            {
+                _stack.back().childTicks += inclusive;
+            }
+        }
+    }
+
+    void ScriptProfiler::reset()
+    {
+        for (FunctionZone& fz : _zones)
+        {
+            fz.calls = 0;
+            fz.inclusiveTicks = 0;
+            fz.exclusiveTicks = 0;
+        }
+        _lines.clear();
+    }
+
+    void ScriptProfiler::writeFlatProfile(const char* fileName)
+    {
+        eastl::string text;
+        char buffer[512];
+
+        eastl::vector<uint32_t> order;
+        eastl::vector<uint64_t> ticks;
+        TicksGreater greater = { &ticks };
+
+        //Functions, slowest first
+        for (uint32_t i = 0; i < (uint32_t)_zones.size(); i++)
+        {
+            if (_zones[i].calls == 0) { continue; }
+            order.push_back(i);
+        }
+        ticks.resize(_zones.size());
+        for (uint32_t i = 0; i < (uint32_t)_zones.size(); i++)
+        {
+            ticks[i] = _zones[i].exclusiveTicks;
+        }
+        eastl::sort(order.begin(), order.end(), greater);
+
+        text += _lineProfiling ? "Script functions (line profiling)\n" : "Script functions (engine calls only)\n";
+        snprintf(buffer, sizeof(buffer), "%12s %12s %12s %12s  %s\n", "calls", "incl ms", "excl ms", "excl us/call", "function");
+        text += buffer;
+        for (uint32_t i : order)
+        {
+            const FunctionZone& fz = _zones[i];
+            double exclusiveMs = profiler::ticksToNs(fz.exclusiveTicks) / 1000000.0;
+            snprintf(buffer, sizeof(buffer), "%12llu %12.3f %12.3f %12.3f  %s\n",
+                (unsigned long long)fz.calls,
+                profiler::ticksToNs(fz.inclusiveTicks) / 1000000.0,
+                exclusiveMs,
+                exclusiveMs * 1000.0 / (double)fz.calls,
+                fz.name);
+            text += buffer;
+        }
+
+        //Lines, slowest first
+        if (!_lines.empty())
+        {
+            eastl::vector<const LineStats*> lines;
+            order.clear();
+            ticks.clear();
+            for (const auto& entry : _lines)
+            {
+                order.push_back((uint32_t)lines.size());
+                ticks.push_back(entry.second.ticks);
+                lines.push_back(&entry.second);
+            }
+            eastl::sort(order.begin(), order.end(), greater);
+            if (order.size() > MAX_HOTSPOT_LINES) { order.resize(MAX_HOTSPOT_LINES); }
+
+            text += "\nLine hotspots\n";
+            snprintf(buffer, sizeof(buffer), "%12s %12s  %s\n", "samples", "ms", "line");
+            text += buffer;
+            for (uint32_t i : order)
+            {
+                const LineStats& stats = *lines[i];
+                snprintf(buffer, sizeof(buffer), "%12llu %12.3f  %s:%d (%s)\n",
+                    (unsigned long long)stats.samples,
+                    profiler::ticksToNs(stats.ticks) / 1000000.0,
+                    stats.section != nullptr ? stats.section : "?",
+                    stats.line,
+                    _zones[stats.zone].name);
+                text += buffer;
+            }
+        }
+
+        util::file::writeAllText(fileName, text.c_str());
+    }
+}
+#endif
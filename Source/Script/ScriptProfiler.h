@@ -0,0 +1,107 @@
+#ifndef SCRIPT_SCRIPT_PROFILER_H
+#define SCRIPT_SCRIPT_PROFILER_H
+
+#include "Core/Features.h"
+
+#ifdef NW_PROFILE
+#include <stdint.h>
+#include <EASTL/vector.h>
+#include <EASTL/hash_map.h>
+#include <angelscript.h>
+
+namespace script
+{
+    //Time spent in script functions, for script authors.
+    //
+    //Every script function gets a zone when the module is loaded, kept in the
+    //function's user data, so timing a call is a lookup and two timestamps.
+    //Calls from the engine also show up as zones in the CPU profiler.
+    //
+    //By default only the functions the engine calls are timed, and their
+    //exclusive time is the same as their inclusive time. Line profiling adds
+    //a line callback that follows the script call stack, which gives
+    //inclusive and exclusive time for every function plus the time spent on
+    //each line. It is a lot slower, so the numbers are best compared to each
+    //other rather than to the rest of the frame.
+    class ScriptProfiler
+    {
+    public:
+        //Function user data slot holding the zone index + 1. The add-ons
+        //reserve 1000 through 1999, the engine's own slots start at 2000.
+        static const asPWORD FUNCTION_ZONE = 2000;
+
+    private:
+        struct FunctionZone
+        {
+            const char* name;       //Interned, shared with the CPU profiler
+            uint64_t calls;
+            uint64_t inclusiveTicks;
+            uint64_t exclusiveTicks;
+        };
+
+        struct StackEntry
+        {
+            asIScriptFunction* fn;
+            uint32_t zone;
+            uint64_t enterTicks;
+            uint64_t childTicks;
+        };
+
+        struct LineStats
+        {
+            uint32_t zone;
+            int line;
+            const char* section;
+            uint64_t ticks;
+            uint64_t samples;
+        };
+
+        eastl::vector<FunctionZone> _zones;
+        eastl::hash_map<const char*, uint32_t> _zonesByName;
+
+        bool _lineProfiling;
+        bool _pendingLineProfiling;
+        eastl::vector<StackEntry> _stack;
+        eastl::hash_map<uint64_t, LineStats> _lines;
+        uint64_t _lineTicks;        //When the current line started
+        uint32_t _lineZone;
+        int _line;
+        const char* _lineSection;
+
+    public:
+        ScriptProfiler();
+
+        //Gives every function and method in the module a zone
+        void assignZones(asIScriptModule* module);
+
+        inline uint32_t getZone(asIScriptFunction* fn)
+        {
+            uintptr_t data = (uintptr_t)fn->GetUserData(FUNCTION_ZONE);
+            return (data != 0) ? (uint32_t)(data - 1) : addZone(fn);
+        }
+
+        //Wrap the engine's calls into script, returns the start timestamp
+        uint64_t beginCall(asIScriptContext* ctx, asIScriptFunction* fn);
+        void endCall(asIScriptFunction* fn, uint64_t begin);
+
+        //Takes effect from the next call, so scripts can toggle it
+        void setLineProfiling(bool enabled) { _pendingLineProfiling = enabled; }
+        bool isLineProfiling() const { return _lineProfiling; }
+
+        void reset();
+        //Writes functions sorted by exclusive time, then the slowest lines
+        void writeFlatProfile(const char* fileName);
+
+    private:
+        uint32_t addZone(asIScriptFunction* fn);
+        void applyLineProfiling(asIScriptContext* ctx);
+
+        static void lineCallback(asIScriptContext* ctx, void* profiler);
+        void onLine(asIScriptContext* ctx);
+        void endLine(uint64_t now);
+        void popStack(uint32_t depth, uint64_t now);
+    };
+}
+#endif
+
+#endif
@@ -35,6 +35,12 @@ void Timer::update()
     }
 }
 
+void Timer::advance(uint32_t ticks)
+{
+    _gamePreviousTime = _gameCurrentTime;
+    _gameCurrentTime += ticks;
+}
+
 uint32_t Timer::elapsedTicks()
 {
     return _gameCurrentTime - _gamePreviousTime;
@@ -23,6 +23,8 @@ public:
 
     void reset();
     void update();
+    //Moves game time on by a recorded amount instead of reading the clock
+    void advance(uint32_t ticks);
     uint32_t elapsedTicks();
     float time();
 };
@@ -0,0 +1,45 @@
+#ifndef UTIL_ARCHIVE_TRAITS_H
+#define UTIL_ARCHIVE_TRAITS_H
+
+#include <stddef.h>
+#include <type_traits>
+
+namespace util
+{
+    template <size_t Size>
+    struct BulkSerializedSize
+    {
+        static const size_t value = Size;
+    };
+
+    template <typename T>
+    struct VoidType
+    {
+        typedef void type;
+    };
+
+    //Types whose in-memory layout is exactly their serialized form.
+    //Arrays of these are read and written with a single copy instead of
+    //calling serialize() per element. Mark types with AR_BULK_SERIALIZABLE().
+    template <typename T, typename = void>
+    struct IsBulkSerializable
+    {
+        static const bool value = std::is_fundamental<T>::value;
+    };
+
+    template <typename T>
+    struct IsBulkSerializable<T, typename VoidType<typename T::ArBulkSerializedSize>::type>
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Bulk serializable types must be trivially copyable");
+        static_assert(sizeof(T) == T::ArBulkSerializedSize::value, "Type has padding or fields that are not serialized");
+        static const bool value = true;
+    };
+}
+
+//Place in the public section of a type. serializedSize is the number of bytes
+//its serialize() function writes, which guards against fields being added to
+//one but not the other.
+#define AR_BULK_SERIALIZABLE(serializedSize) \
+    typedef util::BulkSerializedSize<serializedSize> ArBulkSerializedSize
+
+#endif
@@ -5,8 +5,10 @@
 #include <cassert>
 #include <cstring>
 #include <cstdio>
+#include <type_traits>
 #include <EASTL/vector.h>
 #include <EASTL/hash_map.h>
+#include "ArchiveTraits.h"
 
 #define AR_SERIALIZE_ARRAY(ar, arr, size, fn) \
     do { \
@@ -14,23 +16,35 @@
         for (uint32_t _idx = 0; _idx < size; _idx++) { ar.fn(_ptr[_idx]); } \
     } while (0)
 
-#define AR_SERIALIZE_ARRAY_CHAR(ar, ptr, size) AR_SERIALIZE_ARRAY(ar, ptr, size, serializeChar)
+//Primitive arrays are handed to the archive as a single block so it can
+//copy (and byte swap if needed) the whole range at once
+#define AR_SERIALIZE_ARRAY_BULK(ar, arr, size, type) \
+    do { \
+        auto* _ptr = (arr); \
+        static_assert(sizeof(*_ptr) == sizeof(type), "Array element size does not match " #type); \
+        ar.serializeArray(_ptr, (size_t)(size)); \
+    } while (0)
+
+#define AR_SERIALIZE_ARRAY_CHAR(ar, ptr, size) AR_SERIALIZE_ARRAY_BULK(ar, ptr, size, char)
 
-#define AR_SERIALIZE_ARRAY_U8(ar, ptr, size) AR_SERIALIZE_ARRAY(ar, ptr, size, serializeU8)
-#define AR_SERIALIZE_ARRAY_U16(ar, ptr, size) AR_SERIALIZE_ARRAY(ar, ptr, size, serializeU16)
-#define AR_SERIALIZE_ARRAY_U32(ar, ptr, size) AR_SERIALIZE_ARRAY(ar, ptr, size, serializeU32)
-#define AR_SERIALIZE_ARRAY_U64(ar, ptr, size) AR_SERIALIZE_ARRAY(ar, ptr, size, serializeU64)
+#define AR_SERIALIZE_ARRAY_U8(ar, ptr, size) AR_SERIALIZE_ARRAY_BULK(ar, ptr, size, uint8_t)
+#define AR_SERIALIZE_ARRAY_U16(ar, ptr, size) AR_SERIALIZE_ARRAY_BULK(ar, ptr, size, uint16_t)
+#define AR_SERIALIZE_ARRAY_U32(ar, ptr, size) AR_SERIALIZE_ARRAY_BULK(ar, ptr, size, uint32_t)
+#define AR_SERIALIZE_ARRAY_U64(ar, ptr, size) AR_SERIALIZE_ARRAY_BULK(ar, ptr, size, uint64_t)
 
-#define AR_SERIALIZE_ARRAY_I8(ar, ptr, size) AR_SERIALIZE_ARRAY(ar, ptr, size, serializeI8)
-#define AR_SERIALIZE_ARRAY_I16(ar, ptr, size) AR_SERIALIZE_ARRAY(ar, ptr, size, serializeI16)
-#define AR_SERIALIZE_ARRAY_I32(ar, ptr, size) AR_SERIALIZE_ARRAY(ar, ptr, size, serializeI32)
-#define AR_SERIALIZE_ARRAY_I64(ar, ptr, size) AR_SERIALIZE_ARRAY(ar, ptr, size, serializeI64)
+#define AR_SERIALIZE_ARRAY_I8(ar, ptr, size) AR_SERIALIZE_ARRAY_BULK(ar, ptr, size, int8_t)
+#define AR_SERIALIZE_ARRAY_I16(ar, ptr, size) AR_SERIALIZE_ARRAY_BULK(ar, ptr, size, int16_t)
+#define AR_SERIALIZE_ARRAY_I32(ar, ptr, size) AR_SERIALIZE_ARRAY_BULK(ar, ptr, size, int32_t)
+#define AR_SERIALIZE_ARRAY_I64(ar, ptr, size) AR_SERIALIZE_ARRAY_BULK(ar, ptr, size, int64_t)
 
-#define AR_SERIALIZE_ARRAY_F32(ar, ptr, size) AR_SERIALIZE_ARRAY(ar, ptr, size, serializeF32)
-#define AR_SERIALIZE_ARRAY_F64(ar, ptr, size) AR_SERIALIZE_ARRAY(ar, ptr, size, serializeF64)
+#define AR_SERIALIZE_ARRAY_F32(ar, ptr, size) AR_SERIALIZE_ARRAY_BULK(ar, ptr, size, float)
+#define AR_SERIALIZE_ARRAY_F64(ar, ptr, size) AR_SERIALIZE_ARRAY_BULK(ar, ptr, size, double)
 
-#define AR_SERIALIZE_ARRAY_CUSTOM(ar, ptr, size) AR_SERIALIZE_ARRAY(ar, ptr, size, serializeCustom)
+//Bulk serializable types are copied as a block, everything else is serialized per element
+#define AR_SERIALIZE_ARRAY_CUSTOM(ar, ptr, size) ar.serializeCustomArray((ptr), (size_t)(size))
 
+//Only usable with the per element archive functions, primitive vectors can
+//use AR_SERIALIZE_ARRAY_XX on vec.data() after serializing the size
 #define AR_SERIALIZE_VECTOR(ar, vec, fn) \
     do { \
         uint32_t _size = (uint32_t)vec.size(); \
@@ -60,12 +74,50 @@
 
 namespace util
 {
+    //Byte swaps used by archives that write in the non-native endianness.
+    //Written as plain shifts so the bulk loops below can be vectorized.
+    NW_FORCEINLINE uint8_t byteSwap(uint8_t v) { return v; }
+    NW_FORCEINLINE uint16_t byteSwap(uint16_t v) { return (uint16_t)((v << 8) | (v >> 8)); }
+    NW_FORCEINLINE uint32_t byteSwap(uint32_t v)
+    {
+        return (v << 24) | ((v << 8) & 0x00FF0000u) | ((v >> 8) & 0x0000FF00u) | (v >> 24);
+    }
+    NW_FORCEINLINE uint64_t byteSwap(uint64_t v)
+    {
+        return ((uint64_t)byteSwap((uint32_t)v) << 32) | byteSwap((uint32_t)(v >> 32));
+    }
+
+    template <size_t Size> struct ByteSwapWord;
+    template <> struct ByteSwapWord<1> { typedef uint8_t Type; };
+    template <> struct ByteSwapWord<2> { typedef uint16_t Type; };
+    template <> struct ByteSwapWord<4> { typedef uint32_t Type; };
+    template <> struct ByteSwapWord<8> { typedef uint64_t Type; };
+
+    //Copies count primitives of type T from src into dst, flipping the byte order of each
+    template <typename T>
+    NW_FORCEINLINE void byteSwapCopy(void* dst, const T* src, size_t count)
+    {
+        typedef typename ByteSwapWord<sizeof(T)>::Type Word;
+        static_assert(std::is_trivially_copyable<T>::value, "byteSwapCopy() requires a primitive type");
+
+        //Going through memcpy keeps this valid for floats and unaligned destinations
+        uint8_t* out = (uint8_t*)dst;
+        for (size_t i = 0; i < count; i++)
+        {
+            Word word;
+            memcpy(&word, src + i, sizeof(Word));
+            word = byteSwap(word);
+            memcpy(out + i * sizeof(Word), &word, sizeof(Word));
+        }
+    }
+
     class MemoryReadArchive
     {
     private:
         const char* _memoryStart;
         const char* _memoryEnd;
         const char* _currentPosition;
+        bool _canMap;
 
         NW_FORCEINLINE void serializeInternal(void* ptr, size_t length)
         {
@@ -82,7 +134,8 @@ namespace util
         MemoryReadArchive() :
             _memoryStart(nullptr),
             _memoryEnd(nullptr),
-            _currentPosition(nullptr)
+            _currentPosition(nullptr),
+            _canMap(true)
         {
         }
 
@@ -97,6 +150,10 @@ namespace util
         const char* endPtr() const { return _memoryEnd; }
         const char* currentPtr() const { return _currentPosition; }
 
+        //Archives over memory that won't outlive the read (such as rewind
+        //states) disable mapping, which makes systems copy their data out
+        void setMappingEnabled(bool enabled) { _canMap = enabled; }
+
 
         // === Start Archive Interface ===
         NW_FORCEINLINE void serializeChar(char& v) { serializeInternal(&v, sizeof(v)); }
@@ -114,13 +171,63 @@ namespace util
         NW_FORCEINLINE void serializeF32(float& v) { serializeInternal(&v, sizeof(v)); }
         NW_FORCEINLINE void serializeF64(double& v) { serializeInternal(&v, sizeof(v)); }
 
+        NW_FORCEINLINE void serializeBytes(void* ptr, size_t length) { serializeInternal(ptr, length); }
+
+        //Bytes that are reserved in the archive but have no serialized meaning
+        NW_FORCEINLINE void serializePadding(size_t length) { _currentPosition += length; }
+
+        //Aligns relative to the start of the archive, so the memory the archive
+        //was initialized with should be at least as aligned.
+        NW_FORCEINLINE void serializeAlign(size_t alignment)
+        {
+            size_t offset = (size_t)(_currentPosition - _memoryStart);
+            _currentPosition = _memoryStart + ((offset + alignment - 1) & ~(alignment - 1));
+        }
+
+        //Returns the next length bytes of the archive for the caller to use in place.
+        //The memory is only valid for as long as the archive's memory is.
+        //Returns nullptr without advancing when mapping is disabled.
+        NW_FORCEINLINE void* mapBytes(size_t length)
+        {
+            if (!_canMap) { return nullptr; }
+            void* mapped = (void*)_currentPosition;
+            _currentPosition += length;
+            return mapped;
+        }
+
+        template <typename T>
+        NW_FORCEINLINE void serializeArray(T* ptr, size_t count)
+        {
+            static_assert(std::is_fundamental<T>::value, "serializeArray() should only be called for primitives");
+            serializeInternal(ptr, sizeof(T) * count);
+        }
+
         template <typename T>
         NW_FORCEINLINE void serializeCustom(T& value)
         {
             static_assert(!std::is_fundamental<T>(), "serializeCustom() should not be called for primitives");
-            value.serialize<MemoryReadArchive>(*this);
+            value.template serialize<MemoryReadArchive>(*this);
+        }
+
+        template <typename T>
+        NW_FORCEINLINE void serializeCustomArray(T* ptr, size_t count)
+        {
+            serializeCustomArray(ptr, count, std::integral_constant<bool, IsBulkSerializable<T>::value>());
         }
         // === End Archive Interface ===
+
+    private:
+        template <typename T>
+        NW_FORCEINLINE void serializeCustomArray(T* ptr, size_t count, std::true_type)
+        {
+            serializeInternal(ptr, sizeof(T) * count);
+        }
+
+        template <typename T>
+        NW_FORCEINLINE void serializeCustomArray(T* ptr, size_t count, std::false_type)
+        {
+            for (size_t i = 0; i < count; i++) { serializeCustom(ptr[i]); }
+        }
     };
 
     class EndianVectorWriteArchive
@@ -138,20 +245,53 @@ namespace util
         }
 
         void setFlipEndian(bool flip) { _flipEndian = flip; }
+        void reserve(size_t size) { _data.reserve(size); }
         uint8_t* data() { return _data.data(); }
         size_t size() { return _data.size(); }
 
 
         // === Start Archive Interface ===
-#define IMPLEMENT_SERIALIZE_FN(fnname, type)\
-        NW_FORCEINLINE void fnname(type data)\
-        {\
-            union { type value; char bytes[sizeof(data)]; } temp;\
-            temp.value = data;\
-            if (!_flipEndian) { for (int i = 0; i < sizeof(data); i++) { _data.push_back(temp.bytes[i]); } }\
-            else              { for (int i = 0; i < sizeof(data); i++) { _data.push_back(temp.bytes[sizeof(data) - i]); } }\
+        NW_FORCEINLINE void serializeBytes(const void* ptr, size_t length)
+        {
+            //Raw bytes are never flipped
+            const uint8_t* bytes = (const uint8_t*)ptr;
+            _data.insert(_data.end(), bytes, bytes + length);
         }
 
+        NW_FORCEINLINE void serializePadding(size_t length)
+        {
+            _data.resize(_data.size() + length, 0);
+        }
+
+        NW_FORCEINLINE void serializeAlign(size_t alignment)
+        {
+            size_t offset = _data.size();
+            serializePadding(((offset + alignment - 1) & ~(alignment - 1)) - offset);
+        }
+
+        //Nothing to map when writing; callers fall back to serializing normally
+        NW_FORCEINLINE void* mapBytes(size_t) { return nullptr; }
+
+        template <typename T>
+        NW_FORCEINLINE void serializeArray(const T* ptr, size_t count)
+        {
+            static_assert(std::is_fundamental<T>::value, "serializeArray() should only be called for primitives");
+
+            if (!_flipEndian || sizeof(T) == 1)
+            {
+                serializeBytes(ptr, sizeof(T) * count);
+            }
+            else
+            {
+                size_t offset = _data.size();
+                _data.resize(offset + sizeof(T) * count);
+                byteSwapCopy(_data.data() + offset, ptr, count);
+            }
+        }
+
+#define IMPLEMENT_SERIALIZE_FN(fnname, type)\
+        NW_FORCEINLINE void fnname(type data) { serializeArray(&data, 1); }
+
         IMPLEMENT_SERIALIZE_FN(serializeChar, char);
 
         IMPLEMENT_SERIALIZE_FN(serializeU8, uint8_t);
@@ -171,7 +311,21 @@ namespace util
         template <typename T>
         NW_FORCEINLINE void serializeCustom(T& value)
         {
-            value.serialize<EndianVectorWriteArchive>(*this);
+            value.template serialize<EndianVectorWriteArchive>(*this);
+        }
+
+        template <typename T>
+        NW_FORCEINLINE void serializeCustomArray(T* ptr, size_t count)
+        {
+            //Bulk types are stored in native order, so flipping has to go through each field
+            if (IsBulkSerializable<T>::value && !_flipEndian)
+            {
+                serializeBytes(ptr, sizeof(T) * count);
+            }
+            else
+            {
+                for (size_t i = 0; i < count; i++) { serializeCustom(ptr[i]); }
+            }
         }
         // === End Archive Interface ===
 
@@ -184,10 +338,9 @@ namespace util
 #define IMPLEMENT_SERIALIZE_FN(fnname, type)\
         NW_FORCEINLINE void fnname(size_t offset, type data)\
         {\
-            union { type value; char bytes[sizeof(data)]; } temp;\
-            temp.value = data;\
-            if (!_flipEndian) { for (int i = 0; i < sizeof(data); i++) { _data[offset + i] = temp.bytes[i]; } }\
-            else              { for (int i = 0; i < sizeof(data); i++) { _data[offset + i] = temp.bytes[sizeof(data) - i]; } }\
+            NW_ASSERT(offset + sizeof(data) <= _data.size());\
+            if (!_flipEndian) { memcpy(_data.data() + offset, &data, sizeof(data)); }\
+            else              { byteSwapCopy(_data.data() + offset, &data, 1); }\
         }
 
         IMPLEMENT_SERIALIZE_FN(offsetSerializeChar, char);
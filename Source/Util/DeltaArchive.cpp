@@ -0,0 +1,141 @@
+#include "Core/Core.h"
+#include "DeltaArchive.h"
+
+namespace util
+{
+    //Unchanged runs shorter than this are folded into the surrounding
+    //changed run, since two varints cost about as much as the words
+    const size_t MIN_UNCHANGED_WORDS = 2;
+
+    static void writeVarint(eastl::vector<uint8_t>& out, size_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((uint8_t)value);
+    }
+
+    static size_t readVarint(const uint8_t*& data)
+    {
+        size_t value = 0;
+        uint32_t shift = 0;
+        uint8_t byte;
+        do
+        {
+            byte = *data++;
+            value |= (size_t)(byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        return value;
+    }
+
+    static NW_FORCEINLINE uint64_t loadWord(const uint8_t* data, size_t word)
+    {
+        uint64_t value;
+        memcpy(&value, data + word * sizeof(uint64_t), sizeof(value));
+        return value;
+    }
+
+    static NW_FORCEINLINE void storeWord(uint8_t* data, size_t word, uint64_t value)
+    {
+        memcpy(data + word * sizeof(uint64_t), &value, sizeof(value));
+    }
+
+    static size_t paddedSize(size_t size)
+    {
+        return (size + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+    }
+
+    void DeltaWriteArchive::encodeDelta(eastl::vector<uint8_t>& delta)
+    {
+        const size_t previousSize = _previous.size();
+        const size_t currentSize = _current.size();
+
+        delta.clear();
+        writeVarint(delta, previousSize);
+        writeVarint(delta, currentSize);
+
+        //Both states are compared a word at a time, with bytes past the end
+        //of the shorter one treated as zero
+        const size_t totalSize = paddedSize(previousSize > currentSize ? previousSize : currentSize);
+        _previous.resize(totalSize, 0);
+        _current.resize(totalSize, 0);
+
+        const uint8_t* prev = _previous.data();
+        const uint8_t* curr = _current.data();
+        const size_t wordCount = totalSize / sizeof(uint64_t);
+
+        size_t word = 0;
+        while (word < wordCount)
+        {
+            size_t unchangedStart = word;
+            while (word < wordCount && loadWord(prev, word) == loadWord(curr, word)) { word++; }
+
+            //Extend the changed run until a long enough unchanged run is found
+            size_t changedStart = word;
+            while (word < wordCount)
+            {
+                if (loadWord(prev, word) != loadWord(curr, word)) { word++; continue; }
+
+                size_t runEnd = word + 1;
+                while (runEnd < wordCount && runEnd - word < MIN_UNCHANGED_WORDS &&
+                    loadWord(prev, runEnd) == loadWord(curr, runEnd))
+                {
+                    runEnd++;
+                }
+
+                if (runEnd - word >= MIN_UNCHANGED_WORDS || runEnd == wordCount) { break; }
+                word = runEnd;
+            }
+
+            //Trailing unchanged words don't need a record
+            size_t changedWords = word - changedStart;
+            if (changedWords == 0) { break; }
+
+            writeVarint(delta, changedStart - unchangedStart);
+            writeVarint(delta, changedWords);
+
+            size_t offset = delta.size();
+            delta.resize(offset + changedWords * sizeof(uint64_t));
+            uint8_t* out = delta.data() + offset;
+            for (size_t i = 0; i < changedWords; i++)
+            {
+                storeWord(out, i, loadWord(prev, changedStart + i) ^ loadWord(curr, changedStart + i));
+            }
+        }
+
+        _previous.resize(previousSize);
+        _current.resize(currentSize);
+    }
+
+    void applyDelta(eastl::vector<uint8_t>& state, const uint8_t* delta, size_t deltaSize)
+    {
+        const uint8_t* deltaEnd = delta + deltaSize;
+        const size_t previousSize = readVarint(delta);
+        const size_t currentSize = readVarint(delta);
+        NW_ASSERT(state.size() == previousSize || state.size() == currentSize);
+
+        const size_t targetSize = (state.size() == currentSize) ? previousSize : currentSize;
+        const size_t totalSize = paddedSize(previousSize > currentSize ? previousSize : currentSize);
+        state.resize(totalSize, 0);
+
+        uint8_t* data = state.data();
+        size_t word = 0;
+        while (delta < deltaEnd)
+        {
+            word += readVarint(delta);
+            size_t changedWords = readVarint(delta);
+            NW_ASSERT((word + changedWords) * sizeof(uint64_t) <= totalSize);
+
+            for (size_t i = 0; i < changedWords; i++, word++)
+            {
+                storeWord(data, word, loadWord(data, word) ^ loadWord(delta, i));
+            }
+            delta += changedWords * sizeof(uint64_t);
+        }
+
+        state.resize(targetSize);
+    }
+}
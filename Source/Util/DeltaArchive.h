@@ -0,0 +1,119 @@
+#ifndef UTIL_DELTA_ARCHIVE_H
+#define UTIL_DELTA_ARCHIVE_H
+
+#include <stdint.h>
+#include <cstring>
+#include <type_traits>
+#include <EASTL/vector.h>
+#include "ArchiveTraits.h"
+
+namespace util
+{
+    //Write archive that keeps the previously written state around so the
+    //difference between the two can be encoded cheaply. Data is always
+    //written in native order.
+    //
+    //A delta is the XOR of both states, split into runs of unchanged 8 byte
+    //words and runs of changed words. Since XOR is its own inverse the same
+    //delta turns either state into the other.
+    //
+    //Delta layout (all counts are LEB128 varints):
+    //  previousSize, currentSize
+    //  repeated: unchangedWords, changedWords, changedWords * 8 bytes of XOR
+    class DeltaWriteArchive
+    {
+    private:
+        eastl::vector<uint8_t> _previous;
+        eastl::vector<uint8_t> _current;
+
+    public:
+        static const bool IsReading = false;
+        static const bool IsWriting = true;
+
+        //Keeps the last written state as the base and starts writing a new one
+        void begin()
+        {
+            _previous.swap(_current);
+            _current.clear();
+        }
+
+        //Encodes the difference between the base and the state written since begin()
+        void encodeDelta(eastl::vector<uint8_t>& delta);
+
+        //Last written state. Rewinding applies deltas to it directly.
+        eastl::vector<uint8_t>& getState() { return _current; }
+
+
+        // === Start Archive Interface ===
+        NW_FORCEINLINE void serializeBytes(const void* ptr, size_t length)
+        {
+            const uint8_t* bytes = (const uint8_t*)ptr;
+            _current.insert(_current.end(), bytes, bytes + length);
+        }
+
+        NW_FORCEINLINE void serializePadding(size_t length)
+        {
+            _current.resize(_current.size() + length, 0);
+        }
+
+        NW_FORCEINLINE void serializeAlign(size_t alignment)
+        {
+            size_t offset = _current.size();
+            serializePadding(((offset + alignment - 1) & ~(alignment - 1)) - offset);
+        }
+
+        NW_FORCEINLINE void* mapBytes(size_t) { return nullptr; }
+
+        template <typename T>
+        NW_FORCEINLINE void serializeArray(const T* ptr, size_t count)
+        {
+            static_assert(std::is_fundamental<T>::value, "serializeArray() should only be called for primitives");
+            serializeBytes(ptr, sizeof(T) * count);
+        }
+
+#define IMPLEMENT_SERIALIZE_FN(fnname, type)\
+        NW_FORCEINLINE void fnname(type data) { serializeBytes(&data, sizeof(data)); }
+
+        IMPLEMENT_SERIALIZE_FN(serializeChar, char);
+
+        IMPLEMENT_SERIALIZE_FN(serializeU8, uint8_t);
+        IMPLEMENT_SERIALIZE_FN(serializeU16, uint16_t);
+        IMPLEMENT_SERIALIZE_FN(serializeU32, uint32_t);
+        IMPLEMENT_SERIALIZE_FN(serializeU64, uint64_t);
+
+        IMPLEMENT_SERIALIZE_FN(serializeI8, int8_t);
+        IMPLEMENT_SERIALIZE_FN(serializeI16, int16_t);
+        IMPLEMENT_SERIALIZE_FN(serializeI32, int32_t);
+        IMPLEMENT_SERIALIZE_FN(serializeI64, int64_t);
+
+        IMPLEMENT_SERIALIZE_FN(serializeF32, float);
+        IMPLEMENT_SERIALIZE_FN(serializeF64, double);
+#undef IMPLEMENT_SERIALIZE_FN
+
+        template <typename T>
+        NW_FORCEINLINE void serializeCustom(T& value)
+        {
+            value.template serialize<DeltaWriteArchive>(*this);
+        }
+
+        template <typename T>
+        NW_FORCEINLINE void serializeCustomArray(T* ptr, size_t count)
+        {
+            if (IsBulkSerializable<T>::value)
+            {
+                serializeBytes(ptr, sizeof(T) * count);
+            }
+            else
+            {
+                for (size_t i = 0; i < count; i++) { serializeCustom(ptr[i]); }
+            }
+        }
+        // === End Archive Interface ===
+    };
+
+    //Turns state into the other state the delta was encoded from.
+    //state must be the size of one of the two states.
+    void applyDelta(eastl::vector<uint8_t>& state, const uint8_t* delta, size_t deltaSize);
+}
+
+#endif
@@ -34,5 +34,34 @@ namespace file
         fwrite(text, strlen(text), 1, f);
         fclose(f);
     }
+
+    bool readAllBytes(const char* fileName, eastl::vector<uint8_t>& data)
+    {
+        FILE* f;
+        fopen_s(&f, fileName, "rb");
+
+        if (f == nullptr) { return false; }
+
+        fseek(f, 0, SEEK_END);
+        size_t size = ftell(f);
+        data.resize(size);
+
+        rewind(f);
+        bool read = fread(data.data(), 1, size, f) == size;
+        fclose(f);
+
+        return read;
+    }
+
+    bool writeAllBytes(const char* fileName, const void* data, size_t size)
+    {
+        FILE* f = fopen(fileName, "wb");
+        if (f == nullptr) { return false; }
+
+        bool written = fwrite(data, 1, size, f) == size;
+        fclose(f);
+
+        return written;
+    }
 }
 }
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <stdint.h>
+#include <EASTL/vector.h>
 
 namespace util
 {
@@ -10,6 +11,8 @@ namespace file
 {
     std::string readAllText(const char* fileName);
     void writeAllText(const char* fileName, const char* text);
+    bool readAllBytes(const char* fileName, eastl::vector<uint8_t>& data);
+    bool writeAllBytes(const char* fileName, const void* data, size_t size);
 }
 }
 
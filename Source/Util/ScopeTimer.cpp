@@ -16,5 +16,22 @@ ScopeTimer::~ScopeTimer()
     printf("%s took %lld us\n", _message, endTime.QuadPart - _startTime.QuadPart);
 }
 #else
-#error "Scope timer not implemented."
+#include <time.h>
+
+static uint64_t getTimeNs()
+{
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+}
+
+ScopeTimer::ScopeTimer(const char* message) : _message(message)
+{
+    _startTime = getTimeNs();
+}
+
+ScopeTimer::~ScopeTimer()
+{
+    printf("%s took %llu us\n", _message, (unsigned long long)((getTimeNs() - _startTime) / 1000));
+}
 #endif
\ No newline at end of file
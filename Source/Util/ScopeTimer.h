@@ -1,6 +1,7 @@
 #ifndef UTIL_SCOPE_TIMER_H
 #define UTIL_SCOPE_TIMER_H
 
+#include <stdint.h>
 #ifdef _WIN32
 #define NOMINMAX
 #include <Windows.h>
@@ -12,6 +13,8 @@ private:
     const char* _message;
 #ifdef _WIN32
     LARGE_INTEGER _startTime;
+#else
+    uint64_t _startTime;    //Nanoseconds
 #endif
 
 public:
@@ -0,0 +1,134 @@
+-- Headless build of the game for performance runs on machines without a
+-- window, audio device or GPU. Runs the cooked scene for a number of fixed
+-- updates and prints the profiler zones, see headlessMain().
+project "FairlightBench"
+    uuid (os.uuid("FairlightBench"))
+    kind "ConsoleApp"
+
+    debugdir "../"
+
+    includedirs {
+        path.join(ROOT_DIR, "Source"),
+        path.join(DEPEND_DIR, "EASTL/include"),
+        path.join(DEPEND_DIR, "bx/include"),
+        path.join(DEPEND_DIR, "bimg/include"),
+        path.join(DEPEND_DIR, "bgfx/include"),
+        path.join(DEPEND_DIR, "angelscript/include"),
+        path.join(DEPEND_DIR, "lz4/include"),
+        path.join(DEPEND_DIR, "rapidjson/include"),
+    }
+
+    files {
+        path.join(ROOT_DIR, "Source/**.h"),
+        path.join(ROOT_DIR, "Source/**.cpp"),
+        path.join(ROOT_DIR, "Source/**.c"),
+    }
+
+    links {
+        "angelscript",
+        "EASTL",
+        "LZ4",
+        "SDL2",
+        "SDL2_mixer",
+    }
+
+    defines {
+        "AS_NO_EXCEPTIONS",
+        "EA_COMPILER_NO_NOEXCEPT",
+        "NW_HEADLESS",
+        "NW_PROFILE",
+    }
+
+    configuration { "vs*" }
+        includedirs {
+            path.join(DEPEND_DIR, "bx/include/compat/msvc"),
+            path.join(SDL2_DIR, "include"),
+            path.join(SDL2_MIXER_DIR, "include"),
+        }
+    configuration { "x32", "vs*" }
+        libdirs {
+            path.join(DEPEND_DIR, "bgfx/.build/win32_" .. _ACTION .. "/bin"),
+            path.join(SDL2_DIR, "lib/x86"),
+            path.join(SDL2_MIXER_DIR, "lib/x86"),
+        }
+        links {
+            "psapi"
+        }
+    configuration { "x64", "vs*" }
+        includedirs {
+            path.join(DEPEND_DIR, "PIX/include"),
+        }
+        libdirs {
+            path.join(DEPEND_DIR, "bgfx/.build/win64_" .. _ACTION .. "/bin"),
+            path.join(SDL2_DIR, "lib/x64"),
+            path.join(SDL2_MIXER_DIR, "lib/x64"),
+            path.join(DEPEND_DIR, "PIX/bin"),
+        }
+        links {
+            "WinPixEventRuntime",
+        }
+
+    -- SDL2 and SDL2_mixer come from the system packages, bgfx from
+    -- "make linux-release64" in Dependencies/bgfx
+    configuration { "linux-*" }
+        includedirs {
+            "/usr/include/SDL2",
+        }
+        libdirs {
+            path.join(DEPEND_DIR, "bgfx/.build/linux64_gcc/bin"),
+        }
+        buildoptions_cpp {
+            "-std=c++14",
+        }
+
+    -----------------------
+    -- Include BGFX libs --
+    -----------------------
+    configuration { "Debug" }
+        links {
+            "bgfxDebug",
+            "bimg_decodeDebug",
+            "bimgDebug",
+            "bxDebug",
+        }
+    configuration { "Develop or Profile or Release" }
+        links {
+            "bgfxRelease",
+            "bimg_decodeRelease",
+            "bimgRelease",
+            "bxRelease",
+        }
+
+    -- The static bgfx libs have to come before the system libs they use,
+    -- the linker only resolves symbols from libraries listed later
+    configuration { "linux-*" }
+        links {
+            "GL",
+            "X11",
+            "pthread",
+        }
+
+    ---------------------------
+    -- Configuration Defines --
+    ---------------------------
+    -- Timings are the point of this target, so every configuration profiles.
+    -- Debug and Develop include the asset cook, which only builds with MSVC.
+    configuration { "Debug" }
+        defines {
+            "NW_CONFIG_DEBUG",
+        }
+
+    configuration { "Develop" }
+        defines {
+            "NW_CONFIG_DEVELOP",
+        }
+
+    configuration { "Profile or Release" }
+        defines {
+            "NW_CONFIG_RELEASE",
+        }
+
+    configuration { "vs*" }
+        buildoptions {
+            "/wd4127",  -- warning C4127: conditional expression is constant
+        }
@@ -57,3 +57,4 @@ dofile "eastl.lua"
 dofile "lz4.lua"
 
 dofile "fairlight.lua"
+dofile "fairlightbench.lua"
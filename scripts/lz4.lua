@@ -1,4 +1,4 @@
-LZ4_DIR = path.join(DEPEND_DIR, "LZ4")
+LZ4_DIR = path.join(DEPEND_DIR, "lz4")
 
 project "LZ4"
     uuid (os.uuid("LZ4"))